@@ -0,0 +1,126 @@
+/*
+ * Headless Render Benchmark
+ *
+ * Runs the sprite benchmarks without a window or VSync so results are
+ * comparable between machines and between commits (CI, remote boxes).
+ * The GL context comes from EGL (see HeadlessContext) and renders into an
+ * offscreen framebuffer.
+ *
+ * Usage:
+ *   build/headless_bench [--frames N] [--sprites N] [--seed N] [--dump frame.ppm]
+ *                        [--width W] [--height H] [--scalability] [--vertex-formats]
+ *                        [--kernels] [--atlas-packing] [--asset-loading]
+ *                        [--chunk-meshing]
+ *
+ * --asset-loading times the startup resource set loaded blocking and async;
+ * run it from the directory holding shaders/ and assets/.
+ */
+
+#include "ECS/ECS.hpp"
+#include "ECS/systems/OptimizedRenderSystem2D.hpp"
+#include "HeadlessContext.hpp"
+#include "RenderBenchmark.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    int width = 1280;
+    int height = 720;
+    bool scalability = false;
+    bool vertexFormats = false;
+    bool kernels = false;
+    bool atlasPacking = false;
+    bool assetLoading = false;
+    bool chunkMeshing = false;
+
+    BenchmarkConfig config;
+    config.numSprites = 1000;
+    config.fixedFrameCount = 300;
+    config.fixedTimeStep = 1.0f / 60.0f;
+    config.randomSeed = 1337;
+    config.finishEachFrame = true;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            config.fixedFrameCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--sprites") == 0 && hasValue) {
+            config.numSprites = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            config.randomSeed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--dump") == 0 && hasValue) {
+            config.framebufferDumpPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--width") == 0 && hasValue) {
+            width = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--height") == 0 && hasValue) {
+            height = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--scalability") == 0) {
+            scalability = true;
+        } else if (std::strcmp(argv[i], "--vertex-formats") == 0) {
+            vertexFormats = true;
+        } else if (std::strcmp(argv[i], "--kernels") == 0) {
+            kernels = true;
+        } else if (std::strcmp(argv[i], "--atlas-packing") == 0) {
+            atlasPacking = true;
+        } else if (std::strcmp(argv[i], "--asset-loading") == 0) {
+            assetLoading = true;
+        } else if (std::strcmp(argv[i], "--chunk-meshing") == 0) {
+            chunkMeshing = true;
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // The kernel, packing and meshing benchmarks are CPU-only and need no GL context
+    if (kernels) {
+        RenderBenchmark benchmark;
+        benchmark.runVertexKernelBenchmark(config.numSprites * 10, config.fixedFrameCount);
+        return 0;
+    }
+    if (atlasPacking) {
+        RenderBenchmark benchmark;
+        benchmark.runAtlasPackingBenchmark(config.numSprites * 10);
+        return 0;
+    }
+    if (chunkMeshing) {
+        RenderBenchmark benchmark;
+        benchmark.runChunkMeshingBenchmark();
+        return 0;
+    }
+
+    HeadlessContext context(width, height);
+    if (!context.init()) {
+        std::cerr << "Failed to create headless GL context" << std::endl;
+        return 1;
+    }
+    context.bind();
+
+    if (assetLoading) {
+        RenderBenchmark benchmark;
+        benchmark.runAssetLoadingBenchmark();
+        context.destroy();
+        return 0;
+    }
+
+    ECS ecs;
+    auto renderSystem = ecs.registerSystem<OptimizedRenderSystem2D>();
+    ecs.setSystemSignature<OptimizedRenderSystem2D>({
+        typeid(SpriteComponent).hash_code(),
+        typeid(TransformComponent2D).hash_code()
+    });
+    renderSystem->init();
+
+    RenderBenchmark benchmark;
+    if (vertexFormats) {
+        benchmark.runVertexFormatBenchmark(config.numSprites, config.fixedFrameCount);
+    } else if (scalability) {
+        benchmark.runScalabilityTest(ecs, *renderSystem, config);
+    } else {
+        benchmark.runComparisonBenchmark(ecs, *renderSystem, config);
+    }
+
+    context.destroy();
+    return 0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "RectPacker.hpp"
+#include "VirtualFileSystem.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Baked atlas file (.atlas), written by tools/atlas_baker.
+ *
+ * Layout, little-endian, every section 16-byte aligned:
+ *   AtlasFileHeader
+ *   AtlasFileSprite[spriteCount]      UV table, in the order sprites were listed
+ *   uint32_t[hashCapacity]            name hash table: sprite index + 1, 0 = empty,
+ *                                     FNV-1a of the name, linear probing
+ *   char[]                            sprite names, not terminated
+ *   pixels                            per page, levels 0..levelCount-1, RGBA8,
+ *                                     rows bottom-up (as glTexImage2D takes them)
+ *
+ * The loader maps the file and hands the pixel levels straight to GL, so
+ * nothing is decoded, packed or copied at startup.
+ */
+
+struct AtlasFileHeader {
+    char magic[4];              // "ATLS"
+    uint32_t version;
+    uint32_t pageWidth, pageHeight;
+    uint32_t pageCount, levelCount;
+    uint32_t spriteCount, hashCapacity;
+    uint64_t spriteOffset, hashOffset, nameOffset, pixelOffset;
+    uint64_t fileSize;
+};
+
+struct AtlasFileSprite {
+    float uv0[2], uv1[2];
+    float size[2];              // pixels
+    uint32_t page;
+    uint32_t rotated;
+    uint32_t nameOffset, nameLength;   // into the name section
+};
+
+static const uint32_t ATLAS_FILE_VERSION = 1;
+
+inline uint32_t hashAtlasName(const char* name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Decoded sprite pixels (top row first, as stb_image returns them)
+struct AtlasSourceImage {
+    const unsigned char* data = nullptr;
+    int width = 0, height = 0, channels = 4;
+};
+
+// Copy the sprites placed on one page into its RGBA8 pixels (rows bottom-up).
+// placements are padded by one pixel on each side.
+void composeAtlasPage(int page, int pageWidth, int pageHeight,
+                      const std::vector<AtlasSourceImage>& images,
+                      const std::vector<PackedRect>& placements,
+                      std::vector<unsigned char>& pixels);
+
+// UVs of a padded placement's inner region
+void atlasRegionUV(const PackedRect& rect, int pageWidth, int pageHeight, float uv0[2], float uv1[2]);
+
+// Number of mip levels down to 1x1
+int atlasLevelCount(int width, int height);
+
+// Next mip level of an 8-bit image (RGBA unless channels says otherwise), 2x2 box filter
+void downsampleAtlasLevel(const unsigned char* source, int width, int height,
+                          std::vector<unsigned char>& destination, int channels = 4);
+
+// Sprite entry as the baker sees it
+struct AtlasBakeSprite {
+    std::string name;
+    float uv0[2], uv1[2];
+    float size[2];
+    int page;
+    bool rotated;
+};
+
+// Write pages (level 0, one per page) and their mip chains to path
+bool writeAtlasFile(const std::string& path, int pageWidth, int pageHeight,
+                    const std::vector<AtlasBakeSprite>& sprites,
+                    const std::vector<std::vector<unsigned char>>& pages);
+
+// Read-only mapping of a baked atlas file
+class MappedAtlasFile {
+public:
+    MappedAtlasFile() = default;
+    ~MappedAtlasFile();
+    MappedAtlasFile(const MappedAtlasFile&) = delete;
+    MappedAtlasFile& operator=(const MappedAtlasFile&) = delete;
+
+    // Map and validate the file; false (and a message on std::cerr) if it isn't a usable atlas.
+    // An atlas in a mounted pack is used in place in the pack's mapping.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    const AtlasFileHeader& header() const { return *reinterpret_cast<const AtlasFileHeader*>(data); }
+    const AtlasFileSprite& sprite(int index) const { return sprites()[index]; }
+    std::string spriteName(int index) const;
+
+    // Sprite index by name through the file's hash table, or -1
+    int findSprite(const std::string& name) const;
+
+    // Pixels of one level of one page, and that level's size
+    const unsigned char* levelPixels(int page, int level) const;
+    int levelWidth(int level) const;
+    int levelHeight(int level) const;
+
+    // Let the OS drop the pixel pages once they are on the GPU
+    void releasePixels() const;
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    bool ownsMapping = false;   // mapped by open(), not served from a pack
+    FileBuffer packed;
+
+    const AtlasFileSprite* sprites() const {
+        return reinterpret_cast<const AtlasFileSprite*>(data + header().spriteOffset);
+    }
+    const uint32_t* hashTable() const {
+        return reinterpret_cast<const uint32_t*>(data + header().hashOffset);
+    }
+    size_t pageBytes() const;
+    bool validate(const std::string& path);
+};
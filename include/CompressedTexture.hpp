@@ -0,0 +1,70 @@
+#pragma once
+#include "glad/glad.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Block-compressed textures in KTX2 (written by tools/texture_compress) or
+ * DDS containers.
+ *
+ * BC1 is used for opaque images and BC3/BC7 for images with alpha. ETC2 RGB8
+ * and RGBA8 EAC are the fallback on GPUs without BCn. Files carry their full
+ * mip chain, so nothing is generated at load time. KTX2 files must not be
+ * supercompressed, and only 2D images are supported (cubemaps and arrays are
+ * built from one file per face/layer).
+ */
+
+// Not in the core-profile GLAD header
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+enum class BlockFormat {
+    BC1,        // RGB, 8 bytes per 4x4 block
+    BC3,        // RGBA, 16 bytes
+    BC7,        // RGBA, 16 bytes
+    ETC2_RGB,   // RGB, 8 bytes
+    ETC2_RGBA   // RGBA (EAC alpha), 16 bytes
+};
+
+GLenum blockFormatGLEnum(BlockFormat format);
+size_t blockFormatBlockBytes(BlockFormat format);
+const char* blockFormatName(BlockFormat format);
+
+// GL thread, once: record which formats the context can sample.
+// isBlockFormatSupported() reads the result and is safe on any thread.
+void queryBlockFormatSupport();
+bool isBlockFormatSupported(BlockFormat format);
+
+struct CompressedLevel {
+    int width = 0, height = 0;
+    size_t offset = 0, size = 0;    // into CompressedTextureData::data
+};
+
+struct CompressedTextureData {
+    BlockFormat format = BlockFormat::BC1;
+    int width = 0, height = 0;
+    std::vector<CompressedLevel> levels;    // level 0 first
+    std::vector<unsigned char> data;
+};
+
+// Read a .ktx2 or .dds file (told apart by content); false with a message on std::cerr if unusable
+bool readCompressedTexture(const std::string& path, CompressedTextureData& texture);
+
+// Compressed file to use for an image: "a/b.png" looks for "a/b.ktx2", then
+// "a/b.etc2.ktx2", then "a/b.dds", and returns the first whose format the
+// context supports. A .ktx2/.dds path is checked as is. "" if there is none.
+std::string findCompressedVariant(const std::string& imagePath);
+
+// Encode an RGBA8 image into 4x4 blocks, rows in upload order. Edge blocks
+// repeat the last row/column.
+void compressImage(BlockFormat format, const unsigned char* rgba, int width, int height,
+                   std::vector<unsigned char>& blocks);
+
+// Write texture as a KTX2 file (no supercompression)
+bool writeKtx2(const std::string& path, const CompressedTextureData& texture);
@@ -2,6 +2,8 @@
 #include <unordered_map>
 #include <typeindex>
 #include <memory>
+#include <vector>
+#include <stdexcept>
 
 class ComponentManager {
 private:
@@ -61,4 +63,11 @@ public:
         }
         return pool[entity];
     }
+
+    template <typename T>
+    std::vector<T>* getComponentArray() {
+        auto it = componentPools.find(std::type_index(typeid(T)));
+        if (it == componentPools.end()) return nullptr;
+        return std::static_pointer_cast<std::vector<T>>(it->second).get();
+    }
 };
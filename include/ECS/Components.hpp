@@ -9,6 +9,8 @@
 #include <iostream>
 #include "../Shader.hpp"
 #include "../CommandTypes.hpp"
+#include "../TextureAtlas.hpp"
+#include "../ResourceManager.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -301,12 +303,16 @@ struct SpriteComponent {
     glm::vec4 color = glm::vec4(1.0f);
     bool flipX = false;
     bool flipY = false;
+    glm::vec2 pivot = glm::vec2(0.5f);   // Point placed at the transform position; (0,0) bottom-left, (1,1) top-right
     
     // Atlas support
     std::string spriteName = "";     // Name of sprite in atlas (empty for direct texture)
     std::string atlasName = "";      // Name of atlas containing sprite
+    SpriteHandle spriteHandle;       // spriteName resolved against the atlas manager
+    unsigned int spriteHandleGeneration = 0; // Slot generation of a valid handle, else the atlas generation of the failed lookup (0 = never)
     int renderLayer = 0;             // Rendering layer for depth sorting
     bool useBatching = true;         // Whether to use batched rendering
+    bool animated = false;           // Drawn by AnimatedSpriteRenderer (set by AnimationSystem)
 
     SpriteComponent(
         GLuint texture = 0,
@@ -613,14 +619,15 @@ struct RenderableComponent {
         std::shared_ptr<Shader> shaderProgram = nullptr)
         : VAO(vao), VBO(vbo), EBO(ebo), vertexCount(vertexCount), textureID(texture), shader(shaderProgram) {}
 };
+// Flipbook playback state; change it through AnimationSystem::play/pause/resume
 struct AnimationComponent {
-    std::string currentAnimation;
-    float currentTime = 0.0f;
+    int clipId = -1;            // SpriteAnimationLibrary clip, -1 = not animated
+    float startTime = 0.0f;     // Library clock when playback (re)started
+    float speed = 1.0f;         // Playback rate
+    float timeOffset = 0.0f;    // Clip time already played at startTime
     bool isPlaying = true;
-    bool loop = true;
-    bool isPose = false;
-
-    std::unordered_map<std::string, size_t> animationMap;
+    bool dirty = true;          // State changed since the GPU instance was written
+    int instanceSlot = -1;      // AnimatedSpriteRenderer slot, -1 = not registered
 };
 struct SkeletonComponent {
     std::vector<glm::mat4> boneMatrices;
@@ -639,7 +646,7 @@ struct TransformComponent {
 
 struct TransformComponent2D {
     glm::vec3 position;
-    glm::vec2 rotation;
+    glm::vec2 rotation;   // x: rotation about the view axis in degrees (sprites); y is unused in 2D
     glm::vec2 scale;
 
     TransformComponent2D(
@@ -693,9 +700,13 @@ struct GameStateComponent {
 };
 
 // UI Element Component
+// The codes are resolved to handles once, here, so UIRenderer does not look
+// them up every frame. The handles hold no reference: the resources belong
+// to whoever loaded them.
 struct UITextElement {
     std::string text;
     std::string fontCode;
+    ResourceHandle<Font> font;
     glm::vec3 color;
     float fontsize;
     bool isTextVisible;
@@ -708,17 +719,19 @@ struct UITextElement {
             const glm::vec3 color = glm::vec3(1.0f, 1.0f, 1.0f),
             float fontsize = 12.0f,
             bool isTextVisible = true)
-        : text(text), fontCode(fontCode), color(color), fontsize(fontsize),
-          isTextVisible(isTextVisible) {}
+        : text(text), fontCode(fontCode), font(ResourceManager<Font>::getInstance().getHandle(fontCode)),
+          color(color), fontsize(fontsize), isTextVisible(isTextVisible) {}
 };
 
 struct UIImageElement {
     std::string textureCode;
+    ResourceHandle<Texture> texture;
     bool isImageVisible;
 
     // Constructor
     UIImageElement(const std::string textureCode = "", bool isImageVisible = false)
-        : textureCode(textureCode), isImageVisible(isImageVisible) {}
+        : textureCode(textureCode), texture(ResourceManager<Texture>::getInstance().getHandle(textureCode)),
+          isImageVisible(isImageVisible) {}
 };
 // UI Input Component
 struct UIInput {
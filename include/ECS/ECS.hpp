@@ -64,6 +64,17 @@ public:
         return componentManager.hasComponent<T>(entity);
     }
 
+    /** getComponentArray
+     *  get the dense storage for a component type (indexed by entity),
+     *  or nullptr if no entity has one yet. The pointer is stable until
+     *  the next addComponent of that type, so it can be handed to worker
+     *  threads that only read components.
+     */
+    template <typename T>
+    std::vector<T>* getComponentArray() {
+        return componentManager.getComponentArray<T>();
+    }
+
     // System Management
 
     /** registerSystem
@@ -1,16 +1,186 @@
 #pragma once
+#include <vector>
 #include "../System.hpp"
 #include "../Components.hpp"
+#include "../../SpriteAnimation.hpp"
 
-// Placeholder AnimationSystem for 2D - disabled for now
+/*
+ * Flipbook animation for 2D sprites.
+ *
+ * Frames are selected on the GPU from the library clock, so this system only
+ * advances the clock and rewrites an entity's instance when its playback state
+ * (play/pause/resume/setSpeed), transform, tint or layer changed. Animated
+ * sprites are drawn by AnimatedSpriteRenderer, between the batcher's layers.
+ */
 class AnimationSystem : public System {
 public:
     AnimationSystem() {
-        // Empty signature for now
-        setSignature({});
+        setSignature({
+            typeid(AnimationComponent).hash_code(),
+            typeid(SpriteComponent).hash_code(),
+            typeid(TransformComponent2D).hash_code()
+        });
     }
 
     void update(float deltaTime, ECS& ecs) override {
-        // Disabled for 2D conversion
+        float rebase = SpriteAnimationLibrary::getInstance().advance(deltaTime);
+        ++frame;
+
+        auto entities = ecs.getEntitiesBySignature(signature);
+        auto* animations = ecs.getComponentArray<AnimationComponent>();
+        auto* sprites = ecs.getComponentArray<SpriteComponent>();
+        auto* transforms = ecs.getComponentArray<TransformComponent2D>();
+
+        if (rebase > 0.0f && animations) rebaseClocks(*animations, rebase);
+
+        if (animations && sprites && transforms) {
+            for (auto entity : entities) {
+                if (entity >= animations->size() || entity >= sprites->size() || entity >= transforms->size()) continue;
+                updateEntity(entity, (*animations)[entity], (*sprites)[entity], (*transforms)[entity]);
+            }
+        }
+
+        releaseUnseen(animations, sprites);
+    }
+
+    // Start a clip from its first frame; replaying the current clip is a no-op
+    static void play(AnimationComponent& animation, int clipId, float speed = 1.0f) {
+        if (animation.clipId == clipId && animation.isPlaying) return;
+
+        animation.clipId = clipId;
+        animation.startTime = SpriteAnimationLibrary::getInstance().getTime();
+        animation.timeOffset = 0.0f;
+        animation.speed = speed;
+        animation.isPlaying = true;
+        animation.dirty = true;
+    }
+
+    static void pause(AnimationComponent& animation) {
+        if (!animation.isPlaying) return;
+
+        float now = SpriteAnimationLibrary::getInstance().getTime();
+        animation.timeOffset += (now - animation.startTime) * animation.speed;
+        animation.startTime = now;
+        animation.isPlaying = false;
+        animation.dirty = true;
+    }
+
+    static void resume(AnimationComponent& animation) {
+        if (animation.isPlaying) return;
+
+        animation.startTime = SpriteAnimationLibrary::getInstance().getTime();
+        animation.isPlaying = true;
+        animation.dirty = true;
+    }
+
+    // Change the playback rate without jumping to another frame
+    static void setSpeed(AnimationComponent& animation, float speed) {
+        if (animation.speed == speed) return;
+
+        if (animation.isPlaying) {
+            float now = SpriteAnimationLibrary::getInstance().getTime();
+            animation.timeOffset += (now - animation.startTime) * animation.speed;
+            animation.startTime = now;
+        }
+        animation.speed = speed;
+        animation.dirty = true;
+    }
+
+private:
+    // What each registered entity's GPU instance was last written from
+    struct Placement {
+        TransformComponent2D transform;
+        glm::vec4 color = glm::vec4(1.0f);
+        glm::vec2 pivot = glm::vec2(0.5f);
+        int layer = 0;
+        size_t lastSeen = 0;
+        int slot = -1;
+    };
+
+    std::vector<Placement> placements;          // indexed by entity
+    std::vector<size_t> registeredEntities;
+    size_t frame = 0;
+
+    void updateEntity(size_t entity, AnimationComponent& animation, SpriteComponent& sprite,
+                      const TransformComponent2D& transform) {
+        if (animation.clipId < 0) return;   // not seen, so released below
+
+        if (placements.size() <= entity) placements.resize(entity + 1);
+        Placement& placement = placements[entity];
+        placement.lastSeen = frame;
+
+        bool placed = animation.instanceSlot >= 0 && placement.slot == animation.instanceSlot;
+        if (placed && !animation.dirty && !placementChanged(placement, sprite, transform)) return;
+
+        placement.transform = transform;
+        placement.color = sprite.color;
+        placement.pivot = sprite.pivot;
+        placement.layer = sprite.renderLayer;
+
+        SpriteAffine2D affine = SpriteAffine2D::fromDegrees(transform.position, transform.scale,
+                                                            transform.rotation.x, sprite.pivot);
+        AnimatedSpriteInstance instance = AnimatedSpriteInstance::make(
+            affine, sprite.color, animation.clipId, animation.startTime,
+            animation.isPlaying ? animation.speed : 0.0f, animation.timeOffset);
+
+        auto& renderer = AnimatedSpriteRenderer::getInstance();
+        if (placed) {
+            renderer.updateInstance(animation.instanceSlot, instance, sprite.renderLayer);
+        } else {
+            animation.instanceSlot = renderer.addInstance(instance, sprite.renderLayer);
+            placement.slot = animation.instanceSlot;
+            registeredEntities.push_back(entity);
+        }
+
+        animation.dirty = false;
+        sprite.animated = true;
+    }
+
+    static bool placementChanged(const Placement& placement, const SpriteComponent& sprite,
+                                 const TransformComponent2D& transform) {
+        return placement.transform.position != transform.position
+            || placement.transform.rotation.x != transform.rotation.x
+            || placement.transform.scale != transform.scale
+            || placement.color != sprite.color
+            || placement.pivot != sprite.pivot
+            || placement.layer != sprite.renderLayer;
+    }
+
+    // The library epoch moved forward by `shift` seconds: restart every clip at the
+    // new epoch from the clip time it has reached, so start times stay near zero
+    static void rebaseClocks(std::vector<AnimationComponent>& animations, float shift) {
+        const auto& library = SpriteAnimationLibrary::getInstance();
+        for (auto& animation : animations) {
+            if (animation.clipId < 0) continue;
+
+            if (animation.isPlaying) {
+                float clipTime = animation.timeOffset + (shift - animation.startTime) * animation.speed;
+                animation.timeOffset = library.foldClipTime(animation.clipId, clipTime);
+                animation.dirty = true;
+            }
+            animation.startTime = 0.0f;
+        }
+    }
+
+    // Drop instances of entities that stopped animating or no longer match the signature
+    void releaseUnseen(std::vector<AnimationComponent>* animations, std::vector<SpriteComponent>* sprites) {
+        auto& renderer = AnimatedSpriteRenderer::getInstance();
+
+        for (size_t i = 0; i < registeredEntities.size();) {
+            size_t entity = registeredEntities[i];
+            Placement& placement = placements[entity];
+            if (placement.lastSeen == frame) {
+                ++i;
+                continue;
+            }
+
+            renderer.removeInstance(placement.slot);
+            placement.slot = -1;
+            if (animations && entity < animations->size()) (*animations)[entity].instanceSlot = -1;
+            if (sprites && entity < sprites->size()) (*sprites)[entity].animated = false;
+
+            registeredEntities[i] = registeredEntities.back();
+            registeredEntities.pop_back();
+        }
     }
-};
\ No newline at end of file
+};
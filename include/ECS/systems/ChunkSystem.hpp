@@ -55,7 +55,7 @@ public:
             if(chunk.dirty){
                 std::vector<GLfloat> vertices;
                 std::vector<GLint> indices;
-                updateChunkGeometry(chunk, renderable, vertices, indices);
+                updateChunkGeometry(chunk, renderable, vertices, indices, findNeighbours(ecs, chunk.chunkIndex));
                 chunk.dirty = false;
             }
         }
@@ -115,12 +115,45 @@ public:
                         elevation = map[posx][posy].finalElevation;
                     }
                     ChunkComponent chunk(chunkCoord, chunkSize, chunkSize, 40, 1.0f, elevation);
-                    size_t chunkEntity = addChunk(&ecs, map, chunk);
-                    chunkRegistry.insert({chunkCoord, chunkEntity});
+                    loadChunk(ecs, map, chunk);
                 }
             }
         }
     }
+    // Mesh a new chunk against the loaded ones around it and register it. The faces
+    // those had on the shared borders are hidden now, so they are rebuilt
+    size_t loadChunk(ECS& ecs, const std::vector<std::vector<ChunkData>>& worldMap, ChunkComponent& chunk) {
+        size_t chunkEntity = addChunk(&ecs, worldMap, chunk, findNeighbours(ecs, chunk.chunkIndex));
+        chunkRegistry.insert({chunk.chunkIndex, chunkEntity});
+        forEachNeighbour(chunk.chunkIndex, [&](const glm::ivec3&, size_t neighbour) {
+            ecs.getComponent<ChunkComponent>(neighbour).dirty = true;
+        });
+        return chunkEntity;
+    }
+
+    // The pointers are valid until the next ChunkComponent is added
+    ChunkNeighbours findNeighbours(ECS& ecs, const glm::ivec3& chunkCoord) {
+        ChunkNeighbours neighbours;
+        forEachNeighbour(chunkCoord, [&](const glm::ivec3& offset, size_t neighbour) {
+            neighbours.chunks[offset.x + 1][offset.y + 1][offset.z + 1] = &ecs.getComponent<ChunkComponent>(neighbour);
+        });
+        return neighbours;
+    }
+
+    template<typename Visit>
+    void forEachNeighbour(const glm::ivec3& chunkCoord, Visit visit) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    glm::ivec3 offset(dx, dz, dy);
+                    if (offset == glm::ivec3(0)) continue;
+                    auto it = chunkRegistry.find(chunkCoord + offset);
+                    if (it != chunkRegistry.end()) visit(offset, it->second);
+                }
+            }
+        }
+    }
+
     bool chunkExists(const glm::ivec3 &chunkCoord) {
         return (chunkRegistry.find(chunkCoord) != chunkRegistry.end());
     }
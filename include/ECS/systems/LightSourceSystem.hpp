@@ -1,6 +1,7 @@
 #pragma once;
 #include "../System.hpp"
 #include "../Components.hpp"
+#include "../../LightRenderer2D.hpp"
 
 class LightSourceSystem : public System {
 public:
@@ -9,12 +10,17 @@ public:
             typeid(LightSourceComponent2D).hash_code()
         });
     }
+    // Hand this frame's lights to the light renderer; it culls and draws them
     void update(float deltaTime, ECS& ecs) override {
         auto entities = ecs.getEntitiesBySignature(signature);
+        auto* lights = ecs.getComponentArray<LightSourceComponent2D>();
+
+        auto& lightRenderer = LightRenderer2D::getInstance();
+        lightRenderer.clearLights();
+        if (!lights) return;
 
         for (auto entity : entities) {
-            auto& light = ecs.getComponent<LightSourceComponent2D>(entity);
-            //std::cout << "light: " << light.position.y << " \n";
+            if (entity < lights->size()) lightRenderer.addLight((*lights)[entity]);
         }
     }
 };
\ No newline at end of file
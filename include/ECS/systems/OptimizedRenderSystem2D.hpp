@@ -8,6 +8,11 @@
 #include "../../ResourceManager.hpp"
 #include "../../SpriteBatcher.hpp"
 #include "../../TextureAtlas.hpp"
+#include "../../RenderPipeline.hpp"
+#include "../../SpriteAnimation.hpp"
+#include "../../LightRenderer2D.hpp"
+#include "../../GLStateCache.hpp"
+#include "../../RenderGraph.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -19,6 +24,14 @@ public:
     bool enableBatching = true;
     bool enableFrustumCulling = true;
     bool showDebugInfo = false;
+    
+    // Multiply sprites by a light map built from LightSourceComponent2D (see LightSourceSystem)
+    bool enableLighting = false;
+    
+    // Build render commands on worker threads and draw them on the GL thread
+    bool enablePipelining = true;
+    size_t pipelineWorkers = 2;
+    int pipelineLatency = 1;   // 0 = draw this frame's packet, 1 = draw last frame's
 
     OptimizedRenderSystem2D() {
         setSignature({
@@ -30,11 +43,19 @@ public:
     void init() {
         // Initialize sprite render manager
         SpriteRenderManager::getInstance().init();
+        AnimatedSpriteRenderer::getInstance().init();
+        LightRenderer2D::getInstance().init();
         
         // Set up default atlas
         auto& atlasManager = TextureAtlasManager::getInstance();
         defaultAtlas = atlasManager.createAtlas("default", 1024, 1024);
         
+        if (enablePipelining) {
+            pipeline = std::make_unique<RenderPipeline>(pipelineWorkers, pipelineLatency);
+        }
+        // Dynamic atlases keep what a packet still waiting to be drawn refers to
+        atlasManager.setFrameLatency(pipeline ? pipeline->getFrameLatency() : 0);
+        
         std::cout << "OptimizedRenderSystem2D initialized with batching support" << std::endl;
     }
 
@@ -49,10 +70,61 @@ public:
             updateFrustumCulling(camera);
         }
         
-        if (enableBatching) {
+        // Camera matrices for every shader with the FrameConstants block
+        FrameConstantBuffer::getInstance().setCamera(camera.viewMatrix, camera.projectionMatrix);
+        
+        // Inside a graph frame, draw in the lighting and world passes instead of now
+        auto& graph = RenderGraph::getInstance();
+        if (graph.isRecording()) {
+            submitToGraph(graph, entities, ecs, camera);
+            return;
+        }
+        
+        // Light map first; the sprite shaders sample it
+        renderLightMap(camera);
+        renderSprites(entities, ecs, camera);
+    }
+    
+    void submitToGraph(RenderGraph& graph, const std::vector<size_t>& entities, ECS& ecs,
+                       const CameraComponent2D& camera) {
+        const DefaultRenderPasses& passes = graph.getDefaultPasses();
+        
+        auto& lightRenderer = LightRenderer2D::getInstance();
+        lightRenderer.setEnabled(enableLighting);
+        if (lightRenderer.isEnabled()) {
+            glm::vec3 ambient = lightRenderer.getAmbient();
+            graph.setClear(passes.lighting, GL_COLOR_BUFFER_BIT, glm::vec4(ambient, 1.0f));
+            
+            // Same camera as the world pass, which may draw last frame's packet
+            glm::mat4 viewProjection;
+            FrustumBounds2D bounds;
+            getSubmittedView(camera, viewProjection, bounds);
+            lightRenderer.cullLights(bounds.min, bounds.max);
+            
+            RenderResource lightMap = passes.lightMap;
+            graph.submit(passes.lighting, [&graph, &lightRenderer, viewProjection, lightMap]() {
+                lightRenderer.drawLights(viewProjection);
+                lightRenderer.useLightMap(graph.getTexture(lightMap),
+                                          graph.getWidth(RenderGraph::BACKBUFFER),
+                                          graph.getHeight(RenderGraph::BACKBUFFER));
+            });
+        }
+        
+        graph.submit(passes.world, [this, entities, &ecs, camera]() {
+            renderSprites(entities, ecs, camera);
+        });
+    }
+    
+    void renderSprites(const std::vector<size_t>& entities, ECS& ecs, const CameraComponent2D& camera) {
+        if (enableBatching && enablePipelining && pipeline) {
+            renderPipelined(entities, ecs, camera);
+        } else if (enableBatching) {
             renderWithBatching(entities, ecs, camera);
         } else {
             renderLegacy(entities, ecs, camera);
+            
+            // Immediate sprites aren't sorted by layer, so animated ones go on top
+            AnimatedSpriteRenderer::getInstance().render(camera.projectionMatrix * camera.viewMatrix);
         }
         
         // Display debug information
@@ -92,9 +164,133 @@ public:
     void toggleDebugInfo() { showDebugInfo = !showDebugInfo; }
     void toggleBatching() { enableBatching = !enableBatching; }
     void toggleFrustumCulling() { enableFrustumCulling = !enableFrustumCulling; }
+    
+    // 0 draws commands in the frame they were built, 1 overlaps building frame N+1 with drawing frame N
+    void setPipelineLatency(int latency) {
+        pipelineLatency = latency;
+        if (pipeline) pipeline->setFrameLatency(latency);
+        TextureAtlasManager::getInstance().setFrameLatency(pipeline ? pipeline->getFrameLatency() : 0);
+    }
 
 private:
     std::shared_ptr<TextureAtlas> defaultAtlas;
+    std::unique_ptr<RenderPipeline> pipeline;
+    AnimatedSpriteFrame animatedFrame;   // renderWithBatching's capture
+    
+    void renderPipelined(const std::vector<size_t>& entities, ECS& ecs, const CameraComponent2D& camera) {
+        // Resolve component storage here; workers must not touch the ECS maps
+        auto* sprites = ecs.getComponentArray<SpriteComponent>();
+        const auto* transforms = ecs.getComponentArray<TransformComponent2D>();
+        if (!sprites || !transforms) return;
+        
+        // Sprite names are resolved on this thread so workers only index flat tables
+        for (auto entity : entities) {
+            if (entity < sprites->size()) resolveSpriteHandle((*sprites)[entity]);
+        }
+        
+        RenderFramePacket& buildPacket = pipeline->getBuildPacket();
+        buildPacket.view = camera.viewMatrix;
+        buildPacket.projection = camera.projectionMatrix;
+        buildPacket.viewProjection = camera.projectionMatrix * camera.viewMatrix;
+        buildPacket.frustum = computeFrustumBounds(camera);
+        
+        // Flipbook sprites registered by AnimationSystem, drawn with the packet
+        // between the batched sprites' layers
+        AnimatedSpriteRenderer::getInstance().capture(buildPacket.animated);
+        
+        // Stage one: each worker walks and culls its share of the entities
+        pipeline->beginBuild([&entities, sprites, transforms](RenderFramePacket& packet, size_t workerIndex, size_t workerCount) {
+            buildPacketSlice(packet, workerIndex, workerCount, entities, *sprites, *transforms);
+        });
+        
+        // Stage two: draw last frame's packet while the workers run
+        if (pipeline->getFrameLatency() > 0) {
+            submitPacket(pipeline->getSubmitPacket());
+        }
+        
+        // The ECS is not synchronised, so stage one must finish before simulation resumes
+        pipeline->waitForBuild();
+        
+        if (pipeline->getFrameLatency() == 0) {
+            submitPacket(pipeline->getSubmitPacket());
+        }
+        
+        pipeline->endFrame();
+    }
+    
+    static void buildPacketSlice(RenderFramePacket& packet, size_t workerIndex, size_t workerCount,
+                                 const std::vector<size_t>& entities,
+                                 const std::vector<SpriteComponent>& sprites,
+                                 const std::vector<TransformComponent2D>& transforms) {
+        auto& slice = packet.slices[workerIndex];
+        size_t begin = entities.size() * workerIndex / workerCount;
+        size_t end = entities.size() * (workerIndex + 1) / workerCount;
+        slice.sprites.reserve(end - begin);
+        
+        for (size_t i = begin; i < end; ++i) {
+            size_t entity = entities[i];
+            if (entity >= sprites.size() || entity >= transforms.size()) continue;
+            
+            const auto& sprite = sprites[entity];
+            const auto& transform = transforms[entity];
+            if (sprite.animated) continue;
+            
+            if (!sprite.useBatching) {
+                slice.immediateSprites.push_back({sprite, transform});
+                continue;
+            }
+            
+            SpriteAffine2D placement = createSpriteTransform(sprite, transform);
+            if (!packet.frustum.contains(placement.center(), placement.extent())) {
+                slice.spritesCulled++;
+                continue;
+            }
+            
+            PacketSprite command;
+            command.transform = placement;
+            command.color = sprite.color;
+            command.layer = sprite.renderLayer;
+            
+            // A name that doesn't resolve (yet) falls back to the sprite's own texture
+            if (sprite.spriteHandle.isValid()) {
+                const auto& atlasManager = TextureAtlasManager::getInstance();
+                const SpriteUV& spriteUV = atlasManager.getSpriteUV(sprite.spriteHandle);
+                command.textureID = atlasManager.getTextureID(sprite.spriteHandle);
+                command.uvMin = spriteUV.uv0;
+                command.uvMax = spriteUV.uv1;
+                if (spriteUV.rotated) command.transform = placement.forRotatedUV();
+            } else if (sprite.textureID > 0) {
+                command.textureID = sprite.textureID;
+                command.uvMin = sprite.textureOffset;
+                command.uvMax = sprite.textureOffset + sprite.textureSize;
+                
+                if (sprite.flipX) std::swap(command.uvMin.x, command.uvMax.x);
+                if (sprite.flipY) std::swap(command.uvMin.y, command.uvMax.y);
+            } else {
+                continue;
+            }
+            
+            slice.sprites.push_back(command);
+        }
+    }
+    
+    void submitPacket(const RenderFramePacket& packet) {
+        if (!packet.ready) return;
+        
+        // A packet built last frame draws with that frame's camera
+        auto& frameConstants = FrameConstantBuffer::getInstance();
+        FrameConstants current = frameConstants.get();
+        frameConstants.setCamera(packet.view, packet.projection);
+        
+        for (const auto& slice : packet.slices) {
+            for (const auto& immediate : slice.immediateSprites) {
+                renderSpriteImmediate(immediate.sprite, immediate.transform, packet.view, packet.projection);
+            }
+        }
+        
+        SpriteRenderManager::getInstance().submitPacket(packet);
+        frameConstants.setCamera(current.view, current.projection);
+    }
     
     void renderWithBatching(const std::vector<size_t>& entities, ECS& ecs, const CameraComponent2D& camera) {
         auto& renderManager = SpriteRenderManager::getInstance();
@@ -107,19 +303,21 @@ private:
         for (auto entity : entities) {
             auto& sprite = ecs.getComponent<SpriteComponent>(entity);
             auto& transform = ecs.getComponent<TransformComponent2D>(entity);
+            if (sprite.animated) continue;
             
             if (!sprite.useBatching) {
                 // Render immediately for sprites that don't use batching
-                renderSpriteImmediate(sprite, transform, camera);
+                renderSpriteImmediate(sprite, transform, camera.viewMatrix, camera.projectionMatrix);
                 continue;
             }
             
-            // Create transform matrix
-            glm::mat4 model = createTransformMatrix(transform);
+            // Position, rotation and pivot as a 2D affine transform
+            SpriteAffine2D model = createSpriteTransform(sprite, transform);
             
-            if (!sprite.spriteName.empty() && !sprite.atlasName.empty()) {
+            resolveSpriteHandle(sprite);
+            if (sprite.spriteHandle.isValid()) {
                 // Render atlas-based sprite
-                renderManager.renderSprite(sprite.spriteName, model, sprite.color, sprite.renderLayer);
+                renderManager.renderSprite(sprite.spriteHandle, model, sprite.color, sprite.renderLayer);
             } else if (sprite.textureID > 0) {
                 // Render direct texture sprite
                 glm::vec2 uvMin = sprite.textureOffset;
@@ -137,8 +335,9 @@ private:
             }
         }
         
-        // End batched rendering (submits all draw calls)
-        renderManager.endFrame();
+        // End batched rendering (submits all draw calls), animated sprites in layer order
+        AnimatedSpriteRenderer::getInstance().capture(animatedFrame);
+        renderManager.endFrame(animatedFrame);
     }
     
     void renderLegacy(const std::vector<size_t>& entities, ECS& ecs, const CameraComponent2D& camera) {
@@ -146,13 +345,15 @@ private:
         for (auto entity : entities) {
             auto& sprite = ecs.getComponent<SpriteComponent>(entity);
             auto& transform = ecs.getComponent<TransformComponent2D>(entity);
+            if (sprite.animated) continue;
             
-            renderSpriteImmediate(sprite, transform, camera);
+            resolveSpriteHandle(sprite);
+            renderSpriteImmediate(sprite, transform, camera.viewMatrix, camera.projectionMatrix);
         }
     }
     
     void renderSpriteImmediate(const SpriteComponent& sprite, const TransformComponent2D& transform, 
-                              const CameraComponent2D& camera) {
+                              const glm::mat4& view, const glm::mat4& projection) {
         if (!sprite.shader || (sprite.textureID == 0 && sprite.spriteName.empty())) {
             return;
         }
@@ -160,49 +361,145 @@ private:
         GLuint textureToUse = sprite.textureID;
         glm::vec2 uvMin = sprite.textureOffset;
         glm::vec2 uvMax = sprite.textureOffset + sprite.textureSize;
+        SpriteAffine2D placement = createSpriteTransform(sprite, transform);
         
         // Handle atlas sprites
-        if (!sprite.spriteName.empty() && !sprite.atlasName.empty()) {
-            auto atlas = TextureAtlasManager::getInstance().getAtlas(sprite.atlasName);
-            if (atlas) {
-                const SpriteUV* spriteUV = atlas->getSpriteUV(sprite.spriteName);
-                if (spriteUV) {
-                    textureToUse = atlas->getTextureID();
-                    uvMin = spriteUV->uv0;
-                    uvMax = spriteUV->uv1;
-                }
-            }
+        if (sprite.spriteHandle.isValid()) {
+            const auto& atlasManager = TextureAtlasManager::getInstance();
+            const SpriteUV& spriteUV = atlasManager.getSpriteUV(sprite.spriteHandle);
+            textureToUse = atlasManager.getTextureID(sprite.spriteHandle);
+            uvMin = spriteUV.uv0;
+            uvMax = spriteUV.uv1;
+            if (spriteUV.rotated) placement = placement.forRotatedUV();
         }
         
         if (textureToUse == 0) return;
         
-        glUseProgram(sprite.shader->ID);
+        const Shader& shader = *sprite.shader;
+        shader.use();
+        const ImmediateShaderUniforms& uniforms = bindImmediateShader(shader, view, projection);
         
         // Set up matrices
-        glm::mat4 model = createTransformMatrix(transform);
-        
-        // Upload matrices to shader
-        glUniformMatrix4fv(glGetUniformLocation(sprite.shader->ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(sprite.shader->ID, "view"), 1, GL_FALSE, glm::value_ptr(camera.viewMatrix));
-        glUniformMatrix4fv(glGetUniformLocation(sprite.shader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(camera.projectionMatrix));
+        glm::mat4 model = placement.toMatrix();
+        shader.setMat4(uniforms.model, model);
         
         // Upload sprite color
-        glUniform4fv(glGetUniformLocation(sprite.shader->ID, "spriteColor"), 1, glm::value_ptr(sprite.color));
+        shader.setVec4(uniforms.color, sprite.color);
         
         // Bind texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureToUse);
-        glUniform1i(glGetUniformLocation(sprite.shader->ID, "sprite"), 0);
+        GLStateCache::getInstance().bindTextureUnit(0, GL_TEXTURE_2D, textureToUse);
         
         // Render quad
         renderQuad();
     }
     
-    glm::mat4 createTransformMatrix(const TransformComponent2D& transform) {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, transform.position);
-        model = glm::scale(model, glm::vec3(transform.scale, 1.0f));
-        return model;
+    // Handles of the last shader used by renderSpriteImmediate
+    struct ImmediateShaderUniforms {
+        const Shader* shader = nullptr;
+        GLuint program = 0;
+        size_t frame = 0;
+        UniformHandle model, view, projection, color, sampler;
+    };
+    ImmediateShaderUniforms immediateUniforms;
+    
+    // Resolve the shader's handles when it changes and set the per-frame uniforms
+    // once per frame. Shaders with the FrameConstants block read the camera from there.
+    const ImmediateShaderUniforms& bindImmediateShader(const Shader& shader, const glm::mat4& view,
+                                                      const glm::mat4& projection) {
+        auto& uniforms = immediateUniforms;
+        size_t frame = FrameConstantBuffer::getInstance().getFrame();
+        bool sameShader = uniforms.shader == &shader && uniforms.program == shader.ID;
+        if (sameShader && uniforms.frame == frame && frame != 0) return uniforms;
+        
+        if (!sameShader) {
+            uniforms.shader = &shader;
+            uniforms.program = shader.ID;
+            uniforms.model = shader.getUniform("model");
+            uniforms.view = shader.getUniform("view");
+            uniforms.projection = shader.getUniform("projection");
+            uniforms.color = shader.getUniform("spriteColor");
+            uniforms.sampler = shader.getUniform("sprite");
+        }
+        uniforms.frame = frame;
+        
+        if (!shader.usesFrameConstants()) {
+            shader.setMat4(uniforms.view, view);
+            shader.setMat4(uniforms.projection, projection);
+        }
+        shader.setInt(uniforms.sampler, 0);
+        return uniforms;
+    }
+    
+    // Look the sprite's name up again only if its slot was freed since, or, for a
+    // name that didn't resolve, if sprites were added since the last attempt.
+    // Marking the handle used keeps a dynamic atlas from evicting it.
+    static void resolveSpriteHandle(SpriteComponent& sprite) {
+        auto& atlasManager = TextureAtlasManager::getInstance();
+        bool current = sprite.spriteHandle.isValid()
+            ? atlasManager.getHandleGeneration(sprite.spriteHandle) == sprite.spriteHandleGeneration
+            : atlasManager.getGeneration() == sprite.spriteHandleGeneration;
+        if (!current) {
+            sprite.spriteHandle = sprite.spriteName.empty()
+                ? SpriteHandle()
+                : atlasManager.resolveSprite(sprite.spriteName, sprite.atlasName);
+            sprite.spriteHandleGeneration = sprite.spriteHandle.isValid()
+                ? atlasManager.getHandleGeneration(sprite.spriteHandle)
+                : atlasManager.getGeneration();
+        }
+        if (sprite.spriteHandle.isValid()) atlasManager.markUsed(sprite.spriteHandle);
+    }
+    
+    static SpriteAffine2D createSpriteTransform(const SpriteComponent& sprite, const TransformComponent2D& transform) {
+        return SpriteAffine2D::fromDegrees(transform.position, transform.scale, transform.rotation.x, sprite.pivot);
+    }
+    
+    static glm::vec2 estimateViewSize(const CameraComponent2D& camera) {
+        // Estimate view size from projection matrix
+        float orthoWidth = 2.0f / camera.projectionMatrix[0][0];
+        float orthoHeight = 2.0f / camera.projectionMatrix[1][1];
+        return glm::vec2(orthoWidth, orthoHeight);
+    }
+    
+    FrustumBounds2D computeFrustumBounds(const CameraComponent2D& camera) const {
+        FrustumBounds2D bounds;
+        bounds.enabled = enableFrustumCulling;
+        
+        // Same bounds SpriteRenderManager::updateFrustum would produce
+        glm::vec2 halfSize = estimateViewSize(camera) * 0.5f / camera.zoom;
+        bounds.min = camera.position - halfSize;
+        bounds.max = camera.position + halfSize;
+        return bounds;
+    }
+    
+    void renderLightMap(const CameraComponent2D& camera) {
+        auto& lightRenderer = LightRenderer2D::getInstance();
+        lightRenderer.setEnabled(enableLighting);
+        if (!lightRenderer.isEnabled()) return;
+        
+        // Lights are culled against the view even when sprite culling is off
+        glm::mat4 viewProjection;
+        FrustumBounds2D bounds;
+        getSubmittedView(camera, viewProjection, bounds);
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        lightRenderer.render(viewProjection, bounds.min, bounds.max, viewport[2], viewport[3]);
+    }
+    
+    // Camera the sprites drawn this frame were built with: the pending packet's
+    // when the pipeline draws last frame's packet, otherwise the current one.
+    // The light map is screen space, so it has to match that camera.
+    void getSubmittedView(const CameraComponent2D& camera, glm::mat4& viewProjection,
+                          FrustumBounds2D& bounds) const {
+        bool pipelined = enableBatching && enablePipelining && pipeline && pipeline->getFrameLatency() > 0;
+        if (pipelined && pipeline->getSubmitPacket().ready) {
+            const RenderFramePacket& packet = pipeline->getSubmitPacket();
+            viewProjection = packet.viewProjection;
+            bounds = packet.frustum;
+            return;
+        }
+        
+        viewProjection = camera.projectionMatrix * camera.viewMatrix;
+        bounds = computeFrustumBounds(camera);
     }
     
     void updateFrustumCulling(const CameraComponent2D& camera) {
@@ -211,14 +508,7 @@ private:
         
         if (enableFrustumCulling) {
             // Calculate view bounds from camera
-            glm::vec2 cameraPos = camera.position;
-            
-            // Estimate view size from projection matrix
-            float orthoWidth = 2.0f / camera.projectionMatrix[0][0];
-            float orthoHeight = 2.0f / camera.projectionMatrix[1][1];
-            glm::vec2 viewSize(orthoWidth, orthoHeight);
-            
-            renderManager.updateFrustum(cameraPos, viewSize, camera.zoom);
+            renderManager.updateFrustum(camera.position, estimateViewSize(camera), camera.zoom);
         }
     }
     
@@ -231,6 +521,17 @@ private:
         std::cout << "Sprites Culled: " << stats.spritesCulled << std::endl;
         std::cout << "Batches Created: " << stats.batchesCreated << std::endl;
         std::cout << "Frame Time: " << stats.lastFrameTime << "ms" << std::endl;
+        std::cout << "  Build: " << stats.commandBuildTime << "ms, Sort: " << stats.sortTime
+                  << "ms, Vertices: " << stats.vertexGenTime << "ms, Upload: " << stats.uploadTime
+                  << "ms, Submit: " << stats.submitTime << "ms" << std::endl;
+        std::cout << "GPU Time: " << stats.gpuTime << "ms" << std::endl;
+        std::cout << "Bytes Uploaded: " << stats.bytesUploaded << std::endl;
+        const auto& stateStats = GLStateCache::getInstance().getStats();
+        std::cout << "GL State Calls: " << stateStats.callsIssued << " issued, "
+                  << stateStats.callsSkipped << " skipped" << std::endl;
+        if (LightRenderer2D::getInstance().isEnabled()) {
+            std::cout << "Lights Visible: " << LightRenderer2D::getInstance().getVisibleLightCount() << std::endl;
+        }
         std::cout << "===================" << std::endl;
     }
     
@@ -259,12 +560,12 @@ private:
             glGenBuffers(1, &quadVBO);
             glGenBuffers(1, &quadEBO);
             
-            glBindVertexArray(quadVAO);
+            GLStateCache::getInstance().bindVertexArray(quadVAO);
             
-            glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+            GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, quadVBO);
             glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
             
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+            GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
             
             // Position attribute
@@ -275,11 +576,11 @@ private:
             glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
             glEnableVertexAttribArray(1);
             
-            glBindVertexArray(0);
+            GLStateCache::getInstance().bindVertexArray(0);
         }
         
-        glBindVertexArray(quadVAO);
+        // Left bound so a run of immediate sprites binds it once
+        GLStateCache::getInstance().bindVertexArray(quadVAO);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
     }
 };
\ No newline at end of file
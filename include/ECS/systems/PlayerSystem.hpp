@@ -5,6 +5,7 @@
 #include "../../InputManager.hpp"
 #include "../../InventoryEvents.hpp"
 #include "ChunkSystem.hpp"
+#include "AnimationSystem.hpp"
 
 class PlayerSystem : public System {
 public:
@@ -20,6 +21,8 @@ public:
     ChunkSystem* chunkSystem;
     float playerCameraHeight = 3.0f;
     float playerMovementSpeed = 0.1f;
+    int walkClip = -1;
+    int idleClip = -1;
     ECS* ecs = nullptr;
     PlayerSystem() {
         setSignature({
@@ -56,10 +59,12 @@ void update(float deltaTime, ECS& ecs) override {
         
         
 
-        if (player.isWalking){
-            animation.currentAnimation = "Walk_01";
-        }
-        else animation.currentAnimation = "Idle_01";
+        // Clip ids are looked up until the clips exist, then reused
+        auto& clips = SpriteAnimationLibrary::getInstance();
+        if (walkClip < 0) walkClip = clips.findClip("Walk_01");
+        if (idleClip < 0) idleClip = clips.findClip("Idle_01");
+
+        AnimationSystem::play(animation, player.isWalking ? walkClip : idleClip);
     
     
     
@@ -6,6 +6,8 @@
 #include "../Components.hpp"
 #include "../Archetypes.hpp"
 #include "../../ResourceManager.hpp"
+#include "../../GLStateCache.hpp"
+#include "../../RenderGraph.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -27,6 +29,18 @@ public:
         // Get 2D camera
         auto& camera = ecs.getComponent<CameraComponent2D>(cameraEntity);
         
+        auto& graph = RenderGraph::getInstance();
+        if (graph.isRecording()) {
+            graph.submit(graph.getDefaultPasses().world, [this, entities, &ecs, camera]() {
+                renderSprites(entities, ecs, camera);
+            });
+        } else {
+            renderSprites(entities, ecs, camera);
+        }
+    }
+
+private:
+    void renderSprites(const std::vector<size_t>& entities, ECS& ecs, const CameraComponent2D& camera) {
         // Simple 2D sprite rendering
         for (auto entity : entities) {
             auto& sprite = ecs.getComponent<SpriteComponent>(entity);
@@ -38,9 +52,8 @@ public:
         }
     }
 
-private:
     void renderSprite(const SpriteComponent& sprite, const TransformComponent2D& transform, const CameraComponent2D& camera) {
-        glUseProgram(sprite.shader->ID);
+        GLStateCache::getInstance().useProgram(sprite.shader->ID);
         
         // Set up matrices
         glm::mat4 model = glm::mat4(1.0f);
@@ -48,17 +61,17 @@ private:
         model = glm::scale(model, glm::vec3(transform.scale, 1.0f));
         
         // Upload matrices to shader
-        glUniformMatrix4fv(glGetUniformLocation(sprite.shader->ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(sprite.shader->ID, "view"), 1, GL_FALSE, glm::value_ptr(camera.viewMatrix));
-        glUniformMatrix4fv(glGetUniformLocation(sprite.shader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(camera.projectionMatrix));
+        sprite.shader->setMat4("model", model);
+        sprite.shader->setMat4("view", camera.viewMatrix);
+        sprite.shader->setMat4("projection", camera.projectionMatrix);
         
         // Upload sprite color
-        glUniform4fv(glGetUniformLocation(sprite.shader->ID, "spriteColor"), 1, glm::value_ptr(sprite.color));
+        sprite.shader->setVec4("spriteColor", sprite.color);
         
         // Bind texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, sprite.textureID);
-        glUniform1i(glGetUniformLocation(sprite.shader->ID, "sprite"), 0);
+        GLStateCache::getInstance().activeTexture(GL_TEXTURE0);
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, sprite.textureID);
+        sprite.shader->setInt("sprite", 0);
         
         // Render quad (we'll need to set up a simple quad VBO/VAO)
         // For now, this is a placeholder
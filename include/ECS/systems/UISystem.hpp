@@ -3,6 +3,7 @@
 #include <string>
 #include "../../util/Transforms.hpp"
 #include "../../UIRenderer.hpp"
+#include "../../RenderGraph.hpp"
 #include "../System.hpp"
 #include "../Components.hpp"
 #include "../ArchetypeManager.hpp"
@@ -49,8 +50,15 @@ void update(float deltaTime, ECS& ecs) override {
         }
     }
     
-    // Render the UI entities
-    uiRenderer.render(entities, &ecs);
+    // Render the UI entities (in the graph's UI pass, after the world, when a frame is recording)
+    auto& graph = RenderGraph::getInstance();
+    if (graph.isRecording()) {
+        graph.submit(graph.getDefaultPasses().ui, [this, entities, &ecs]() {
+            uiRenderer.render(entities, &ecs);
+        });
+    } else {
+        uiRenderer.render(entities, &ecs);
+    }
     
 }
 
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Reports files written under watched directories (inotify, Linux only).
+ *
+ * A file counts as written when it is closed after writing or renamed into
+ * place, so editors that save through a temporary file are seen once, with
+ * the final name. Subdirectories are watched too, including ones created
+ * later. Elsewhere watch() fails and poll() never reports anything.
+ */
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watch directory and everything below it; false with a message on std::cerr if it can't
+    bool watch(const std::string& directory);
+
+    // Paths written since the last call ("dir/sub/file.png", joined onto the
+    // directory as given to watch()). Never blocks.
+    std::vector<std::string> poll();
+
+    void stop();
+
+private:
+    int descriptor = -1;
+    std::unordered_map<int, std::string> directories;   // watch descriptor -> directory
+
+    bool addWatch(const std::string& directory);
+};
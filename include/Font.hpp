@@ -3,8 +3,10 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <ResourceManager.hpp>
+#include "ResourceHandle.hpp"
 #include <glm/glm.hpp>
 #include "Shader.hpp"
 
@@ -16,6 +18,14 @@ struct Character {
     unsigned int Advance;   // Offset to advance to next glyph
 };
 
+// A glyph rendered by FreeType, not yet on the GPU
+struct GlyphBitmap {
+    std::vector<unsigned char> pixels;   // one byte per pixel, rows top-down
+    glm::ivec2 Size;
+    glm::ivec2 Bearing;
+    unsigned int Advance;
+};
+
 class Font {
 public:
     Font();
@@ -24,9 +34,19 @@ public:
     unsigned int VAO;
     unsigned int VBO;
     // Loads a font from a file with the specified size
-    Shader m_tileShader;
     bool loadFromFile(const std::string& fontPath, unsigned int fontSize);
+
+    // Render the ASCII glyphs with FreeType; no GL, safe on any thread
+    static bool rasterize(const std::string& fontPath, unsigned int fontSize, std::map<char, GlyphBitmap>& glyphs);
+
+    // Create the glyph textures and quad buffers (GL thread)
+    bool upload(const std::map<char, GlyphBitmap>& glyphs);
+
     bool renderText(std::string text, float x, float y, float scale, glm::vec3 color);
+
+private:
+    // Every font draws with the one "textShader" program
+    ResourceHandle<Shader> textShader;
 };
 
 #endif // FONT_HPP
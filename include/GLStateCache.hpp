@@ -0,0 +1,86 @@
+#pragma once
+#include "glad/glad.h"
+#include <cstddef>
+
+/*
+ * Shadow copy of the GL binding and enable state the renderers touch.
+ *
+ * Every bind/enable goes through here so calls that would not change
+ * anything are skipped. State the cache has not seen yet (or was told to
+ * forget with invalidate()) is treated as unknown and always issued.
+ * Deleting objects through the cache keeps it from treating a recycled
+ * name as still bound.
+ */
+struct GLStateStats {
+    size_t callsIssued = 0;    // state calls that reached GL
+    size_t callsSkipped = 0;   // redundant calls elided
+};
+
+class GLStateCache {
+public:
+    static GLStateCache& getInstance();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    // unit is the GL_TEXTUREi enum, as for glActiveTexture
+    void activeTexture(GLenum unit);
+    void bindTexture(GLenum target, GLuint texture);
+    // Bind to a unit without leaving the caller to restore the active unit
+    void bindTextureUnit(GLuint unit, GLenum target, GLuint texture);
+
+    void enable(GLenum cap);
+    void disable(GLenum cap);
+    void setEnabled(GLenum cap, bool enabled);
+    bool isEnabled(GLenum cap);
+
+    void blendFunc(GLenum source, GLenum destination);
+    void blendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha);
+    // Current blend factors (source rgb, destination rgb, source alpha, destination alpha)
+    void getBlendFunc(GLenum factors[4]);
+
+    void deleteProgram(GLuint program);
+    void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+    void deleteBuffers(GLsizei count, const GLuint* buffers);
+    void deleteTextures(GLsizei count, const GLuint* textures);
+
+    // Forget everything, e.g. after a new context was made current or
+    // after code that changes state behind the cache's back
+    void invalidate();
+
+    const GLStateStats& getStats() const { return stats; }
+    void resetStats() { stats = GLStateStats(); }
+
+    static const int MAX_TRACKED_TEXTURE_UNITS = 32;
+
+private:
+    static const GLuint UNKNOWN = ~0u;
+
+    // Buffer targets with a single binding point each
+    enum BufferSlot { ARRAY_BUFFER, ELEMENT_ARRAY_BUFFER, UNIFORM_BUFFER, TEXTURE_BUFFER,
+                      DRAW_INDIRECT_BUFFER, PIXEL_UNPACK_BUFFER, PIXEL_PACK_BUFFER, BUFFER_SLOT_COUNT };
+    // Texture targets tracked per unit
+    enum TextureSlot { TEXTURE_2D, TEXTURE_2D_ARRAY, TEXTURE_CUBE_MAP, TEXTURE_BUFFER_TARGET, TEXTURE_SLOT_COUNT };
+    // Capabilities tracked by enable()/disable()
+    enum CapabilitySlot { BLEND, DEPTH_TEST, CULL_FACE, SCISSOR_TEST, STENCIL_TEST, CAPABILITY_SLOT_COUNT };
+    enum CapabilityState : unsigned char { CAP_UNKNOWN, CAP_OFF, CAP_ON };
+
+    GLuint program = UNKNOWN;
+    GLuint vertexArray = UNKNOWN;
+    GLuint buffers[BUFFER_SLOT_COUNT];
+    GLuint activeUnit = UNKNOWN;   // index, not the GL_TEXTUREi enum
+    GLuint textures[MAX_TRACKED_TEXTURE_UNITS][TEXTURE_SLOT_COUNT];
+    CapabilityState capabilities[CAPABILITY_SLOT_COUNT];
+    GLenum blendFactors[4];
+    bool blendFactorsKnown = false;
+
+    GLStateStats stats;
+
+    GLStateCache() { invalidate(); }
+
+    static int bufferSlot(GLenum target);
+    static int textureSlot(GLenum target);
+    static int capabilitySlot(GLenum cap);
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/*
+ * Work that has to run on the thread owning the GL context, typically the
+ * upload after a worker finished decoding a file.
+ *
+ * Any thread may push. The GL thread drains the queue once per frame within
+ * a time budget, so a burst of finished loads is spread over several frames
+ * instead of stalling one.
+ */
+class GLUploadQueue {
+public:
+    static GLUploadQueue& getInstance();
+
+    // Thread-safe
+    void push(std::function<void()> upload);
+
+    // GL thread: run queued uploads until budgetMs has passed. At least one
+    // runs if any are queued, so a single large upload cannot stall the queue.
+    // Returns how many ran.
+    size_t process(double budgetMs);
+
+    // Block until an upload is queued or timeoutMs passes; true if one is queued
+    bool waitForWork(int timeoutMs);
+
+    size_t getPendingCount() const;
+    double getLastProcessTime() const { return lastProcessTime; }   // ms
+
+    GLUploadQueue(const GLUploadQueue&) = delete;
+    GLUploadQueue& operator=(const GLUploadQueue&) = delete;
+
+private:
+    std::deque<std::function<void()>> uploads;
+    mutable std::mutex mutex;
+    std::condition_variable pushed;
+    double lastProcessTime = 0.0;
+
+    GLUploadQueue() = default;
+};
@@ -233,8 +233,7 @@ private:
         // playerRenderable.m_model = ResourceManager<Model>::getInstance().get("riggedFigure"); // Disabled for 2D conversion
         // playerRenderable.m_model -> printAnimations(); // Disabled for 2D conversion
         // playerAnimation.animationMap = playerRenderable.m_model -> populateAnimationMap(); // Disabled for 2D conversion
-        playerAnimation.currentAnimation = "Idle_01";
-        size_t animationIndex = playerAnimation.animationMap[playerAnimation.currentAnimation];
+        playerAnimation.clipId = SpriteAnimationLibrary::getInstance().findClip("Idle_01");
         // playerSkeleton.boneMatrices = playerRenderable.m_model -> calculateFinalBoneMatrices(0.0f, animationIndex); // Disabled for 2D conversion
         playerRenderable.shader = ResourceManager<Shader>::getInstance().get("modelShader");
         playerRenderable.textureID = ResourceManager<Texture>::getInstance().get("playerTexture") -> getID();
@@ -290,8 +289,7 @@ private:
             
             glm::ivec3 chunkCoord = glm::ivec3(x - i, y - j,0);
             ChunkComponent chunk(chunkCoord, 16, 16, 40, 1.0f, worldMap[x][y].finalElevation);
-            size_t chunkEntity = addChunk(ecs.get(), worldMap, chunk);
-            chunkSystem ->chunkRegistry.insert({chunkCoord, chunkEntity});
+            chunkSystem -> loadChunk(*ecs, worldMap, chunk);
         }
         }
         // Create Test NPC's
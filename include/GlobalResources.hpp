@@ -0,0 +1,14 @@
+#pragma once
+
+// The shaders, textures and fonts shared by every game state, loaded once at startup.
+
+// Blocking: just the shaders
+void loadGlobalShaders();
+
+// Blocking: everything is decoded and uploaded on the calling (GL) thread
+void loadGlobalResources();
+
+// Through ResourceManager::loadAsync. Returns once the shaders are linked,
+// since systems resolve uniform handles when they are created. Textures and
+// fonts are served as placeholders until GLUploadQueue uploads them.
+void loadGlobalResourcesAsync();
@@ -0,0 +1,64 @@
+#pragma once
+#include "glad/glad.h"
+#include <string>
+#include <vector>
+
+/*
+ * Offscreen OpenGL context for running render code without a window or a
+ * display server (CI machines, deterministic benchmarks).
+ *
+ * Uses EGL (Mesa surfaceless platform when available, default display
+ * otherwise) to create a 3.3 core context, loads GLAD through it, and
+ * renders into an RGBA8 + depth framebuffer object. There is no swap chain,
+ * so nothing is ever throttled by VSync.
+ */
+class HeadlessContext {
+public:
+    HeadlessContext(int width = 1280, int height = 720);
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    // Create the context and offscreen framebuffer; false if EGL/GL is unavailable
+    bool init();
+    void destroy();
+
+    // Bind the offscreen framebuffer and viewport as the render target
+    void bind() const;
+
+    // Clear the offscreen framebuffer
+    void clear() const;
+
+    // Wait for all queued GL work to finish (stand-in for a swap)
+    void finish() const;
+
+    bool isInitialized() const { return initialized; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    GLuint getFramebuffer() const { return framebuffer; }
+
+    // Read back the colour attachment as tightly packed RGBA8, top row first
+    std::vector<unsigned char> readPixels() const;
+
+    // Write the colour attachment to a binary PPM for image-diff regression tests
+    bool saveFramebuffer(const std::string& path) const;
+
+private:
+    int width, height;
+    bool initialized;
+
+    void* display;
+    void* context;
+    void* surface;
+
+    GLuint framebuffer;
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+
+    bool createContext();
+    bool createFramebuffer();
+};
+
+// Write the currently bound read framebuffer (window or FBO) to a binary PPM
+bool saveFramebufferPPM(const std::string& path, int width, int height);
@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FileWatcher.hpp"
+
+class TextureAtlas;
+
+/*
+ * Reloads textures, shaders and atlas sprites when their files change on disk.
+ *
+ * Written files are picked up from a FileWatcher once they have been quiet
+ * for SETTLE_MS, so a save that touches a file several times reloads once.
+ * Files are read and decoded on the ThreadPool. The new version replaces the
+ * old one on the GL thread between frames, behind the same ResourceHandle,
+ * texture name and sprite index, so nothing that resolved them needs to
+ * know. A file that fails to load or compile leaves the old version in use.
+ * If a file changes again before its reload lands, the older reload is
+ * dropped.
+ *
+ * Fonts and baked atlases are not reloaded.
+ */
+class HotReload {
+public:
+    static HotReload& getInstance();
+
+    // Watch directories (recursively); false if none can be watched
+    bool start(const std::vector<std::string>& directories);
+
+    // GL thread, once per frame before GLUploadQueue::process(): start
+    // reloads for the files that have settled
+    void process();
+
+    void stop();
+    bool isRunning() const { return running; }
+
+    // Resources swapped so far
+    size_t getReloadCount() const { return reloadCount; }
+
+    HotReload(const HotReload&) = delete;
+    HotReload& operator=(const HotReload&) = delete;
+
+private:
+    static const int SETTLE_MS = 100;
+
+    FileWatcher watcher;
+    bool running = false;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> changed;   // path -> last write
+    std::unordered_map<std::string, uint64_t> serials;   // resource -> latest reload started
+    size_t reloadCount = 0;
+
+    HotReload() = default;
+
+    // False to try again next frame (a resource from the file is still loading)
+    bool reloadFile(const std::string& path);
+    void reloadTexture(const std::string& key, bool allowCompressed);
+    void reloadShader(const std::string& key);
+    void reloadSprite(std::shared_ptr<TextureAtlas> atlas, const std::string& spriteName, const std::string& path);
+
+    uint64_t beginReload(const std::string& resource) { return ++serials[resource]; }
+    bool isLatest(const std::string& resource, uint64_t serial) const;
+};
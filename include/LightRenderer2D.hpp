@@ -0,0 +1,108 @@
+#pragma once
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+struct LightSourceComponent2D;
+
+// Texture unit the sprite shaders read the light map from (atlases use the units below it)
+const int LIGHT_MAP_TEXTURE_UNIT = 15;
+
+// One light as the GPU sees it; std140-compatible, also the instance layout, 32 bytes
+struct PackedLight2D {
+    glm::vec4 positionRadius;    // xy position, z unused, w radius
+    glm::vec4 colorIntensity;    // rgb color, a intensity
+};
+
+// Light-map inputs of a sprite shader (uLightMap, uLightingEnabled, uInverseViewport)
+struct LightMapBinding {
+    GLint enabledLocation = -1;
+    GLint inverseViewportLocation = -1;
+
+    // Look the uniforms up once after linking; points uLightMap at LIGHT_MAP_TEXTURE_UNIT
+    void locate(GLuint program);
+
+    // Bind the current light map to the program in use, or switch lighting off
+    void apply() const;
+};
+
+/*
+ * 2D lighting: lights are collected once per frame, culled to the view and
+ * drawn as additive instanced quads into a light map (one upload, one draw).
+ * Sprite shaders then multiply by the light map at their pixel.
+ */
+class LightRenderer2D {
+public:
+    static LightRenderer2D& getInstance();
+
+    void init();
+    void shutdown();
+
+    // Lighting off: sprites are drawn unlit and render() does nothing
+    void setEnabled(bool enabled) { lightingEnabled = enabled; }
+    bool isEnabled() const { return lightingEnabled && initialized; }
+
+    // Light that reaches every pixel
+    void setAmbient(const glm::vec3& color) { ambient = color; }
+    const glm::vec3& getAmbient() const { return ambient; }
+
+    // Light map resolution relative to the viewport (lights are smooth, 0.5 is usually enough)
+    void setResolutionScale(float scale) { resolutionScale = scale; }
+
+    // Per-frame light list (LightSourceSystem fills this)
+    void clearLights() { lights.clear(); }
+    void addLight(const LightSourceComponent2D& light);
+    const std::vector<PackedLight2D>& getLights() const { return lights; }
+
+    // Cull to [viewMin, viewMax] and accumulate visible lights into the light map.
+    // Restores the framebuffer, viewport, blend and depth state it changes.
+    void render(const glm::mat4& viewProjection, const glm::vec2& viewMin, const glm::vec2& viewMax,
+                int viewportWidth, int viewportHeight);
+
+    // The same work in pieces, for a render graph pass that owns the target:
+    // cull, then draw additively into the bound framebuffer (cleared to the
+    // ambient color by the caller), then point the sprite shaders at it
+    void cullLights(const glm::vec2& viewMin, const glm::vec2& viewMax);
+    void drawLights(const glm::mat4& viewProjection);
+    void useLightMap(GLuint texture, int viewportWidth, int viewportHeight) {
+        externalLightMap = texture;
+        inverseViewport = glm::vec2(1.0f / viewportWidth, 1.0f / viewportHeight);
+    }
+
+    // Upload every light (not culled) to a std140 uniform block for custom shaders:
+    //   layout(std140) uniform LightBlock2D { ivec4 lightCount; Light2D lights[MAX_BLOCK_LIGHTS]; };
+    // with struct Light2D { vec4 positionRadius; vec4 colorIntensity; }
+    void bindLightBlock(GLuint program);
+
+    static const int MAX_BLOCK_LIGHTS = 256;
+    static const GLuint LIGHT_BLOCK_BINDING = 1;
+
+    GLuint getLightMapTexture() const { return externalLightMap ? externalLightMap : lightMapTexture; }
+    int getVisibleLightCount() const { return visibleLightCount; }
+    float getInverseViewportWidth() const { return inverseViewport.x; }
+    float getInverseViewportHeight() const { return inverseViewport.y; }
+
+private:
+    bool initialized = false;
+    bool lightingEnabled = false;
+    glm::vec3 ambient = glm::vec3(0.2f);
+    float resolutionScale = 0.5f;
+
+    std::vector<PackedLight2D> lights;
+    std::vector<PackedLight2D> visibleLights;
+    int visibleLightCount = 0;
+
+    GLuint framebuffer = 0, lightMapTexture = 0;
+    GLuint externalLightMap = 0;    // set by useLightMap, cleared by render
+    int lightMapWidth = 0, lightMapHeight = 0;
+    glm::vec2 inverseViewport = glm::vec2(0.0f);
+
+    GLuint VAO = 0, instanceVBO = 0, shaderProgram = 0;
+    GLint viewProjectionLocation = -1;
+    size_t instanceCapacity = 0;
+
+    GLuint lightBlockBuffer = 0;
+
+    LightRenderer2D() = default;
+    void resizeLightMap(int width, int height);
+};
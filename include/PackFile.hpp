@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Asset pack (.pak), written by tools/pack_builder and read through
+ * VirtualFileSystem.
+ *
+ * Layout, little-endian, every section and file 16-byte aligned:
+ *   PackFileHeader
+ *   PackFileEntry[entryCount]         sorted by path hash, for binary search
+ *   char[]                            paths, not terminated
+ *   file data                         in path order, so the files of one
+ *                                     directory are one contiguous region
+ *
+ * Paths are stored normalized and relative ("assets/textures/a.png"). A file
+ * is stored as is, or as one LZ4 block when that makes it at least 1/8
+ * smaller. Stored files are served straight from the mapping.
+ */
+
+struct PackFileHeader {
+    char magic[4];              // "PACK"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t entryOffset, nameOffset, dataOffset;
+    uint64_t fileSize;
+};
+
+enum PackCompression : uint32_t {
+    PACK_STORED = 0,
+    PACK_LZ4 = 1            // LZ4 block format, no frame
+};
+
+struct PackFileEntry {
+    uint64_t pathHash;
+    uint64_t offset;            // from the start of the pack
+    uint64_t storedSize;        // bytes in the pack
+    uint64_t size;              // bytes once decompressed
+    uint32_t nameOffset, nameLength;   // into the path section
+    uint32_t compression;       // PackCompression
+    uint32_t reserved;
+};
+
+static const uint32_t PACK_FILE_VERSION = 1;
+
+// 64-bit FNV-1a of a normalized path
+inline uint64_t hashPackPath(const char* path, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(path[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Path as stored in a pack: "./assets/../assets/a.png" is "assets/a.png"
+std::string normalizePackPath(const std::string& path);
+
+// LZ4 block compression (greedy, single pass); compressed is replaced
+void lz4Compress(const unsigned char* source, size_t size, std::vector<unsigned char>& compressed);
+
+// Decode until destinationSize bytes are written. False if source is
+// malformed or ends first. Stopping early is allowed, to read a file's start.
+bool lz4Decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize);
+
+struct PackWriteStats {
+    size_t fileCount = 0, compressedCount = 0;
+    uint64_t bytes = 0;         // of the files
+    uint64_t storedBytes = 0;   // of the files in the pack
+};
+
+// Read files (paths as they will be looked up) and write them to path.
+// compress allows LZ4 per file.
+bool writePackFile(const std::string& path, const std::vector<std::string>& files, bool compress,
+                   PackWriteStats* stats = nullptr);
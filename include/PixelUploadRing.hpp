@@ -0,0 +1,114 @@
+#pragma once
+#include "glad/glad.h"
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+
+/*
+ * Texture uploads through a ring of pixel unpack buffers (PBOs).
+ *
+ * Rows are copied into a mapped PBO and glTexSubImage* reads them from there,
+ * so the driver returns right away and the transfer runs asynchronously.
+ * Every slot is fenced and reused only once the GPU is done reading it.
+ *
+ * upload() sends a region through the ring right away (for the blocking
+ * loaders). stream() queues it. process() then sends queued rows once per
+ * frame within a byte budget, so a large texture is spread over several
+ * frames instead of stalling one.
+ *
+ * GL thread only. The target must already have storage (glTexImage* with null
+ * data) and the pixels must be tightly packed rows. Block compressed regions
+ * move in rows of 4x4 blocks; they must start on a block boundary and reach
+ * the level's edge, as glCompressedTexSubImage* requires.
+ */
+struct PixelRegion {
+    GLenum target = GL_TEXTURE_2D;   // GL_TEXTURE_2D, a cube map face or GL_TEXTURE_2D_ARRAY
+    GLuint texture = 0;
+    GLint level = 0;
+    GLint x = 0, y = 0, layer = 0;   // layer: GL_TEXTURE_2D_ARRAY only
+    GLsizei width = 0, height = 0;
+    GLenum format = GL_RGBA;         // GL_RED, GL_RG, GL_RGB or GL_RGBA; GL_UNSIGNED_BYTE data
+    GLenum compressedFormat = 0;     // if set, pixels are 4x4 blocks of this format (format is ignored)
+    size_t blockBytes = 0;           // bytes per block when compressed
+};
+
+struct PixelUploadStats {
+    size_t bytesLastFrame = 0;     // streamed by the last process()
+    size_t bytesTotal = 0;         // through the ring, both paths
+    size_t stalls = 0;             // upload() waited for the GPU to free a slot
+};
+
+class PixelUploadRing {
+public:
+    static PixelUploadRing& getInstance();
+
+    // Blocking: every row is submitted before this returns
+    void upload(const PixelRegion& region, const unsigned char* pixels);
+
+    // Queue a region; pixels must stay valid until done() runs (on the GL
+    // thread, from process(), after the last rows are submitted). begin, if
+    // set, runs right before the first rows go out, so allocating the
+    // region's storage there is spread over frames as well.
+    void stream(const PixelRegion& region, const unsigned char* pixels, std::function<void()> done,
+                std::function<void()> begin = nullptr);
+
+    // Once per frame: submit queued rows until the budget is spent or every
+    // slot is busy. At least one band goes out if a slot is free, so a
+    // budget smaller than a row cannot stall the queue.
+    void process();
+
+    void setFrameBudget(size_t bytes) { frameBudget = bytes; }
+    size_t getFrameBudget() const { return frameBudget; }
+    size_t getPendingCount() const { return jobs.size(); }
+    const PixelUploadStats& getStats() const { return stats; }
+
+    // Drop the queued regions of a texture about to be deleted (done() is not
+    // called), so their rows can't land in a texture that reuses the name
+    void cancel(GLuint texture);
+
+    // Delete the buffers (queued regions are dropped, done() is not called)
+    void shutdown();
+
+    PixelUploadRing(const PixelUploadRing&) = delete;
+    PixelUploadRing& operator=(const PixelUploadRing&) = delete;
+
+    static const size_t SLOT_BYTES = 4 * 1024 * 1024;
+    static const int SLOT_COUNT = 4;
+    static const size_t DEFAULT_FRAME_BUDGET = 8 * 1024 * 1024;
+
+private:
+    struct Slot {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+    };
+
+    struct Job {
+        PixelRegion region;
+        const unsigned char* pixels;
+        GLsizei nextRow = 0;
+        std::function<void()> begin;
+        std::function<void()> done;
+    };
+
+    std::vector<Slot> slots;
+    int nextSlot = 0;
+    std::deque<Job> jobs;
+    size_t frameBudget = DEFAULT_FRAME_BUDGET;
+    PixelUploadStats stats;
+
+    PixelUploadRing() = default;
+
+    void createSlots();
+    // Next slot the GPU is done with, or -1; wait blocks on the oldest fence instead
+    int acquireSlot(bool wait);
+    // Copy rows [firstRow, firstRow + rows) into slot and submit them
+    void submitRows(int slot, const PixelRegion& region, const unsigned char* pixels, GLsizei firstRow, GLsizei rows);
+};
+
+// Bytes per pixel for GL_UNSIGNED_BYTE data in format
+size_t pixelFormatBytes(GLenum format);
+
+// Bytes in one row of region's data (a row of blocks if compressed), and the row count
+size_t regionRowBytes(const PixelRegion& region);
+GLsizei regionRows(const PixelRegion& region);
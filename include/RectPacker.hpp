@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/*
+ * MaxRects rectangle packer (best short side fit) over any number of pages.
+ *
+ * Each page keeps the maximal free rectangles left after every placement.
+ * A rect goes on the first page with room and a new page is opened when
+ * none has any, so packing only fails for rects larger than a page.
+ * With rotation allowed a rect may be placed turned a quarter turn.
+ */
+
+struct PackedRect {
+    int x = 0, y = 0;
+    int width = 0, height = 0;  // as placed (swapped when rotated)
+    int page = -1;              // -1 when the rect is larger than a page
+    bool rotated = false;
+
+    bool isPacked() const { return page >= 0; }
+};
+
+class RectPacker {
+public:
+    RectPacker(int pageWidth, int pageHeight, bool allowRotation = false);
+
+    // Place one rect, in the order given
+    PackedRect insert(int width, int height);
+
+    // Stop opening pages after maxPages (0 = no limit); insert() then fails when full
+    void setPageLimit(int maxPages) { pageLimit = maxPages; }
+
+    // Place a set of rects, larger first for tighter packing. Results follow
+    // the input order.
+    std::vector<PackedRect> pack(const std::vector<int>& widths, const std::vector<int>& heights);
+
+    int getPageCount() const { return static_cast<int>(pages.size()); }
+    int getPageWidth() const { return pageWidth; }
+    int getPageHeight() const { return pageHeight; }
+
+    // Used area over the area of all open pages (or one page), 0..1
+    double getOccupancy() const;
+    double getPageOccupancy(int page) const;
+
+    // Give a placed rect's area back to its page (for atlases that evict).
+    // Freed space is not merged with its neighbours; see getFragmentation().
+    void release(const PackedRect& rect);
+
+    // 1 - largest free rect / free area over all pages: 0 when the free space
+    // is one block, near 1 when it is scattered in small pieces
+    double getFragmentation() const;
+
+    void reset() { pages.clear(); }
+
+private:
+    struct Rect {
+        int x, y, width, height;
+    };
+
+    struct Page {
+        std::vector<Rect> freeRects;
+        long long usedArea = 0;
+    };
+
+    int pageWidth, pageHeight;
+    bool allowRotation;
+    int pageLimit = 0;
+    std::vector<Page> pages;
+
+    Page& openPage();
+    bool findPosition(const Page& page, int width, int height, PackedRect& result) const;
+    void place(Page& page, const Rect& used);
+    static bool splitFreeRect(const Rect& freeRect, const Rect& used, std::vector<Rect>& out);
+    static void pruneFreeRects(std::vector<Rect>& freeRects, size_t firstNew);
+};
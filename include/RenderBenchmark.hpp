@@ -2,7 +2,18 @@
 #include "ECS/ECS.hpp"
 #include "ECS/systems/OptimizedRenderSystem2D.hpp"
 #include "TextureAtlas.hpp"
+#include "RectPacker.hpp"
+#include "HeadlessContext.hpp"
+#include "SpriteBatcher.hpp"
+#include "GLStateCache.hpp"
+#include "GLUploadQueue.hpp"
+#include "PixelUploadRing.hpp"
+#include "GlobalResources.hpp"
+#include "ResourceManager.hpp"
+#include "ShaderCache.hpp"
+#include "util/Render.hpp"
 #include <chrono>
+#include <cmath>
 #include <vector>
 #include <random>
 #include <iostream>
@@ -24,6 +35,13 @@ struct BenchmarkConfig {
     // Camera movement for culling test
     bool movingCamera = true;
     float cameraSpeed = 5.0f;
+    
+    // Deterministic runs (headless / CI)
+    int fixedFrameCount = 0;          // > 0: run exactly this many frames instead of testDurationSeconds
+    float fixedTimeStep = 0.0f;       // > 0: advance the camera by this much per frame instead of wall-clock time
+    unsigned int randomSeed = 0;      // 0: random sprite placement, otherwise reproducible
+    bool finishEachFrame = false;     // glFinish() every frame so frame time includes GPU work
+    std::string framebufferDumpPath;  // If set, the last frame is written here as a PPM
 };
 
 struct BenchmarkResults {
@@ -35,6 +53,24 @@ struct BenchmarkResults {
     double minFrameTime = std::numeric_limits<double>::max();
     double maxFrameTime = 0.0;
     
+    // CPU time spent inside the render system only (no swap, no VSync)
+    double averageCpuTime = 0.0;
+    double minCpuTime = std::numeric_limits<double>::max();
+    double maxCpuTime = 0.0;
+    
+    // Per-stage timings reported by the batcher (ms)
+    double averageCommandBuildTime = 0.0;
+    double averageSortTime = 0.0;
+    double averageVertexGenTime = 0.0;
+    double averageUploadTime = 0.0;
+    double averageSubmitTime = 0.0;
+    double averageGpuTime = 0.0;         // -1 if timer queries are unavailable
+    double averageBytesUploaded = 0.0;
+    
+    // GL state calls per frame, as counted by GLStateCache
+    double averageStateCallsIssued = 0.0;
+    double averageStateCallsSkipped = 0.0;
+    
     int totalFrames = 0;
     int averageDrawCalls = 0;
     int averageSpritesRendered = 0;
@@ -67,6 +103,18 @@ struct BenchmarkResults {
         std::cout << "  Average Frame Time: " << averageFrameTime << "ms" << std::endl;
         std::cout << "  Min Frame Time: " << minFrameTime << "ms" << std::endl;
         std::cout << "  Max Frame Time: " << maxFrameTime << "ms" << std::endl;
+        std::cout << "  Average CPU Time: " << averageCpuTime << "ms" << std::endl;
+        std::cout << "  Min CPU Time: " << minCpuTime << "ms" << std::endl;
+        std::cout << "  Max CPU Time: " << maxCpuTime << "ms" << std::endl;
+        std::cout << "  Command Build: " << averageCommandBuildTime << "ms" << std::endl;
+        std::cout << "  Sort: " << averageSortTime << "ms" << std::endl;
+        std::cout << "  Vertex Generation: " << averageVertexGenTime << "ms" << std::endl;
+        std::cout << "  Upload: " << averageUploadTime << "ms" << std::endl;
+        std::cout << "  Submission: " << averageSubmitTime << "ms" << std::endl;
+        std::cout << "  GPU Time: " << averageGpuTime << "ms" << std::endl;
+        std::cout << "  Bytes Uploaded/Frame: " << averageBytesUploaded << std::endl;
+        std::cout << "  GL State Calls/Frame: " << averageStateCallsIssued
+                  << " issued, " << averageStateCallsSkipped << " skipped" << std::endl;
         std::cout << "\nRendering:" << std::endl;
         std::cout << "  Average Draw Calls: " << averageDrawCalls << std::endl;
         std::cout << "  Average Sprites Rendered: " << averageSpritesRendered << std::endl;
@@ -76,6 +124,74 @@ struct BenchmarkResults {
     }
 };
 
+// Upload cost of one sprite vertex layout
+struct VertexFormatResults {
+    std::string name;
+    size_t vertexSize = 0;
+    int sprites = 0;
+    int frames = 0;
+    double averageVertexGenTime = 0.0;   // ms
+    double averageUploadTime = 0.0;      // ms
+    double averageGpuTime = 0.0;         // ms, -1 if unavailable
+    double bytesPerFrame = 0.0;
+    double uploadBandwidthMBps = 0.0;
+    
+    void print() const {
+        std::cout << "  " << name << " (" << vertexSize << " bytes/vertex):" << std::endl;
+        std::cout << "    Bytes/Frame: " << bytesPerFrame << std::endl;
+        std::cout << "    Vertex Generation: " << averageVertexGenTime << "ms" << std::endl;
+        std::cout << "    Upload: " << averageUploadTime << "ms (" << uploadBandwidthMBps << " MB/s)" << std::endl;
+        std::cout << "    GPU Time: " << averageGpuTime << "ms" << std::endl;
+    }
+};
+
+// Throughput of the quad expansion kernel for one layout and instruction set.
+// Only the corner positions are computed with SIMD; encoding the corner
+// vertices (SpriteQuadStream::push) and copying them out stay scalar, so the
+// scalar encode rate is reported alongside.
+struct VertexKernelResults {
+    std::string layout;
+    std::string path;
+    int sprites = 0;
+    int iterations = 0;
+    double spritesPerSecond = 0.0;        // expandSpriteQuads
+    double encodeSpritesPerSecond = 0.0;  // push(), scalar on every path
+};
+
+// Time and occupancy of packing one sprite set into atlas pages
+struct AtlasPackingResults {
+    bool rotation = false;
+    int sprites = 0;
+    int pageSize = 0;
+    double packTime = 0.0;       // ms
+    int pages = 0;
+    double occupancy = 0.0;      // all pages, 0..1
+    double fullPageOccupancy = 0.0;   // all pages but the last, 0..1
+};
+
+// Size of one chunk's mesh as meshing first did it (every face of every tile),
+// with hidden faces culled, and with exposed faces merged as well
+struct ChunkMeshingResults {
+    std::string terrain;
+    std::string surroundings;
+    size_t trianglesAllFaces = 0;
+    size_t trianglesCulled = 0;
+    size_t trianglesMerged = 0;
+    size_t verticesAllFaces = 0;
+    size_t verticesCulled = 0;
+    size_t verticesMerged = 0;
+    double meshTime = 0.0;   // ms per chunk, culled and merged
+};
+
+// Startup resource loading, blocking vs. through the thread pool
+struct AssetLoadingResults {
+    std::string mode;
+    int runs = 0;
+    double firstFrameTime = 0.0;   // ms until the game loop could start
+    double totalTime = 0.0;        // ms until every resource is uploaded
+    double worstFrameTime = 0.0;   // ms, longest frame spent uploading (blocking: all of it)
+};
+
 class RenderBenchmark {
 public:
     RenderBenchmark() : generator(std::random_device{}()) {}
@@ -101,18 +217,22 @@ public:
     }
     
     void runComparisonBenchmark(ECS& ecs, OptimizedRenderSystem2D& renderSystem) {
-        std::cout << "Running comparison benchmark..." << std::endl;
-        
         BenchmarkConfig config;
         config.numSprites = 1000;
         config.testDurationSeconds = 5.0f;
+        runComparisonBenchmark(ecs, renderSystem, config);
+    }
+    
+    // Same four-way comparison, inheriting everything else (headless settings, seed...) from baseConfig
+    void runComparisonBenchmark(ECS& ecs, OptimizedRenderSystem2D& renderSystem, const BenchmarkConfig& baseConfig) {
+        std::cout << "Running comparison benchmark..." << std::endl;
         
         // Test configurations
         std::vector<std::pair<std::string, BenchmarkConfig>> tests = {
-            {"No Batching, No Culling", {config.numSprites, 1024, false, false, config.testDurationSeconds}},
-            {"Batching Only", {config.numSprites, 1024, true, false, config.testDurationSeconds}},
-            {"Culling Only", {config.numSprites, 1024, false, true, config.testDurationSeconds}},
-            {"Batching + Culling", {config.numSprites, 1024, true, true, config.testDurationSeconds}},
+            {"No Batching, No Culling", withFeatures(baseConfig, false, false, 0)},
+            {"Batching Only", withFeatures(baseConfig, true, false, 1)},
+            {"Culling Only", withFeatures(baseConfig, false, true, 2)},
+            {"Batching + Culling", withFeatures(baseConfig, true, true, 3)},
         };
         
         std::vector<BenchmarkResults> results;
@@ -129,17 +249,22 @@ public:
     }
     
     void runScalabilityTest(ECS& ecs, OptimizedRenderSystem2D& renderSystem) {
+        BenchmarkConfig config;
+        config.testDurationSeconds = 3.0f;
+        runScalabilityTest(ecs, renderSystem, config);
+    }
+    
+    // Sprite counts are swept; everything else comes from baseConfig
+    void runScalabilityTest(ECS& ecs, OptimizedRenderSystem2D& renderSystem, const BenchmarkConfig& baseConfig) {
         std::cout << "Running scalability test..." << std::endl;
         
         std::vector<int> spriteCounts = {100, 250, 500, 750, 1000, 1500, 2000, 3000, 5000};
         std::vector<BenchmarkResults> results;
         
-        for (int spriteCount : spriteCounts) {
-            BenchmarkConfig config;
+        for (size_t i = 0; i < spriteCounts.size(); ++i) {
+            int spriteCount = spriteCounts[i];
+            BenchmarkConfig config = withFeatures(baseConfig, true, true, static_cast<int>(i));
             config.numSprites = spriteCount;
-            config.testDurationSeconds = 3.0f;
-            config.enableBatching = true;
-            config.enableCulling = true;
             
             std::cout << "\nTesting with " << spriteCount << " sprites..." << std::endl;
             BenchmarkResults result = runBenchmark(ecs, renderSystem, config);
@@ -157,12 +282,290 @@ public:
         saveScalabilityResults(results, spriteCounts);
     }
 
+    // Drive a standalone batcher per vertex layout with identical sprites and
+    // compare bytes uploaded and upload bandwidth
+    void runVertexFormatBenchmark(int numSprites = 5000, int frames = 200) {
+        std::cout << "Running vertex format benchmark..." << std::endl;
+        
+        std::vector<VertexFormatResults> results;
+        results.push_back(measureVertexFormat<SpriteVertex>("SpriteVertex", numSprites, frames));
+        results.push_back(measureVertexFormat<PackedSpriteVertex>("PackedSpriteVertex", numSprites, frames));
+        
+        for (const auto& result : results) {
+            result.print();
+        }
+        
+        saveVertexFormatResults(results);
+    }
+
+    // CPU-only: sprites per second of the quad expansion kernel for every
+    // supported path (scalar, SSE, AVX2) and vertex layout. The paths differ
+    // only in the corner position adds; see VertexKernelResults
+    void runVertexKernelBenchmark(int numSprites = 10000, int iterations = 200) {
+        std::cout << "Running vertex kernel benchmark..." << std::endl;
+        
+        std::vector<VertexKernelResults> results;
+        measureVertexKernel<SpriteVertex>("SpriteVertex", numSprites, iterations, results);
+        measureVertexKernel<PackedSpriteVertex>("PackedSpriteVertex", numSprites, iterations, results);
+        
+        std::ofstream file("vertex_kernel_benchmark.csv");
+        file << "Layout,Path,Sprites,Iterations,SpritesPerSecond,EncodeSpritesPerSecond\n";
+        for (const auto& result : results) {
+            std::cout << "  " << result.layout << " / " << result.path << ": "
+                      << result.spritesPerSecond / 1.0e6 << " M sprites/s expanded, "
+                      << result.encodeSpritesPerSecond / 1.0e6 << " M sprites/s encoded (scalar)" << std::endl;
+            file << result.layout << "," << result.path << "," << result.sprites << ","
+                 << result.iterations << "," << result.spritesPerSecond << ","
+                 << result.encodeSpritesPerSecond << "\n";
+        }
+        file.close();
+        std::cout << "Vertex kernel results saved to vertex_kernel_benchmark.csv" << std::endl;
+    }
+
+    // CPU-only: pack numSprites random sprite sizes (padding included) into
+    // pageSize pages with and without rotation
+    void runAtlasPackingBenchmark(int numSprites = 10000, int pageSize = 2048) {
+        std::cout << "Running atlas packing benchmark..." << std::endl;
+        
+        std::mt19937 packingGenerator(4321);
+        std::uniform_int_distribution<int> sideDist(8, 96);
+        std::vector<int> widths(numSprites), heights(numSprites);
+        for (int i = 0; i < numSprites; ++i) {
+            widths[i] = sideDist(packingGenerator) + 2;
+            heights[i] = sideDist(packingGenerator) + 2;
+        }
+        
+        std::ofstream file("atlas_packing_benchmark.csv");
+        file << "Rotation,Sprites,PageSize,PackTime(ms),Pages,Occupancy,FullPageOccupancy\n";
+        for (bool rotation : { false, true }) {
+            RectPacker packer(pageSize, pageSize, rotation);
+            auto start = std::chrono::high_resolution_clock::now();
+            std::vector<PackedRect> placements = packer.pack(widths, heights);
+            auto end = std::chrono::high_resolution_clock::now();
+            
+            AtlasPackingResults result;
+            result.rotation = rotation;
+            result.sprites = numSprites;
+            result.pageSize = pageSize;
+            result.packTime = std::chrono::duration<double, std::milli>(end - start).count();
+            result.pages = packer.getPageCount();
+            result.occupancy = packer.getOccupancy();
+            double fullPages = 0.0;
+            for (int page = 0; page + 1 < result.pages; ++page) {
+                fullPages += packer.getPageOccupancy(page);
+            }
+            result.fullPageOccupancy = result.pages > 1 ? fullPages / (result.pages - 1) : result.occupancy;
+            
+            std::cout << "  " << (rotation ? "With rotation" : "Upright") << ": " << result.packTime << "ms, "
+                      << result.pages << " pages, occupancy " << result.occupancy * 100.0 << "% ("
+                      << result.fullPageOccupancy * 100.0 << "% excluding the last page)" << std::endl;
+            file << (rotation ? 1 : 0) << "," << result.sprites << "," << result.pageSize << ","
+                 << result.packTime << "," << result.pages << "," << result.occupancy << ","
+                 << result.fullPageOccupancy << "\n";
+        }
+        file.close();
+        std::cout << "Atlas packing results saved to atlas_packing_benchmark.csv" << std::endl;
+    }
+
+    // CPU-only: mesh one 16x16x40 chunk of each terrain kind, alone and with
+    // loaded chunks on all sides
+    void runChunkMeshingBenchmark(int iterations = 20) {
+        std::cout << "Running chunk meshing benchmark..." << std::endl;
+
+        // No water in the map, so no beaches
+        std::vector<std::vector<ChunkData>> map(8, std::vector<ChunkData>(8));
+        for (auto& row : map) for (auto& cell : row) cell.finalElevation = 1.0f;
+        const size_t vertexSize = 6 * sizeof(GLfloat);
+
+        std::ofstream file("chunk_meshing_benchmark.csv");
+        file << "Terrain,Surroundings,TrianglesAllFaces,TrianglesCulled,TrianglesMerged,"
+             << "VertexBytesAllFaces,VertexBytesCulled,VertexBytesMerged,MeshTime(ms)\n";
+        for (std::string terrain : { "Water", "Land", "Hilly", "Solid" }) {
+            ChunkComponent chunk(glm::ivec3(0), 16, 16, 40, 1.0f, terrain == "Water" ? 0 : 1);
+            chunk.palette = chunk.elevation == 0 ? std::vector<TileType>{TileType::WATER}
+                                                 : std::vector<TileType>{TileType::SAND, TileType::DIRT};
+            std::vector<GLfloat> vertices;
+            std::vector<GLint> indices;
+            generateChunkGeometry(chunk, map, vertices, indices);
+            for (int layer = 0; layer < chunk.depth; ++layer) {
+                for (int r = 0; r < chunk.columns; ++r) {
+                    for (int q = 0; q < chunk.rows; ++q) {
+                        int height = 1 + static_cast<int>(fractalNoise(q * 0.15f, r * 0.15f, 5, 0.5f, 2.0f) * (chunk.depth - 1));
+                        if (terrain == "Hilly") chunk.occupancy[chunk.indexFrom3D(q, r, layer)] = layer < height;
+                        if (terrain == "Solid") chunk.occupancy[chunk.indexFrom3D(q, r, layer)] = 1;
+                    }
+                }
+            }
+            size_t solidTiles = std::count(chunk.occupancy.begin(), chunk.occupancy.end(), 1);
+
+            // The same chunk stands in for each of its neighbours in the same layer
+            ChunkNeighbours surrounded;
+            for (int dx = 0; dx < 3; ++dx) for (int dz = 0; dz < 3; ++dz) surrounded.chunks[dx][dz][1] = &chunk;
+            for (bool enclosed : { false, true }) {
+                ChunkNeighbours neighbours = enclosed ? surrounded : ChunkNeighbours();
+                ChunkMeshingResults result;
+                result.terrain = terrain;
+                result.surroundings = enclosed ? "Surrounded" : "Alone";
+
+                // Before culling: a 7 vertex fan on the top and bottom and 12 side vertices per tile
+                result.trianglesAllFaces = solidTiles * 24;
+                result.verticesAllFaces = solidTiles * 26;
+
+                vertices.clear();
+                indices.clear();
+                emitChunkFaces(chunk, neighbours, vertices, indices, false);
+                result.trianglesCulled = indices.size() / 3;
+                result.verticesCulled = vertices.size() / 6;
+
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int i = 0; i < iterations; ++i) {
+                    vertices.clear();
+                    indices.clear();
+                    emitChunkFaces(chunk, neighbours, vertices, indices);
+                }
+                auto end = std::chrono::high_resolution_clock::now();
+                result.trianglesMerged = indices.size() / 3;
+                result.verticesMerged = vertices.size() / 6;
+                result.meshTime = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+                std::cout << "  " << result.terrain << " (" << result.surroundings << "): triangles "
+                          << result.trianglesAllFaces << " / " << result.trianglesCulled << " / " << result.trianglesMerged
+                          << ", vertices " << result.verticesAllFaces << " / " << result.verticesCulled << " / "
+                          << result.verticesMerged << " (all faces / culled / merged), "
+                          << result.verticesMerged * vertexSize / 1024 << " KB, " << result.meshTime << "ms" << std::endl;
+                file << result.terrain << "," << result.surroundings << "," << result.trianglesAllFaces << ","
+                     << result.trianglesCulled << "," << result.trianglesMerged << ","
+                     << result.verticesAllFaces * vertexSize << "," << result.verticesCulled * vertexSize << ","
+                     << result.verticesMerged * vertexSize << "," << result.meshTime << "\n";
+            }
+        }
+        file.close();
+        std::cout << "Chunk meshing results saved to chunk_meshing_benchmark.csv" << std::endl;
+    }
+
+    // Needs a GL context and the game's shaders/ and assets/ in the working
+    // directory. Loads the startup set (see GlobalResources.cpp) runs times
+    // each way, alternating so both see the same file cache.
+    void runAssetLoadingBenchmark(int runs = 3) {
+        std::cout << "Running asset loading benchmark..." << std::endl;
+        
+        AssetLoadingResults blocking, async;
+        blocking.mode = "Blocking";
+        async.mode = "Async";
+        
+        // Dropping the programs too makes every run start like a new launch
+        // (binaries on disk, nothing linked yet). Nothing else holds one here.
+        auto clearResources = []() {
+            ResourceManager<Shader>::getInstance().clear();
+            ResourceManager<Texture>::getInstance().clear();
+            ResourceManager<Font>::getInstance().clear();
+            ShaderCache::getInstance().shutdown();
+        };
+        auto elapsed = [](std::chrono::high_resolution_clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        };
+        
+        // Warm the file cache so the first run isn't the only cold one
+        loadGlobalResources();
+        clearResources();
+        
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+            loadGlobalResources();
+            glFinish();
+            double time = elapsed(start);
+            blocking.firstFrameTime += time;
+            blocking.totalTime += time;
+            blocking.worstFrameTime = std::max(blocking.worstFrameTime, time);
+            clearResources();
+            
+            start = std::chrono::high_resolution_clock::now();
+            loadGlobalResourcesAsync();
+            async.firstFrameTime += elapsed(start);
+            
+            // What the game loop does per frame; glFinish charges the GPU side of the uploads to the frame
+            while (ResourceManager<Texture>::getInstance().getPendingCount() + ResourceManager<Font>::getInstance().getPendingCount() > 0) {
+                if (GLUploadQueue::getInstance().getPendingCount() == 0 && PixelUploadRing::getInstance().getPendingCount() == 0) {
+                    GLUploadQueue::getInstance().waitForWork(1);
+                }
+                auto frameStart = std::chrono::high_resolution_clock::now();
+                GLUploadQueue::getInstance().process(2.0);
+                PixelUploadRing::getInstance().process();
+                glFinish();
+                async.worstFrameTime = std::max(async.worstFrameTime, elapsed(frameStart));
+            }
+            async.totalTime += elapsed(start);
+            clearResources();
+        }
+        
+        // The shaders alone: compiled from source vs loaded from the binary cache
+        AssetLoadingResults compiledShaders, cachedShaders;
+        compiledShaders.mode = "Shaders compiled";
+        cachedShaders.mode = "Shaders cached";
+        auto& shaderCache = ShaderCache::getInstance();
+        std::string cacheDirectory = shaderCache.getCacheDirectory();
+        for (int run = 0; run < runs; ++run) {
+            for (AssetLoadingResults* result : { &compiledShaders, &cachedShaders }) {
+                shaderCache.setCacheDirectory(result == &cachedShaders ? cacheDirectory : "");
+                auto start = std::chrono::high_resolution_clock::now();
+                loadGlobalShaders();
+                glFinish();
+                double time = elapsed(start);
+                result->firstFrameTime += time;
+                result->totalTime += time;
+                result->worstFrameTime = std::max(result->worstFrameTime, time);
+                clearResources();
+            }
+        }
+        shaderCache.setCacheDirectory(cacheDirectory);
+        if (!shaderCache.isBinaryCacheSupported()) {
+            std::cout << "  (no program binary formats: shaders are recompiled every run)" << std::endl;
+        }
+        
+        std::ofstream file("asset_loading_benchmark.csv");
+        file << "Mode,Runs,FirstFrameTime(ms),TotalTime(ms),WorstFrameTime(ms)\n";
+        for (AssetLoadingResults* result : { &blocking, &async, &compiledShaders, &cachedShaders }) {
+            result->runs = runs;
+            result->firstFrameTime /= runs;
+            result->totalTime /= runs;
+            std::cout << "  " << result->mode << ": first frame after " << result->firstFrameTime
+                      << "ms, everything loaded after " << result->totalTime << "ms, worst frame "
+                      << result->worstFrameTime << "ms" << std::endl;
+            file << result->mode << "," << result->runs << "," << result->firstFrameTime << ","
+                 << result->totalTime << "," << result->worstFrameTime << "\n";
+        }
+        file.close();
+        std::cout << "Asset loading results saved to asset_loading_benchmark.csv" << std::endl;
+    }
+
 private:
     std::vector<size_t> benchmarkEntities;
     std::mt19937 generator;
     size_t cameraEntity;
     
+    static BenchmarkConfig withFeatures(const BenchmarkConfig& base, bool batching, bool culling, int runIndex) {
+        BenchmarkConfig config = base;
+        config.enableBatching = batching;
+        config.enableCulling = culling;
+        
+        // One dump per run: "frame.ppm" -> "frame_2.ppm"
+        if (!config.framebufferDumpPath.empty()) {
+            size_t dot = config.framebufferDumpPath.find_last_of('.');
+            std::string suffix = "_" + std::to_string(runIndex);
+            if (dot == std::string::npos) {
+                config.framebufferDumpPath += suffix;
+            } else {
+                config.framebufferDumpPath.insert(dot, suffix);
+            }
+        }
+        return config;
+    }
+    
     void setupBenchmark(ECS& ecs, OptimizedRenderSystem2D& renderSystem, const BenchmarkConfig& config) {
+        if (config.randomSeed != 0) {
+            generator.seed(config.randomSeed);
+        }
+        
         // Create camera entity
         cameraEntity = ecs.createEntity();
         ecs.addComponent(cameraEntity, CameraComponent2D(glm::vec2(0.0f), 0.0f, 1.0f));
@@ -215,25 +618,42 @@ private:
         double totalSpritesRendered = 0;
         double totalSpritesCulled = 0;
         double totalBatches = 0;
+        double totalCpuTime = 0;
+        double totalCommandBuildTime = 0;
+        double totalSortTime = 0;
+        double totalVertexGenTime = 0;
+        double totalUploadTime = 0;
+        double totalSubmitTime = 0;
+        double totalGpuTime = 0;
+        double totalBytesUploaded = 0;
+        double totalStateCallsIssued = 0;
+        double totalStateCallsSkipped = 0;
+        int gpuSamples = 0;
+        double elapsed = 0.0;
         
         float cameraX = 0.0f;
         float cameraY = 0.0f;
         
         while (true) {
             auto currentTime = std::chrono::high_resolution_clock::now();
-            auto elapsed = std::chrono::duration<double>(currentTime - startTime).count();
+            elapsed = std::chrono::duration<double>(currentTime - startTime).count();
             
-            if (elapsed >= config.testDurationSeconds) {
+            bool finished = config.fixedFrameCount > 0 ? frameCount >= config.fixedFrameCount
+                                                       : elapsed >= config.testDurationSeconds;
+            if (finished) {
                 break;
             }
             
             auto frameDelta = std::chrono::duration<double>(currentTime - lastFrameTime).count();
             lastFrameTime = currentTime;
             
+            // Fixed steps keep camera motion (and therefore culling) identical between runs
+            double simulationDelta = config.fixedTimeStep > 0.0f ? config.fixedTimeStep : frameDelta;
+            
             // Update camera position for culling test
             if (config.movingCamera) {
-                cameraX += config.cameraSpeed * frameDelta;
-                cameraY += config.cameraSpeed * frameDelta * 0.5f;
+                cameraX += config.cameraSpeed * simulationDelta;
+                cameraY += config.cameraSpeed * simulationDelta * 0.5f;
                 
                 auto& camera = ecs.getComponent<CameraComponent2D>(cameraEntity);
                 camera.position = glm::vec2(cameraX, cameraY);
@@ -245,9 +665,17 @@ private:
             
             // Reset render stats
             SpriteRenderManager::getInstance().resetStats();
+            GLStateCache::getInstance().resetStats();
+            
+            // Run render system (CPU-side cost only: GL calls are queued, not waited on)
+            auto cpuStart = std::chrono::high_resolution_clock::now();
+            renderSystem.update(simulationDelta, ecs);
+            auto cpuEnd = std::chrono::high_resolution_clock::now();
+            double cpuTimeMs = std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count();
             
-            // Run render system
-            renderSystem.update(frameDelta, ecs);
+            if (config.finishEachFrame) {
+                glFinish();
+            }
             
             // Collect statistics
             const auto& stats = SpriteRenderManager::getInstance().getStats();
@@ -261,30 +689,181 @@ private:
             results.maxFPS = std::max(results.maxFPS, fps);
             results.minFrameTime = std::min(results.minFrameTime, frameTimeMs);
             results.maxFrameTime = std::max(results.maxFrameTime, frameTimeMs);
+            results.minCpuTime = std::min(results.minCpuTime, cpuTimeMs);
+            results.maxCpuTime = std::max(results.maxCpuTime, cpuTimeMs);
+            totalCpuTime += cpuTimeMs;
             
             totalDrawCalls += stats.drawCalls;
             totalSpritesRendered += stats.spritesRendered;
             totalSpritesCulled += stats.spritesCulled;
             totalBatches += stats.batchesCreated;
             
+            totalCommandBuildTime += stats.commandBuildTime;
+            totalSortTime += stats.sortTime;
+            totalVertexGenTime += stats.vertexGenTime;
+            totalUploadTime += stats.uploadTime;
+            totalSubmitTime += stats.submitTime;
+            totalBytesUploaded += stats.bytesUploaded;
+            totalStateCallsIssued += GLStateCache::getInstance().getStats().callsIssued;
+            totalStateCallsSkipped += GLStateCache::getInstance().getStats().callsSkipped;
+            if (stats.gpuTime >= 0.0f) {
+                totalGpuTime += stats.gpuTime;
+                gpuSamples++;
+            }
+            
             frameCount++;
         }
         
         // Calculate final results
         results.totalFrames = frameCount;
-        results.testDuration = config.testDurationSeconds;
+        results.testDuration = config.fixedFrameCount > 0 ? elapsed : config.testDurationSeconds;
         results.calculateAverages();
         
+        if (!config.framebufferDumpPath.empty()) {
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            saveFramebufferPPM(config.framebufferDumpPath, viewport[2], viewport[3]);
+        }
+        
         if (frameCount > 0) {
+            results.averageCpuTime = totalCpuTime / frameCount;
             results.averageDrawCalls = static_cast<int>(totalDrawCalls / frameCount);
             results.averageSpritesRendered = static_cast<int>(totalSpritesRendered / frameCount);
             results.averageSpritesCulled = static_cast<int>(totalSpritesCulled / frameCount);
             results.averageBatches = static_cast<int>(totalBatches / frameCount);
+            results.averageCommandBuildTime = totalCommandBuildTime / frameCount;
+            results.averageSortTime = totalSortTime / frameCount;
+            results.averageVertexGenTime = totalVertexGenTime / frameCount;
+            results.averageUploadTime = totalUploadTime / frameCount;
+            results.averageSubmitTime = totalSubmitTime / frameCount;
+            results.averageBytesUploaded = totalBytesUploaded / frameCount;
+            results.averageStateCallsIssued = totalStateCallsIssued / frameCount;
+            results.averageStateCallsSkipped = totalStateCallsSkipped / frameCount;
+            results.averageGpuTime = gpuSamples > 0 ? totalGpuTime / gpuSamples : -1.0;
         }
         
         return results;
     }
     
+    template <typename Vertex>
+    VertexFormatResults measureVertexFormat(const std::string& name, int numSprites, int frames) {
+        VertexFormatResults result;
+        result.name = name;
+        result.vertexSize = sizeof(Vertex);
+        result.sprites = numSprites;
+        result.frames = frames;
+        
+        BasicSpriteBatcher<Vertex> batcher(numSprites, 8);
+        batcher.init();
+        
+        // Same sprites for every layout
+        std::mt19937 layoutGenerator(1234);
+        std::uniform_real_distribution<float> posDist(-0.9f, 0.9f);
+        std::uniform_real_distribution<float> colorDist(0.5f, 1.0f);
+        
+        std::vector<SpriteAffine2D> transforms(numSprites);
+        std::vector<glm::vec4> colors(numSprites);
+        for (int i = 0; i < numSprites; ++i) {
+            glm::vec3 position(posDist(layoutGenerator), posDist(layoutGenerator), 0.0f);
+            transforms[i] = SpriteAffine2D::fromComponents(position, glm::vec2(0.02f), 0.0f, 1.0f);
+            colors[i] = glm::vec4(colorDist(layoutGenerator), colorDist(layoutGenerator), colorDist(layoutGenerator), 1.0f);
+        }
+        
+        double totalVertexGenTime = 0.0;
+        double totalUploadTime = 0.0;
+        double totalGpuTime = 0.0;
+        double totalBytes = 0.0;
+        int gpuSamples = 0;
+        
+        for (int frame = 0; frame < frames; ++frame) {
+            batcher.begin(glm::mat4(1.0f));
+            for (int i = 0; i < numSprites; ++i) {
+                batcher.addSprite(transforms[i], colors[i], 0);
+            }
+            batcher.end();
+            
+            const auto& stats = batcher.getStats();
+            totalVertexGenTime += stats.vertexGenTime;
+            totalUploadTime += stats.uploadTime;
+            totalBytes += stats.bytesUploaded;
+            if (stats.gpuTime >= 0.0f) {
+                totalGpuTime += stats.gpuTime;
+                gpuSamples++;
+            }
+        }
+        glFinish();
+        
+        if (frames > 0) {
+            result.averageVertexGenTime = totalVertexGenTime / frames;
+            result.averageUploadTime = totalUploadTime / frames;
+            result.bytesPerFrame = totalBytes / frames;
+            result.averageGpuTime = gpuSamples > 0 ? totalGpuTime / gpuSamples : -1.0;
+        }
+        if (totalUploadTime > 0.0) {
+            result.uploadBandwidthMBps = (totalBytes / (1024.0 * 1024.0)) / (totalUploadTime / 1000.0);
+        }
+        
+        return result;
+    }
+    
+    template <typename Vertex>
+    void measureVertexKernel(const std::string& layout, int numSprites, int iterations,
+                             std::vector<VertexKernelResults>& results) {
+        std::mt19937 kernelGenerator(1234);
+        std::uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> scaleDist(0.5f, 4.0f);
+        std::uniform_real_distribution<float> angleDist(0.0f, 6.2831853f);
+        
+        std::vector<SpriteAffine2D> transforms;
+        transforms.reserve(numSprites);
+        for (int i = 0; i < numSprites; ++i) {
+            float angle = angleDist(kernelGenerator);
+            transforms.push_back(SpriteAffine2D::fromComponents(
+                glm::vec3(posDist(kernelGenerator), posDist(kernelGenerator), 0.0f),
+                glm::vec2(scaleDist(kernelGenerator), scaleDist(kernelGenerator)),
+                std::sin(angle), std::cos(angle)));
+        }
+        
+        // Encoding the corner vertices is the scalar half of the work
+        SpriteQuadStream<Vertex> stream;
+        stream.reserve(numSprites);
+        auto encodeStart = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            stream.clear();
+            for (int i = 0; i < numSprites; ++i) {
+                stream.push(transforms[i], glm::vec2(0.0f), glm::vec2(1.0f), glm::vec4(1.0f), i % 8);
+            }
+        }
+        double encodeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - encodeStart).count();
+        double encodeRate = encodeSeconds > 0.0 ? (double(numSprites) * iterations) / encodeSeconds : 0.0;
+        
+        std::vector<Vertex> output(numSprites * 4);
+        const SpriteKernelPath paths[] = { SpriteKernelPath::Scalar, SpriteKernelPath::SSE, SpriteKernelPath::AVX2 };
+        
+        for (SpriteKernelPath path : paths) {
+            if (!isSpriteKernelPathSupported(path)) continue;
+            
+            // Warm caches before timing
+            expandSpriteQuads(stream, output.data(), path);
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                expandSpriteQuads(stream, output.data(), path);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            
+            VertexKernelResults result;
+            result.layout = layout;
+            result.path = spriteKernelPathName(path);
+            result.sprites = numSprites;
+            result.iterations = iterations;
+            result.spritesPerSecond = seconds > 0.0 ? (double(numSprites) * iterations) / seconds : 0.0;
+            result.encodeSpritesPerSecond = encodeRate;
+            results.push_back(result);
+        }
+    }
+    
     void cleanupBenchmark(ECS& ecs) {
         // Remove all benchmark entities
         for (size_t entity : benchmarkEntities) {
@@ -319,7 +898,7 @@ private:
     void saveComparisonResults(const std::vector<BenchmarkResults>& results, 
                               const std::vector<std::pair<std::string, BenchmarkConfig>>& tests) {
         std::ofstream file("comparison_benchmark.csv");
-        file << "Test,FPS,FrameTime(ms),DrawCalls,SpritesRendered,SpritesCulled,Batches\n";
+        file << "Test,FPS,FrameTime(ms),CpuTime(ms),DrawCalls,SpritesRendered,SpritesCulled,Batches,BuildTime(ms),SortTime(ms),VertexGenTime(ms),UploadTime(ms),SubmitTime(ms),GpuTime(ms),BytesUploaded,StateCallsIssued,StateCallsSkipped\n";
         
         for (size_t i = 0; i < results.size() && i < tests.size(); ++i) {
             const auto& result = results[i];
@@ -328,20 +907,50 @@ private:
             file << testName << "," 
                  << result.averageFPS << ","
                  << result.averageFrameTime << ","
+                 << result.averageCpuTime << ","
                  << result.averageDrawCalls << ","
                  << result.averageSpritesRendered << ","
                  << result.averageSpritesCulled << ","
-                 << result.averageBatches << "\n";
+                 << result.averageBatches << ","
+                 << result.averageCommandBuildTime << ","
+                 << result.averageSortTime << ","
+                 << result.averageVertexGenTime << ","
+                 << result.averageUploadTime << ","
+                 << result.averageSubmitTime << ","
+                 << result.averageGpuTime << ","
+                 << result.averageBytesUploaded << ","
+                 << result.averageStateCallsIssued << ","
+                 << result.averageStateCallsSkipped << "\n";
         }
         
         file.close();
         std::cout << "Comparison results saved to comparison_benchmark.csv" << std::endl;
     }
     
+    void saveVertexFormatResults(const std::vector<VertexFormatResults>& results) {
+        std::ofstream file("vertex_format_benchmark.csv");
+        file << "Layout,VertexSize,Sprites,Frames,BytesPerFrame,VertexGenTime(ms),UploadTime(ms),UploadMBps,GpuTime(ms)\n";
+        
+        for (const auto& result : results) {
+            file << result.name << ","
+                 << result.vertexSize << ","
+                 << result.sprites << ","
+                 << result.frames << ","
+                 << result.bytesPerFrame << ","
+                 << result.averageVertexGenTime << ","
+                 << result.averageUploadTime << ","
+                 << result.uploadBandwidthMBps << ","
+                 << result.averageGpuTime << "\n";
+        }
+        
+        file.close();
+        std::cout << "Vertex format results saved to vertex_format_benchmark.csv" << std::endl;
+    }
+    
     void saveScalabilityResults(const std::vector<BenchmarkResults>& results, 
                                const std::vector<int>& spriteCounts) {
         std::ofstream file("scalability_benchmark.csv");
-        file << "SpriteCount,FPS,FrameTime(ms),DrawCalls,SpritesRendered,SpritesCulled,Batches\n";
+        file << "SpriteCount,FPS,FrameTime(ms),CpuTime(ms),DrawCalls,SpritesRendered,SpritesCulled,Batches,BuildTime(ms),SortTime(ms),VertexGenTime(ms),UploadTime(ms),SubmitTime(ms),GpuTime(ms),BytesUploaded\n";
         
         for (size_t i = 0; i < results.size() && i < spriteCounts.size(); ++i) {
             const auto& result = results[i];
@@ -350,10 +959,18 @@ private:
             file << spriteCount << "," 
                  << result.averageFPS << ","
                  << result.averageFrameTime << ","
+                 << result.averageCpuTime << ","
                  << result.averageDrawCalls << ","
                  << result.averageSpritesRendered << ","
                  << result.averageSpritesCulled << ","
-                 << result.averageBatches << "\n";
+                 << result.averageBatches << ","
+                 << result.averageCommandBuildTime << ","
+                 << result.averageSortTime << ","
+                 << result.averageVertexGenTime << ","
+                 << result.averageUploadTime << ","
+                 << result.averageSubmitTime << ","
+                 << result.averageGpuTime << ","
+                 << result.averageBytesUploaded << "\n";
         }
         
         file.close();
@@ -0,0 +1,116 @@
+#pragma once
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Frame render graph.
+ *
+ * Passes declare the textures they read and write. The graph orders them
+ * once (writers before readers, declaration order otherwise), drops passes
+ * whose output nobody reads, and lets transient textures with the same
+ * format share storage when their lifetimes do not overlap.
+ *
+ * Each frame: beginFrame(), systems submit() draw work to passes while they
+ * update, then execute() binds each pass's framebuffer, clears it and runs
+ * the submitted work. Outside a frame (benchmarks, tools) isRecording() is
+ * false and systems draw immediately as before.
+ */
+
+using RenderResource = int;
+
+// Transient texture sized relative to the viewport
+struct RenderTextureDesc {
+    float scale = 1.0f;
+    GLenum internalFormat = GL_RGBA8;
+};
+
+// The passes every frame has (see createDefaultPasses)
+struct DefaultRenderPasses {
+    int lighting = -1;          // writes lightMap
+    int world = -1;             // reads lightMap, writes the backbuffer, clears it
+    int ui = -1;                // writes the backbuffer
+    int post = -1;              // writes the backbuffer
+    RenderResource lightMap = -1;
+};
+
+class RenderGraph {
+public:
+    static RenderGraph& getInstance();
+
+    // The window's default framebuffer; always present, never transient
+    static constexpr RenderResource BACKBUFFER = 0;
+
+    RenderResource createTexture(const std::string& name, const RenderTextureDesc& desc);
+
+    // Passes run in dependency order; passes that touch the same resource keep
+    // the order they were added in
+    int addPass(const std::string& name, const std::vector<RenderResource>& reads,
+                const std::vector<RenderResource>& writes);
+
+    // Clear the pass's targets before it runs (mask as for glClear)
+    void setClear(int pass, GLbitfield mask, const glm::vec4& color = glm::vec4(0.0f));
+
+    // lighting -> world -> ui -> post, with a half-float light map at lightMapScale
+    const DefaultRenderPasses& createDefaultPasses(float lightMapScale = 0.5f);
+    const DefaultRenderPasses& getDefaultPasses() const { return defaultPasses; }
+
+    // Work recorded between beginFrame() and execute(); cleared after execute()
+    void beginFrame() { recording = true; }
+    bool isRecording() const { return recording; }
+    void submit(int pass, std::function<void()> work);
+
+    void execute(int viewportWidth, int viewportHeight);
+
+    // Valid during execute() (and until the next resize) for transient textures
+    GLuint getTexture(RenderResource resource) const;
+    int getWidth(RenderResource resource) const;
+    int getHeight(RenderResource resource) const;
+
+    // Compiled pass order (pass indices) and the number of physical textures used
+    const std::vector<int>& getPassOrder();
+    size_t getPhysicalTextureCount();
+
+    void shutdown();
+
+private:
+    struct Resource {
+        std::string name;
+        RenderTextureDesc desc;
+        int physical = -1;              // index into physicalTextures
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<RenderResource> reads;
+        std::vector<RenderResource> writes;
+        GLbitfield clearMask = 0;
+        glm::vec4 clearColor = glm::vec4(0.0f);
+        std::vector<std::function<void()>> work;
+        GLuint framebuffer = 0;         // 0 when the pass writes the backbuffer
+    };
+
+    struct PhysicalTexture {
+        RenderTextureDesc desc;
+        GLuint texture = 0;
+        int width = 0, height = 0;
+    };
+
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<int> passOrder;
+    std::vector<PhysicalTexture> physicalTextures;
+    DefaultRenderPasses defaultPasses;
+
+    bool compiled = false;
+    bool recording = false;
+    int allocatedWidth = 0, allocatedHeight = 0;
+
+    RenderGraph();
+    void compile();
+    void allocate(int viewportWidth, int viewportHeight);
+    void releaseTargets();
+    static bool isDepthFormat(GLenum internalFormat);
+};
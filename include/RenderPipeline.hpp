@@ -0,0 +1,151 @@
+#pragma once
+#include "glad/glad.h"
+#include "ECS/Components.hpp"
+#include "SpriteVertexKernel.hpp"
+#include "SpriteAnimation.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+// Axis-aligned view bounds used to cull sprites before they reach the batcher
+struct FrustumBounds2D {
+    glm::vec2 min;
+    glm::vec2 max;
+    bool enabled;
+
+    FrustumBounds2D() : min(-1000.0f), max(1000.0f), enabled(false) {}
+
+    bool contains(const glm::vec2& position, const glm::vec2& size) const {
+        if (!enabled) return true;
+        glm::vec2 halfSize = size * 0.5f;
+        return !(position.x + halfSize.x < min.x ||
+                 position.x - halfSize.x > max.x ||
+                 position.y + halfSize.y < min.y ||
+                 position.y - halfSize.y > max.y);
+    }
+};
+
+// One batched sprite, fully resolved (texture + UVs) so submission needs no lookups
+struct PacketSprite {
+    SpriteAffine2D transform;
+    glm::vec4 color;
+    glm::vec2 uvMin, uvMax;
+    GLuint textureID;
+    int layer;
+};
+
+// Sprites that bypass the batcher are copied so they can be drawn a frame later
+struct PacketImmediateSprite {
+    SpriteComponent sprite;
+    TransformComponent2D transform;
+};
+
+// Everything stage two needs to draw one frame. Each worker writes its own slice.
+struct RenderFramePacket {
+    glm::mat4 viewProjection;
+    glm::mat4 view;
+    glm::mat4 projection;
+    FrustumBounds2D frustum;
+
+    struct Slice {
+        std::vector<PacketSprite> sprites;
+        std::vector<PacketImmediateSprite> immediateSprites;
+        int spritesCulled = 0;
+        float buildTime = 0.0f;   // ms this worker spent on its slice
+    };
+    std::vector<Slice> slices;
+    AnimatedSpriteFrame animated;   // captured on the main thread, not by the workers
+    bool ready;
+
+    RenderFramePacket() : viewProjection(1.0f), view(1.0f), projection(1.0f), ready(false) {}
+
+    void reset(size_t sliceCount) {
+        slices.resize(sliceCount);
+        for (auto& slice : slices) {
+            slice.sprites.clear();
+            slice.immediateSprites.clear();
+            slice.spritesCulled = 0;
+            slice.buildTime = 0.0f;
+        }
+        ready = false;
+    }
+
+    size_t spriteCount() const {
+        size_t count = 0;
+        for (const auto& slice : slices) count += slice.sprites.size();
+        return count;
+    }
+
+    int spritesCulled() const {
+        int count = 0;
+        for (const auto& slice : slices) count += slice.spritesCulled;
+        return count;
+    }
+
+    // Workers run in parallel, so the slowest slice is the build time
+    float buildTime() const {
+        float time = 0.0f;
+        for (const auto& slice : slices) time = std::max(time, slice.buildTime);
+        return time;
+    }
+};
+
+/*
+ * Two-stage render pipeline.
+ *
+ * Stage one (command generation) runs on a pool of worker threads and fills
+ * a RenderFramePacket. Stage two (sort, upload, draw) runs on the GL thread.
+ * Packets are double buffered: with a frame latency of 1 the GL thread draws
+ * packet N while the workers build packet N+1; with a latency of 0 the packet
+ * is built and drawn in the same frame.
+ */
+class RenderPipeline {
+public:
+    // Called once per worker with that worker's slice of the build packet
+    using BuildJob = std::function<void(RenderFramePacket& packet, size_t workerIndex, size_t workerCount)>;
+
+    explicit RenderPipeline(size_t workerCount = 2, int frameLatency = 1);
+    ~RenderPipeline();
+
+    RenderPipeline(const RenderPipeline&) = delete;
+    RenderPipeline& operator=(const RenderPipeline&) = delete;
+
+    // Packet being filled by stage one this frame
+    RenderFramePacket& getBuildPacket() { return packets[buildIndex]; }
+
+    // Packet stage two should draw this frame (built last frame when latency is 1)
+    RenderFramePacket& getSubmitPacket() { return packets[frameLatency == 0 ? buildIndex : 1 - buildIndex]; }
+
+    // Hand the build packet to the workers; returns immediately
+    void beginBuild(const BuildJob& job);
+
+    // Block until every worker has finished the current build
+    void waitForBuild();
+
+    // Flip the double buffer at the end of the frame
+    void endFrame();
+
+    void setFrameLatency(int latency) { frameLatency = latency > 0 ? 1 : 0; }
+    int getFrameLatency() const { return frameLatency; }
+    size_t getWorkerCount() const { return workers.size(); }
+
+private:
+    std::vector<std::thread> workers;
+    RenderFramePacket packets[2];
+    int buildIndex;
+    int frameLatency;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    BuildJob currentJob;
+    unsigned long long generation;
+    size_t pendingWorkers;
+    bool shuttingDown;
+
+    void workerLoop(size_t workerIndex);
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+/*
+ * Reference to a ResourceManager<Resource> slot.
+ *
+ * The index is the slot and the generation tells reuses of it apart: once a
+ * resource is unloaded its slot's generation changes, so an old handle
+ * resolves to nullptr instead of to whatever is loaded there next.
+ */
+template <typename Resource>
+struct ResourceHandle {
+    static const uint32_t INVALID = 0xFFFFFFFFu;
+
+    uint32_t index = INVALID;
+    uint32_t generation = 0;
+
+    bool isValid() const { return index != INVALID; }
+    bool operator==(const ResourceHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const ResourceHandle& other) const { return !(*this == other); }
+};
@@ -1,10 +1,13 @@
 #pragma once
 #include <unordered_map>
 
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "ResourceHandle.hpp"
 #include "Shader.hpp"
 #include "Texture.hpp"
 #include "Font.hpp"
@@ -19,11 +22,65 @@ public:
     bool load(const std::string& key, const std::string& filepath, unsigned int fontSize);
     bool loadCubemap(const std::string& key, const std::vector<std::string>& faces);
     bool loadTextureArray(const std::string& key, const std::vector<std::string>& layers);
+
+    // Asynchronous versions: files are read and decoded on the ThreadPool and
+    // the GL work runs later on the GL thread through GLUploadQueue. get(key)
+    // works right away and returns a placeholder (a checkerboard texture, a
+    // font without glyphs, a shader with no program) that becomes the real
+    // resource in place once its upload has run. The future is true when it
+    // has, false if the load failed (the placeholder is kept).
+    std::shared_future<bool> loadAsync(const std::string& key, const std::string& filepath);
+    std::shared_future<bool> loadAsync(const std::string& key, const char* vertexPath, const char* fragmentPath);
+    std::shared_future<bool> loadAsync(const std::string& key, const std::string& filepath, unsigned int fontSize);
+    std::shared_future<bool> loadCubemapAsync(const std::string& key, const std::vector<std::string>& faces);
+    std::shared_future<bool> loadTextureArrayAsync(const std::string& key, const std::vector<std::string>& layers);
+
+    // False while key is still a placeholder
+    bool isReady(const std::string& key) const;
+    size_t getPendingCount() const { return pending.size(); }
+
+    // GL thread: run uploads until every async load of this type has finished
+    void waitForPending();
     
     std::shared_ptr<Resource> get(const std::string& key) const;
+
+    // Handles: resolve a key once, then get(handle) is an array access. A key
+    // can be resolved before it is loaded; the handle picks the resource up
+    // when it is stored. Invalid for "".
+    ResourceHandle<Resource> getHandle(const std::string& key);
+
+    // nullptr if the handle is stale or its resource is not loaded yet. The
+    // pointer stays valid until the next processUnloads().
+    Resource* get(ResourceHandle<Resource> handle) const {
+        if (handle.index >= slots.size()) return nullptr;
+        const Slot& slot = slots[handle.index];
+        return slot.generation == handle.generation ? slot.resource.get() : nullptr;
+    }
+
+    // Explicit reference counting. Loading holds one reference and
+    // release(key) drops it; acquire/release(handle) add and drop others.
+    // A resource is unloaded once no reference is left, UNLOAD_DELAY_FRAMES
+    // processUnloads() calls later, so reacquiring or loading it again in
+    // between (a menu closed and reopened) keeps it.
+    ResourceHandle<Resource> acquire(const std::string& key);
+    void retain(ResourceHandle<Resource> handle);
+    void release(ResourceHandle<Resource> handle);
     void release(const std::string& key);
+
+    // Hot reload: keys loaded from path, and the files key was loaded from
+    // (normalized, "./a/../b.png" is "b.png")
+    std::vector<std::string> findKeysForFile(const std::string& path) const;
+    std::vector<std::string> getSourceFiles(const std::string& key) const;
+
+    // Once per frame, between frames: unload what is due
+    void processUnloads();
+    size_t getUnloadQueueSize() const { return unloadQueue.size(); }
+
+    // Unload everything now; every handle goes stale
     void clear();
 
+    static const uint32_t UNLOAD_DELAY_FRAMES = 3;
+
 
     bool isResourceLoaded(const std::string& key) const;
     ResourceManager(const ResourceManager&) = delete;
@@ -31,5 +88,34 @@ public:
 
 private:
     ResourceManager();
-    std::unordered_map<std::string, std::shared_ptr<Resource>> resources;
+
+    struct Slot {
+        std::shared_ptr<Resource> resource;
+        std::string key;
+        std::vector<std::string> files;   // loaded from, for hot reload
+        uint32_t generation = 1;
+        uint32_t refCount = 0;
+        uint64_t unloadFrame = 0;   // processUnloads() frame it is due in, while queued
+        bool loadReference = false; // refCount includes the one loading took
+    };
+
+    std::vector<Slot> slots;
+    std::unordered_map<std::string, uint32_t> keys;    // interned key -> slot
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> unloadQueue;
+    uint64_t frame = 0;
+
+    uint32_t intern(const std::string& key);
+    // Put a loaded resource into key's slot and take the load reference
+    void store(const std::string& key, std::shared_ptr<Resource> resource, const std::vector<std::string>& files);
+    // If key is loaded, take the load reference back (cancels a pending unload)
+    bool retakeLoadReference(const std::string& key);
+    void dropReference(uint32_t index);
+    void unload(uint32_t index);
+
+    // Async loads not uploaded yet; only touched on the GL thread
+    std::unordered_map<std::string, std::shared_future<bool>> pending;
+
+    template <typename Decode, typename Upload>
+    std::shared_future<bool> startAsync(const std::string& key, Decode decode, Upload upload);
 };
\ No newline at end of file
@@ -3,6 +3,25 @@
 #include "glad/glad.h"
 #include <glm/glm.hpp>
 #include <string>
+#include <vector>
+
+// A slot in the shader's handle table, resolved once by name. The shader
+// refills the table's locations when it relinks (hot reload), so handles
+// stay valid. A name the program lacks sets nothing, the same as GL does
+// for unknown names; an invalid handle (-1) does the same.
+struct UniformHandle {
+    int index = -1;
+    bool isValid() const { return index >= 0; }
+};
+
+// One active uniform of a linked program. Arrays are listed once under
+// their base name ("uTextures") with size > 1.
+struct ShaderUniform {
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint size;
+};
 
 class Shader
 {
@@ -15,9 +34,28 @@ public:
     // Load shader from file paths
     bool loadFromFile(const char* vertexPath, const char* fragmentPath);
 
+    // Compile sources read elsewhere (GL thread)
+    bool loadFromSource(const std::string& vertexCode, const std::string& fragmentCode);
+
+    // Hot reload (GL thread): switch to a program built from new sources. The
+    // old program stays if they don't compile. Uniform handles resolved
+    // earlier follow the new program's locations.
+    bool reload(const std::string& vertexCode, const std::string& fragmentCode, const std::string& name = "shader");
+
+    // Read a shader file; no GL, safe on any thread
+    static bool readSource(const char* path, std::string& code);
+
     // Activate the shader
     void use() const;
 
+    // Resolve a uniform from the table built at link time (no GL call).
+    // Handles belong to this shader; repeated names share one handle.
+    UniformHandle getUniform(const std::string& name) const;
+    const std::vector<ShaderUniform>& getUniforms() const { return uniforms; }
+
+    // True if the program declares the FrameConstants block (see FrameConstantBuffer)
+    bool usesFrameConstants() const { return frameConstantsBlock; }
+
     // Utility uniform functions (setting uniforms)
     void setBool(const std::string& name, bool value) const;
     void setInt(const std::string& name, int value) const;
@@ -32,12 +70,88 @@ public:
     void setMat3(const std::string& name, const glm::mat3& mat) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
 
+    // Same as above through pre-resolved handles
+    void setBool(UniformHandle handle, bool value) const;
+    void setInt(UniformHandle handle, int value) const;
+    void setFloat(UniformHandle handle, float value) const;
+    void setVec2(UniformHandle handle, const glm::vec2& value) const;
+    void setVec3(UniformHandle handle, const glm::vec3& value) const;
+    void setVec4(UniformHandle handle, const glm::vec4& value) const;
+    void setMat2(UniformHandle handle, const glm::mat2& mat) const;
+    void setMat3(UniformHandle handle, const glm::mat3& mat) const;
+    void setMat4(UniformHandle handle, const glm::mat4& mat) const;
+
+private:
+    std::vector<ShaderUniform> uniforms;   // sorted by name
+    bool frameConstantsBlock = false;
+
+    // Handle table: names handed out by getUniform and their current locations
+    mutable std::vector<std::string> handleNames;
+    mutable std::vector<GLint> handleLocations;
+
+    // Fill the uniform table, re-resolve the handle table and bind the
+    // FrameConstants block if present
+    void reflectUniforms();
+    GLint findLocation(const std::string& name) const;
+    GLint handleLocation(UniformHandle handle) const;
+
+    // Compile and link shaders (through ShaderCache)
+    bool compileAndLink(const char* vertexCode, const char* fragmentCode, const std::string& name = "shader");
+};
+
+/*
+ * Per-frame values shared by every shader that declares
+ *
+ *   layout(std140) uniform FrameConstants {
+ *       mat4 uView;
+ *       mat4 uProjection;
+ *       mat4 uViewProjection;
+ *       mat4 uScreenProjection;   // pixels, origin bottom left
+ *       vec4 uTimeScreen;         // time, delta time, screen width, screen height
+ *   };
+ *
+ * The buffer is written once per frame (and again when the camera moves) and
+ * stays bound to FRAME_CONSTANTS_BINDING, so draws do not re-upload any of it.
+ */
+struct FrameConstants {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::mat4 screenProjection;
+    glm::vec4 timeScreen;
+};
+
+const GLuint FRAME_CONSTANTS_BINDING = 0;
+
+// Point a program's FrameConstants block at FRAME_CONSTANTS_BINDING; false if it has none
+bool bindFrameConstantsBlock(GLuint program);
+
+class FrameConstantBuffer {
+public:
+    static FrameConstantBuffer& getInstance();
+
+    // Call once at the start of each frame
+    void beginFrame(float time, float deltaTime, int screenWidth, int screenHeight);
+
+    // Upload the camera matrices if they changed
+    void setCamera(const glm::mat4& view, const glm::mat4& projection);
+
+    // Draw with a different uViewProjection (a pipelined packet built with last
+    // frame's camera). Uploads only when it differs; setCamera restores it.
+    void useViewProjection(const glm::mat4& viewProjection);
+
+    const FrameConstants& get() const { return constants; }
+    size_t getFrame() const { return frame; }
+
+    void shutdown();
+
 private:
-    // Compile and link shaders
-    bool compileAndLink(const char* vertexCode, const char* fragmentCode);
-    
-    // Utility function for checking shader compilation/linking errors.
-    bool checkCompileErrors(GLuint shader, const std::string& type);
+    GLuint buffer = 0;
+    FrameConstants constants;
+    size_t frame = 0;
+
+    FrameConstantBuffer();
+    void upload(size_t offset, size_t size);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include "glad/glad.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Linked GL programs, shared by source and kept on disk between runs.
+ *
+ * Programs are keyed by a hash of their vertex and fragment source, so every
+ * Shader, batcher and renderer built from the same GLSL gets the same
+ * program. Linked programs are also written to the cache directory with
+ * glGetProgramBinary, tagged with the driver that produced them. The next
+ * run loads them with glProgramBinary and compiles nothing. A binary from a
+ * different driver, or one the driver rejects, is recompiled and replaced.
+ *
+ * GL thread only. The disk cache needs GL 4.1 or ARB_get_program_binary and
+ * at least one binary format; without them programs are only shared.
+ */
+struct ShaderCacheStats {
+    size_t shared = 0;       // acquire() found the program already linked
+    size_t loaded = 0;       // from a binary on disk
+    size_t compiled = 0;     // compiled and linked from source
+    size_t rejected = 0;     // binaries on disk that could not be used
+    double loadTime = 0.0;   // ms in glProgramBinary
+    double compileTime = 0.0;   // ms compiling and linking
+};
+
+class ShaderCache {
+public:
+    static ShaderCache& getInstance();
+
+    // Program for the sources, 0 if they do not compile (the log goes to
+    // std::cerr, labelled with name). Every acquire needs a release.
+    GLuint acquire(const std::string& vertexCode, const std::string& fragmentCode, const std::string& name = "shader");
+    // Delete the program once its last user has released it
+    void release(GLuint program);
+
+    // "" turns the disk cache off. Default "./shader_cache".
+    void setCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+    const std::string& getCacheDirectory() const { return cacheDirectory; }
+    bool isBinaryCacheSupported();
+
+    const ShaderCacheStats& getStats() const { return stats; }
+    void resetStats() { stats = ShaderCacheStats(); }
+
+    // Delete every program, released or not
+    void shutdown();
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+private:
+    struct Entry {
+        GLuint program = 0;
+        int users = 0;
+        std::string vertexCode, fragmentCode;   // to tell hash collisions apart
+    };
+
+    std::unordered_map<uint64_t, Entry> programs;   // by source hash
+    std::unordered_map<GLuint, uint64_t> sourceHashes;
+    std::string cacheDirectory = "./shader_cache";
+    uint64_t driverHash = 0;
+    int binarySupport = -1;   // unknown until the first acquire
+    ShaderCacheStats stats;
+
+    ShaderCache() = default;
+
+    std::string binaryPath(uint64_t sourceHash) const;
+    GLuint loadBinary(uint64_t sourceHash, uint64_t sourceLength);
+    void saveBinary(uint64_t sourceHash, uint64_t sourceLength, GLuint program);
+    GLuint compile(const std::string& vertexCode, const std::string& fragmentCode, const std::string& name);
+};
+
+// 64-bit FNV-1a, continuing from hash
+inline uint64_t hashShaderSource(const char* data, size_t length, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,197 @@
+#pragma once
+#include "glad/glad.h"
+#include "SpriteVertexKernel.hpp"
+#include "LightRenderer2D.hpp"
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Flipbook animation for atlas sprites.
+ *
+ * A clip is a contiguous range of an atlas's UV table (frames added to the
+ * atlas one after another). The frame to show is picked in the vertex shader
+ * from a global clock, so an animated sprite costs CPU time only when its
+ * state (clip, speed, pause) or placement changes.
+ */
+
+struct SpriteAnimationClip {
+    std::string name;
+    std::string atlasName;
+    std::vector<std::string> frameNames;
+    float framesPerSecond;
+    bool loop;
+
+    // Filled in when the frame tables are built (after atlas generation)
+    int firstFrame = -1;    // index into the combined frame table
+    int frameCount = 0;
+    int textureSlot = -1;   // texture unit of the clip's atlas
+    int atlasIndex = -1;    // atlas and UV index of the first frame
+    int firstSprite = -1;
+};
+
+class SpriteAnimationLibrary {
+public:
+    static SpriteAnimationLibrary& getInstance();
+
+    // Define a clip from frames that were added to one atlas in order.
+    // Returns the clip id; frames are checked when the atlas is generated.
+    int defineClip(const std::string& name, const std::string& atlasName,
+                   const std::vector<std::string>& frameNames,
+                   float framesPerSecond, bool loop = true);
+
+    // Clip id by name, or -1. Hashes, so look ids up once and keep them.
+    int findClip(const std::string& name) const;
+    const SpriteAnimationClip& getClip(int clipId) const { return clips[clipId]; }
+    int getClipCount() const { return static_cast<int>(clips.size()); }
+
+    // Global animation clock, in seconds since the current epoch. The epoch
+    // moves forward by REBASE_INTERVAL whenever the clock reaches it, so the
+    // clock (uTime in the shader) keeps its precision in long sessions.
+    // Returns how far the epoch moved, 0 on most frames; start times taken
+    // from getTime() must be moved back by that much (AnimationSystem does).
+    float advance(float deltaTime);
+    float getTime() const { return time; }
+
+    // Clip time folded into one pass of the clip: wrapped for looping clips,
+    // held on the last frame otherwise. Same frame, smaller number.
+    float foldClipTime(int clipId, float clipTime) const;
+
+    static constexpr float REBASE_INTERVAL = 256.0f;
+
+    // Mark every frame of a clip drawn this frame, so a dynamic atlas doesn't
+    // evict frames the shader may pick (see TextureAtlas::markUsed)
+    void markClipUsed(int clipId);
+
+    // Rebuild the GPU frame/clip tables if clips or atlases changed, then bind
+    // them (units FRAME_TABLE_UNIT/CLIP_TABLE_UNIT) and the clips' atlases
+    void bindTables();
+
+    static const int FRAME_TABLE_UNIT = 16;
+    static const int CLIP_TABLE_UNIT = 17;
+
+    void shutdown();
+
+private:
+    std::vector<SpriteAnimationClip> clips;
+    std::unordered_map<std::string, int> clipIds;
+    std::vector<GLuint> slotTextures;   // atlas page texture per texture slot
+    float time = 0.0f;
+
+    // Texture buffers: frames are (uv0, uv1), clips are two texels each:
+    // (first frame, frame count, frames per second, loop) and (texture slot, 0, 0, 0)
+    GLuint frameBuffer = 0, frameTexture = 0;
+    GLuint clipBuffer = 0, clipTexture = 0;
+    unsigned int builtGeneration = 0;   // atlas generation the tables match
+    std::vector<std::pair<int, unsigned int>> builtAtlases;   // atlas index, UV generation in the tables
+    bool unresolvedClips = false;
+    bool clipsChanged = true;
+
+    SpriteAnimationLibrary() = default;
+    void buildTables();
+    bool tablesStale() const;
+};
+
+// Per-instance data of an animated sprite, 48 bytes
+struct AnimatedSpriteInstance {
+    float translation[3];   // quad (0, 0) corner xy, depth
+    float axes[4];          // axisX.xy, axisY.xy
+    GLubyte color[4];       // tint, unorm8
+    GLuint clip;            // SpriteAnimationLibrary clip id
+    float timing[3];        // start time, speed (0 when paused), clip time at start
+
+    static AnimatedSpriteInstance make(const SpriteAffine2D& transform, const glm::vec4& color,
+                                       int clipId, float startTime, float speed, float timeOffset);
+};
+
+// Instances of one renderLayer, a contiguous range of the instance array
+struct AnimatedLayerRange {
+    int layer;
+    size_t first;
+    size_t count;
+};
+
+// Animated sprites as they were when a frame was built: the instances that
+// changed since the previous capture, the layer ranges and the clock. Drawing
+// a frame later (pipeline latency 1) shows it as it was captured.
+struct AnimatedSpriteFrame {
+    std::vector<AnimatedSpriteInstance> changed;   // instances changedBegin onwards
+    size_t changedBegin = 0;
+    size_t instanceCount = 0;
+    size_t capacity = 0;                            // instance buffer size to draw from
+    std::vector<AnimatedLayerRange> layers;         // ascending layer
+    float time = 0.0f;
+    unsigned long long sequence = 0;                // 0 = never captured
+};
+
+// Draws animated sprites as instanced quads from a persistent instance buffer.
+// Only instances that changed since the last capture are uploaded. Instances
+// are kept sorted by layer so each layer is one draw that the sprite batcher
+// can slot between its own layers.
+class AnimatedSpriteRenderer {
+public:
+    static AnimatedSpriteRenderer& getInstance();
+
+    void init();
+    void shutdown();
+
+    // Slots stay valid until removed; the instance array itself is kept dense
+    int addInstance(const AnimatedSpriteInstance& instance, int layer = 0);
+    void updateInstance(int slot, const AnimatedSpriteInstance& instance, int layer = 0);
+    void removeInstance(int slot);
+
+    // Snapshot what changed since the previous capture into `frame`
+    void capture(AnimatedSpriteFrame& frame);
+
+    // Upload a captured frame. Frames must be prepared in capture order; one
+    // that is out of order (the pipeline latency changed) is replaced by the
+    // current state. Returns the frame drawLayer() will draw, or nullptr.
+    const AnimatedSpriteFrame* prepare(const AnimatedSpriteFrame& frame, const glm::mat4& viewProjection);
+
+    // Draw one of the prepared frame's layer ranges
+    void drawLayer(size_t rangeIndex);
+
+    // Capture, prepare and draw every layer now
+    void render(const glm::mat4& viewProjection);
+
+    size_t getInstanceCount() const { return instances.size(); }
+    size_t getBytesUploaded() const { return bytesUploaded; }   // last prepare() call
+
+private:
+    GLuint VAO = 0, instanceVBO = 0;
+    GLuint shaderProgram = 0;
+    GLint timeLocation = -1;
+    LightMapBinding lightMap;
+    bool initialized = false;
+
+    std::vector<AnimatedSpriteInstance> instances;
+    std::vector<int> instanceLayers;    // per instance, ascending
+    std::vector<int> slotToIndex;       // -1 for free slots
+    std::vector<int> indexToSlot;
+    std::vector<int> freeSlots;
+    std::vector<AnimatedLayerRange> layerRanges;
+    std::vector<int> clipInstances;     // per clip id, instances playing it
+    bool layersChanged = false;
+    size_t dirtyBegin = 0, dirtyEnd = 0;   // instance range changed since the last capture
+    size_t capturedCapacity = 0;           // buffer size the captured frames assume
+    unsigned long long captureSequence = 0;
+
+    size_t bufferCapacity = 0;
+    unsigned long long uploadedSequence = 0;
+    const AnimatedSpriteFrame* preparedFrame = nullptr;
+    AnimatedSpriteFrame currentFrame;      // render() and out of order frames
+    glm::mat4 preparedViewProjection = glm::mat4(1.0f);
+    size_t boundFirstInstance = 0;
+    size_t bytesUploaded = 0;
+
+    AnimatedSpriteRenderer() = default;
+    void markDirty(size_t index);
+    void countClip(GLuint clip, int delta);
+    void moveInstance(size_t from, size_t to);
+    void updateLayerRanges();
+    void insertAt(int slot, const AnimatedSpriteInstance& instance, int layer);
+    void detach(int slot);
+    void bindInstanceRange(size_t first);
+};
@@ -1,33 +1,27 @@
 #pragma once
 #include "glad/glad.h"
 #include "TextureAtlas.hpp"
+#include "SpriteVertexKernel.hpp"
+#include "LightRenderer2D.hpp"
 #include <glm/glm.hpp>
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <chrono>
+#include <functional>
 
-struct SpriteVertex {
-    glm::vec3 position;     // World position
-    glm::vec2 texCoord;     // UV coordinates  
-    glm::vec4 color;        // Tint color
-    float textureIndex;     // Which texture to sample from
-    
-    SpriteVertex(glm::vec3 pos = glm::vec3(0.0f), 
-                 glm::vec2 uv = glm::vec2(0.0f),
-                 glm::vec4 col = glm::vec4(1.0f),
-                 float texIdx = 0.0f)
-        : position(pos), texCoord(uv), color(col), textureIndex(texIdx) {}
-};
+struct RenderFramePacket;
+struct AnimatedSpriteFrame;
 
 struct SpriteRenderCommand {
-    glm::mat4 transform;
+    SpriteAffine2D transform;
     glm::vec4 color;
     glm::vec2 uvMin, uvMax;
     float textureIndex;
     int layer;
     
     SpriteRenderCommand() 
-        : transform(1.0f), color(1.0f), uvMin(0.0f), uvMax(1.0f), textureIndex(0.0f), layer(0) {}
+        : transform(), color(1.0f), uvMin(0.0f), uvMax(1.0f), textureIndex(0.0f), layer(0) {}
 };
 
 struct SpriteBatch {
@@ -74,10 +68,57 @@ struct SpriteBatch {
     }
 };
 
-class SpriteBatcher {
+// Layout of GL_DRAW_INDIRECT_BUFFER entries for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;   // indexes the per-draw texture base (sprites are never instanced)
+};
+
+// Atlas samplers declared by the sprite fragment shader (unit 15 is the light map)
+const int SPRITE_SHADER_TEXTURE_UNITS = 15;
+
+// Per-frame statistics shared by every vertex layout
+struct SpriteRenderStats {
+    int drawCalls;
+    int spritesRendered;
+    int spritesCulled;
+    int batchesCreated;
+    
+    // CPU time per stage in ms
+    float commandBuildTime;   // begin() until end(): culling and batch assignment
+    float sortTime;           // layer sort
+    float vertexGenTime;      // quad expansion
+    float uploadTime;         // buffer uploads
+    float submitTime;         // texture binds and draw calls
+    float lastFrameTime;      // total CPU time from begin() to the end of end()
+    
+    // GPU time in ms of the most recent frame whose timer query finished
+    // (normally the previous frame), -1 if timer queries are unavailable
+    float gpuTime;
+    
+    size_t bytesUploaded;     // vertex + index bytes sent this frame
+    
+    SpriteRenderStats() : drawCalls(0), spritesRendered(0), spritesCulled(0), batchesCreated(0)
+                        , commandBuildTime(0.0f), sortTime(0.0f), vertexGenTime(0.0f), uploadTime(0.0f)
+                        , submitTime(0.0f), lastFrameTime(0.0f), gpuTime(-1.0f), bytesUploaded(0) {}
+};
+
+// Batches sprites into as few draw calls as possible. The vertex layout is a
+// template parameter; SpriteVertex and PackedSpriteVertex are instantiated.
+template <typename Vertex>
+class BasicSpriteBatcher {
 public:
-    SpriteBatcher(int maxSpritesPerBatch = 1000, int maxTexturesPerBatch = 8);
-    ~SpriteBatcher();
+    using VertexType = Vertex;
+    using RenderStats = SpriteRenderStats;
+    
+    BasicSpriteBatcher(int maxSpritesPerBatch = 1000, int maxTexturesPerBatch = 8);
+    ~BasicSpriteBatcher();
+    
+    BasicSpriteBatcher(const BasicSpriteBatcher&) = delete;
+    BasicSpriteBatcher& operator=(const BasicSpriteBatcher&) = delete;
     
     // Initialize OpenGL resources
     void init();
@@ -86,33 +127,57 @@ public:
     void begin(const glm::mat4& viewProjectionMatrix);
     
     // Add a sprite to be rendered
-    void addSprite(const glm::mat4& transform, 
+    void addSprite(const SpriteAffine2D& transform,
                    const glm::vec4& color,
                    GLuint textureID,
                    const glm::vec2& uvMin = glm::vec2(0.0f, 0.0f),
                    const glm::vec2& uvMax = glm::vec2(1.0f, 1.0f),
                    int layer = 0);
     
+    // Model matrix for the centered unit quad; converted with SpriteAffine2D::fromMatrix
+    void addSprite(const glm::mat4& transform, 
+                   const glm::vec4& color,
+                   GLuint textureID,
+                   const glm::vec2& uvMin = glm::vec2(0.0f, 0.0f),
+                   const glm::vec2& uvMax = glm::vec2(1.0f, 1.0f),
+                   int layer = 0) {
+        addSprite(SpriteAffine2D::fromMatrix(transform), color, textureID, uvMin, uvMax, layer);
+    }
+    
+    // Draws something the batcher doesn't own (animated sprites) between two layers
+    using LayerCallback = std::function<void(size_t)>;
+    
     // End batching and submit all draw calls
     void end();
     
+    // Same, but drawInterleaved(i) runs after the sprites of layer interleavedLayers[i]
+    // and before any sprite above it. interleavedLayers must be ascending.
+    void end(const std::vector<int>& interleavedLayers, const LayerCallback& drawInterleaved);
+    
     // Set up frustum culling bounds
     void setFrustumBounds(const glm::vec2& min, const glm::vec2& max, const glm::vec2& size);
     
     // Enable/disable frustum culling
     void setFrustumCullingEnabled(bool enabled) { frustumCullingEnabled = enabled; }
+    bool isFrustumCullingEnabled() const { return frustumCullingEnabled; }
     
-    // Get rendering statistics
-    struct RenderStats {
-        int drawCalls;
-        int spritesRendered;
-        int spritesCulled;
-        int batchesCreated;
-        float lastFrameTime;
-        
-        RenderStats() : drawCalls(0), spritesRendered(0), spritesCulled(0), batchesCreated(0), lastFrameTime(0.0f) {}
-    };
+    // Account for sprites that were culled before reaching the batcher
+    void addCulledSprites(int count) { stats.spritesCulled += count; }
+    
+    // Override the detected quad expansion kernel (benchmarks, debugging)
+    void setKernelPath(SpriteKernelPath path) { kernelPath = path; }
+    SpriteKernelPath getKernelPath() const { return kernelPath; }
+    
+    // Submit all batches with glMultiDrawElementsIndirect when the context
+    // supports it (GL 4.3); otherwise batches are drawn one by one
+    void setMultiDrawEnabled(bool enabled) { multiDrawEnabled = enabled; }
+    bool isMultiDrawEnabled() const { return multiDrawEnabled; }
+    bool isMultiDrawSupported() const { return multiDrawSupported; }
     
+    // Account for command generation done outside the batcher (pipeline workers)
+    void addCommandBuildTime(float ms) { stats.commandBuildTime += ms; }
+    
+    // Get rendering statistics
     const RenderStats& getStats() const { return stats; }
     void resetStats() { stats = RenderStats(); }
     
@@ -120,11 +185,33 @@ private:
     // OpenGL resources
     GLuint VAO, VBO, EBO;
     GLuint shaderProgram;
+    LightMapBinding lightMap;
+    
+    // Multi-draw indirect: one command and one texture base per batch
+    GLuint indirectBuffer;
+    GLuint drawTextureBaseBuffer;   // attribute 5, divisor 1, selected by baseInstance
+    bool multiDrawSupported;
+    bool multiDrawEnabled;
+    int textureUnitBudget;          // texture units one multi-draw may bind
+    std::vector<DrawElementsIndirectCommand> indirectCommands;
+    std::vector<GLuint> drawTextureBases;
+    std::vector<GLuint> drawTextures;
+    
+    // Consecutive batches whose textures fit in textureUnitBudget together
+    struct MultiDrawGroup {
+        size_t firstCommand;
+        size_t firstTexture;
+    };
+    std::vector<MultiDrawGroup> multiDrawGroups;
+    
+    // Set for the duration of end(layers, callback)
+    const std::vector<int>* interleavedLayers = nullptr;
+    const LayerCallback* drawInterleaved = nullptr;
+    std::vector<size_t> interleaveCursors;   // per batch, first command not drawn yet
     
     // Batching data
     std::vector<SpriteBatch> batches;
-    std::vector<SpriteVertex> vertices;
-    std::vector<GLuint> indices;
+    SpriteQuadStream<Vertex> quadStream;   // sorted sprites in SoA form for the kernel
     glm::mat4 viewProjectionMatrix;
     
     // Configuration
@@ -137,23 +224,50 @@ private:
     
     // Statistics
     RenderStats stats;
+    std::chrono::high_resolution_clock::time_point frameStartTime;
+    std::chrono::high_resolution_clock::time_point commandStartTime;
+    
+    // GPU timing: a small ring of GL_TIME_ELAPSED queries so results are read
+    // back without stalling on the frame that was just submitted
+    static const int GPU_QUERY_COUNT = 3;
+    GLuint gpuQueries[GPU_QUERY_COUNT];
+    bool gpuQueryPending[GPU_QUERY_COUNT];
+    int gpuQueryIndex;
+    float lastGpuTime;
+    
+    // Sprites the VBO/EBO can currently hold
+    int bufferCapacity;
+    
+    // Quad expansion kernel (SSE/AVX2/scalar)
+    SpriteKernelPath kernelPath;
     
     // Shader setup
     void createShader();
     void setupBuffers();
+    void resizeBuffers(int spriteCapacity);
     
     // Batching logic
     void createBatches();
     void renderBatches();
+    void renderBatchesIndirect();
+    void renderBatchesInterleaved();
     void flushBatch(const SpriteBatch& batch);
     
-    // Culling
-    bool isInFrustum(const glm::vec3& position, const glm::vec2& size) const;
+    // GPU timing
+    void collectGpuTime();
     
-    // Vertex generation
-    void generateQuadVertices(const SpriteRenderCommand& cmd, int vertexIndex, float textureIndex);
+    // Culling
+    bool isInFrustum(const glm::vec2& center, const glm::vec2& size) const;
 };
 
+// Layout used by SpriteRenderManager. Define SPRITE_BATCHER_FULL_PRECISION
+// to go back to the 40 byte float vertex.
+#ifdef SPRITE_BATCHER_FULL_PRECISION
+using SpriteBatcher = BasicSpriteBatcher<SpriteVertex>;
+#else
+using SpriteBatcher = BasicSpriteBatcher<PackedSpriteVertex>;
+#endif
+
 class SpriteRenderManager {
 public:
     static SpriteRenderManager& getInstance();
@@ -164,31 +278,64 @@ public:
     void beginFrame(const glm::mat4& viewProjectionMatrix);
     void endFrame();
     
-    // Render a sprite using atlas
+    // End the frame with a captured animated sprite frame drawn in layer order
+    void endFrame(const AnimatedSpriteFrame& animated);
+    
+    // Render a sprite from a resolved atlas handle (no hashing; invalid handles are skipped)
+    void renderSprite(const SpriteHandle& sprite,
+                      const SpriteAffine2D& transform,
+                      const glm::vec4& color = glm::vec4(1.0f),
+                      int layer = 0);
+    
+    // Render a sprite using atlas; resolves the name every call, prefer handles per frame
     void renderSprite(const std::string& spriteName,
-                      const glm::mat4& transform,
+                      const SpriteAffine2D& transform,
                       const glm::vec4& color = glm::vec4(1.0f),
                       int layer = 0);
     
     // Render a sprite with direct texture
     void renderSprite(GLuint textureID,
-                      const glm::mat4& transform,
+                      const SpriteAffine2D& transform,
                       const glm::vec4& color = glm::vec4(1.0f),
                       const glm::vec2& uvMin = glm::vec2(0.0f, 0.0f),
                       const glm::vec2& uvMax = glm::vec2(1.0f, 1.0f),
                       int layer = 0);
     
+    // mat4 overloads for existing callers (centered unit quad model matrix)
+    void renderSprite(const std::string& spriteName,
+                      const glm::mat4& transform,
+                      const glm::vec4& color = glm::vec4(1.0f),
+                      int layer = 0) {
+        renderSprite(spriteName, SpriteAffine2D::fromMatrix(transform), color, layer);
+    }
+    
+    void renderSprite(GLuint textureID,
+                      const glm::mat4& transform,
+                      const glm::vec4& color = glm::vec4(1.0f),
+                      const glm::vec2& uvMin = glm::vec2(0.0f, 0.0f),
+                      const glm::vec2& uvMax = glm::vec2(1.0f, 1.0f),
+                      int layer = 0) {
+        renderSprite(textureID, SpriteAffine2D::fromMatrix(transform), color, uvMin, uvMax, layer);
+    }
+    
+    // Draw a packet produced by RenderPipeline (begin + add + end in one call)
+    void submitPacket(const RenderFramePacket& packet);
+    
     // Configuration
     void setFrustumCullingEnabled(bool enabled);
+    void setMultiDrawEnabled(bool enabled);
     void updateFrustum(const glm::vec2& cameraPos, const glm::vec2& viewSize, float zoom = 1.0f);
     
     // Statistics
-    const SpriteBatcher::RenderStats& getStats() const;
+    const SpriteRenderStats& getStats() const;
     void resetStats();
     
 private:
     std::unique_ptr<SpriteBatcher> batcher;
     bool initialized;
+    glm::mat4 frameViewProjection;
+    
+    void endFrameInterleaved(const AnimatedSpriteFrame& animated, const glm::mat4& viewProjection);
     
-    SpriteRenderManager() : initialized(false) {}
+    SpriteRenderManager() : initialized(false), frameViewProjection(1.0f) {}
 };
\ No newline at end of file
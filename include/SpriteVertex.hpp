@@ -0,0 +1,52 @@
+#pragma once
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+/*
+ * Vertex layouts usable with BasicSpriteBatcher. Each layout provides:
+ *   make()               - build a vertex from full-precision inputs
+ *   setPosition()        - overwrite xy only (used by the quad expansion kernel)
+ *   setupAttributes()    - glVertexAttrib*Pointer calls for the bound VAO/VBO
+ *   vertexShaderSource() - vertex shader matching those attributes
+ *
+ * Attribute location 5 (uint aTextureBase) is reserved: the batcher feeds it
+ * per draw and the shader adds it to the vertex's texture index.
+ */
+
+// Full precision layout, 40 bytes
+struct SpriteVertex {
+    glm::vec3 position;     // World position
+    glm::vec2 texCoord;     // UV coordinates  
+    glm::vec4 color;        // Tint color
+    float textureIndex;     // Which texture to sample from
+    
+    SpriteVertex(glm::vec3 pos = glm::vec3(0.0f), 
+                 glm::vec2 uv = glm::vec2(0.0f),
+                 glm::vec4 col = glm::vec4(1.0f),
+                 float texIdx = 0.0f)
+        : position(pos), texCoord(uv), color(col), textureIndex(texIdx) {}
+    
+    static SpriteVertex make(const glm::vec3& position, const glm::vec2& uv,
+                             const glm::vec4& color, int textureIndex);
+    void setPosition(float x, float y) { position.x = x; position.y = y; }
+    static void setupAttributes();
+    static const char* vertexShaderSource();
+};
+
+// Quantized layout, 20 bytes. UVs are unorm16, color is RGBA8 and depth is
+// snorm16, so z is clamped to [-1, 1] (the 2D camera's near/far range).
+struct PackedSpriteVertex {
+    float x, y;             // World position
+    GLushort u, v;          // UV coordinates, unorm16
+    GLubyte color[4];       // Tint color, unorm8
+    GLshort z;              // Depth, snorm16
+    GLushort textureIndex;  // Integer texture slot
+    
+    static PackedSpriteVertex make(const glm::vec3& position, const glm::vec2& uv,
+                                   const glm::vec4& color, int textureIndex);
+    void setPosition(float newX, float newY) { x = newX; y = newY; }
+    static void setupAttributes();
+    static const char* vertexShaderSource();
+};
+
+static_assert(sizeof(PackedSpriteVertex) == 20, "PackedSpriteVertex must stay 20 bytes");
@@ -0,0 +1,89 @@
+#pragma once
+#include "SpriteVertex.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+#include <cmath>
+
+// Instruction set used to expand sprites into quads
+enum class SpriteKernelPath {
+    Scalar,
+    SSE,     // 4 sprites per step
+    AVX2     // 8 sprites per step
+};
+
+// Best path the running CPU supports (checked once)
+SpriteKernelPath detectSpriteKernelPath();
+const char* spriteKernelPathName(SpriteKernelPath path);
+bool isSpriteKernelPathSupported(SpriteKernelPath path);
+
+/*
+ * 2D affine placement of a sprite quad, 28 bytes instead of a 64 byte mat4.
+ * Maps the unit quad [0,1]^2 to the world:
+ *   world = translation + axisX * u + axisY * v
+ * The pivot is already folded into the translation.
+ */
+struct SpriteAffine2D {
+    glm::vec2 axisX;        // world-space direction and length of the quad's x edge
+    glm::vec2 axisY;        // world-space direction and length of the quad's y edge
+    glm::vec2 translation;  // world position of the quad's (0, 0) corner
+    float z;                // depth, unchanged by the transform
+
+    SpriteAffine2D() : axisX(1.0f, 0.0f), axisY(0.0f, 1.0f), translation(-0.5f), z(0.0f) {}
+
+    // position is where the pivot lands; pivot is in quad space ((0.5, 0.5) = center)
+    static SpriteAffine2D fromComponents(const glm::vec3& position, const glm::vec2& scale,
+                                         float sinRotation, float cosRotation,
+                                         const glm::vec2& pivot = glm::vec2(0.5f));
+
+    // Degrees, matching CameraComponent2D::rotation
+    static SpriteAffine2D fromDegrees(const glm::vec3& position, const glm::vec2& scale,
+                                      float rotationDegrees, const glm::vec2& pivot = glm::vec2(0.5f));
+
+    // Legacy model matrix applied to the centered unit quad [-0.5, 0.5]^2
+    static SpriteAffine2D fromMatrix(const glm::mat4& transform);
+
+    // Same quad for an atlas region stored a quarter turn clockwise (SpriteUV::rotated)
+    SpriteAffine2D forRotatedUV() const;
+
+    // Model matrix for the centered unit quad (immediate-mode fallback)
+    glm::mat4 toMatrix() const;
+
+    // World-space center and axis-aligned extent, for culling
+    glm::vec2 center() const { return translation + (axisX + axisY) * 0.5f; }
+    glm::vec2 extent() const {
+        return glm::vec2(std::fabs(axisX.x) + std::fabs(axisY.x), std::fabs(axisX.y) + std::fabs(axisY.y));
+    }
+};
+
+/*
+ * Structure-of-arrays input for quad expansion.
+ *
+ * The affine transform is split into separate arrays so the kernel can
+ * transform several sprites per instruction. Everything that does not depend
+ * on the transform (UVs, color, texture slot, depth) is encoded once into
+ * four corner vertices per sprite; the kernel only writes their xy. That
+ * encoding (push) and the copy out are scalar; the SIMD paths vectorise the
+ * corner position adds only.
+ */
+template <typename Vertex>
+struct SpriteQuadStream {
+    std::vector<float> translationX, translationY;
+    std::vector<float> axisXx, axisXy;
+    std::vector<float> axisYx, axisYy;
+    std::vector<Vertex> corners;   // 4 per sprite: bottom-left, bottom-right, top-right, top-left
+
+    size_t size() const { return translationX.size(); }
+    void clear();
+    void reserve(size_t count);
+
+    void push(const SpriteAffine2D& transform,
+              const glm::vec2& uvMin, const glm::vec2& uvMax,
+              const glm::vec4& color, int textureIndex);
+};
+
+// Write 4 vertices per sprite into out, in stream order. out may be mapped
+// GPU memory: every vertex is written exactly once, front to back.
+template <typename Vertex>
+void expandSpriteQuads(const SpriteQuadStream<Vertex>& stream, Vertex* out,
+                       SpriteKernelPath path = detectSpriteKernelPath());
@@ -1,7 +1,10 @@
 #pragma once
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include "glad/glad.h"
+#include "CompressedTexture.hpp"
 
 enum class TextureType {
     TEXTURE_2D,
@@ -9,6 +12,19 @@ enum class TextureType {
     TEXTURE_ARRAY
 };
 
+// Pixels decoded off the GL thread (see ResourceManager::loadAsync).
+// Either pixels or, when a KTX2/DDS file was found, blocks is filled.
+struct TextureImage {
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels{nullptr, nullptr};
+    int width = 0, height = 0, channels = 0;
+
+    bool compressed = false;
+    CompressedTextureData blocks;
+
+    // Levels 1.. of pixels when buildMips() ran; uploads then skip glGenerateMipmap
+    std::vector<std::vector<unsigned char>> mips;
+};
+
 class Texture {
 public:
     Texture(TextureType type);
@@ -17,11 +33,50 @@ public:
     bool loadFromFile(const std::string& filepath);
     void bind(GLenum textureUnit) const;
     GLuint getID() const;
+    TextureType getType() const { return textureType; }
 
     bool loadTexture(const char* path);
     bool loadCubemap(const std::vector<std::string>& faces);
     bool loadTextureArray(const std::vector<std::string>& filePaths);
 
+    // Read and decode an image; no GL, safe on any thread. A pre-compressed
+    // sibling ("x.ktx2" next to "x.png", see findCompressedVariant) the GPU
+    // can sample is read instead when allowCompressed is set.
+    static bool decode(const std::string& filepath, TextureImage& image, bool allowCompressed = true);
+
+    // Decode faces/layers that must share one format: if only some have a
+    // compressed version, all of them are decoded from the source images
+    static bool decodeLayers(const std::vector<std::string>& filepaths, std::vector<TextureImage>& images,
+                             bool allowCompressed = true);
+
+    // Box-filter the mip chain of a decoded image on the CPU (no GL, any
+    // thread), so the upload doesn't have to generate it on the GL thread
+    static void buildMips(TextureImage& image);
+
+    // GL thread: a small checkerboard of the texture's type to draw until
+    // the real pixels are uploaded. The texture name stays the same, so
+    // IDs taken from the placeholder stay valid.
+    void createPlaceholder(int layers = 1);
+    bool upload(const TextureImage& image);
+    bool uploadCubemap(const std::vector<TextureImage>& faces);
+    bool uploadTextureArray(const std::vector<TextureImage>& layers);
+
+    // Streaming versions: storage is allocated now and the pixels follow
+    // through PixelUploadRing within its per-frame budget. Until done(true)
+    // runs the texture is mipmap incomplete and samples black rather than
+    // half-written rows. The texture must outlive the upload. Compressed
+    // images are small and go up at once.
+    void streamUpload(std::shared_ptr<const TextureImage> image, std::function<void(bool)> done);
+    void streamCubemap(std::shared_ptr<const std::vector<TextureImage>> faces, std::function<void(bool)> done);
+    void streamTextureArray(std::shared_ptr<const std::vector<TextureImage>> layers, std::function<void(bool)> done);
+
+    // GL thread: copy every level (and face or layer) of source, a texture
+    // of the same type, size, format and levels, on the GPU
+    // (glCopyImageSubData, GL 4.3). False, and nothing copied, if they
+    // differ. Hot reload swaps new pixels in this way, all at once and
+    // under the same texture name.
+    bool copyLevelsFrom(const Texture& source);
+
     Texture(const Texture&) = delete;
     Texture& operator=(const Texture&) = delete;
 
@@ -29,4 +84,9 @@ private:
     TextureType textureType;
     GLuint textureID;
     void configureParameters();
+
+    // Blocking when done is empty; otherwise streamed, and done gets the result
+    bool uploadImage(const TextureImage& image, std::function<void(bool)> done);
+    bool uploadFaces(const std::vector<TextureImage>& faces, std::function<void(bool)> done);
+    bool uploadLayers(const std::vector<TextureImage>& layers, std::function<void(bool)> done);
 };
\ No newline at end of file
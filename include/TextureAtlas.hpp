@@ -5,11 +5,16 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <functional>
+#include "RectPacker.hpp"
+#include "AtlasFile.hpp"
 
 struct SpriteUV {
     glm::vec2 uv0;  // Bottom-left UV
     glm::vec2 uv1;  // Top-right UV
     glm::vec2 size; // Original size in pixels (for scaling)
+    int page = 0;         // atlas page (texture) holding the sprite
+    bool rotated = false; // stored a quarter turn clockwise; draw with SpriteAffine2D::forRotatedUV()
     
     SpriteUV(glm::vec2 bottomLeft = glm::vec2(0.0f), 
              glm::vec2 topRight = glm::vec2(1.0f),
@@ -17,6 +22,14 @@ struct SpriteUV {
         : uv0(bottomLeft), uv1(topRight), size(pixelSize) {}
 };
 
+// Sprite resolved once by name; indexes flat tables so per-frame lookups don't hash
+struct SpriteHandle {
+    int atlasIndex = -1;  // slot in TextureAtlasManager
+    int uvIndex = -1;     // slot in that atlas's UV table
+
+    bool isValid() const { return atlasIndex >= 0 && uvIndex >= 0; }
+};
+
 class TextureAtlas {
 public:
     TextureAtlas(int width = 1024, int height = 1024);
@@ -31,19 +44,92 @@ public:
     // Get UV coordinates for a sprite
     const SpriteUV* getSpriteUV(const std::string& spriteName) const;
     
-    // Get the atlas texture ID
+    // Index into the UV table, or -1 (valid once the atlas is generated).
+    // Indices follow addSprite order, so frames added in sequence are contiguous.
+    int getSpriteIndex(const std::string& spriteName) const;
+    const SpriteUV& getSpriteUV(int index) const { return uvTable[index]; }
+    int getSpriteCount() const { return static_cast<int>(uvTable.size()); }
+    
+    // Get the atlas texture ID (first page)
     GLuint getTextureID() const { return textureID; }
     
-    // Get atlas dimensions
+    // Sprites that don't fit on one page spill onto more pages of the same size
+    int getPageCount() const { return static_cast<int>(pageTextures.size()); }
+    GLuint getPageTextureID(int page) const { return pageTextures[page]; }
+    
+    // Get atlas dimensions (of one page)
     int getWidth() const { return atlasWidth; }
     int getHeight() const { return atlasHeight; }
     
+    // Let the packer turn sprites a quarter turn for a tighter fit. Off by default:
+    // only the batched paths honor SpriteUV::rotated, animation clips do not.
+    void setAllowRotation(bool allow) { allowRotation = allow; }
+    
+    // Share of the pages' area covered by sprites (padding included), after generation
+    double getOccupancy() const { return occupancy; }
+    
     // Generate the atlas texture (call after adding all sprites)
     bool generateAtlas();
     
+    // Load a file written by tools/atlas_baker instead of adding sprites and
+    // generating: maps the file and uploads its pages and mip levels as they are
+    bool loadFromFile(const std::string& filePath);
+    bool isAtlasGenerated() const { return isGenerated; }
+    
+    // Stamps for cached lookups (never 0 for a live slot). A slot's changes when
+    // it is freed or reused, so a handle resolved to it must be resolved again.
+    // The UV generation changes when any slot's UVs or page texture change
+    // (generate, remove, evict, defragment, repack); inserts leave both alone.
+    unsigned int getSlotGeneration(int index) const;
+    unsigned int getUVGeneration() const { return uvGeneration; }
+    
     // Get all sprite names (for debugging/iteration)
     std::vector<std::string> getSpriteNames() const;
     
+    /*
+     * Dynamic atlases (TextureAtlasManager::createDynamicAtlas) are one page
+     * that takes sprites at any time: addSprite finds a free rect and streams
+     * just that rect through PixelUploadRing, so the name resolves once its
+     * rows are submitted (a later PixelUploadRing::process()). When nothing
+     * fits, the least recently used sprites are evicted; when the free space
+     * is too scattered, live sprites are repacked on the GPU (not while
+     * uploads are queued). UV indices stay stable until a sprite is removed
+     * or evicted.
+     */
+    bool isDynamic() const { return dynamic; }
+    bool removeSprite(const std::string& spriteName);
+    
+    // Record that a sprite was drawn this frame (protects it from eviction)
+    void markUsed(int index) { if (dynamic) lastUsedFrame[index] = currentFrame; }
+    
+    // Frames between building a draw and submitting it (the renderer's pipeline
+    // latency). Sprites used that recently are not evicted, and the texture a
+    // defragment() replaces lives until draws built before the swap are submitted
+    void setFrameLatency(int latency) { frameLatency = latency > 0 ? latency : 0; }
+    
+    // Once per frame: advance the LRU clock, delete textures no pending draw uses
+    // any more, and defragment past the threshold
+    void beginFrame();
+    
+    // See RectPacker::getFragmentation(); defragment() repacks when it's over the threshold
+    double getFragmentation() const;
+    void setDefragmentThreshold(double threshold) { defragmentThreshold = threshold; }
+    bool defragment();
+    size_t getEvictionCount() const { return evictionCount; }
+    
+    /*
+     * Hot reload: give a generated sprite new pixels (RGBA, rows top-down).
+     * Same size writes over its rect. A new size takes a free rect of a
+     * dynamic atlas, or repacks the sprite's page of a static one; other
+     * pages are untouched. Baked atlases can't be changed. The pixels are
+     * streamed like dynamic inserts; a static page's mips are rebuilt when
+     * they land.
+     */
+    bool replaceSprite(const std::string& spriteName, const unsigned char* rgba, int width, int height);
+    
+    // Sprites added from filePath (compared normalized)
+    std::vector<std::string> getSpritesForFile(const std::string& filePath) const;
+    
 private:
     struct SpriteData {
         unsigned char* data;
@@ -54,30 +140,65 @@ private:
         ~SpriteData() { if (allocated && data) delete[] data; }
     };
     
-    struct AtlasNode {
-        int x, y, width, height;
-        bool occupied;
-        std::unique_ptr<AtlasNode> left, right;
-        
-        AtlasNode(int x, int y, int w, int h) 
-            : x(x), y(y), width(w), height(h), occupied(false), left(nullptr), right(nullptr) {}
-    };
-    
     GLuint textureID;
+    std::vector<GLuint> pageTextures;    // pageTextures[0] == textureID
     int atlasWidth, atlasHeight;
-    std::unordered_map<std::string, SpriteUV> spriteUVs;
+    std::vector<SpriteUV> uvTable;
+    std::unordered_map<std::string, int> spriteIndices; // name -> uvTable slot
     std::unordered_map<std::string, std::unique_ptr<SpriteData>> spriteDataMap;
-    std::unique_ptr<AtlasNode> rootNode;
+    std::vector<std::string> spriteOrder; // addSprite order, becomes uvTable order
+    std::vector<PackedRect> placements;   // per uvTable slot, padded (kept for replaceSprite)
+    std::unordered_map<std::string, std::string> spriteFiles; // name -> file added from
+    std::unique_ptr<MappedAtlasFile> bakedFile;   // set when loaded from a baked file
     bool isGenerated;
+    bool allowRotation = false;
+    double occupancy = 0.0;
+    unsigned int slotGeneration;   // every slot of a static atlas
+    unsigned int uvGeneration;
+    
+    // Dynamic atlas state, per uvTable slot (page -1 marks a free slot)
+    bool dynamic = false;
+    std::unique_ptr<RectPacker> dynamicPacker;
+    std::vector<PackedRect> dynamicRects;
+    std::vector<std::string> slotNames;
+    std::vector<unsigned long long> lastUsedFrame;
+    std::vector<unsigned int> slotGenerations;
+    std::vector<bool> slotLanded;         // pixels submitted; the name resolves
+    std::vector<int> freeSlots;
+    unsigned long long currentFrame = 0;
+    int frameLatency = 1;
+    double defragmentThreshold = 0.6;
+    bool releasedSinceDefragment = false;
+    size_t evictionCount = 0;
+    size_t pendingUploads = 0;            // rects queued on PixelUploadRing
+    
+    // Pages replaced by defragment(), deleted once currentFrame passes lastFrame
+    struct RetiredTexture {
+        GLuint texture;
+        unsigned long long lastFrame;
+    };
+    std::vector<RetiredTexture> retiredTextures;
+    
+    friend class TextureAtlasManager;
+    void makeDynamic();
+    int insertDynamicSprite(const std::string& spriteName, const unsigned char* data, int width, int height, int channels);
+    bool evictLeastRecentlyUsed();
+    void releaseSlot(int index);
     
-    // Texture packing algorithm
-    AtlasNode* insertSprite(AtlasNode* node, int width, int height);
+    // Stream image into its padded rect (border cleared) on texture; landed
+    // runs from PixelUploadRing::process() once the rows are submitted
+    void uploadSpriteRect(GLuint texture, const PackedRect& rect, const AtlasSourceImage& image,
+                          std::function<void()> landed = nullptr);
+    bool repackPage(int index, const AtlasSourceImage& image, std::function<void()> landed);
+    void blitRects(GLuint source, GLuint destination, const std::vector<PackedRect>& from,
+                   const std::vector<PackedRect>& to);
     
-    // Pack all sprites into the atlas
+    // Pack all sprites into the atlas pages
     bool packSprites();
     
-    // Generate the final texture
+    // Generate the final page textures
     void generateTexture();
+    GLuint createPageTexture();
 };
 
 class TextureAtlasManager {
@@ -90,18 +211,67 @@ public:
     // Get an existing atlas
     std::shared_ptr<TextureAtlas> getAtlas(const std::string& name);
     
+    // Create a dynamic atlas (see TextureAtlas::isDynamic). Its sprites resolve
+    // by atlas name: resolveSprite(spriteName, name).
+    std::shared_ptr<TextureAtlas> createDynamicAtlas(const std::string& name, int width = 1024, int height = 1024);
+    
+    // Advance every dynamic atlas's LRU clock (once per frame)
+    void beginFrame();
+    
+    // See TextureAtlas::setFrameLatency; applies to existing and later atlases
+    void setFrameLatency(int latency);
+    
+    // Create an atlas from a baked atlas file (see TextureAtlas::loadFromFile)
+    std::shared_ptr<TextureAtlas> loadAtlasFile(const std::string& name, const std::string& filePath);
+    
     // Load a sprite into a specific atlas
     bool loadSpriteToAtlas(const std::string& atlasName, const std::string& spriteName, const std::string& filePath);
     
     // Find which atlas contains a sprite
     std::shared_ptr<TextureAtlas> findAtlasForSprite(const std::string& spriteName);
     
+    // Hot reload: (atlas, sprite) pairs added from filePath
+    std::vector<std::pair<std::shared_ptr<TextureAtlas>, std::string>> findSpritesForFile(const std::string& filePath);
+    
+    // Resolve a sprite name to a handle (hashes; do this once, not per frame).
+    // An empty atlasName falls back to the atlas the sprite was loaded into.
+    SpriteHandle resolveSprite(const std::string& spriteName, const std::string& atlasName = "");
+    
+    // Handle lookups are plain array indexing; the handle must be valid
+    const SpriteUV& getSpriteUV(const SpriteHandle& handle) const {
+        return atlasList[handle.atlasIndex]->getSpriteUV(handle.uvIndex);
+    }
+    GLuint getTextureID(const SpriteHandle& handle) const {
+        const TextureAtlas& atlas = *atlasList[handle.atlasIndex];
+        return atlas.getPageTextureID(atlas.getSpriteUV(handle.uvIndex).page);
+    }
+    void markUsed(const SpriteHandle& handle) {
+        atlasList[handle.atlasIndex]->markUsed(handle.uvIndex);
+    }
+    
+    // Bumped whenever an atlas is created or generated or a sprite is inserted:
+    // names that didn't resolve under an older generation may resolve now
+    unsigned int getGeneration() const;
+    
+    // A resolved handle stays current while its slot's generation is unchanged
+    // (see TextureAtlas::getSlotGeneration); 0 for an invalid handle
+    unsigned int getHandleGeneration(const SpriteHandle& handle) const {
+        if (!handle.isValid() || handle.atlasIndex >= static_cast<int>(atlasList.size())) return 0;
+        return atlasList[handle.atlasIndex]->getSlotGeneration(handle.uvIndex);
+    }
+    
+    // Atlases by slot (the atlasIndex of a SpriteHandle)
+    int getAtlasCount() const { return static_cast<int>(atlasList.size()); }
+    std::shared_ptr<TextureAtlas> getAtlasByIndex(int index) const { return atlasList[index]; }
+    
     // Generate all atlases
     void generateAllAtlases();
     
 private:
-    std::unordered_map<std::string, std::shared_ptr<TextureAtlas>> atlases;
+    std::vector<std::shared_ptr<TextureAtlas>> atlasList;
+    std::unordered_map<std::string, int> atlases; // atlas name -> atlasList slot
     std::unordered_map<std::string, std::string> spriteToAtlasMap; // sprite name -> atlas name
+    int frameLatency = 1;
     
     TextureAtlasManager() = default;
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed set of worker threads for CPU work that must not block the frame
+ * (file reads, image decodes, glyph rasterization).
+ *
+ * Tasks never touch GL: anything that has to reach the GL context is handed
+ * back to the GL thread through GLUploadQueue.
+ */
+class ThreadPool {
+public:
+    // Shared pool, one worker per core minus the GL thread (at least one)
+    static ThreadPool& getInstance();
+
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a task; the future holds its result (or exception)
+    template <typename Function>
+    auto submit(Function&& function) -> std::future<decltype(function())> {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    size_t getThreadCount() const { return workers.size(); }
+    size_t getQueuedCount() const;
+
+    // Finish the queued tasks and join the workers; later submits run inline
+    void shutdown();
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    mutable std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+};
@@ -12,6 +12,7 @@ public:
     UIRenderer();
     void render(const std::vector<size_t>& uiEntities, ECS* ecs);
     void renderText(const std::string& text, const std::string& fontKey, float x, float y, float scale, const glm::vec3& color);
+    void renderText(const std::string& text, const Font& font, float x, float y, float scale, const glm::vec3& color);
 
 private:
     GLuint textVAO, quadVAO;
@@ -19,10 +20,8 @@ private:
     GLuint textEBO, quadEBO;
     std::shared_ptr<Shader> uiShader;
     std::shared_ptr<Shader> textShader;
-    glm::mat4 projectionMatrix;
-    glm::mat4 viewMatrix;
-    int windowWidth, windowHeight;
-    void setupMatrices();
+    UniformHandle uiModel, uiColor;
+    UniformHandle textColor;
     void initializeQuadBuffers();
     void initializeTextBuffers();
     float calculateTextWidth(const std::string& text, const std::shared_ptr<Font>& font, float scale);
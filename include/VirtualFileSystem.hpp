@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PackFile.hpp"
+
+// A file's bytes: a view into a mounted pack when the file is stored there
+// uncompressed (valid until the pack is unmounted), otherwise memory of its own
+class FileBuffer {
+public:
+    const unsigned char* data() const { return view ? view : owned.data(); }
+    size_t size() const { return view ? viewSize : owned.size(); }
+    bool isMapped() const { return view != nullptr; }
+
+private:
+    const unsigned char* view = nullptr;
+    size_t viewSize = 0;
+    std::vector<unsigned char> owned;
+
+    friend class VirtualFileSystem;
+};
+
+/*
+ * One place every loader reads asset files from.
+ *
+ * Mounted packs (see PackFile.hpp) are each a single read-only mapping:
+ * opening a file is a binary search of the pack's table and reading it is a
+ * page fault, or an LZ4 decode for compressed files. Paths not in any pack
+ * are read from disk as before, so loose files keep working without a pack.
+ * Packs mounted later take precedence.
+ *
+ * Mount and unmount between loads (not while workers read); read and exists
+ * are safe on any thread.
+ */
+class VirtualFileSystem {
+public:
+    static VirtualFileSystem& getInstance();
+
+    // Map a pack; false with a message on std::cerr if it is missing or invalid
+    bool mount(const std::string& packPath);
+    void unmountAll();
+    size_t getMountedCount() const { return packs.size(); }
+
+    // Read at most limit bytes of path, from a pack if one has it
+    bool read(const std::string& path, FileBuffer& buffer,
+              size_t limit = std::numeric_limits<size_t>::max()) const;
+    bool exists(const std::string& path) const;
+    bool isPacked(const std::string& path) const;
+
+    // Ask the OS to page in every packed file under a directory ("assets/fonts")
+    // ahead of the loads; they are one contiguous region of the pack
+    void prefetch(const std::string& directory) const;
+
+    VirtualFileSystem(const VirtualFileSystem&) = delete;
+    VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+
+private:
+    struct MountedPack {
+        std::string path;
+        unsigned char* data = nullptr;
+        size_t size = 0;
+
+        ~MountedPack();
+        const PackFileHeader& header() const { return *reinterpret_cast<const PackFileHeader*>(data); }
+        const PackFileEntry* entries() const {
+            return reinterpret_cast<const PackFileEntry*>(data + header().entryOffset);
+        }
+        const char* name(const PackFileEntry& entry) const {
+            return reinterpret_cast<const char*>(data + header().nameOffset + entry.nameOffset);
+        }
+        const PackFileEntry* find(const std::string& normalizedPath) const;
+    };
+
+    std::vector<std::unique_ptr<MountedPack>> packs;   // searched last to first
+
+    VirtualFileSystem() = default;
+
+    const PackFileEntry* find(const std::string& path, const MountedPack*& pack) const;
+};
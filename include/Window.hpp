@@ -11,7 +11,7 @@
 class Window {
 public:
     static std::vector<InputEvent> eventBuffer;
-    Window(int width, int height);
+    Window(int width, int height, bool vsync = true);
     ~Window();
 
     void update();
@@ -23,6 +23,10 @@ public:
     void swapBuffers();
     GLFWwindow* getWindow();
     
+    // Benchmarks turn this off so frame times are not capped at the refresh rate
+    void setVSync(bool enabled);
+    bool isVSyncEnabled() const;
+    
     void processInput();
     
     int getWidth() const;
@@ -44,6 +48,7 @@ private:
 
     const char* title;
     GLFWwindow* window;
+    bool vsyncEnabled;
 
 void handleKeyEvent(int key, int action, int mods) {
     // If it's a repeat event, we don't want to add a new KEY_PRESS event to the buffer.
@@ -1,7 +1,11 @@
 #pragma once
 #include <vector>
+#include <unordered_map>
 #include "ECS/Archetypes.hpp"
 #include "ECS/Components.hpp"
+#include "SpriteAnimation.hpp"
+#include "GLStateCache.hpp"
+#include "ItemRegistry.hpp"
 #include <cstdlib>   // for rand
 #include <ctime>     // for time
 #include <glm/glm.hpp>
@@ -198,46 +202,176 @@ inline float fractalNoise(float x, float y, int octaves, float persistence, floa
 }
 
 
-inline void generateChunkGeometry(ChunkComponent& chunk, std::vector<std::vector<ChunkData>> map,
-                               std::vector<GLfloat>& vertexData,
-                               std::vector<GLint>& indices)
+// Neighbour across side i of a hex (hexagonVertices corner i to corner i + 1), as a
+// (q, r) step for even and odd q. Odd columns sit half a row further along +z (see
+// getTilePosition)
+inline const int hexSideNeighbours[2][6][2] = {
+    { {1, 0}, {0, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} },
+    { {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {0, -1}, {1, 0} }
+};
+
+// Loaded chunks around the one being meshed, indexed [dx + 1][dz + 1][dy + 1] by
+// chunkIndex offset; null where there is none. Faces on a border with no chunk
+// behind it are kept until one loads (see ChunkSystem::loadChunk)
+struct ChunkNeighbours {
+    const ChunkComponent* chunks[3][3][3] = {};
+};
+
+// Whether the tile at (q, r, layer) is solid; coordinates past the edge of the
+// chunk are looked up in its neighbours
+inline bool isTileSolid(const ChunkComponent& chunk, const ChunkNeighbours& neighbours, int q, int r, int layer) {
+    int dx = q < 0 ? -1 : (q >= chunk.rows ? 1 : 0);
+    int dz = r < 0 ? -1 : (r >= chunk.columns ? 1 : 0);
+    int dy = layer < 0 ? -1 : (layer >= chunk.depth ? 1 : 0);
+    if (dx == 0 && dz == 0 && dy == 0) return chunk.occupancy[chunk.indexFrom3D(q, r, layer)] == 1;
+
+    const ChunkComponent* other = neighbours.chunks[dx + 1][dz + 1][dy + 1];
+    if (!other || other->occupancy.empty()) return false;
+    if (dx != 0) q += dx > 0 ? -chunk.rows : other->rows;
+    if (dz != 0) r += dz > 0 ? -chunk.columns : other->columns;
+    if (dy != 0) layer += dy > 0 ? -chunk.depth : other->depth;
+    if (q < 0 || q >= other->rows || r < 0 || r >= other->columns || layer < 0 || layer >= other->depth) return false;
+    return other->occupancy[other->indexFrom3D(q, r, layer)] == 1;
+}
+
+// Hex corners on a lattice of quarter radii along x and half rows along z, relative
+// to the tile's (3q, 2r + q % 2). Exact, so hexes meeting at a corner agree on it
+inline const int hexCornerLattice[6][2] = {
+    {2, 0}, {1, 1}, {-1, 1}, {-2, 0}, {-1, -1}, {1, -1}
+};
+
+// Append the faces of every occupied tile that are not against another solid tile.
+// With mergeFaces, runs of side faces of one texture up a column become one tall
+// quad with the texture repeated once per layer, and tops and bottoms at the same
+// height and texture share their corner vertices. Without it, each face has
+// vertices of its own
+inline void emitChunkFaces(const ChunkComponent& chunk, const ChunkNeighbours& neighbours,
+                           std::vector<GLfloat>& vertexData, std::vector<GLint>& indices,
+                           bool mergeFaces = true)
 {
-    vertexData.clear();
-    indices.clear();
-    
-    float tileHeight = chunk.hexRadius / 2.0f; // Height of the hex tile
-    
-    auto pushVertex = [&](const glm::vec3& pos, const glm::vec2& texCoord, const float texIndex) {
-        //std::cout << "\tVertex:" << pos.x << " "<<  pos.y << " " << pos.z << " \n";
+    float tileHeight = chunk.hexRadius / 2.0f;
+    float xOffset = chunk.hexRadius * 3.0f / 2.0f;
+    float yOffset = chunk.hexRadius * sqrt(3.0f) * 0.5f;
+    glm::vec3 origin(chunk.chunkIndex[0] * (chunk.columns * xOffset / 2.0f),
+                     chunk.chunkIndex[2] * (chunk.depth * tileHeight),
+                     chunk.chunkIndex[1] * (chunk.rows * yOffset));
+
+    auto pushVertex = [&](int x, int z, int height, const glm::vec2& texCoord, float texIndex) {
+        glm::vec3 pos = origin + glm::vec3(x * chunk.hexRadius / 4.0f, height * tileHeight, z * yOffset / 2.0f);
         vertexData.push_back(pos.x);
         vertexData.push_back(pos.y);
         vertexData.push_back(pos.z);
         vertexData.push_back(texCoord.x);
         vertexData.push_back(texCoord.y);
         vertexData.push_back(texIndex);
+        return static_cast<GLint>(vertexData.size() / 6 - 1);
     };
 
-    glm::vec2 texCoords[6] = {
-        {0.5f, 1.0f}, {1.0f, 0.75f}, {1.0f, 0.25f},
-        {0.5f, 0.0f}, {0.0f, 0.25f}, {0.0f, 0.75f}
+    // Tops and bottoms are textured by position in the chunk, one texture per hex
+    // across as before, so a corner's UV is the same for every hex around it
+    std::unordered_map<uint64_t, GLint> sharedCorners;
+    auto horizontalVertex = [&](int x, int z, int height, int texIndex) {
+        uint64_t key = uint64_t(uint16_t(x)) | uint64_t(uint16_t(z)) << 16
+                     | uint64_t(uint16_t(height)) << 32 | uint64_t(uint16_t(texIndex)) << 48;
+        if (mergeFaces) {
+            auto it = sharedCorners.find(key);
+            if (it != sharedCorners.end()) return it->second;
+        }
+        glm::vec2 texCoord(z / 2.0f, x / 4.0f);
+        GLint index = pushVertex(x, z, height, texCoord, static_cast<float>(texIndex));
+        if (mergeFaces) sharedCorners.emplace(key, index);
+        return index;
     };
 
-    glm::vec2 sideTexCoords[6] = {
-        {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}, {0.0f, 0.0f},  // Square for each side face
-    };
+    for (int r = 0; r < chunk.columns; ++r) {
+        for (int q = 0; q < chunk.rows; ++q) {
+            int x = 3 * q;
+            int z = 2 * r + (q & 1);
+            int corners[6][2];
+            for (int i = 0; i < 6; ++i) {
+                corners[i][0] = x + hexCornerLattice[i][0];
+                corners[i][1] = z + hexCornerLattice[i][1];
+            }
+
+            // Top and Bottom Faces, fanned from corner 0
+            for (int layer = 0; layer < chunk.depth; ++layer) {
+                int tileIndex = chunk.indexFrom3D(q, r, layer);
+                if (chunk.occupancy[tileIndex] != 1) continue;
+                int texIndex = chunk.tiles[tileIndex].texIndex;
+
+                if (!isTileSolid(chunk, neighbours, q, r, layer + 1)) {
+                    GLint top[6];
+                    for (int i = 0; i < 6; ++i) top[i] = horizontalVertex(corners[i][0], corners[i][1], layer + 1, texIndex);
+                    for (int i = 1; i < 5; ++i) {
+                        indices.push_back(top[i + 1]);
+                        indices.push_back(top[i]);
+                        indices.push_back(top[0]);
+                    }
+                }
+                if (!isTileSolid(chunk, neighbours, q, r, layer - 1)) {
+                    GLint bottom[6];
+                    for (int i = 0; i < 6; ++i) bottom[i] = horizontalVertex(corners[i][0], corners[i][1], layer, texIndex);
+                    for (int i = 1; i < 5; ++i) {
+                        indices.push_back(bottom[0]);
+                        indices.push_back(bottom[i]);
+                        indices.push_back(bottom[i + 1]);
+                    }
+                }
+            }
 
+            // Side Faces, a run of exposed layers of one texture at a time
+            for (int i = 0; i < 6; ++i) {
+                const int* step = hexSideNeighbours[q & 1][i];
+                int next = (i + 1) % 6;
+                auto sideExposed = [&](int layer) {
+                    return chunk.occupancy[chunk.indexFrom3D(q, r, layer)] == 1
+                        && !isTileSolid(chunk, neighbours, q + step[0], r + step[1], layer);
+                };
+
+                for (int layer = 0; layer < chunk.depth;) {
+                    if (!sideExposed(layer)) {
+                        ++layer;
+                        continue;
+                    }
+                    int texIndex = chunk.tiles[chunk.indexFrom3D(q, r, layer)].texIndex;
+                    int end = layer + 1;
+                    while (mergeFaces && end < chunk.depth && sideExposed(end)
+                           && chunk.tiles[chunk.indexFrom3D(q, r, end)].texIndex == texIndex) {
+                        ++end;
+                    }
 
+                    float repeats = static_cast<float>(end - layer);
+                    GLint base = pushVertex(corners[i][0], corners[i][1], end, {0.0f, repeats}, texIndex);
+                    pushVertex(corners[next][0], corners[next][1], end, {1.0f, repeats}, texIndex);
+                    pushVertex(corners[next][0], corners[next][1], layer, {1.0f, 0.0f}, texIndex);
+                    pushVertex(corners[i][0], corners[i][1], layer, {0.0f, 0.0f}, texIndex);
+                    indices.push_back(base);
+                    indices.push_back(base + 1);
+                    indices.push_back(base + 2);
+                    indices.push_back(base);
+                    indices.push_back(base + 2);
+                    indices.push_back(base + 3);
+                    layer = end;
+                }
+            }
+        }
+    }
+}
+
+inline void generateChunkGeometry(ChunkComponent& chunk, std::vector<std::vector<ChunkData>> map,
+                               std::vector<GLfloat>& vertexData,
+                               std::vector<GLint>& indices,
+                               const ChunkNeighbours& neighbours = ChunkNeighbours())
+{
+    vertexData.clear();
+    indices.clear();
+
+    // Occupancy for the whole chunk first: whether a face shows depends on the tiles around it
     for (int layer = 0; layer < chunk.depth; ++layer) {
         for (int r = 0; r < chunk.columns; ++r) {
             for (int q = 0; q < chunk.rows; ++q) {
                 int tileIndex = chunk.indexFrom3D(q, r, layer);
                 HexTile& tile = chunk.tiles[tileIndex];
-                glm::vec3 center = getTilePosition(q, r, chunk.hexRadius);
-                
-                
-                float xOffset = chunk.hexRadius * 3.0f / 2.0f; 
-                float yOffset = chunk.hexRadius * sqrt(3.0f) * 0.5f;
-                
                 // Generate tile type
                 float tileValue = generateNoise(r, q, 5, 0.2f);
                 int idx;
@@ -245,16 +379,13 @@ inline void generateChunkGeometry(ChunkComponent& chunk, std::vector<std::vector
                     idx = 0;
                 }
                 else if (tileValue < 0.7f) {
-                    idx = std::min(1, (int)chunk.palette.size());
+                    idx = std::min(1, (int)chunk.palette.size() - 1);
                 }
                 else{
-                    idx = std::min(2, (int)chunk.palette.size());
+                    idx = std::min(2, (int)chunk.palette.size() - 1);
                 }
 
                 tile.texIndex = getTextureIndex(chunk.palette[idx]);
-                center.x += (float)chunk.chunkIndex[0] * ((float) (chunk.columns) * xOffset / 2.0f);
-                center.z += (float)chunk.chunkIndex[1] * ((float) (chunk.rows) * yOffset);
-                center.y += (float)chunk.chunkIndex[2] * (float)chunk.depth * tileHeight;
                 
                 //generate heightvalue
                 
@@ -307,238 +438,29 @@ inline void generateChunkGeometry(ChunkComponent& chunk, std::vector<std::vector
                         chunk.occupancy[tileIndex] = 1;                        
                     }
                 else chunk.occupancy[tileIndex] = 0;
-
-
-                // Generate Chunk Geometry
-                if(chunk.occupancy[tileIndex] == 1){
-                    GLint baseIndex = static_cast<GLint>(vertexData.size() / 6);
-
-                    float hz = tileHeight * (layer + 1);
-                    float hz2 = (tileHeight * layer);
-                    // std::cout << "Tile at :" << q << " " << r << " " << layer <<"\n";
-                    // std::cout << "\tCenter:" << center.x << " " << hz2 + (hz - hz2) / 2.0f << " " << center.z <<"\n";
-                    // Top Face
-                    glm::vec3 topCenter = center + glm::vec3(0.0f, hz, 0.0f);
-                    pushVertex(topCenter, {0.5f, 0.5f}, static_cast<float>(tile.texIndex)); // Center UV
-
-                    std::vector<GLint> topPerimeterIndices;
-                    for (int i = 0; i < 6; ++i) {
-                        float hx = hexagonVertices[i * 2] * chunk.hexRadius;
-                        float hy = hexagonVertices[i * 2 + 1] * chunk.hexRadius;
-
-                        glm::vec3 pos = center + glm::vec3(hx, hz, hy);
-                        pushVertex(pos, texCoords[i], static_cast<float>(tile.texIndex));
-                        topPerimeterIndices.push_back(static_cast<GLint>(vertexData.size() / 6 - 1));
-                    }
-                
-                    for (int i = 0; i < 6; ++i) {
-                        indices.push_back(topPerimeterIndices[(i + 1) % 6]);
-                        indices.push_back(topPerimeterIndices[i]);
-                        indices.push_back(baseIndex);
-                        
-                        
-                    }
-
-                    // Bottom Face
-                    GLint bottomBase = static_cast<GLint>(vertexData.size() /6);
-                    glm::vec3 bottomCenter = center + glm::vec3(0.0f, hz2, 0.0f);
-                    pushVertex(bottomCenter, {0.5f, 0.5f}, static_cast<float>(tile.texIndex));
-
-                    std::vector<GLint> bottomPerimeterIndices;
-                    for (int i = 0; i < 6; ++i) {
-                        float hx = hexagonVertices[i * 2] * chunk.hexRadius;
-                        float hy = hexagonVertices[i * 2 + 1] * chunk.hexRadius;
-                        glm::vec3 pos = center + glm::vec3(hx, hz2, hy);
-
-                        pushVertex(pos, texCoords[i], static_cast<float>(tile.texIndex));
-                        bottomPerimeterIndices.push_back(static_cast<GLint>(vertexData.size() / 6 - 1));
-                    }
-
-                    for (int i = 0; i < 6; ++i) {
-                        indices.push_back(bottomBase);
-                        indices.push_back(bottomPerimeterIndices[i]);
-                        indices.push_back(bottomPerimeterIndices[(i + 1) % 6]);
-                        
-                        
-
-                    }
-
-                    // Side Faces
-                    std::vector<GLint> sideTopIndices(6), sideBottomIndices(6);
-                    for (int i = 0; i < 6; ++i) {
-                        float hx = hexagonVertices[i * 2] * chunk.hexRadius;
-                        float hy = hexagonVertices[i * 2 + 1] * chunk.hexRadius;
-
-                        // Top and bottom positions for the side face
-                        glm::vec3 posTop = center + glm::vec3(hx, hz, hy);
-                        glm::vec3 posBottom = center + glm::vec3(hx, hz2, hy);
-
-                        // Assign unique texture coordinates for top and bottom faces
-                        glm::vec2 texCoordTop = sideTexCoords[i % 4];    // Use one of the four tex coordinates for the top
-                        glm::vec2 texCoordBottom = sideTexCoords[(i + 2) % 4]; // Use one of the four tex coordinates for the bottom
-
-                        pushVertex(posTop, texCoordTop, static_cast<float>(tile.texIndex));
-                        sideTopIndices[i] = static_cast<GLint>(vertexData.size() / 6 - 1);
-                        pushVertex(posBottom, texCoordBottom, static_cast<float>(tile.texIndex));
-                        sideBottomIndices[i] = static_cast<GLint>(vertexData.size() / 6 - 1);
-                    }
-
-                    // Create the side faces using the new texture coordinates
-                    for (int i = 0; i < 6; ++i) {
-                        int next = (i + 1) % 6;
-                        GLint v0 = sideTopIndices[i];
-                        GLint v1 = sideTopIndices[next];
-                        GLint v2 = sideBottomIndices[next];
-                        GLint v3 = sideBottomIndices[i];
-                        indices.push_back(v0);
-                        indices.push_back(v1);
-                        indices.push_back(v2);
-                        indices.push_back(v0);
-                        indices.push_back(v2);
-                        indices.push_back(v3);
-
-
-                    }
-                
-                }
             }
         }
     }
+
+    emitChunkFaces(chunk, neighbours, vertexData, indices);
 }
 
 
 inline void updateChunkGeometry(ChunkComponent& chunk, RenderableComponent& renderable,
                                 std::vector<GLfloat>& vertexData,
-                                std::vector<GLint>& indices)
+                                std::vector<GLint>& indices,
+                                const ChunkNeighbours& neighbours = ChunkNeighbours())
 {
     vertexData.clear();
     indices.clear();
-    
-    float tileHeight = chunk.hexRadius / 2.0f;
-    float xOffset = chunk.hexRadius * 3.0f / 2.0f; 
-    float yOffset = chunk.hexRadius * sqrt(3.0f) * 0.5f;
-
-    auto pushVertex = [&](const glm::vec3& pos, const glm::vec2& texCoord, float texIndex) {
-        vertexData.push_back(pos.x);
-        vertexData.push_back(pos.y);
-        vertexData.push_back(pos.z);
-        vertexData.push_back(texCoord.x);
-        vertexData.push_back(texCoord.y);
-        vertexData.push_back(texIndex);
-    };
-
-    glm::vec2 texCoords[6] = {
-        {0.5f, 1.0f}, {1.0f, 0.75f}, {1.0f, 0.25f},
-        {0.5f, 0.0f}, {0.0f, 0.25f}, {0.0f, 0.75f}
-    };
-
-    glm::vec2 sideTexCoords[4] = {
-        {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}, {0.0f, 0.0f}
-    };
-
-    for (int layer = 0; layer < chunk.depth; ++layer) {
-        for (int r = 0; r < chunk.columns; ++r) {
-            for (int q = 0; q < chunk.rows; ++q) {
-                int tileIndex = chunk.indexFrom3D(q, r, layer);
-                if (chunk.occupancy[tileIndex] != 1) continue;
-
-                HexTile& tile = chunk.tiles[tileIndex];
-                glm::vec3 center = getTilePosition(q, r, chunk.hexRadius);
-
-                center.x += chunk.chunkIndex[0] * (chunk.columns * xOffset / 2.0f);
-                center.z += chunk.chunkIndex[1] * (chunk.rows * yOffset);
-                center.y += chunk.chunkIndex[2] * (chunk.depth * tileHeight);
-
-                float hz = tileHeight * (layer + 1);
-                float hz2 = tileHeight * layer;
-
-                GLint baseIndex = static_cast<GLint>(vertexData.size() / 6);
+    emitChunkFaces(chunk, neighbours, vertexData, indices);
 
-                // Top Face
-                glm::vec3 topCenter = center + glm::vec3(0.0f, hz, 0.0f);
-                pushVertex(topCenter, {0.5f, 0.5f}, tile.texIndex);
-
-                std::vector<GLint> topPerimeter;
-                for (int i = 0; i < 6; ++i) {
-                    float hx = hexagonVertices[i * 2] * chunk.hexRadius;
-                    float hy = hexagonVertices[i * 2 + 1] * chunk.hexRadius;
-                    glm::vec3 pos = center + glm::vec3(hx, hz, hy);
-                    pushVertex(pos, texCoords[i], tile.texIndex);
-                    topPerimeter.push_back(static_cast<GLint>(vertexData.size() / 6 - 1));
-                }
-
-                for (int i = 0; i < 6; ++i) {
-                    indices.push_back(topPerimeter[(i + 1) % 6]);
-                    indices.push_back(topPerimeter[i]);
-                    indices.push_back(baseIndex);
-                    
-
-                }
-
-                // Bottom Face
-                GLint bottomBase = static_cast<GLint>(vertexData.size() / 6);
-                glm::vec3 bottomCenter = center + glm::vec3(0.0f, hz2, 0.0f);
-                pushVertex(bottomCenter, {0.5f, 0.5f}, tile.texIndex);
-
-                std::vector<GLint> bottomPerimeter;
-                for (int i = 0; i < 6; ++i) {
-                    float hx = hexagonVertices[i * 2] * chunk.hexRadius;
-                    float hy = hexagonVertices[i * 2 + 1] * chunk.hexRadius;
-                    glm::vec3 pos = center + glm::vec3(hx, hz2, hy);
-                    pushVertex(pos, texCoords[i], tile.texIndex);
-                    bottomPerimeter.push_back(static_cast<GLint>(vertexData.size() / 6 - 1));
-                }
-
-                for (int i = 0; i < 6; ++i) {
-                    
-                    indices.push_back(bottomBase);
-                    indices.push_back(bottomPerimeter[i]);
-                    indices.push_back(bottomPerimeter[(i + 1) % 6]);
-
-                }
-
-                // Side Faces
-                std::vector<GLint> sideTop(6), sideBottom(6);
-                for (int i = 0; i < 6; ++i) {
-                    float hx = hexagonVertices[i * 2] * chunk.hexRadius;
-                    float hy = hexagonVertices[i * 2 + 1] * chunk.hexRadius;
-
-                    glm::vec3 posTop = center + glm::vec3(hx, hz, hy);
-                    glm::vec3 posBottom = center + glm::vec3(hx, hz2, hy);
-
-                    glm::vec2 texCoordTop = sideTexCoords[i % 4];
-                    glm::vec2 texCoordBottom = sideTexCoords[(i + 2) % 4];
-
-                    pushVertex(posTop, texCoordTop, tile.texIndex);
-                    sideTop[i] = static_cast<GLint>(vertexData.size() / 6 - 1);
-                    pushVertex(posBottom, texCoordBottom, tile.texIndex);
-                    sideBottom[i] = static_cast<GLint>(vertexData.size() / 6 - 1);
-                }
-
-                for (int i = 0; i < 6; ++i) {
-                    int next = (i + 1) % 6;
-                    GLint v0 = sideTop[i];
-                    GLint v1 = sideTop[next];
-                    GLint v2 = sideBottom[next];
-                    GLint v3 = sideBottom[i];
-
-                    indices.push_back(v0);
-                    indices.push_back(v1);
-                    indices.push_back(v2);
-                    indices.push_back(v0);
-                    indices.push_back(v2);
-                    indices.push_back(v3);
-
-
-                }
-            }
-        }
-    }
-
-    glBindBuffer(GL_ARRAY_BUFFER, renderable.VBO);
+    // The element buffer binding is VAO state; bind ours so another VAO's is not replaced
+    GLStateCache::getInstance().bindVertexArray(renderable.VAO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, renderable.VBO);
     glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(GLfloat), vertexData.data(), GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderable.EBO);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderable.EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLint), indices.data(), GL_STATIC_DRAW);
 
     renderable.vertexCount = indices.size();
@@ -555,17 +477,17 @@ inline void initializeSkyboxRenderable(RenderableComponent& renderableComponent,
         glGenBuffers(1, &renderableComponent.VBO);
     }
 
-    glBindVertexArray(renderableComponent.VAO);
+    GLStateCache::getInstance().bindVertexArray(renderableComponent.VAO);
 
     // Bind and upload vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, renderableComponent.VBO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, renderableComponent.VBO);
     glBufferData(GL_ARRAY_BUFFER, skybox.skyboxVertices.size() * sizeof(GLfloat), skybox.skyboxVertices.data(), GL_STATIC_DRAW);
 
     // Configure vertex attributes
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindVertexArray(0);
 
     // Assign the shader
     renderableComponent.shader = ResourceManager<Shader>::getInstance().get(skybox.skyboxShader);
@@ -575,7 +497,8 @@ inline void initializeSkyboxRenderable(RenderableComponent& renderableComponent,
     renderableComponent.textureID = ResourceManager<Texture>::getInstance().get(skybox.cubemapId)->getID();
 }
 
-inline size_t addChunk(ECS* ecs, std::vector<std::vector<ChunkData>> map, ChunkComponent& chunk){
+inline size_t addChunk(ECS* ecs, std::vector<std::vector<ChunkData>> map, ChunkComponent& chunk,
+                       const ChunkNeighbours& neighbours = ChunkNeighbours()){
     auto startingChunk = ecs -> createEntity();
     ecs -> assignArchetype(startingChunk, {typeid(RenderableComponent).hash_code(), typeid(TransformComponent).hash_code()});
     ecs -> assignArchetype(startingChunk, dungeonRoomArchetype);
@@ -601,19 +524,19 @@ inline size_t addChunk(ECS* ecs, std::vector<std::vector<ChunkData>> map, ChunkC
     }
     chunkRenderable.textureID = ResourceManager<Texture>::getInstance().get("chunkArray") -> getID();
     
-    generateChunkGeometry(chunk, map, vertices, indices);
+    generateChunkGeometry(chunk, map, vertices, indices, neighbours);
                     
     // Generate buffers
     glGenVertexArrays(1, &chunkRenderable.VAO);
     glGenBuffers(1, &chunkRenderable.VBO);
     glGenBuffers(1, &chunkRenderable.EBO);
     // Bind and fill the VAO/VBO/EBO
-    glBindVertexArray(chunkRenderable.VAO);
+    GLStateCache::getInstance().bindVertexArray(chunkRenderable.VAO);
     // Vertex Buffer: upload vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, chunkRenderable.VBO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, chunkRenderable.VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
     // Element Buffer: upload index data
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunkRenderable.EBO);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunkRenderable.EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLint), indices.data(), GL_STATIC_DRAW);
     // Setup vertex attributes
     glEnableVertexAttribArray(0); // Position
@@ -626,7 +549,7 @@ inline size_t addChunk(ECS* ecs, std::vector<std::vector<ChunkData>> map, ChunkC
     glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(5 * sizeof(GLfloat)));
     
     // Unbind VAO
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindVertexArray(0);
     // Save the total index count in the component (for glDrawElements)
     chunkRenderable.vertexCount = indices.size();
     
@@ -654,21 +577,21 @@ inline void initializeRenderableComponent(
         glGenBuffers(1, &renderableComponent.EBO);
     }
 
-    glBindVertexArray(renderableComponent.VAO);
+    GLStateCache::getInstance().bindVertexArray(renderableComponent.VAO);
 
     // Bind and upload vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, renderableComponent.VBO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, renderableComponent.VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
 
     // Bind and upload index data
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderableComponent.EBO);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderableComponent.EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 
     // Configure vertex attributes
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindVertexArray(0);
 
     // Assign the shader
     renderableComponent.shader = ResourceManager<Shader>::getInstance().get(shaderCode);
@@ -679,8 +602,8 @@ inline void initializeRenderableComponent(
 }
 
 inline void cleanupRenderableComponent(RenderableComponent& renderableComponent) {
-        glDeleteVertexArrays(1, &renderableComponent.VAO);
-        glDeleteBuffers(1, &renderableComponent.VBO);
+        GLStateCache::getInstance().deleteVertexArrays(1, &renderableComponent.VAO);
+        GLStateCache::getInstance().deleteBuffers(1, &renderableComponent.VBO);
         renderableComponent.VAO = 0;
         renderableComponent.VBO = 0;
     }
@@ -736,12 +659,12 @@ inline void initializePlayerRenderable(RenderableComponent& renderableComponent)
     glGenBuffers(1, &renderableComponent.VBO);
     glGenBuffers(1, &renderableComponent.EBO);
     // Bind and fill the VAO/VBO/EBO
-    glBindVertexArray(renderableComponent.VAO);
+    GLStateCache::getInstance().bindVertexArray(renderableComponent.VAO);
     // Vertex Buffer: upload vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, renderableComponent.VBO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, renderableComponent.VBO);
     glBufferData(GL_ARRAY_BUFFER, playerVertices.size() * sizeof(GLfloat), playerVertices.data(), GL_STATIC_DRAW);
     // Element Buffer: upload index data
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderableComponent.EBO);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderableComponent.EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, playerIndices.size() * sizeof(GLint), playerIndices.data(), GL_STATIC_DRAW);
     // Setup vertex attributes
     glEnableVertexAttribArray(0); // Position
@@ -751,7 +674,7 @@ inline void initializePlayerRenderable(RenderableComponent& renderableComponent)
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
 
     // Unbind VAO
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindVertexArray(0);
     // Save the total index count in the component (for glDrawElements)
     renderableComponent.vertexCount = playerIndices.size();
 }
@@ -889,7 +812,7 @@ inline size_t addNPC(ECS* ecs, glm::vec3 startingPosition, std::string modelID,
     RenderableComponent npcRenderable;
     SkeletonComponent npcSkeleton;
     AnimationComponent npcAnimation;
-    npcAnimation.currentAnimation = "Idle_01";
+    npcAnimation.clipId = SpriteAnimationLibrary::getInstance().findClip("Idle_01");
     NPCComponent npcComponent;
     npcComponent.name = name;
     npcComponent.level = level;
@@ -1171,24 +1094,6 @@ inline InventoryMenuElements createInventoryMenu(ECS& ecs, InventoryComponent& i
     return ids;
 }
 
-inline void uploadLightsToShader2D(const std::vector<LightSourceComponent2D>& lights, GLuint shaderProgram) {
-    glUseProgram(shaderProgram);
-
-    GLint numLightsLoc = glGetUniformLocation(shaderProgram, "numLights");
-    glUniform1i(numLightsLoc, lights.size());
-
-    for (size_t i = 0; i < lights.size(); ++i) {
-        const auto& light = lights[i];
-
-        std::string idx = "lights[" + std::to_string(i) + "].";
-
-        glUniform3fv(glGetUniformLocation(shaderProgram, (idx + "position").c_str()), 1, &light.position[0]);
-        glUniform3fv(glGetUniformLocation(shaderProgram, (idx + "color").c_str()), 1, &light.color[0]);
-        glUniform1f(glGetUniformLocation(shaderProgram, (idx + "intensity").c_str()), light.intensity);
-        glUniform1f(glGetUniformLocation(shaderProgram, (idx + "radius").c_str()), light.radius);
-        glUniform1i(glGetUniformLocation(shaderProgram, (idx + "enabled").c_str()), light.enabled);
-    }
-}
     inline void updateInventoryBar(ECS* ecs, InventoryBarComponent& inventoryBar, InventoryComponent& inventory, ItemRegistry itemRegistry){ 
         inventoryBar.itemSlots.clear();
         inventoryBar.itemNames.clear();
@@ -5,10 +5,16 @@ layout (location = 1) in vec2 aTexCoord; // Texture coordinate
 out vec2 TexCoord;
 
 uniform mat4 model;       // Model matrix for transforming the image
-uniform mat4 projection;   // Projection matrix (usually orthographic for 2D)
+layout(std140) uniform FrameConstants {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    mat4 uScreenProjection;   // pixels, origin bottom left
+    vec4 uTimeScreen;
+};
 
 void main()
 {
-    gl_Position = projection * model * vec4(aPos, 0.0, 1.0); // Calculate position
+    gl_Position = uScreenProjection * model * vec4(aPos, 0.0, 1.0); // Calculate position
     TexCoord = aTexCoord; // Pass texture coordinate to fragment shader
 }
@@ -2,10 +2,16 @@
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
 out vec2 TexCoords;
 
-uniform mat4 projection;
+layout(std140) uniform FrameConstants {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    mat4 uScreenProjection;   // pixels, origin bottom left
+    vec4 uTimeScreen;
+};
 
 void main()
 {
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    gl_Position = uScreenProjection * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
 }  
\ No newline at end of file
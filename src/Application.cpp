@@ -5,6 +5,15 @@
 #include <string>
 #include <fstream>
 #include <Shader.hpp>
+#include "RenderGraph.hpp"
+#include "TextureAtlas.hpp"
+#include "GlobalResources.hpp"
+#include "GLUploadQueue.hpp"
+#include "HotReload.hpp"
+#include "PixelUploadRing.hpp"
+#include "ThreadPool.hpp"
+#include "VirtualFileSystem.hpp"
+#include <chrono>
 #include <GLFW/glfw3.h>
 #include <sstream>
 #include <glm/gtc/type_ptr.hpp>
@@ -15,6 +24,7 @@ int running = true;
 float lastFrame = 0.0;
 float timerInterval = 2.0f; // Timer interval in seconds
 float timer = 0.0f;          // Accumulated time
+const double UPLOAD_BUDGET_MS = 2.0;  // GL upload time per frame for async loads
 
 Application::Application()
     : window(1200, 800) { 
@@ -67,52 +77,21 @@ void Application::run() {
     //------------------------
     // Load Global Resources
     //------------------------
-    ResourceManager<Shader>::getInstance().load("skyboxShader", "./shaders/skyboxVert.glsl", "./shaders/skyboxFrag.glsl");
-    ResourceManager<Shader>::getInstance().load("uiShader", "./shaders/imageVert.glsl", "./shaders/imageFrag.glsl");
-    ResourceManager<Shader>::getInstance().load("textShader", "./shaders/textVert.glsl", "./shaders/textFrag.glsl");
-    ResourceManager<Shader>::getInstance().load("chunkShader", "./shaders/chunkVert.glsl", "./shaders/chunkFrag.glsl");
-    ResourceManager<Shader>::getInstance().load("playerShader", "./shaders/playerVert.glsl", "./shaders/playerFrag.glsl");
-    ResourceManager<Shader>::getInstance().load("modelShader", "./shaders/modelVert.glsl", "./shaders/modelFrag.glsl");
-    ResourceManager<Shader>::getInstance().load("treeShader", "./shaders/treeShaderVert.glsl", "./shaders/treeShaderFrag.glsl");
-
-    ResourceManager<Texture>::getInstance().load("buttonTexture", "./assets/textures/buttonTexture.png");
-    ResourceManager<Texture>::getInstance().load("inventoryBarTexture", "./assets/textures/inventoryBarTexture.png");
-    ResourceManager<Texture>::getInstance().load("textBoxTexture", "./assets/textures/textbox_01.png");
-    ResourceManager<Texture>::getInstance().load("cursorTexture", "./assets/textures/cursor_01.png");
-    ResourceManager<Texture>::getInstance().load("tileTexture", "./assets/textures/cursorTexture.png");
-    ResourceManager<Texture>::getInstance().load("playerTexture", "./assets/textures/t1.png");
-    ResourceManager<Texture>::getInstance().load("shovelIcon", "./assets/textures/shovel_01.png");
-    ResourceManager<Texture>::getInstance().load("handgunIcon", "./assets/textures/handgun_01.png");
-    ResourceManager<Texture>::getInstance().load("dirtIcon", "./assets/textures/dirtIcon.png");
-    ResourceManager<Texture>::getInstance().load("ammunitionIcon", "./assets/textures/ammunition_01.png");
-    ResourceManager<Texture>::getInstance().load("npc_dialog_bg", "./assets/textures/npc_menu_box.png");
-    ResourceManager<Texture>::getInstance().load("npc_portrait_default", "./assets/textures/npc_portrait_default.png");
-    ResourceManager<Texture>::getInstance().load("inventory_menu_bg", "./assets/textures/inventory_dialog_bg.png");
-
-    std::vector<std::string> chunkArrayFiles = {
-    "./assets/textures/water_01.png",
-    "./assets/textures/sand_01.png",
-    "./assets/textures/grass_01.png",
-    "./assets/textures/dirt_01.png",
-    "./assets/textures/stone_01.png",
-    };
-    ResourceManager<Texture>::getInstance().loadTextureArray("chunkArray", chunkArrayFiles);
-    
-    std::vector<std::string> faces {
-    "./assets/skybox/right.jpg",
-    "./assets/skybox/left.jpg",
-    "./assets/skybox/top.jpg",
-    "./assets/skybox/bottom.jpg",
-    "./assets/skybox/front.jpg",
-    "./assets/skybox/back.jpg"
-};
-
-    ResourceManager<Texture>::getInstance().loadCubemap("skyboxTexture", faces);
-    
-    ResourceManager<Font>::getInstance().load("titleFont", "./assets/fonts/FacultyGlyphic.ttf", 40);
-    ResourceManager<Font>::getInstance().load("headerFont", "./assets/fonts/FacultyGlyphic.ttf", 25);
-    ResourceManager<Font>::getInstance().load("Faculty-Glyphic", "./assets/fonts/FacultyGlyphic.ttf", 16);
-    ResourceManager<Font>::getInstance().load("default", "./assets/fonts/FacultyGlyphic.ttf", 16);
+    // Read assets from the pack when one was built (make pack), loose files otherwise
+    auto& files = VirtualFileSystem::getInstance();
+    if (files.exists("./assets.pak") && files.mount("./assets.pak")) {
+        files.prefetch("shaders");
+        files.prefetch("assets/fonts");
+    }
+
+    // Files are decoded on the thread pool; textures and fonts show
+    // placeholders until the upload queue below gets to them
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    loadGlobalResourcesAsync();
+    double loadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+    std::cout << "Startup resources queued in " << loadTime << "ms ("
+              << ResourceManager<Texture>::getInstance().getPendingCount() + ResourceManager<Font>::getInstance().getPendingCount()
+              << " still loading)" << std::endl;
 
     // Disabled 3D model loading for 2D conversion
     // ResourceManager<Model>::getInstance().load("riggedFigure", "./assets/models/baseModel.glb");
@@ -123,6 +102,12 @@ void Application::run() {
     // ResourceManager<Model>::getInstance().load("tree4", "./assets/models/Tree4.glb");
 
 
+    // Frame passes: lighting -> world -> ui -> post
+    RenderGraph::getInstance().createDefaultPasses();
+
+    // Edited textures, shaders and sprites are swapped in while the game runs
+    HotReload::getInstance().start({ "./assets", "./shaders" });
+
     float accumulatedTime = 0.0f;
     auto& eventQueue = GameStateManager::getInstance().getEventQueue();
     GameStateManager::getInstance().pushState(std::make_unique<MainMenuState>(eventQueue));
@@ -147,6 +132,16 @@ void Application::run() {
         }
 
         processInput(deltaTime);
+        RenderGraph::getInstance().beginFrame();
+        TextureAtlasManager::getInstance().beginFrame();
+        // Between frames, so get(handle) pointers hold for a whole frame
+        ResourceManager<Texture>::getInstance().processUnloads();
+        ResourceManager<Shader>::getInstance().processUnloads();
+        ResourceManager<Font>::getInstance().processUnloads();
+        HotReload::getInstance().process();
+        GLUploadQueue::getInstance().process(UPLOAD_BUDGET_MS);
+        PixelUploadRing::getInstance().process();
+        FrameConstantBuffer::getInstance().beginFrame(elapsedTime, deltaTime, window.getWidth(), window.getHeight());
 
     //------------------------
     // Render                
@@ -163,17 +158,26 @@ void Application::run() {
             
             currentState -> update(deltaTime);
         }
+        
+        // Draw what the systems submitted, in pass order, before a state change can free it
+        RenderGraph::getInstance().execute(window.getWidth(), window.getHeight());
+        
         GameStateManager::getInstance().processEvents();
         if(GameStateManager::getInstance().isEmpty()){
             running = false;
         }
         window.update();
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
 }
 
 void Application::cleanup() {
+    HotReload::getInstance().stop();
+    // Workers may still hold decoded files; let them finish before GL goes away
+    ThreadPool::getInstance().shutdown();
+    RenderGraph::getInstance().shutdown();
+    PixelUploadRing::getInstance().shutdown();
     window.destroy();
+    VirtualFileSystem::getInstance().unmountAll();
 }
 
 void Application::print(std::string message){
@@ -0,0 +1,327 @@
+#include "AtlasFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t alignTo16(uint64_t offset) {
+    return (offset + 15) & ~uint64_t(15);
+}
+
+// Far past any GL_MAX_TEXTURE_SIZE; bounds a corrupt header's sizes
+static const uint32_t MAX_PAGE_SIZE = 65536;
+
+static size_t levelBytes(int width, int height, int level) {
+    return static_cast<size_t>(std::max(1, width >> level)) * std::max(1, height >> level) * 4;
+}
+
+void composeAtlasPage(int page, int pageWidth, int pageHeight,
+                      const std::vector<AtlasSourceImage>& images,
+                      const std::vector<PackedRect>& placements,
+                      std::vector<unsigned char>& pixels) {
+    pixels.assign(static_cast<size_t>(pageWidth) * pageHeight * 4, 0);
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        const PackedRect& rect = placements[i];
+        if (rect.page != page) continue;
+
+        const AtlasSourceImage& image = images[i];
+        int x = rect.x + 1;
+        int y = rect.y + 1;
+        int placedWidth = rect.width - 2;
+        int placedHeight = rect.height - 2;
+
+        for (int row = 0; row < placedHeight; ++row) {
+            unsigned char* destination = &pixels[(static_cast<size_t>(y + row) * pageWidth + x) * 4];
+
+            // Atlas rows go up, image rows go down
+            if (!rect.rotated && image.channels == 4) {
+                const unsigned char* source = image.data + static_cast<size_t>(image.height - 1 - row) * image.width * 4;
+                std::memcpy(destination, source, static_cast<size_t>(placedWidth) * 4);
+                continue;
+            }
+
+            // A rotated sprite is stored a quarter turn clockwise: its bottom row
+            // becomes the region's left column
+            for (int col = 0; col < placedWidth; ++col) {
+                int sourceCol = rect.rotated ? image.width - 1 - row : col;
+                int sourceRow = rect.rotated ? image.height - 1 - col : image.height - 1 - row;
+                const unsigned char* source = image.data + (static_cast<size_t>(sourceRow) * image.width + sourceCol) * image.channels;
+                destination[col * 4 + 0] = source[0];
+                destination[col * 4 + 1] = image.channels > 1 ? source[1] : source[0];
+                destination[col * 4 + 2] = image.channels > 2 ? source[2] : source[0];
+                destination[col * 4 + 3] = image.channels == 4 ? source[3] : 255;
+            }
+        }
+    }
+}
+
+void atlasRegionUV(const PackedRect& rect, int pageWidth, int pageHeight, float uv0[2], float uv1[2]) {
+    // Skip the 1-pixel border on each side
+    uv0[0] = static_cast<float>(rect.x + 1) / pageWidth;
+    uv0[1] = static_cast<float>(rect.y + 1) / pageHeight;
+    uv1[0] = static_cast<float>(rect.x + rect.width - 1) / pageWidth;
+    uv1[1] = static_cast<float>(rect.y + rect.height - 1) / pageHeight;
+}
+
+int atlasLevelCount(int width, int height) {
+    int levels = 1;
+    while ((width >> levels) > 0 || (height >> levels) > 0) ++levels;
+    return levels;
+}
+
+void downsampleAtlasLevel(const unsigned char* source, int width, int height,
+                          std::vector<unsigned char>& destination, int channels) {
+    int nextWidth = std::max(1, width / 2);
+    int nextHeight = std::max(1, height / 2);
+    destination.resize(static_cast<size_t>(nextWidth) * nextHeight * channels);
+
+    for (int y = 0; y < nextHeight; ++y) {
+        int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for (int x = 0; x < nextWidth; ++x) {
+            int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < channels; ++c) {
+                int sum = source[(y0 * width + x0) * channels + c] + source[(y0 * width + x1) * channels + c]
+                        + source[(y1 * width + x0) * channels + c] + source[(y1 * width + x1) * channels + c];
+                destination[(static_cast<size_t>(y) * nextWidth + x) * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+bool writeAtlasFile(const std::string& path, int pageWidth, int pageHeight,
+                    const std::vector<AtlasBakeSprite>& sprites,
+                    const std::vector<std::vector<unsigned char>>& pages) {
+    AtlasFileHeader header = {};
+    std::memcpy(header.magic, "ATLS", 4);
+    header.version = ATLAS_FILE_VERSION;
+    header.pageWidth = pageWidth;
+    header.pageHeight = pageHeight;
+    header.pageCount = static_cast<uint32_t>(pages.size());
+    header.levelCount = atlasLevelCount(pageWidth, pageHeight);
+    header.spriteCount = static_cast<uint32_t>(sprites.size());
+
+    // At most half full so probes stay short
+    header.hashCapacity = 16;
+    while (header.hashCapacity < sprites.size() * 2) header.hashCapacity *= 2;
+
+    std::vector<AtlasFileSprite> entries(sprites.size());
+    std::vector<uint32_t> hashTable(header.hashCapacity, 0);
+    std::string names;
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        const AtlasBakeSprite& sprite = sprites[i];
+        AtlasFileSprite& entry = entries[i];
+        std::memcpy(entry.uv0, sprite.uv0, sizeof(entry.uv0));
+        std::memcpy(entry.uv1, sprite.uv1, sizeof(entry.uv1));
+        std::memcpy(entry.size, sprite.size, sizeof(entry.size));
+        entry.page = sprite.page;
+        entry.rotated = sprite.rotated ? 1 : 0;
+        entry.nameOffset = static_cast<uint32_t>(names.size());
+        entry.nameLength = static_cast<uint32_t>(sprite.name.size());
+        names += sprite.name;
+
+        uint32_t slot = hashAtlasName(sprite.name.data(), sprite.name.size()) & (header.hashCapacity - 1);
+        while (hashTable[slot] != 0) slot = (slot + 1) & (header.hashCapacity - 1);
+        hashTable[slot] = static_cast<uint32_t>(i + 1);
+    }
+
+    header.spriteOffset = alignTo16(sizeof(AtlasFileHeader));
+    header.hashOffset = alignTo16(header.spriteOffset + entries.size() * sizeof(AtlasFileSprite));
+    header.nameOffset = alignTo16(header.hashOffset + hashTable.size() * sizeof(uint32_t));
+    header.pixelOffset = alignTo16(header.nameOffset + names.size());
+
+    size_t pageBytes = 0;
+    for (uint32_t level = 0; level < header.levelCount; ++level) {
+        pageBytes += levelBytes(pageWidth, pageHeight, level);
+    }
+    header.fileSize = header.pixelOffset + pageBytes * pages.size();
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open atlas file for writing: " << path << std::endl;
+        return false;
+    }
+
+    auto writeAt = [&](uint64_t offset, const void* bytes, size_t count) {
+        static const char zeros[16] = {};
+        uint64_t position = static_cast<uint64_t>(file.tellp());
+        file.write(zeros, static_cast<std::streamsize>(offset - position));
+        file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(count));
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.spriteOffset, entries.data(), entries.size() * sizeof(AtlasFileSprite));
+    writeAt(header.hashOffset, hashTable.data(), hashTable.size() * sizeof(uint32_t));
+    writeAt(header.nameOffset, names.data(), names.size());
+
+    uint64_t offset = header.pixelOffset;
+    std::vector<unsigned char> level, nextLevel;
+    for (const auto& page : pages) {
+        level = page;
+        int width = pageWidth, height = pageHeight;
+        for (uint32_t l = 0; l < header.levelCount; ++l) {
+            writeAt(offset, level.data(), level.size());
+            offset += level.size();
+            if (l + 1 < header.levelCount) {
+                downsampleAtlasLevel(level.data(), width, height, nextLevel);
+                level.swap(nextLevel);
+                width = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+            }
+        }
+    }
+
+    if (!file) {
+        std::cerr << "Failed to write atlas file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// MappedAtlasFile
+MappedAtlasFile::~MappedAtlasFile() {
+    close();
+}
+
+bool MappedAtlasFile::open(const std::string& path) {
+    close();
+
+    if (VirtualFileSystem::getInstance().isPacked(path)) {
+        if (!VirtualFileSystem::getInstance().read(path, packed) || packed.size() < sizeof(AtlasFileHeader)) {
+            std::cerr << "Failed to read atlas file: " << path << std::endl;
+            close();
+            return false;
+        }
+        data = packed.data();
+        size = packed.size();
+        return validate(path);
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open atlas file: " << path << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(AtlasFileHeader)) {
+        std::cerr << "Atlas file is too small: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map atlas file: " << path << std::endl;
+        return false;
+    }
+    data = static_cast<const unsigned char*>(mapping);
+    size = static_cast<size_t>(info.st_size);
+    ownsMapping = true;
+    return validate(path);
+}
+
+bool MappedAtlasFile::validate(const std::string& path) {
+    const AtlasFileHeader& h = header();
+    // Sizes are checked before pageBytes() walks the levels: more levels than
+    // the full chain would shift past the page size, and the page count is
+    // compared by division so a huge one can't overflow
+    bool valid = std::memcmp(h.magic, "ATLS", 4) == 0 && h.version == ATLAS_FILE_VERSION
+        && h.fileSize == size && h.pageCount > 0 && h.levelCount > 0
+        && h.pageWidth > 0 && h.pageWidth <= MAX_PAGE_SIZE && h.pageHeight > 0 && h.pageHeight <= MAX_PAGE_SIZE
+        && h.levelCount <= static_cast<uint32_t>(atlasLevelCount(h.pageWidth, h.pageHeight))
+        && h.hashCapacity > 0 && (h.hashCapacity & (h.hashCapacity - 1)) == 0
+        && h.spriteOffset + uint64_t(h.spriteCount) * sizeof(AtlasFileSprite) <= h.hashOffset
+        && h.hashOffset + uint64_t(h.hashCapacity) * sizeof(uint32_t) <= h.nameOffset
+        && h.nameOffset <= h.pixelOffset && h.pixelOffset <= size
+        && h.pageCount <= (size - h.pixelOffset) / pageBytes();
+    for (uint32_t i = 0; valid && i < h.spriteCount; ++i) {
+        const AtlasFileSprite& entry = sprites()[i];
+        valid = entry.page < h.pageCount
+            && uint64_t(entry.nameOffset) + entry.nameLength <= h.pixelOffset - h.nameOffset;
+    }
+    for (uint32_t slot = 0; valid && slot < h.hashCapacity; ++slot) {
+        valid = hashTable()[slot] <= h.spriteCount;
+    }
+    if (!valid) {
+        std::cerr << "Not a valid atlas file (version " << ATLAS_FILE_VERSION << "): " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedAtlasFile::close() {
+    if (ownsMapping) munmap(const_cast<unsigned char*>(data), size);
+    data = nullptr;
+    size = 0;
+    ownsMapping = false;
+    packed = FileBuffer();
+}
+
+std::string MappedAtlasFile::spriteName(int index) const {
+    const AtlasFileSprite& entry = sprite(index);
+    return std::string(reinterpret_cast<const char*>(data + header().nameOffset + entry.nameOffset), entry.nameLength);
+}
+
+int MappedAtlasFile::findSprite(const std::string& name) const {
+    const AtlasFileHeader& h = header();
+    const char* names = reinterpret_cast<const char*>(data + h.nameOffset);
+    uint32_t mask = h.hashCapacity - 1;
+
+    // A full table has no empty slot to stop at
+    uint32_t slot = hashAtlasName(name.data(), name.size()) & mask;
+    for (uint32_t probe = 0; probe < h.hashCapacity; ++probe, slot = (slot + 1) & mask) {
+        uint32_t entry = hashTable()[slot];
+        if (entry == 0) return -1;
+
+        const AtlasFileSprite& candidate = sprites()[entry - 1];
+        if (candidate.nameLength == name.size()
+            && std::memcmp(names + candidate.nameOffset, name.data(), name.size()) == 0) {
+            return static_cast<int>(entry - 1);
+        }
+    }
+    return -1;
+}
+
+size_t MappedAtlasFile::pageBytes() const {
+    size_t bytes = 0;
+    for (uint32_t level = 0; level < header().levelCount; ++level) {
+        bytes += levelBytes(header().pageWidth, header().pageHeight, level);
+    }
+    return bytes;
+}
+
+const unsigned char* MappedAtlasFile::levelPixels(int page, int level) const {
+    size_t offset = header().pixelOffset + pageBytes() * page;
+    for (int l = 0; l < level; ++l) {
+        offset += levelBytes(header().pageWidth, header().pageHeight, l);
+    }
+    return data + offset;
+}
+
+int MappedAtlasFile::levelWidth(int level) const {
+    return std::max(1, static_cast<int>(header().pageWidth) >> level);
+}
+
+int MappedAtlasFile::levelHeight(int level) const {
+    return std::max(1, static_cast<int>(header().pageHeight) >> level);
+}
+
+void MappedAtlasFile::releasePixels() const {
+    // Only file pages can be dropped and read back; a decompressed copy is plain memory
+    if (!ownsMapping && !packed.isMapped()) return;
+
+    // madvise wants page-aligned bounds; the header and tables before them stay
+    // resident, and so do the neighbouring files of a pack
+    uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(data + header().pixelOffset);
+    uintptr_t end = reinterpret_cast<uintptr_t>(data + size);
+    start = (start + pageSize - 1) / pageSize * pageSize;
+    if (!ownsMapping) end = end / pageSize * pageSize;
+    if (start < end) madvise(reinterpret_cast<void*>(start), end - start, MADV_DONTNEED);
+}
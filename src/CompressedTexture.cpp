@@ -0,0 +1,885 @@
+#include "CompressedTexture.hpp"
+#include "VirtualFileSystem.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Formats
+
+GLenum blockFormatGLEnum(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case BlockFormat::ETC2_RGB: return GL_COMPRESSED_RGB8_ETC2;
+        case BlockFormat::ETC2_RGBA: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+    }
+    return 0;
+}
+
+size_t blockFormatBlockBytes(BlockFormat format) {
+    return (format == BlockFormat::BC1 || format == BlockFormat::ETC2_RGB) ? 8 : 16;
+}
+
+const char* blockFormatName(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return "BC1";
+        case BlockFormat::BC3: return "BC3";
+        case BlockFormat::BC7: return "BC7";
+        case BlockFormat::ETC2_RGB: return "ETC2 RGB8";
+        case BlockFormat::ETC2_RGBA: return "ETC2 RGBA8";
+    }
+    return "?";
+}
+
+// Vulkan format numbers used by KTX2
+static const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+static const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+static const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+static const uint32_t VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK = 147;
+static const uint32_t VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK = 151;
+
+static uint32_t vkFormatOf(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case BlockFormat::BC3: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case BlockFormat::BC7: return VK_FORMAT_BC7_UNORM_BLOCK;
+        case BlockFormat::ETC2_RGB: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+        case BlockFormat::ETC2_RGBA: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+    }
+    return 0;
+}
+
+static bool formatFromVk(uint32_t vkFormat, BlockFormat& format) {
+    for (BlockFormat candidate : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC7,
+                                   BlockFormat::ETC2_RGB, BlockFormat::ETC2_RGBA }) {
+        if (vkFormatOf(candidate) == vkFormat) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::atomic<bool> supportQueried(false);
+static bool formatSupported[5] = {};
+
+void queryBlockFormatSupport() {
+    if (supportQueried.load()) return;
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+    std::vector<GLint> listed(count);
+    if (count > 0) glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, listed.data());
+
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    auto hasExtension = [extensionCount](const char* name) {
+        for (GLint i = 0; i < extensionCount; ++i) {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension && std::strcmp(extension, name) == 0) return true;
+        }
+        return false;
+    };
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    int version = major * 10 + minor;
+
+    // Core formats (BPTC since 4.2, ETC2 since 4.3) don't have to be listed
+    bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+    bool bptc = version >= 42 || hasExtension("GL_ARB_texture_compression_bptc");
+    bool etc2 = version >= 43 || hasExtension("GL_ARB_ES3_compatibility");
+    for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC7,
+                                BlockFormat::ETC2_RGB, BlockFormat::ETC2_RGBA }) {
+        bool supported = std::find(listed.begin(), listed.end(), static_cast<GLint>(blockFormatGLEnum(format))) != listed.end();
+        if (format == BlockFormat::BC1 || format == BlockFormat::BC3) supported = supported || s3tc;
+        if (format == BlockFormat::BC7) supported = supported || bptc;
+        if (format == BlockFormat::ETC2_RGB || format == BlockFormat::ETC2_RGBA) supported = supported || etc2;
+        formatSupported[static_cast<int>(format)] = supported;
+    }
+    supportQueried.store(true);
+}
+
+bool isBlockFormatSupported(BlockFormat format) {
+    return supportQueried.load() && formatSupported[static_cast<int>(format)];
+}
+
+// Reading
+
+static const unsigned char KTX2_IDENTIFIER[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+struct Ktx2Header {
+    uint32_t vkFormat, typeSize;
+    uint32_t pixelWidth, pixelHeight, pixelDepth;
+    uint32_t layerCount, faceCount, levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset, dfdByteLength;
+    uint32_t kvdByteOffset, kvdByteLength;
+    uint32_t sgdByteOffset[2], sgdByteLength[2];   // uint64 in the file, split to keep the struct unpadded
+};
+
+static_assert(sizeof(Ktx2Header) == 68, "KTX2 header layout");
+
+struct Ktx2Level {
+    uint64_t byteOffset, byteLength, uncompressedByteLength;
+};
+
+static size_t levelBlockBytes(BlockFormat format, int width, int height) {
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockFormatBlockBytes(format);
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& bytes) {
+    FileBuffer file;
+    if (!VirtualFileSystem::getInstance().read(path, file)) return false;
+    bytes.assign(file.data(), file.data() + file.size());
+    return true;
+}
+
+static bool parseKtx2(const std::string& path, std::vector<unsigned char>& bytes, CompressedTextureData& texture) {
+    Ktx2Header header;
+    if (bytes.size() < sizeof(KTX2_IDENTIFIER) + sizeof(header)) {
+        std::cerr << "KTX2 file is too small: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(&header, bytes.data() + sizeof(KTX2_IDENTIFIER), sizeof(header));
+
+    if (!formatFromVk(header.vkFormat, texture.format)) {
+        std::cerr << "Unsupported KTX2 format " << header.vkFormat << " (BC1/BC3/BC7/ETC2 only): " << path << std::endl;
+        return false;
+    }
+    if (header.supercompressionScheme != 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1) {
+        std::cerr << "Only plain 2D KTX2 files are supported: " << path << std::endl;
+        return false;
+    }
+
+    texture.width = static_cast<int>(header.pixelWidth);
+    texture.height = static_cast<int>(header.pixelHeight);
+    uint32_t levelCount = std::max(1u, header.levelCount);
+    size_t indexOffset = sizeof(KTX2_IDENTIFIER) + sizeof(header);
+    if (indexOffset + levelCount * sizeof(Ktx2Level) > bytes.size()) {
+        std::cerr << "Truncated KTX2 level index: " << path << std::endl;
+        return false;
+    }
+
+    texture.levels.clear();
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        Ktx2Level entry;
+        std::memcpy(&entry, bytes.data() + indexOffset + level * sizeof(Ktx2Level), sizeof(entry));
+
+        CompressedLevel compressed;
+        compressed.width = std::max(1, texture.width >> level);
+        compressed.height = std::max(1, texture.height >> level);
+        compressed.offset = static_cast<size_t>(entry.byteOffset);
+        compressed.size = static_cast<size_t>(entry.byteLength);
+        if (entry.byteOffset + entry.byteLength > bytes.size()
+            || compressed.size != levelBlockBytes(texture.format, compressed.width, compressed.height)) {
+            std::cerr << "Bad KTX2 level " << level << ": " << path << std::endl;
+            return false;
+        }
+        texture.levels.push_back(compressed);
+    }
+
+    texture.data.swap(bytes);
+    return true;
+}
+
+static uint32_t readU32(const std::vector<unsigned char>& bytes, size_t offset) {
+    uint32_t value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+static bool parseDds(const std::string& path, std::vector<unsigned char>& bytes, CompressedTextureData& texture) {
+    // "DDS " + DDS_HEADER (124 bytes), optionally followed by DDS_HEADER_DXT10 (20 bytes)
+    if (bytes.size() < 128) {
+        std::cerr << "DDS file is too small: " << path << std::endl;
+        return false;
+    }
+
+    uint32_t height = readU32(bytes, 12);
+    uint32_t width = readU32(bytes, 16);
+    uint32_t mipCount = readU32(bytes, 28);
+    uint32_t fourCC = readU32(bytes, 84);
+    uint32_t caps2 = readU32(bytes, 112);
+    size_t dataOffset = 128;
+
+    auto makeFourCC = [](const char* code) {
+        return static_cast<uint32_t>(code[0]) | (static_cast<uint32_t>(code[1]) << 8)
+             | (static_cast<uint32_t>(code[2]) << 16) | (static_cast<uint32_t>(code[3]) << 24);
+    };
+
+    bool known = true;
+    if (fourCC == makeFourCC("DXT1")) {
+        texture.format = BlockFormat::BC1;
+    } else if (fourCC == makeFourCC("DXT5")) {
+        texture.format = BlockFormat::BC3;
+    } else if (fourCC == makeFourCC("DX10") && bytes.size() >= 148) {
+        // DXGI_FORMAT_BC1_UNORM, BC3_UNORM, BC7_UNORM
+        uint32_t dxgiFormat = readU32(bytes, 128);
+        uint32_t arraySize = readU32(bytes, 140);
+        dataOffset = 148;
+        if (dxgiFormat == 71) texture.format = BlockFormat::BC1;
+        else if (dxgiFormat == 77) texture.format = BlockFormat::BC3;
+        else if (dxgiFormat == 98) texture.format = BlockFormat::BC7;
+        else known = false;
+        if (arraySize > 1) caps2 |= 0x200;
+    } else {
+        known = false;
+    }
+    if (!known) {
+        std::cerr << "Unsupported DDS format (DXT1/DXT5/BC7 only): " << path << std::endl;
+        return false;
+    }
+    if (caps2 & 0x200) {
+        std::cerr << "Only 2D DDS files are supported: " << path << std::endl;
+        return false;
+    }
+
+    texture.width = static_cast<int>(width);
+    texture.height = static_cast<int>(height);
+    texture.levels.clear();
+    size_t offset = dataOffset;
+    for (uint32_t level = 0; level < std::max(1u, mipCount); ++level) {
+        CompressedLevel compressed;
+        compressed.width = std::max(1, texture.width >> level);
+        compressed.height = std::max(1, texture.height >> level);
+        compressed.offset = offset;
+        compressed.size = levelBlockBytes(texture.format, compressed.width, compressed.height);
+        if (offset + compressed.size > bytes.size()) {
+            std::cerr << "Truncated DDS level " << level << ": " << path << std::endl;
+            return false;
+        }
+        texture.levels.push_back(compressed);
+        offset += compressed.size;
+    }
+
+    texture.data.swap(bytes);
+    return true;
+}
+
+bool readCompressedTexture(const std::string& path, CompressedTextureData& texture) {
+    std::vector<unsigned char> bytes;
+    if (!readFile(path, bytes)) {
+        std::cerr << "Failed to read compressed texture: " << path << std::endl;
+        return false;
+    }
+
+    if (bytes.size() >= sizeof(KTX2_IDENTIFIER) && std::memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+        return parseKtx2(path, bytes, texture);
+    }
+    if (bytes.size() >= 4 && std::memcmp(bytes.data(), "DDS ", 4) == 0) {
+        return parseDds(path, bytes, texture);
+    }
+    std::cerr << "Not a KTX2 or DDS file: " << path << std::endl;
+    return false;
+}
+
+// Format of a container without reading its data
+static bool peekFormat(const std::string& path, BlockFormat& format) {
+    FileBuffer file;
+    unsigned char head[148] = {};
+    if (!VirtualFileSystem::getInstance().read(path, file, sizeof(head))) return false;
+    size_t read = file.size();
+    std::memcpy(head, file.data(), read);
+
+    if (read >= 16 && std::memcmp(head, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+        uint32_t vkFormat;
+        std::memcpy(&vkFormat, head + 12, sizeof(vkFormat));
+        return formatFromVk(vkFormat, format);
+    }
+    if (read >= 128 && std::memcmp(head, "DDS ", 4) == 0) {
+        std::vector<unsigned char> bytes(head, head + read);
+        std::string code(reinterpret_cast<const char*>(head + 84), 4);
+        if (code == "DXT1") { format = BlockFormat::BC1; return true; }
+        if (code == "DXT5") { format = BlockFormat::BC3; return true; }
+        if (code == "DX10" && read >= 148) {
+            uint32_t dxgiFormat = readU32(bytes, 128);
+            if (dxgiFormat == 71) { format = BlockFormat::BC1; return true; }
+            if (dxgiFormat == 77) { format = BlockFormat::BC3; return true; }
+            if (dxgiFormat == 98) { format = BlockFormat::BC7; return true; }
+        }
+    }
+    return false;
+}
+
+static bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string findCompressedVariant(const std::string& imagePath) {
+    std::vector<std::string> candidates;
+    if (endsWith(imagePath, ".ktx2") || endsWith(imagePath, ".dds")) {
+        candidates.push_back(imagePath);
+    } else {
+        size_t slash = imagePath.find_last_of("/\\");
+        size_t dot = imagePath.find_last_of('.');
+        std::string base = (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            ? imagePath : imagePath.substr(0, dot);
+        candidates = { base + ".ktx2", base + ".etc2.ktx2", base + ".dds" };
+    }
+
+    for (const auto& candidate : candidates) {
+        if (!VirtualFileSystem::getInstance().exists(candidate)) continue;
+        BlockFormat format;
+        if (peekFormat(candidate, format) && isBlockFormatSupported(format)) return candidate;
+    }
+    return "";
+}
+
+// Encoding
+
+namespace {
+
+struct Color {
+    float c[4];
+};
+
+inline int clampByte(int value) {
+    return std::min(255, std::max(0, value));
+}
+
+inline float squaredDistance(const Color& a, const Color& b, int channels) {
+    float sum = 0.0f;
+    for (int i = 0; i < channels; ++i) {
+        float d = a.c[i] - b.c[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+// Endpoints of the block's colours projected on their principal axis
+void principalEndpoints(const Color pixels[16], int channels, Color& low, Color& high) {
+    Color mean = {};
+    for (int p = 0; p < 16; ++p) {
+        for (int i = 0; i < channels; ++i) mean.c[i] += pixels[p].c[i] / 16.0f;
+    }
+
+    float covariance[4][4] = {};
+    for (int p = 0; p < 16; ++p) {
+        for (int i = 0; i < channels; ++i) {
+            for (int j = 0; j < channels; ++j) {
+                covariance[i][j] += (pixels[p].c[i] - mean.c[i]) * (pixels[p].c[j] - mean.c[j]);
+            }
+        }
+    }
+
+    // Power iteration from the widest channel
+    float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int i = 0; i < channels; ++i) {
+            for (int j = 0; j < channels; ++j) next[i] += covariance[i][j] * axis[j];
+            length += next[i] * next[i];
+        }
+        if (length < 1e-6f) break;
+        length = std::sqrt(length);
+        for (int i = 0; i < channels; ++i) axis[i] = next[i] / length;
+    }
+
+    float minProjection = 0.0f, maxProjection = 0.0f;
+    for (int p = 0; p < 16; ++p) {
+        float projection = 0.0f;
+        for (int i = 0; i < channels; ++i) projection += (pixels[p].c[i] - mean.c[i]) * axis[i];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        float a = i < channels ? axis[i] : 0.0f;
+        low.c[i] = std::min(255.0f, std::max(0.0f, mean.c[i] + a * minProjection));
+        high.c[i] = std::min(255.0f, std::max(0.0f, mean.c[i] + a * maxProjection));
+    }
+}
+
+// BC1 / BC3 colour block (always 4-colour mode)
+uint16_t pack565(const Color& color) {
+    int r = static_cast<int>(std::lround(color.c[0] * 31.0f / 255.0f));
+    int g = static_cast<int>(std::lround(color.c[1] * 63.0f / 255.0f));
+    int b = static_cast<int>(std::lround(color.c[2] * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+Color unpack565(uint16_t packed) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    return { { static_cast<float>((r << 3) | (r >> 2)), static_cast<float>((g << 2) | (g >> 4)),
+               static_cast<float>((b << 3) | (b >> 2)), 255.0f } };
+}
+
+void encodeColorBlock(const Color pixels[16], unsigned char* out) {
+    Color low, high;
+    principalEndpoints(pixels, 3, low, high);
+    uint16_t color0 = pack565(high);
+    uint16_t color1 = pack565(low);
+    if (color0 < color1) std::swap(color0, color1);
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        Color palette[4];
+        palette[0] = unpack565(color0);
+        palette[1] = unpack565(color1);
+        for (int i = 0; i < 3; ++i) {
+            palette[2].c[i] = (2.0f * palette[0].c[i] + palette[1].c[i]) / 3.0f;
+            palette[3].c[i] = (palette[0].c[i] + 2.0f * palette[1].c[i]) / 3.0f;
+        }
+        for (int p = 0; p < 16; ++p) {
+            int best = 0;
+            float bestError = squaredDistance(pixels[p], palette[0], 3);
+            for (int i = 1; i < 4; ++i) {
+                float error = squaredDistance(pixels[p], palette[i], 3);
+                if (error < bestError) { bestError = error; best = i; }
+            }
+            indices |= static_cast<uint32_t>(best) << (2 * p);
+        }
+    }
+
+    out[0] = color0 & 0xFF; out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF; out[3] = color1 >> 8;
+    for (int i = 0; i < 4; ++i) out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+// BC3 alpha block (8-value mode)
+void encodeBC3Alpha(const Color pixels[16], unsigned char* out) {
+    int alphaMax = 0, alphaMin = 255;
+    for (int p = 0; p < 16; ++p) {
+        alphaMax = std::max(alphaMax, static_cast<int>(pixels[p].c[3]));
+        alphaMin = std::min(alphaMin, static_cast<int>(pixels[p].c[3]));
+    }
+
+    uint64_t indices = 0;
+    if (alphaMax != alphaMin) {
+        int palette[8] = { alphaMax, alphaMin };
+        for (int i = 2; i < 8; ++i) palette[i] = ((8 - i) * alphaMax + (i - 1) * alphaMin) / 7;
+        for (int p = 0; p < 16; ++p) {
+            int best = 0;
+            int bestError = 256;
+            for (int i = 0; i < 8; ++i) {
+                int error = std::abs(palette[i] - static_cast<int>(pixels[p].c[3]));
+                if (error < bestError) { bestError = error; best = i; }
+            }
+            indices |= static_cast<uint64_t>(best) << (3 * p);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(alphaMax);
+    out[1] = static_cast<unsigned char>(alphaMin);
+    for (int i = 0; i < 6; ++i) out[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+// BC7 mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4-bit indices
+struct BitWriter {
+    uint64_t words[2] = { 0, 0 };
+    int position = 0;
+
+    void write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++position) {
+            if ((value >> i) & 1) words[position / 64] |= uint64_t(1) << (position % 64);
+        }
+    }
+};
+
+void quantizeBC7Endpoint(const Color& endpoint, int quantized[4], int& pBit) {
+    float bestError = 1e30f;
+    for (int p = 0; p < 2; ++p) {
+        int candidate[4];
+        float error = 0.0f;
+        for (int i = 0; i < 4; ++i) {
+            candidate[i] = std::min(127, std::max(0, static_cast<int>(std::lround((endpoint.c[i] - p) / 2.0f))));
+            float d = static_cast<float>(candidate[i] * 2 + p) - endpoint.c[i];
+            error += d * d;
+        }
+        if (error < bestError) {
+            bestError = error;
+            pBit = p;
+            std::copy(candidate, candidate + 4, quantized);
+        }
+    }
+}
+
+void encodeBC7(const Color pixels[16], unsigned char* out) {
+    static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    Color low, high;
+    principalEndpoints(pixels, 4, low, high);
+    int endpoint[2][4], pBit[2];
+    quantizeBC7Endpoint(low, endpoint[0], pBit[0]);
+    quantizeBC7Endpoint(high, endpoint[1], pBit[1]);
+
+    Color palette[16];
+    for (int w = 0; w < 16; ++w) {
+        for (int i = 0; i < 4; ++i) {
+            int e0 = endpoint[0][i] * 2 + pBit[0];
+            int e1 = endpoint[1][i] * 2 + pBit[1];
+            palette[w].c[i] = static_cast<float>(((64 - weights[w]) * e0 + weights[w] * e1 + 32) >> 6);
+        }
+    }
+
+    int indices[16];
+    for (int p = 0; p < 16; ++p) {
+        int best = 0;
+        float bestError = squaredDistance(pixels[p], palette[0], 4);
+        for (int w = 1; w < 16; ++w) {
+            float error = squaredDistance(pixels[p], palette[w], 4);
+            if (error < bestError) { bestError = error; best = w; }
+        }
+        indices[p] = best;
+    }
+
+    // The first index is stored with 3 bits, so its top bit must be 0
+    if (indices[0] >= 8) {
+        std::swap(endpoint[0], endpoint[1]);
+        std::swap(pBit[0], pBit[1]);
+        for (int& index : indices) index = 15 - index;
+    }
+
+    BitWriter bits;
+    bits.write(1 << 6, 7);     // mode 6
+    for (int i = 0; i < 4; ++i) {
+        bits.write(endpoint[0][i], 7);
+        bits.write(endpoint[1][i], 7);
+    }
+    bits.write(pBit[0], 1);
+    bits.write(pBit[1], 1);
+    bits.write(indices[0], 3);
+    for (int p = 1; p < 16; ++p) bits.write(indices[p], 4);
+
+    for (int i = 0; i < 16; ++i) out[i] = (bits.words[i / 8] >> (8 * (i % 8))) & 0xFF;
+}
+
+// ETC2 RGB, written in the ETC1-compatible individual/differential modes
+const int etcModifiers[8][2] = {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+// Best table for a sub-block around base; pixel indices per the ETC order (+a, +b, -a, -b)
+float encodeEtcSubblock(const Color pixels[16], const int members[8], const int base[3], int& table, int indices[16]) {
+    float bestTableError = 1e30f;
+    for (int t = 0; t < 8; ++t) {
+        int modifiers[4] = { etcModifiers[t][0], etcModifiers[t][1], -etcModifiers[t][0], -etcModifiers[t][1] };
+        float tableError = 0.0f;
+        int tableIndices[8];
+        for (int m = 0; m < 8; ++m) {
+            const Color& pixel = pixels[members[m]];
+            float bestError = 1e30f;
+            for (int i = 0; i < 4; ++i) {
+                float error = 0.0f;
+                for (int c = 0; c < 3; ++c) {
+                    float d = static_cast<float>(clampByte(base[c] + modifiers[i])) - pixel.c[c];
+                    error += d * d;
+                }
+                if (error < bestError) { bestError = error; tableIndices[m] = i; }
+            }
+            tableError += bestError;
+        }
+        if (tableError < bestTableError) {
+            bestTableError = tableError;
+            table = t;
+            for (int m = 0; m < 8; ++m) indices[members[m]] = tableIndices[m];
+        }
+    }
+    return bestTableError;
+}
+
+void encodeEtc2RGB(const Color pixels[16], unsigned char* out) {
+    uint64_t bestBlock = 0;
+    float bestError = 1e30f;
+
+    for (int flip = 0; flip < 2; ++flip) {
+        // Pixels are numbered row-major here (y * 4 + x)
+        int members[2][8];
+        int counts[2] = { 0, 0 };
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                int subblock = flip ? (y >= 2) : (x >= 2);
+                members[subblock][counts[subblock]++] = y * 4 + x;
+            }
+        }
+
+        float average[2][3] = {};
+        for (int s = 0; s < 2; ++s) {
+            for (int m = 0; m < 8; ++m) {
+                for (int c = 0; c < 3; ++c) average[s][c] += pixels[members[s][m]].c[c] / 8.0f;
+            }
+        }
+
+        for (int differential = 0; differential < 2; ++differential) {
+            int quantized[2][3], base[2][3];
+            bool valid = true;
+            for (int s = 0; s < 2; ++s) {
+                for (int c = 0; c < 3; ++c) {
+                    int levels = differential ? 31 : 15;
+                    quantized[s][c] = static_cast<int>(std::lround(average[s][c] * levels / 255.0f));
+                    base[s][c] = differential ? ((quantized[s][c] << 3) | (quantized[s][c] >> 2))
+                                              : ((quantized[s][c] << 4) | quantized[s][c]);
+                }
+            }
+            if (differential) {
+                for (int c = 0; c < 3; ++c) {
+                    int delta = quantized[1][c] - quantized[0][c];
+                    if (delta < -4 || delta > 3) valid = false;
+                }
+            }
+            if (!valid) continue;
+
+            int tables[2], indices[16];
+            float error = encodeEtcSubblock(pixels, members[0], base[0], tables[0], indices)
+                        + encodeEtcSubblock(pixels, members[1], base[1], tables[1], indices);
+            if (error >= bestError) continue;
+            bestError = error;
+
+            uint64_t block = 0;
+            for (int c = 0; c < 3; ++c) {
+                int shift = 59 - c * 8;   // R from bit 63, G from 55, B from 47
+                if (differential) {
+                    block |= static_cast<uint64_t>(quantized[0][c]) << (shift);
+                    block |= static_cast<uint64_t>((quantized[1][c] - quantized[0][c]) & 7) << (shift - 3);
+                } else {
+                    block |= static_cast<uint64_t>(quantized[0][c]) << (shift + 1);
+                    block |= static_cast<uint64_t>(quantized[1][c]) << (shift - 3);
+                }
+            }
+            block |= static_cast<uint64_t>(tables[0]) << 37;
+            block |= static_cast<uint64_t>(tables[1]) << 34;
+            block |= static_cast<uint64_t>(differential) << 33;
+            block |= static_cast<uint64_t>(flip) << 32;
+
+            // Index bits are numbered column-major (x * 4 + y)
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    int index = indices[y * 4 + x];
+                    int bit = x * 4 + y;
+                    block |= static_cast<uint64_t>(index >> 1) << (16 + bit);
+                    block |= static_cast<uint64_t>(index & 1) << bit;
+                }
+            }
+            bestBlock = block;
+        }
+    }
+
+    for (int i = 0; i < 8; ++i) out[i] = (bestBlock >> (56 - 8 * i)) & 0xFF;
+}
+
+// ETC2 EAC alpha
+const int eacModifiers[16][8] = {
+    { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+void encodeEacAlpha(const Color pixels[16], unsigned char* out) {
+    int alphaMin = 255, alphaMax = 0;
+    for (int p = 0; p < 16; ++p) {
+        alphaMin = std::min(alphaMin, static_cast<int>(pixels[p].c[3]));
+        alphaMax = std::max(alphaMax, static_cast<int>(pixels[p].c[3]));
+    }
+
+    // Constant alpha is exact with table 13, whose index 4 adds 0
+    int bestBase = alphaMin, bestMultiplier = 1, bestTable = 13;
+    int bestIndices[16];
+    std::fill(bestIndices, bestIndices + 16, 4);
+
+    if (alphaMin != alphaMax) {
+        int bestError = 1 << 30;
+        for (int t = 0; t < 16; ++t) {
+            int spread = eacModifiers[t][7] - eacModifiers[t][3];
+            int multiplier = std::min(15, std::max(1, static_cast<int>(std::lround(static_cast<float>(alphaMax - alphaMin) / spread))));
+            int center = static_cast<int>(std::lround((alphaMin + alphaMax) / 2.0f
+                - (eacModifiers[t][3] + eacModifiers[t][7]) * multiplier / 2.0f));
+            for (int base = center - 1; base <= center + 1; ++base) {
+                int clampedBase = clampByte(base);
+                int error = 0;
+                int indices[16];
+                for (int p = 0; p < 16 && error < bestError; ++p) {
+                    int alpha = static_cast<int>(pixels[p].c[3]);
+                    int bestPixelError = 1 << 30;
+                    for (int i = 0; i < 8; ++i) {
+                        int d = clampByte(clampedBase + eacModifiers[t][i] * multiplier) - alpha;
+                        if (d * d < bestPixelError) { bestPixelError = d * d; indices[p] = i; }
+                    }
+                    error += bestPixelError;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    bestBase = clampedBase;
+                    bestMultiplier = multiplier;
+                    bestTable = t;
+                    std::copy(indices, indices + 16, bestIndices);
+                }
+            }
+        }
+    }
+
+    uint64_t block = (static_cast<uint64_t>(bestBase) << 56) | (static_cast<uint64_t>(bestMultiplier) << 52)
+                   | (static_cast<uint64_t>(bestTable) << 48);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            int bit = x * 4 + y;
+            block |= static_cast<uint64_t>(bestIndices[y * 4 + x]) << (45 - 3 * bit);
+        }
+    }
+    for (int i = 0; i < 8; ++i) out[i] = (block >> (56 - 8 * i)) & 0xFF;
+}
+
+void encodeBlock(BlockFormat format, const Color pixels[16], unsigned char* out) {
+    switch (format) {
+        case BlockFormat::BC1:
+            encodeColorBlock(pixels, out);
+            break;
+        case BlockFormat::BC3:
+            encodeBC3Alpha(pixels, out);
+            encodeColorBlock(pixels, out + 8);
+            break;
+        case BlockFormat::BC7:
+            encodeBC7(pixels, out);
+            break;
+        case BlockFormat::ETC2_RGB:
+            encodeEtc2RGB(pixels, out);
+            break;
+        case BlockFormat::ETC2_RGBA:
+            encodeEacAlpha(pixels, out);
+            encodeEtc2RGB(pixels, out + 8);
+            break;
+    }
+}
+
+} // namespace
+
+void compressImage(BlockFormat format, const unsigned char* rgba, int width, int height,
+                   std::vector<unsigned char>& blocks) {
+    int blocksX = (width + 3) / 4;
+    int blocksY = (height + 3) / 4;
+    size_t blockBytes = blockFormatBlockBytes(format);
+    blocks.assign(static_cast<size_t>(blocksX) * blocksY * blockBytes, 0);
+
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            Color pixels[16];
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    int sourceX = std::min(bx * 4 + x, width - 1);
+                    int sourceY = std::min(by * 4 + y, height - 1);
+                    const unsigned char* source = rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+                    for (int c = 0; c < 4; ++c) pixels[y * 4 + x].c[c] = source[c];
+                }
+            }
+            encodeBlock(format, pixels, &blocks[(static_cast<size_t>(by) * blocksX + bx) * blockBytes]);
+        }
+    }
+}
+
+// Writing
+
+// Basic data format descriptor (KTX2 requires one): colour model and the
+// bit ranges of the block's alpha and colour parts
+static std::vector<unsigned char> buildDataFormatDescriptor(BlockFormat format) {
+    struct Sample {
+        uint16_t bitOffset;
+        uint8_t bitLength;
+        uint8_t channel;
+    };
+
+    uint8_t colorModel = 0;
+    std::vector<Sample> samples;
+    switch (format) {
+        case BlockFormat::BC1: colorModel = 128; samples = { { 0, 64, 0 } }; break;
+        case BlockFormat::BC3: colorModel = 130; samples = { { 0, 64, 15 }, { 64, 64, 0 } }; break;
+        case BlockFormat::BC7: colorModel = 134; samples = { { 0, 128, 0 } }; break;
+        case BlockFormat::ETC2_RGB: colorModel = 161; samples = { { 0, 64, 2 } }; break;
+        case BlockFormat::ETC2_RGBA: colorModel = 161; samples = { { 0, 64, 15 }, { 64, 64, 2 } }; break;
+    }
+
+    uint16_t blockSize = static_cast<uint16_t>(24 + 16 * samples.size());
+    std::vector<unsigned char> dfd(4 + blockSize, 0);
+    auto put32 = [&dfd](size_t offset, uint32_t value) { std::memcpy(&dfd[offset], &value, 4); };
+    auto put16 = [&dfd](size_t offset, uint16_t value) { std::memcpy(&dfd[offset], &value, 2); };
+
+    put32(0, static_cast<uint32_t>(dfd.size()));
+    put32(4, 0);                 // vendor Khronos, basic descriptor
+    put16(8, 2);                 // version
+    put16(10, blockSize);
+    dfd[12] = colorModel;
+    dfd[13] = 1;                 // BT.709 primaries
+    dfd[14] = 1;                 // linear transfer (UNORM formats)
+    dfd[15] = 0;                 // straight alpha
+    dfd[16] = 3;                 // 4x4 texel blocks
+    dfd[17] = 3;
+    dfd[20] = static_cast<unsigned char>(blockFormatBlockBytes(format));
+    for (size_t i = 0; i < samples.size(); ++i) {
+        size_t offset = 28 + 16 * i;
+        put16(offset, samples[i].bitOffset);
+        dfd[offset + 2] = samples[i].bitLength - 1;
+        dfd[offset + 3] = samples[i].channel;
+        put32(offset + 8, 0);
+        put32(offset + 12, 0xFFFFFFFFu);
+    }
+    return dfd;
+}
+
+bool writeKtx2(const std::string& path, const CompressedTextureData& texture) {
+    std::vector<unsigned char> dfd = buildDataFormatDescriptor(texture.format);
+
+    std::string key = "KTXwriter";
+    std::string value = "crawler texture_compress";
+    uint32_t keyValueLength = static_cast<uint32_t>(key.size() + 1 + value.size() + 1);
+    std::vector<unsigned char> kvd(4 + keyValueLength, 0);
+    std::memcpy(kvd.data(), &keyValueLength, 4);
+    std::memcpy(kvd.data() + 4, key.c_str(), key.size() + 1);
+    std::memcpy(kvd.data() + 4 + key.size() + 1, value.c_str(), value.size() + 1);
+    while (kvd.size() % 4) kvd.push_back(0);
+
+    Ktx2Header header = {};
+    header.vkFormat = vkFormatOf(texture.format);
+    header.typeSize = 1;
+    header.pixelWidth = static_cast<uint32_t>(texture.width);
+    header.pixelHeight = static_cast<uint32_t>(texture.height);
+    header.faceCount = 1;
+    header.levelCount = static_cast<uint32_t>(texture.levels.size());
+
+    size_t levelIndexOffset = sizeof(KTX2_IDENTIFIER) + sizeof(header);
+    header.dfdByteOffset = static_cast<uint32_t>(levelIndexOffset + texture.levels.size() * sizeof(Ktx2Level));
+    header.dfdByteLength = static_cast<uint32_t>(dfd.size());
+    header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+    header.kvdByteLength = static_cast<uint32_t>(kvd.size());
+
+    // Level data goes smallest first, each aligned to the block size
+    size_t alignment = blockFormatBlockBytes(texture.format);
+    size_t offset = header.kvdByteOffset + header.kvdByteLength;
+    std::vector<Ktx2Level> levelIndex(texture.levels.size());
+    for (size_t level = texture.levels.size(); level-- > 0;) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levelIndex[level].byteOffset = offset;
+        levelIndex[level].byteLength = texture.levels[level].size;
+        levelIndex[level].uncompressedByteLength = texture.levels[level].size;
+        offset += texture.levels[level].size;
+    }
+
+    std::vector<unsigned char> file(offset, 0);
+    std::memcpy(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    std::memcpy(file.data() + sizeof(KTX2_IDENTIFIER), &header, sizeof(header));
+    std::memcpy(file.data() + levelIndexOffset, levelIndex.data(), levelIndex.size() * sizeof(Ktx2Level));
+    std::memcpy(file.data() + header.dfdByteOffset, dfd.data(), dfd.size());
+    std::memcpy(file.data() + header.kvdByteOffset, kvd.data(), kvd.size());
+    for (size_t level = 0; level < texture.levels.size(); ++level) {
+        const CompressedLevel& source = texture.levels[level];
+        std::memcpy(file.data() + levelIndex[level].byteOffset, texture.data.data() + source.offset, source.size);
+    }
+
+    std::ofstream output(path, std::ios::binary);
+    if (!output || !output.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()))) {
+        std::cerr << "Failed to write KTX2 file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
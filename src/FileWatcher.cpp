@@ -0,0 +1,109 @@
+#include "FileWatcher.hpp"
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+#ifdef __linux__
+
+static const uint32_t WATCH_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+bool FileWatcher::addWatch(const std::string& directory) {
+    int watch = inotify_add_watch(descriptor, directory.c_str(), WATCH_EVENTS);
+    if (watch < 0) {
+        std::cerr << "Failed to watch " << directory << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    directories[watch] = directory;
+    return true;
+}
+
+bool FileWatcher::watch(const std::string& directory) {
+    if (descriptor < 0) {
+        descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (descriptor < 0) {
+            std::cerr << "Failed to start file watcher: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    if (!std::filesystem::is_directory(directory, error)) {
+        std::cerr << "Not a directory, not watching: " << directory << std::endl;
+        return false;
+    }
+    if (!addWatch(directory)) return false;
+
+    // inotify is not recursive
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (error) break;
+        if (it->is_directory(error)) addWatch(it->path().string());
+    }
+    return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> written;
+    if (descriptor < 0) return written;
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        ssize_t length = read(descriptor, buffer, sizeof(buffer));
+        if (length <= 0) break;   // EAGAIN: nothing more queued
+
+        for (char* next = buffer; next < buffer + length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+            next += sizeof(inotify_event) + event->len;
+
+            auto directory = directories.find(event->wd);
+            if (directory == directories.end() || event->len == 0) continue;
+            std::string path = directory->second + "/" + event->name;
+
+            if (event->mask & IN_ISDIR) {
+                // New directory: watch it; files already in it were written before it was watched
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) watch(path);
+                continue;
+            }
+            // IN_CREATE alone is an empty file, its IN_CLOSE_WRITE follows
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) written.push_back(path);
+        }
+    }
+    return written;
+}
+
+void FileWatcher::stop() {
+    if (descriptor >= 0) close(descriptor);
+    descriptor = -1;
+    directories.clear();
+}
+
+#else
+
+bool FileWatcher::addWatch(const std::string&) {
+    return false;
+}
+
+bool FileWatcher::watch(const std::string& directory) {
+    std::cerr << "File watching is not supported on this platform: " << directory << std::endl;
+    return false;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    return {};
+}
+
+void FileWatcher::stop() {}
+
+#endif
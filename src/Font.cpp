@@ -1,29 +1,37 @@
 #include "Font.hpp"
+#include "GLStateCache.hpp"
+#include "VirtualFileSystem.hpp"
+#include <algorithm>
 #include <ft2build.h>
 #include <glm/ext/matrix_clip_space.hpp>
 #include FT_FREETYPE_H
 
-Font::Font() : VAO(0), VBO(0), m_tileShader() {
-    m_tileShader.loadFromFile("./shaders/textVert.glsl", "./shaders/textFrag.glsl");
-    m_tileShader.use();
-}
+Font::Font() : VAO(0), VBO(0), textShader(ResourceManager<Shader>::getInstance().getHandle("textShader")) {}
 
 Font::~Font() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    GLStateCache::getInstance().deleteVertexArrays(1, &VAO);
+    GLStateCache::getInstance().deleteBuffers(1, &VBO);
 }
 
 bool Font::loadFromFile(const std::string& fontPath, unsigned int fontSize) {
-    // Initialize FreeType
+    std::map<char, GlyphBitmap> glyphs;
+    if (!rasterize(fontPath, fontSize, glyphs)) return false;
+    return upload(glyphs);
+}
+
+bool Font::rasterize(const std::string& fontPath, unsigned int fontSize, std::map<char, GlyphBitmap>& glyphs) {
+    // Initialize FreeType (one library per call, so workers can rasterize in parallel)
     FT_Library ft;
     if (FT_Init_FreeType(&ft)) {
         std::cerr << "ERROR::FREETYPE: Could not initialize FreeType Library" << std::endl;
         return false;
     }
 
-    // Load font face
+    // Load font face (FreeType reads from the buffer until FT_Done_Face)
+    FileBuffer file;
     FT_Face face;
-    if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
+    if (!VirtualFileSystem::getInstance().read(fontPath, file)
+        || FT_New_Memory_Face(ft, file.data(), static_cast<FT_Long>(file.size()), 0, &face)) {
         std::cerr << "ERROR::FREETYPE: Failed to load font" << std::endl;
         FT_Done_FreeType(ft);
         return false;
@@ -33,27 +41,52 @@ bool Font::loadFromFile(const std::string& fontPath, unsigned int fontSize) {
     FT_Set_Pixel_Sizes(face, 0, fontSize);
 
     // Load characters
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Disable byte-alignment restriction
     for (unsigned char c = 0; c < 128; ++c) {
         if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
             std::cerr << "ERROR::FREETYPE: Failed to load glyph '" << c << "'" << std::endl;
             continue;
         }
 
+        const FT_Bitmap& bitmap = face->glyph->bitmap;
+        GlyphBitmap glyph;
+        glyph.Size = glm::ivec2(bitmap.width, bitmap.rows);
+        glyph.Bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+        glyph.Advance = static_cast<unsigned int>(face->glyph->advance.x);
+
+        // Copy out tightly packed; FreeType's pitch may pad the rows
+        glyph.pixels.resize(static_cast<size_t>(bitmap.width) * bitmap.rows);
+        for (unsigned int row = 0; row < bitmap.rows; ++row) {
+            std::copy(bitmap.buffer + row * bitmap.pitch, bitmap.buffer + row * bitmap.pitch + bitmap.width,
+                      glyph.pixels.begin() + static_cast<size_t>(row) * bitmap.width);
+        }
+        glyphs[static_cast<char>(c)] = std::move(glyph);
+    }
+
+    // Clean up FreeType resources
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+    return true;
+}
+
+bool Font::upload(const std::map<char, GlyphBitmap>& glyphs) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Disable byte-alignment restriction
+    for (const auto& entry : glyphs) {
+        const GlyphBitmap& glyph = entry.second;
+
         // Generate texture
         unsigned int texture;
         glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, texture);
         glTexImage2D(
             GL_TEXTURE_2D,
             0,
             GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
+            glyph.Size.x,
+            glyph.Size.y,
             0,
             GL_RED,
             GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
+            glyph.pixels.empty() ? nullptr : glyph.pixels.data()
         );
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -63,42 +96,45 @@ bool Font::loadFromFile(const std::string& fontPath, unsigned int fontSize) {
         // Store character information
         Character character = {
             texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            static_cast<unsigned int>(face->glyph->advance.x)
+            glyph.Size,
+            glyph.Bearing,
+            glyph.Advance
         };
-        Characters.insert(std::pair<char, Character>(c, character));
+        Characters.insert(std::pair<char, Character>(entry.first, character));
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    // Clean up FreeType resources
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, 0);
 
     // Generate VAO and VBO for text rendering
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLStateCache::getInstance().bindVertexArray(VAO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::getInstance().bindVertexArray(0);
 
     return true;
 }
 
 bool Font::renderText(std::string text, float x, float y, float scale, glm::vec3 color) {
+    // Still loading (see ResourceManager::loadAsync): nothing to draw yet
+    if (!VAO) return false;
+
+    Shader* shader = ResourceManager<Shader>::getInstance().get(textShader);
+    if (!shader) return false;
+
     // Activate shader
-    glDisable(GL_DEPTH_TEST);
-    std::shared_ptr<Shader> shader = ResourceManager<Shader>::getInstance().get("textShader");
+    auto& glState = GLStateCache::getInstance();
+    glState.disable(GL_DEPTH_TEST);
     shader -> use();
     shader -> setVec3("textColor", color);
-    shader -> setMat4("projection", glm::ortho(0.0f, static_cast<float>(1200), 0.0f, static_cast<float>(800)));
+    // Screen projection comes from the FrameConstants block
     shader -> setInt("text", 0); // Set the sampler to use texture unit 0
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(VAO);
+    glState.activeTexture(GL_TEXTURE0);
+    glState.bindVertexArray(VAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, VBO);
 
     // Iterate through characters
     for (const char& c : text) {
@@ -122,12 +158,10 @@ bool Font::renderText(std::string text, float x, float y, float scale, glm::vec3
         };
 
         // Render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
+        glState.bindTexture(GL_TEXTURE_2D, ch.TextureID);
 
         // Update VBO
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         // Draw quad
         glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -136,8 +170,6 @@ bool Font::renderText(std::string text, float x, float y, float scale, glm::vec3
         x += (ch.Advance >> 6) * scale; // Bitshift by 6 to get value in pixels
     }
 
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_DEPTH_TEST);
+    glState.disable(GL_DEPTH_TEST);
     return true;
 }
@@ -0,0 +1,228 @@
+#include "GLStateCache.hpp"
+
+GLStateCache& GLStateCache::getInstance() {
+    static GLStateCache instance;
+    return instance;
+}
+
+int GLStateCache::bufferSlot(GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER:         return ARRAY_BUFFER;
+        case GL_ELEMENT_ARRAY_BUFFER: return ELEMENT_ARRAY_BUFFER;
+        case GL_UNIFORM_BUFFER:       return UNIFORM_BUFFER;
+        case GL_TEXTURE_BUFFER:       return TEXTURE_BUFFER;
+        case GL_DRAW_INDIRECT_BUFFER: return DRAW_INDIRECT_BUFFER;
+        case GL_PIXEL_UNPACK_BUFFER:  return PIXEL_UNPACK_BUFFER;
+        case GL_PIXEL_PACK_BUFFER:    return PIXEL_PACK_BUFFER;
+        default:                      return -1;
+    }
+}
+
+int GLStateCache::textureSlot(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D:       return TEXTURE_2D;
+        case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+        case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+        case GL_TEXTURE_BUFFER:   return TEXTURE_BUFFER_TARGET;
+        default:                  return -1;
+    }
+}
+
+int GLStateCache::capabilitySlot(GLenum cap) {
+    switch (cap) {
+        case GL_BLEND:        return BLEND;
+        case GL_DEPTH_TEST:   return DEPTH_TEST;
+        case GL_CULL_FACE:    return CULL_FACE;
+        case GL_SCISSOR_TEST: return SCISSOR_TEST;
+        case GL_STENCIL_TEST: return STENCIL_TEST;
+        default:              return -1;
+    }
+}
+
+void GLStateCache::useProgram(GLuint newProgram) {
+    if (program == newProgram) {
+        stats.callsSkipped++;
+        return;
+    }
+    glUseProgram(newProgram);
+    program = newProgram;
+    stats.callsIssued++;
+}
+
+void GLStateCache::bindVertexArray(GLuint newVertexArray) {
+    if (vertexArray == newVertexArray) {
+        stats.callsSkipped++;
+        return;
+    }
+    glBindVertexArray(newVertexArray);
+    vertexArray = newVertexArray;
+    // The element buffer binding belongs to the vertex array
+    buffers[ELEMENT_ARRAY_BUFFER] = UNKNOWN;
+    stats.callsIssued++;
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+    int slot = bufferSlot(target);
+    if (slot >= 0 && buffers[slot] == buffer) {
+        stats.callsSkipped++;
+        return;
+    }
+    glBindBuffer(target, buffer);
+    if (slot >= 0) buffers[slot] = buffer;
+    stats.callsIssued++;
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    // Indexed bindings are not tracked, but this also sets the generic binding
+    glBindBufferBase(target, index, buffer);
+    int slot = bufferSlot(target);
+    if (slot >= 0) buffers[slot] = buffer;
+    stats.callsIssued++;
+}
+
+void GLStateCache::activeTexture(GLenum unit) {
+    GLuint index = unit - GL_TEXTURE0;
+    if (activeUnit == index) {
+        stats.callsSkipped++;
+        return;
+    }
+    glActiveTexture(unit);
+    activeUnit = index;
+    stats.callsIssued++;
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture) {
+    int slot = textureSlot(target);
+    bool tracked = slot >= 0 && activeUnit < static_cast<GLuint>(MAX_TRACKED_TEXTURE_UNITS);
+    if (tracked && textures[activeUnit][slot] == texture) {
+        stats.callsSkipped++;
+        return;
+    }
+    glBindTexture(target, texture);
+    if (tracked) textures[activeUnit][slot] = texture;
+    stats.callsIssued++;
+}
+
+void GLStateCache::bindTextureUnit(GLuint unit, GLenum target, GLuint texture) {
+    int slot = textureSlot(target);
+    if (slot >= 0 && unit < static_cast<GLuint>(MAX_TRACKED_TEXTURE_UNITS) && textures[unit][slot] == texture) {
+        stats.callsSkipped++;
+        return;
+    }
+    activeTexture(GL_TEXTURE0 + unit);
+    bindTexture(target, texture);
+}
+
+void GLStateCache::enable(GLenum cap) {
+    setEnabled(cap, true);
+}
+
+void GLStateCache::disable(GLenum cap) {
+    setEnabled(cap, false);
+}
+
+void GLStateCache::setEnabled(GLenum cap, bool enabled) {
+    int slot = capabilitySlot(cap);
+    CapabilityState state = enabled ? CAP_ON : CAP_OFF;
+    if (slot >= 0 && capabilities[slot] == state) {
+        stats.callsSkipped++;
+        return;
+    }
+    if (enabled) glEnable(cap);
+    else glDisable(cap);
+    if (slot >= 0) capabilities[slot] = state;
+    stats.callsIssued++;
+}
+
+bool GLStateCache::isEnabled(GLenum cap) {
+    int slot = capabilitySlot(cap);
+    if (slot < 0) return glIsEnabled(cap) == GL_TRUE;
+
+    if (capabilities[slot] == CAP_UNKNOWN) {
+        capabilities[slot] = glIsEnabled(cap) ? CAP_ON : CAP_OFF;
+    }
+    return capabilities[slot] == CAP_ON;
+}
+
+void GLStateCache::blendFunc(GLenum source, GLenum destination) {
+    blendFuncSeparate(source, destination, source, destination);
+}
+
+void GLStateCache::blendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha) {
+    if (blendFactorsKnown && blendFactors[0] == sourceRGB && blendFactors[1] == destinationRGB
+        && blendFactors[2] == sourceAlpha && blendFactors[3] == destinationAlpha) {
+        stats.callsSkipped++;
+        return;
+    }
+    glBlendFuncSeparate(sourceRGB, destinationRGB, sourceAlpha, destinationAlpha);
+    blendFactors[0] = sourceRGB;
+    blendFactors[1] = destinationRGB;
+    blendFactors[2] = sourceAlpha;
+    blendFactors[3] = destinationAlpha;
+    blendFactorsKnown = true;
+    stats.callsIssued++;
+}
+
+void GLStateCache::getBlendFunc(GLenum factors[4]) {
+    if (!blendFactorsKnown) {
+        const GLenum queries[4] = { GL_BLEND_SRC_RGB, GL_BLEND_DST_RGB, GL_BLEND_SRC_ALPHA, GL_BLEND_DST_ALPHA };
+        for (int i = 0; i < 4; ++i) {
+            GLint value = 0;
+            glGetIntegerv(queries[i], &value);
+            blendFactors[i] = static_cast<GLenum>(value);
+        }
+        blendFactorsKnown = true;
+    }
+    for (int i = 0; i < 4; ++i) factors[i] = blendFactors[i];
+}
+
+// GL unbinds deleted objects, so a cached binding to one is now 0
+void GLStateCache::deleteProgram(GLuint deletedProgram) {
+    // A program in use stays in use until another is bound
+    glDeleteProgram(deletedProgram);
+    if (program == deletedProgram) program = UNKNOWN;
+}
+
+void GLStateCache::deleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (vertexArrays[i] != 0 && vertexArray == vertexArrays[i]) {
+            vertexArray = 0;
+            buffers[ELEMENT_ARRAY_BUFFER] = UNKNOWN;
+        }
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GLStateCache::deleteBuffers(GLsizei count, const GLuint* deletedBuffers) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (deletedBuffers[i] == 0) continue;
+        for (GLuint& bound : buffers) {
+            if (bound == deletedBuffers[i]) bound = 0;
+        }
+    }
+    glDeleteBuffers(count, deletedBuffers);
+}
+
+void GLStateCache::deleteTextures(GLsizei count, const GLuint* deletedTextures) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (deletedTextures[i] == 0) continue;
+        for (auto& unit : textures) {
+            for (GLuint& bound : unit) {
+                if (bound == deletedTextures[i]) bound = 0;
+            }
+        }
+    }
+    glDeleteTextures(count, deletedTextures);
+}
+
+void GLStateCache::invalidate() {
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (GLuint& bound : buffers) bound = UNKNOWN;
+    for (auto& unit : textures) {
+        for (GLuint& bound : unit) bound = UNKNOWN;
+    }
+    for (auto& capability : capabilities) capability = CAP_UNKNOWN;
+    blendFactorsKnown = false;
+}
@@ -0,0 +1,51 @@
+#include "GLUploadQueue.hpp"
+#include <chrono>
+
+GLUploadQueue& GLUploadQueue::getInstance() {
+    static GLUploadQueue instance;
+    return instance;
+}
+
+void GLUploadQueue::push(std::function<void()> upload) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uploads.push_back(std::move(upload));
+    }
+    pushed.notify_one();
+}
+
+size_t GLUploadQueue::process(double budgetMs) {
+    using Clock = std::chrono::high_resolution_clock;
+    auto start = Clock::now();
+    size_t ran = 0;
+
+    for (;;) {
+        std::function<void()> upload;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (uploads.empty()) break;
+            upload = std::move(uploads.front());
+            uploads.pop_front();
+        }
+
+        // Uploads may push more work (or finish futures others wait on), so
+        // run them without holding the lock
+        upload();
+        ++ran;
+
+        if (std::chrono::duration<double, std::milli>(Clock::now() - start).count() >= budgetMs) break;
+    }
+
+    lastProcessTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return ran;
+}
+
+bool GLUploadQueue::waitForWork(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return pushed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]() { return !uploads.empty(); });
+}
+
+size_t GLUploadQueue::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return uploads.size();
+}
@@ -0,0 +1,107 @@
+#include "GlobalResources.hpp"
+#include "ResourceManager.hpp"
+#include <string>
+#include <vector>
+
+struct ShaderEntry {
+    const char* key;
+    const char* vertexPath;
+    const char* fragmentPath;
+};
+
+struct FileEntry {
+    const char* key;
+    const char* path;
+};
+
+struct FontEntry {
+    const char* key;
+    const char* path;
+    unsigned int size;
+};
+
+static const std::vector<ShaderEntry> shaders = {
+    { "skyboxShader", "./shaders/skyboxVert.glsl", "./shaders/skyboxFrag.glsl" },
+    { "uiShader", "./shaders/imageVert.glsl", "./shaders/imageFrag.glsl" },
+    { "textShader", "./shaders/textVert.glsl", "./shaders/textFrag.glsl" },
+    { "chunkShader", "./shaders/chunkVert.glsl", "./shaders/chunkFrag.glsl" },
+    { "playerShader", "./shaders/playerVert.glsl", "./shaders/playerFrag.glsl" },
+    { "modelShader", "./shaders/modelVert.glsl", "./shaders/modelFrag.glsl" },
+    { "treeShader", "./shaders/treeShaderVert.glsl", "./shaders/treeShaderFrag.glsl" },
+};
+
+static const std::vector<FileEntry> textures = {
+    { "buttonTexture", "./assets/textures/buttonTexture.png" },
+    { "inventoryBarTexture", "./assets/textures/inventoryBarTexture.png" },
+    { "textBoxTexture", "./assets/textures/textbox_01.png" },
+    { "cursorTexture", "./assets/textures/cursor_01.png" },
+    { "tileTexture", "./assets/textures/cursorTexture.png" },
+    { "playerTexture", "./assets/textures/t1.png" },
+    { "shovelIcon", "./assets/textures/shovel_01.png" },
+    { "handgunIcon", "./assets/textures/handgun_01.png" },
+    { "dirtIcon", "./assets/textures/dirtIcon.png" },
+    { "ammunitionIcon", "./assets/textures/ammunition_01.png" },
+    { "npc_dialog_bg", "./assets/textures/npc_menu_box.png" },
+    { "npc_portrait_default", "./assets/textures/npc_portrait_default.png" },
+    { "inventory_menu_bg", "./assets/textures/inventory_dialog_bg.png" },
+};
+
+static const std::vector<std::string> chunkArrayFiles = {
+    "./assets/textures/water_01.png",
+    "./assets/textures/sand_01.png",
+    "./assets/textures/grass_01.png",
+    "./assets/textures/dirt_01.png",
+    "./assets/textures/stone_01.png",
+};
+
+static const std::vector<std::string> skyboxFaces = {
+    "./assets/skybox/right.jpg",
+    "./assets/skybox/left.jpg",
+    "./assets/skybox/top.jpg",
+    "./assets/skybox/bottom.jpg",
+    "./assets/skybox/front.jpg",
+    "./assets/skybox/back.jpg"
+};
+
+static const std::vector<FontEntry> fonts = {
+    { "titleFont", "./assets/fonts/FacultyGlyphic.ttf", 40 },
+    { "headerFont", "./assets/fonts/FacultyGlyphic.ttf", 25 },
+    { "Faculty-Glyphic", "./assets/fonts/FacultyGlyphic.ttf", 16 },
+    { "default", "./assets/fonts/FacultyGlyphic.ttf", 16 },
+};
+
+void loadGlobalShaders() {
+    for (const auto& shader : shaders) {
+        ResourceManager<Shader>::getInstance().load(shader.key, shader.vertexPath, shader.fragmentPath);
+    }
+}
+
+void loadGlobalResources() {
+    loadGlobalShaders();
+    for (const auto& texture : textures) {
+        ResourceManager<Texture>::getInstance().load(texture.key, texture.path);
+    }
+    ResourceManager<Texture>::getInstance().loadTextureArray("chunkArray", chunkArrayFiles);
+    ResourceManager<Texture>::getInstance().loadCubemap("skyboxTexture", skyboxFaces);
+    for (const auto& font : fonts) {
+        ResourceManager<Font>::getInstance().load(font.key, font.path, font.size);
+    }
+}
+
+void loadGlobalResourcesAsync() {
+    // Shaders first so their (small) reads come back ahead of the image decodes
+    for (const auto& shader : shaders) {
+        ResourceManager<Shader>::getInstance().loadAsync(shader.key, shader.vertexPath, shader.fragmentPath);
+    }
+    // Larger decodes first, they gate the end of loading
+    ResourceManager<Texture>::getInstance().loadCubemapAsync("skyboxTexture", skyboxFaces);
+    ResourceManager<Texture>::getInstance().loadTextureArrayAsync("chunkArray", chunkArrayFiles);
+    for (const auto& texture : textures) {
+        ResourceManager<Texture>::getInstance().loadAsync(texture.key, texture.path);
+    }
+    for (const auto& font : fonts) {
+        ResourceManager<Font>::getInstance().loadAsync(font.key, font.path, font.size);
+    }
+
+    ResourceManager<Shader>::getInstance().waitForPending();
+}
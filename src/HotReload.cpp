@@ -0,0 +1,221 @@
+#include "HotReload.hpp"
+#include "GLUploadQueue.hpp"
+#include "ResourceManager.hpp"
+#include "TextureAtlas.hpp"
+#include "ThreadPool.hpp"
+#include "VirtualFileSystem.hpp"
+#include "stb_image.h"
+#include <filesystem>
+#include <iostream>
+
+// Source images a KTX2/DDS file may have been built from (see findCompressedVariant)
+static const char* const SOURCE_IMAGE_EXTENSIONS[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+
+static bool isCompressedFile(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    return extension == ".ktx2" || extension == ".dds";
+}
+
+HotReload& HotReload::getInstance() {
+    static HotReload instance;
+    return instance;
+}
+
+bool HotReload::start(const std::vector<std::string>& directories) {
+    for (const auto& directory : directories) {
+        if (watcher.watch(directory)) running = true;
+    }
+    if (running) std::cout << "Hot reload: watching for changed files" << std::endl;
+    return running;
+}
+
+void HotReload::stop() {
+    watcher.stop();
+    changed.clear();
+    running = false;
+}
+
+bool HotReload::isLatest(const std::string& resource, uint64_t serial) const {
+    auto it = serials.find(resource);
+    return it != serials.end() && it->second == serial;
+}
+
+void HotReload::process() {
+    if (!running) return;
+
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& path : watcher.poll()) changed[path] = now;
+
+    for (auto it = changed.begin(); it != changed.end();) {
+        if (now - it->second < std::chrono::milliseconds(SETTLE_MS) || !reloadFile(it->first)) {
+            ++it;
+            continue;
+        }
+        it = changed.erase(it);
+    }
+}
+
+bool HotReload::reloadFile(const std::string& path) {
+    // Loaders read packed files from the pack, not from the edited loose copy
+    if (VirtualFileSystem::getInstance().isPacked(path)) {
+        std::cerr << "Hot reload: " << path << " is served from a pack, not reloading" << std::endl;
+        return true;
+    }
+
+    auto& textures = ResourceManager<Texture>::getInstance();
+    auto& shaders = ResourceManager<Shader>::getInstance();
+
+    // A KTX2/DDS file stands in for its source image, which is what resources are keyed by
+    std::filesystem::path file(path);
+    bool compressed = isCompressedFile(file);
+    std::vector<std::string> textureKeys;
+    if (compressed) {
+        for (const char* extension : SOURCE_IMAGE_EXTENSIONS) {
+            for (const auto& key : textures.findKeysForFile(std::filesystem::path(file).replace_extension(extension).string())) {
+                textureKeys.push_back(key);
+            }
+        }
+    } else {
+        textureKeys = textures.findKeysForFile(path);
+    }
+    std::vector<std::string> shaderKeys = shaders.findKeysForFile(path);
+
+    // A load still in flight may have read the old file; reload once it has landed
+    for (const auto& key : textureKeys) if (!textures.isReady(key)) return false;
+    for (const auto& key : shaderKeys) if (!shaders.isReady(key)) return false;
+
+    if (!textureKeys.empty() && !compressed && !findCompressedVariant(path).empty()) {
+        std::cerr << "Hot reload: " << path << " changed but its compressed version did not; "
+                  << "using the image until that is rebuilt" << std::endl;
+    }
+    for (const auto& key : textureKeys) reloadTexture(key, compressed);
+    for (const auto& key : shaderKeys) reloadShader(key);
+    if (!compressed) {
+        for (const auto& sprite : TextureAtlasManager::getInstance().findSpritesForFile(path)) {
+            reloadSprite(sprite.first, sprite.second, path);
+        }
+    }
+    return true;
+}
+
+void HotReload::reloadTexture(const std::string& key, bool allowCompressed) {
+    auto& textures = ResourceManager<Texture>::getInstance();
+    ResourceHandle<Texture> handle = textures.getHandle(key);
+    Texture* texture = textures.get(handle);
+    if (!texture) return;
+
+    std::string resource = "texture:" + key;
+    uint64_t serial = beginReload(resource);
+    std::vector<std::string> files = textures.getSourceFiles(key);
+
+    if (texture->getType() != TextureType::TEXTURE_2D) {
+        // Faces and layers share one format, so they are decoded and replaced together.
+        // Array mips are built here so neither upload runs glGenerateMipmap on the GL thread.
+        TextureType type = texture->getType();
+        auto images = std::make_shared<std::vector<TextureImage>>();
+        ThreadPool::getInstance().submit([this, key, resource, serial, handle, type, files, images, allowCompressed]() {
+            bool decoded = Texture::decodeLayers(files, *images, allowCompressed);
+            if (decoded && type == TextureType::TEXTURE_ARRAY) {
+                for (auto& image : *images) Texture::buildMips(image);
+            }
+            GLUploadQueue::getInstance().push([this, key, resource, serial, handle, type, images, decoded]() {
+                if (!decoded) {
+                    std::cerr << "Hot reload failed, keeping the previous texture: " << key << std::endl;
+                    return;
+                }
+                if (!isLatest(resource, serial)) return;
+
+                // Streamed into a staging texture and copied over once complete, as for 2D
+                auto staging = std::make_shared<Texture>(type);
+                auto swap = [this, key, resource, serial, handle, type, images, staging](bool uploaded) {
+                    Texture* live = ResourceManager<Texture>::getInstance().get(handle);
+                    if (!uploaded || !live || !isLatest(resource, serial)) return;
+                    bool replaced = live->copyLevelsFrom(*staging)
+                        || (type == TextureType::CUBEMAP ? live->uploadCubemap(*images)
+                                                         : live->uploadTextureArray(*images));
+                    if (!replaced) {
+                        std::cerr << "Hot reload failed, keeping the previous texture: " << key << std::endl;
+                        return;
+                    }
+                    ++reloadCount;
+                    std::cout << "Reloaded texture: " << key << std::endl;
+                };
+                if (type == TextureType::CUBEMAP) {
+                    staging->streamCubemap(images, swap);
+                } else {
+                    staging->streamTextureArray(images, swap);
+                }
+            });
+        });
+        return;
+    }
+
+    auto image = std::make_shared<TextureImage>();
+    std::string file = files.empty() ? std::string() : files[0];
+    ThreadPool::getInstance().submit([this, key, resource, serial, handle, file, image, allowCompressed]() {
+        bool decoded = Texture::decode(file, *image, allowCompressed);
+        if (decoded) Texture::buildMips(*image);
+        GLUploadQueue::getInstance().push([this, key, resource, serial, handle, image, decoded]() {
+            if (!decoded) {
+                std::cerr << "Hot reload failed, keeping the previous texture: " << key << std::endl;
+                return;
+            }
+            if (!isLatest(resource, serial)) return;
+
+            // Streamed into a texture of its own; the live one keeps drawing the old
+            // pixels until every level is there, then takes them all at once
+            auto staging = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+            staging->streamUpload(image, [this, key, resource, serial, handle, image, staging](bool uploaded) {
+                Texture* live = ResourceManager<Texture>::getInstance().get(handle);
+                if (!uploaded || !live || !isLatest(resource, serial)) return;
+                // A new size or format can't be copied; respecify under the same name
+                if (!live->copyLevelsFrom(*staging) && !live->upload(*image)) {
+                    std::cerr << "Hot reload failed, keeping the previous texture: " << key << std::endl;
+                    return;
+                }
+                ++reloadCount;
+                std::cout << "Reloaded texture: " << key << std::endl;
+            });
+        });
+    });
+}
+
+void HotReload::reloadShader(const std::string& key) {
+    auto& shaders = ResourceManager<Shader>::getInstance();
+    ResourceHandle<Shader> handle = shaders.getHandle(key);
+    std::vector<std::string> files = shaders.getSourceFiles(key);
+    if (!shaders.get(handle) || files.size() != 2) return;
+
+    std::string resource = "shader:" + key;
+    uint64_t serial = beginReload(resource);
+    auto sources = std::make_shared<std::pair<std::string, std::string>>();
+    ThreadPool::getInstance().submit([this, key, resource, serial, handle, files, sources]() {
+        bool read = Shader::readSource(files[0].c_str(), sources->first)
+                    && Shader::readSource(files[1].c_str(), sources->second);
+        GLUploadQueue::getInstance().push([this, key, resource, serial, handle, sources, read]() {
+            Shader* live = ResourceManager<Shader>::getInstance().get(handle);
+            if (!read || !live || !isLatest(resource, serial)) return;
+            if (live->reload(sources->first, sources->second, key)) ++reloadCount;
+        });
+    });
+}
+
+void HotReload::reloadSprite(std::shared_ptr<TextureAtlas> atlas, const std::string& spriteName, const std::string& path) {
+    std::string resource = "sprite:" + std::to_string(reinterpret_cast<uintptr_t>(atlas.get())) + ":" + spriteName;
+    uint64_t serial = beginReload(resource);
+    ThreadPool::getInstance().submit([this, atlas, spriteName, path, resource, serial]() {
+        int width = 0, height = 0, channels = 0;
+        std::shared_ptr<unsigned char> pixels(stbi_load(path.c_str(), &width, &height, &channels, 4), stbi_image_free);
+        GLUploadQueue::getInstance().push([this, atlas, spriteName, path, resource, serial, pixels, width, height]() {
+            if (!pixels) {
+                std::cerr << "Hot reload failed to load sprite: " << path << std::endl;
+                return;
+            }
+            if (!isLatest(resource, serial)) return;
+            if (atlas->replaceSprite(spriteName, pixels.get(), width, height)) {
+                ++reloadCount;
+                std::cout << "Reloaded sprite: " << spriteName << std::endl;
+            }
+        });
+    });
+}
@@ -0,0 +1,238 @@
+#include "LightRenderer2D.hpp"
+#include "ECS/Components.hpp"
+#include "GLStateCache.hpp"
+#include "ShaderCache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+// Each light is a quad around its position; quad corners come from gl_VertexID
+static const char* lightVertexShaderSource = R"glsl(
+#version 330 core
+layout (location = 0) in vec4 aPositionRadius;
+layout (location = 1) in vec4 aColorIntensity;
+
+uniform mat4 uViewProjection;
+
+out vec2 vLocal;
+out vec3 vLight;
+
+void main() {
+    vLocal = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    vec2 world = aPositionRadius.xy + vLocal * aPositionRadius.w;
+    gl_Position = uViewProjection * vec4(world, 0.0, 1.0);
+    vLight = aColorIntensity.rgb * aColorIntensity.a;
+}
+)glsl";
+
+static const char* lightFragmentShaderSource = R"glsl(
+#version 330 core
+in vec2 vLocal;
+in vec3 vLight;
+
+out vec4 FragColor;
+
+void main() {
+    // Smooth quadratic falloff reaching zero at the radius
+    float falloff = clamp(1.0 - length(vLocal), 0.0, 1.0);
+    FragColor = vec4(vLight * falloff * falloff, 1.0);
+}
+)glsl";
+
+// LightMapBinding
+void LightMapBinding::locate(GLuint program) {
+    GLStateCache::getInstance().useProgram(program);
+    glUniform1i(glGetUniformLocation(program, "uLightMap"), LIGHT_MAP_TEXTURE_UNIT);
+    enabledLocation = glGetUniformLocation(program, "uLightingEnabled");
+    inverseViewportLocation = glGetUniformLocation(program, "uInverseViewport");
+}
+
+void LightMapBinding::apply() const {
+    const auto& lighting = LightRenderer2D::getInstance();
+    if (!lighting.isEnabled()) {
+        glUniform1i(enabledLocation, 0);
+        return;
+    }
+
+    GLStateCache::getInstance().bindTextureUnit(LIGHT_MAP_TEXTURE_UNIT, GL_TEXTURE_2D, lighting.getLightMapTexture());
+    glUniform1i(enabledLocation, 1);
+    glUniform2f(inverseViewportLocation, lighting.getInverseViewportWidth(), lighting.getInverseViewportHeight());
+}
+
+// LightRenderer2D
+LightRenderer2D& LightRenderer2D::getInstance() {
+    static LightRenderer2D instance;
+    return instance;
+}
+
+void LightRenderer2D::init() {
+    if (initialized) return;
+
+    shaderProgram = ShaderCache::getInstance().acquire(lightVertexShaderSource, lightFragmentShaderSource, "light");
+    viewProjectionLocation = glGetUniformLocation(shaderProgram, "uViewProjection");
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &instanceVBO);
+    GLStateCache::getInstance().bindVertexArray(VAO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(PackedLight2D), (void*)offsetof(PackedLight2D, positionRadius));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PackedLight2D), (void*)offsetof(PackedLight2D, colorIntensity));
+    for (GLuint location = 0; location <= 1; ++location) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    GLStateCache::getInstance().bindVertexArray(0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glGenTextures(1, &lightMapTexture);
+
+    initialized = true;
+}
+
+void LightRenderer2D::shutdown() {
+    if (VAO) GLStateCache::getInstance().deleteVertexArrays(1, &VAO);
+    if (instanceVBO) GLStateCache::getInstance().deleteBuffers(1, &instanceVBO);
+    ShaderCache::getInstance().release(shaderProgram);
+    if (framebuffer) glDeleteFramebuffers(1, &framebuffer);
+    if (lightMapTexture) GLStateCache::getInstance().deleteTextures(1, &lightMapTexture);
+    if (lightBlockBuffer) GLStateCache::getInstance().deleteBuffers(1, &lightBlockBuffer);
+    VAO = instanceVBO = shaderProgram = framebuffer = lightMapTexture = lightBlockBuffer = 0;
+    instanceCapacity = 0;
+    lightMapWidth = lightMapHeight = 0;
+    initialized = false;
+}
+
+void LightRenderer2D::addLight(const LightSourceComponent2D& light) {
+    if (!light.enabled || light.radius <= 0.0f) return;
+
+    PackedLight2D packed;
+    packed.positionRadius = glm::vec4(light.position.x, light.position.y, 0.0f, light.radius);
+    packed.colorIntensity = glm::vec4(light.color, light.intensity);
+    lights.push_back(packed);
+}
+
+void LightRenderer2D::resizeLightMap(int width, int height) {
+    lightMapWidth = width;
+    lightMapHeight = height;
+
+    // Half float so overlapping lights can exceed 1.0 without clipping
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, lightMapTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lightMapTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Light map framebuffer is incomplete" << std::endl;
+    }
+}
+
+void LightRenderer2D::render(const glm::mat4& viewProjection, const glm::vec2& viewMin, const glm::vec2& viewMax,
+                             int viewportWidth, int viewportHeight) {
+    if (!isEnabled() || viewportWidth <= 0 || viewportHeight <= 0) return;
+
+    cullLights(viewMin, viewMax);
+    externalLightMap = 0;
+
+    // Save the state this pass touches
+    GLint previousFramebuffer = 0;
+    GLint previousViewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    GLfloat previousClearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColor);
+
+    int width = std::max(1, static_cast<int>(std::lround(viewportWidth * resolutionScale)));
+    int height = std::max(1, static_cast<int>(std::lround(viewportHeight * resolutionScale)));
+    if (width != lightMapWidth || height != lightMapHeight) {
+        resizeLightMap(width, height);
+    }
+    inverseViewport = glm::vec2(1.0f / viewportWidth, 1.0f / viewportHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, lightMapWidth, lightMapHeight);
+    glClearColor(ambient.x, ambient.y, ambient.z, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    drawLights(viewProjection);
+
+    // Restore
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    glClearColor(previousClearColor[0], previousClearColor[1], previousClearColor[2], previousClearColor[3]);
+}
+
+void LightRenderer2D::cullLights(const glm::vec2& viewMin, const glm::vec2& viewMax) {
+    // Keep lights whose radius reaches the view rectangle
+    visibleLights.clear();
+    for (const auto& light : lights) {
+        float radius = light.positionRadius.w;
+        if (light.positionRadius.x + radius < viewMin.x || light.positionRadius.x - radius > viewMax.x ||
+            light.positionRadius.y + radius < viewMin.y || light.positionRadius.y - radius > viewMax.y) {
+            continue;
+        }
+        visibleLights.push_back(light);
+    }
+    visibleLightCount = static_cast<int>(visibleLights.size());
+}
+
+void LightRenderer2D::drawLights(const glm::mat4& viewProjection) {
+    if (visibleLights.empty()) return;
+
+    auto& glState = GLStateCache::getInstance();
+    GLenum previousBlend[4];
+    glState.getBlendFunc(previousBlend);
+    bool blendWasEnabled = glState.isEnabled(GL_BLEND);
+    bool depthWasEnabled = glState.isEnabled(GL_DEPTH_TEST);
+
+    // One upload for every visible light
+    glState.bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    size_t bytes = visibleLights.size() * sizeof(PackedLight2D);
+    if (visibleLights.size() > instanceCapacity) {
+        instanceCapacity = std::max(visibleLights.size(), instanceCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(PackedLight2D), nullptr, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, visibleLights.data());
+
+    glState.disable(GL_DEPTH_TEST);
+    glState.enable(GL_BLEND);
+    glState.blendFunc(GL_ONE, GL_ONE);
+
+    glState.useProgram(shaderProgram);
+    glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+    glState.bindVertexArray(VAO);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(visibleLights.size()));
+
+    glState.blendFuncSeparate(previousBlend[0], previousBlend[1], previousBlend[2], previousBlend[3]);
+    glState.setEnabled(GL_BLEND, blendWasEnabled);
+    glState.setEnabled(GL_DEPTH_TEST, depthWasEnabled);
+}
+
+void LightRenderer2D::bindLightBlock(GLuint program) {
+    GLuint blockIndex = glGetUniformBlockIndex(program, "LightBlock2D");
+    if (blockIndex == GL_INVALID_INDEX) {
+        std::cerr << "Shader has no LightBlock2D uniform block" << std::endl;
+        return;
+    }
+    glUniformBlockBinding(program, blockIndex, LIGHT_BLOCK_BINDING);
+
+    if (!lightBlockBuffer) {
+        glGenBuffers(1, &lightBlockBuffer);
+        GLStateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, lightBlockBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(GLint) * 4 + MAX_BLOCK_LIGHTS * sizeof(PackedLight2D), nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    // ivec4 header (count in x), then the light array
+    GLint count = std::min(static_cast<int>(lights.size()), MAX_BLOCK_LIGHTS);
+    GLint header[4] = { count, 0, 0, 0 };
+    GLStateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, lightBlockBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(header), header);
+    if (count > 0) {
+        glBufferSubData(GL_UNIFORM_BUFFER, sizeof(header), count * sizeof(PackedLight2D), lights.data());
+    }
+    GLStateCache::getInstance().bindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, lightBlockBuffer);
+}
@@ -1,6 +1,7 @@
 #include "glad/glad.h"
 #include <iostream>
 #include "LoadTexture.hpp"
+#include "GLStateCache.hpp"
 #include <vector>
 #include <string>
 #define STB_IMAGE_IMPLEMENTATION
@@ -10,7 +11,7 @@ GLuint loadTexture(const char* filePath) {
     // Generate and bind a texture object
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
 
     // Set texture wrapping parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // x-axis wrap
@@ -45,7 +46,7 @@ GLuint loadCubemap(std::vector<std::string> faces)
 {
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, nrChannels;
     for (unsigned int i = 0; i < faces.size(); i++)
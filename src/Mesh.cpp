@@ -1,4 +1,5 @@
 #include "Mesh.hpp"
+#include "GLStateCache.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
@@ -11,9 +12,9 @@ Mesh::Mesh(const std::vector<float>& vertices, const std::vector<unsigned int>&
 }
 
 Mesh::~Mesh() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    GLStateCache::getInstance().deleteVertexArrays(1, &VAO);
+    GLStateCache::getInstance().deleteBuffers(1, &VBO);
+    GLStateCache::getInstance().deleteBuffers(1, &EBO);
 }
 std::vector<float> Mesh::getVertices() const {
     return m_vertices;
@@ -31,11 +32,11 @@ void Mesh::setupMesh(const std::vector<float>& vertices, const std::vector<unsig
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLStateCache::getInstance().bindVertexArray(VAO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
     constexpr GLsizei stride = 16 * sizeof(float);
@@ -60,7 +61,7 @@ void Mesh::setupMesh(const std::vector<float>& vertices, const std::vector<unsig
     glEnableVertexAttribArray(4);
     glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*)(12 * sizeof(float)));
 
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindVertexArray(0);
 }
 void Mesh::setBaseColor(glm::vec4 color) {
     baseColor = color;
@@ -74,12 +75,12 @@ void Mesh::setupStaticMesh(const std::vector<float>& vertices, const std::vector
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
+    GLStateCache::getInstance().bindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
     constexpr GLsizei stride = 6 * sizeof(float); // position (3) + normal (3)
@@ -92,7 +93,7 @@ void Mesh::setupStaticMesh(const std::vector<float>& vertices, const std::vector
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
 
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindVertexArray(0);
 }
 
 
@@ -101,8 +102,7 @@ void Mesh::draw(GLuint shaderProgram) const {
     GLint colorLoc = glGetUniformLocation(shaderProgram, "uBaseColor");
     glUniform4fv(colorLoc, 1, glm::value_ptr(baseColor));
     
-    glBindVertexArray(VAO);
+    GLStateCache::getInstance().bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
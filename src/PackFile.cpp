@@ -0,0 +1,238 @@
+#include "PackFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static uint64_t alignTo16(uint64_t offset) {
+    return (offset + 15) & ~uint64_t(15);
+}
+
+std::string normalizePackPath(const std::string& path) {
+    std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+    while (normalized.compare(0, 2, "./") == 0) normalized.erase(0, 2);
+    return normalized;
+}
+
+// LZ4 block format: sequences of [token][literal length+][literals][offset][match length+].
+// The token's high nibble is the literal length, the low one the match length - 4;
+// 15 means more length bytes follow. The last sequence is literals only.
+
+static const size_t LZ4_MIN_MATCH = 4;
+static const size_t LZ4_LAST_LITERALS = 5;   // a block ends with at least this many literals
+static const size_t LZ4_MATCH_START_LIMIT = 12;   // no match starts closer than this to the end
+static const size_t LZ4_MAX_OFFSET = 65535;
+static const int LZ4_HASH_BITS = 16;
+
+static uint32_t read32(const unsigned char* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static void writeLength(std::vector<unsigned char>& out, size_t length) {
+    for (; length >= 255; length -= 255) out.push_back(255);
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+static void writeSequence(std::vector<unsigned char>& out, const unsigned char* literals, size_t literalLength,
+                          size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength ? matchLength - LZ4_MIN_MATCH : 0;
+    out.push_back(static_cast<unsigned char>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+    if (literalLength >= 15) writeLength(out, literalLength - 15);
+    out.insert(out.end(), literals, literals + literalLength);
+    if (!matchLength) return;
+
+    out.push_back(static_cast<unsigned char>(offset & 0xFF));
+    out.push_back(static_cast<unsigned char>(offset >> 8));
+    if (matchCode >= 15) writeLength(out, matchCode - 15);
+}
+
+void lz4Compress(const unsigned char* source, size_t size, std::vector<unsigned char>& compressed) {
+    compressed.clear();
+    compressed.reserve(size + size / 255 + 16);
+
+    // Last position each 4-byte sequence was seen at, + 1 (0 = never)
+    std::vector<uint32_t> table(size_t(1) << LZ4_HASH_BITS, 0);
+    size_t anchor = 0;
+    size_t position = 0;
+    if (size > LZ4_MATCH_START_LIMIT) {
+        size_t matchEndLimit = size - LZ4_LAST_LITERALS;
+        while (position + LZ4_MATCH_START_LIMIT <= size) {
+            uint32_t sequence = read32(source + position);
+            uint32_t slot = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+            size_t candidate = table[slot];
+            table[slot] = static_cast<uint32_t>(position + 1);
+
+            if (candidate == 0 || position - (candidate - 1) > LZ4_MAX_OFFSET
+                || read32(source + candidate - 1) != sequence) {
+                ++position;
+                continue;
+            }
+
+            size_t match = candidate - 1;
+            size_t length = LZ4_MIN_MATCH;
+            while (position + length < matchEndLimit && source[match + length] == source[position + length]) ++length;
+
+            writeSequence(compressed, source + anchor, position - anchor, position - match, length);
+            position += length;
+            anchor = position;
+        }
+    }
+    writeSequence(compressed, source + anchor, size - anchor, 0, 0);
+}
+
+bool lz4Decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize) {
+    const unsigned char* in = source;
+    const unsigned char* inEnd = source + sourceSize;
+    size_t written = 0;
+
+    auto readLength = [&](size_t length) -> size_t {
+        if (length != 15) return length;
+        for (;;) {
+            if (in >= inEnd) return SIZE_MAX;
+            unsigned char next = *in++;
+            length += next;
+            if (next != 255) return length;
+        }
+    };
+
+    while (written < destinationSize) {
+        if (in >= inEnd) return false;
+        unsigned char token = *in++;
+
+        size_t literalLength = readLength(token >> 4);
+        if (literalLength == SIZE_MAX || literalLength > static_cast<size_t>(inEnd - in)) return false;
+        size_t copy = std::min(literalLength, destinationSize - written);
+        std::memcpy(destination + written, in, copy);
+        in += literalLength;
+        written += copy;
+        if (written == destinationSize) return true;
+        if (in == inEnd) return false;   // the last sequence ended short of the size
+
+        if (inEnd - in < 2) return false;
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > written) return false;
+
+        size_t matchLength = readLength(token & 0x0F);
+        if (matchLength == SIZE_MAX) return false;
+        matchLength = std::min(matchLength + LZ4_MIN_MATCH, destinationSize - written);
+
+        // Byte by byte: a match may overlap the bytes it produces
+        const unsigned char* from = destination + written - offset;
+        for (size_t i = 0; i < matchLength; ++i) destination[written + i] = from[i];
+        written += matchLength;
+    }
+    return true;
+}
+
+static bool readWholeFile(const std::string& path, std::vector<unsigned char>& bytes) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamsize size = file.tellg();
+    file.seekg(0);
+    bytes.resize(static_cast<size_t>(size));
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(bytes.data()), size));
+}
+
+bool writePackFile(const std::string& path, const std::vector<std::string>& files, bool compress,
+                   PackWriteStats* stats) {
+    // Data goes in path order; the table is sorted by hash afterwards
+    std::vector<std::string> paths;
+    for (const auto& file : files) paths.push_back(normalizePackPath(file));
+    std::vector<size_t> order(files.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return paths[a] < paths[b]; });
+
+    PackFileHeader header = {};
+    std::memcpy(header.magic, "PACK", 4);
+    header.version = PACK_FILE_VERSION;
+    header.entryCount = static_cast<uint32_t>(files.size());
+
+    std::vector<PackFileEntry> entries(files.size());
+    std::string names;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const std::string& name = paths[order[i]];
+        if (i > 0 && name == paths[order[i - 1]]) {
+            std::cerr << "File listed twice: " << name << std::endl;
+            return false;
+        }
+        PackFileEntry& entry = entries[i];
+        entry.pathHash = hashPackPath(name.data(), name.size());
+        entry.nameOffset = static_cast<uint32_t>(names.size());
+        entry.nameLength = static_cast<uint32_t>(name.size());
+        names += name;
+    }
+
+    header.entryOffset = alignTo16(sizeof(PackFileHeader));
+    header.nameOffset = alignTo16(header.entryOffset + entries.size() * sizeof(PackFileEntry));
+    header.dataOffset = alignTo16(header.nameOffset + names.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to open pack file for writing: " << path << std::endl;
+        return false;
+    }
+    // Seeking past the end and writing leaves zeros in between
+    auto writeAt = [&](uint64_t offset, const void* bytes, size_t count) {
+        out.seekp(static_cast<std::streamoff>(offset));
+        out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(count));
+    };
+
+    // File data first, one file in memory at a time; the offsets aren't known until it's written
+    PackWriteStats written;
+    uint64_t offset = header.dataOffset;
+    std::vector<unsigned char> bytes, packed;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (!readWholeFile(files[order[i]], bytes)) {
+            std::cerr << "Failed to read " << files[order[i]] << std::endl;
+            return false;
+        }
+        PackFileEntry& entry = entries[i];
+        entry.size = bytes.size();
+        entry.compression = PACK_STORED;
+
+        const std::vector<unsigned char>* data = &bytes;
+        if (compress && !bytes.empty()) {
+            lz4Compress(bytes.data(), bytes.size(), packed);
+            if (packed.size() <= bytes.size() - bytes.size() / 8) {
+                entry.compression = PACK_LZ4;
+                data = &packed;
+                ++written.compressedCount;
+            }
+        }
+        entry.offset = offset;
+        entry.storedSize = data->size();
+        writeAt(offset, data->data(), data->size());
+        offset = alignTo16(offset + data->size());
+
+        ++written.fileCount;
+        written.bytes += entry.size;
+        written.storedBytes += entry.storedSize;
+    }
+    header.fileSize = offset;
+    static const char zeros[16] = {};
+    out.write(zeros, static_cast<std::streamsize>(offset - static_cast<uint64_t>(out.tellp())));   // pad the last file
+
+    std::sort(entries.begin(), entries.end(),
+              [](const PackFileEntry& a, const PackFileEntry& b) { return a.pathHash < b.pathHash; });
+    for (size_t i = 1; i < entries.size(); ++i) {
+        if (entries[i].pathHash == entries[i - 1].pathHash) {
+            std::cerr << "Path hash collision in pack: "
+                      << names.substr(entries[i].nameOffset, entries[i].nameLength) << std::endl;
+            return false;
+        }
+    }
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.entryOffset, entries.data(), entries.size() * sizeof(PackFileEntry));
+    writeAt(header.nameOffset, names.data(), names.size());
+
+    if (!out) {
+        std::cerr << "Failed to write pack file: " << path << std::endl;
+        return false;
+    }
+    if (stats) *stats = written;
+    return true;
+}
@@ -0,0 +1,218 @@
+#include "PixelUploadRing.hpp"
+#include "GLStateCache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+size_t pixelFormatBytes(GLenum format) {
+    switch (format) {
+        case GL_RED:  return 1;
+        case GL_RG:   return 2;
+        case GL_RGB:  return 3;
+        default:      return 4;
+    }
+}
+
+size_t regionRowBytes(const PixelRegion& region) {
+    if (region.compressedFormat) return static_cast<size_t>((region.width + 3) / 4) * region.blockBytes;
+    return static_cast<size_t>(region.width) * pixelFormatBytes(region.format);
+}
+
+GLsizei regionRows(const PixelRegion& region) {
+    return region.compressedFormat ? (region.height + 3) / 4 : region.height;
+}
+
+// Cube map faces are uploaded by face but bound as the cube map
+static GLenum bindTarget(GLenum target) {
+    if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z) return GL_TEXTURE_CUBE_MAP;
+    return target;
+}
+
+// Rows [firstRow, firstRow + rows) of region from pixels, which is client
+// memory or, with a buffer bound, an offset into it
+static void submitBand(const PixelRegion& region, const unsigned char* pixels, GLsizei firstRow, GLsizei rows) {
+    GLStateCache::getInstance().bindTexture(bindTarget(region.target), region.texture);
+    if (region.compressedFormat) {
+        // Block rows are 4 texels tall; the last one may end at the edge
+        GLint y = region.y + firstRow * 4;
+        GLsizei height = std::min(rows * 4, region.height - firstRow * 4);
+        GLsizei bytes = static_cast<GLsizei>(regionRowBytes(region) * rows);
+        if (region.target == GL_TEXTURE_2D_ARRAY) {
+            glCompressedTexSubImage3D(region.target, region.level, region.x, y, region.layer, region.width, height, 1,
+                                      region.compressedFormat, bytes, pixels);
+        } else {
+            glCompressedTexSubImage2D(region.target, region.level, region.x, y, region.width, height,
+                                      region.compressedFormat, bytes, pixels);
+        }
+        return;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (region.target == GL_TEXTURE_2D_ARRAY) {
+        glTexSubImage3D(region.target, region.level, region.x, region.y + firstRow, region.layer, region.width, rows, 1,
+                        region.format, GL_UNSIGNED_BYTE, pixels);
+    } else {
+        glTexSubImage2D(region.target, region.level, region.x, region.y + firstRow, region.width, rows,
+                        region.format, GL_UNSIGNED_BYTE, pixels);
+    }
+}
+
+// Rows too wide for a slot skip the ring
+static void submitDirect(const PixelRegion& region, const unsigned char* pixels) {
+    submitBand(region, pixels, 0, regionRows(region));
+}
+
+PixelUploadRing& PixelUploadRing::getInstance() {
+    static PixelUploadRing instance;
+    return instance;
+}
+
+void PixelUploadRing::createSlots() {
+    slots.resize(SLOT_COUNT);
+    for (auto& slot : slots) {
+        glGenBuffers(1, &slot.buffer);
+        GLStateCache::getInstance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, SLOT_BYTES, nullptr, GL_STREAM_DRAW);
+    }
+    GLStateCache::getInstance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+int PixelUploadRing::acquireSlot(bool wait) {
+    if (slots.empty()) createSlots();
+
+    // Slots are used in order, so the next one is always the oldest
+    Slot& slot = slots[nextSlot];
+    if (slot.fence) {
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            if (!wait) return -1;
+            ++stats.stalls;
+            do {
+                status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+
+    int acquired = nextSlot;
+    nextSlot = (nextSlot + 1) % static_cast<int>(slots.size());
+    return acquired;
+}
+
+void PixelUploadRing::submitRows(int slotIndex, const PixelRegion& region, const unsigned char* pixels,
+                                 GLsizei firstRow, GLsizei rows) {
+    Slot& slot = slots[slotIndex];
+    size_t rowBytes = regionRowBytes(region);
+    size_t bytes = rowBytes * rows;
+
+    auto& glState = GLStateCache::getInstance();
+    glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+
+    // The fence already passed, so nothing needs to synchronize on the old contents
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!mapped) {
+        std::cerr << "Failed to map pixel upload buffer, uploading directly" << std::endl;
+        glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        submitBand(region, pixels + rowBytes * firstRow, firstRow, rows);
+        return;
+    }
+    std::memcpy(mapped, pixels + rowBytes * firstRow, bytes);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // With a buffer bound the data pointer is an offset into it
+    submitBand(region, nullptr, firstRow, rows);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // Unbound again, or every later client-memory upload would read from the buffer
+    glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    stats.bytesTotal += bytes;
+}
+
+void PixelUploadRing::upload(const PixelRegion& region, const unsigned char* pixels) {
+    size_t rowBytes = regionRowBytes(region);
+    GLsizei rowCount = regionRows(region);
+    if (rowBytes == 0 || rowCount == 0) return;
+    if (rowBytes > SLOT_BYTES) {
+        submitDirect(region, pixels);
+        return;
+    }
+
+    GLsizei rowsPerSlot = static_cast<GLsizei>(SLOT_BYTES / rowBytes);
+    for (GLsizei row = 0; row < rowCount; row += rowsPerSlot) {
+        submitRows(acquireSlot(true), region, pixels, row, std::min(rowsPerSlot, rowCount - row));
+    }
+}
+
+void PixelUploadRing::stream(const PixelRegion& region, const unsigned char* pixels, std::function<void()> done,
+                             std::function<void()> begin) {
+    Job job;
+    job.region = region;
+    job.pixels = pixels;
+    job.begin = std::move(begin);
+    job.done = std::move(done);
+    jobs.push_back(std::move(job));
+}
+
+void PixelUploadRing::process() {
+    size_t sent = 0;
+
+    while (!jobs.empty()) {
+        Job& job = jobs.front();
+        size_t rowBytes = regionRowBytes(job.region);
+        GLsizei rowCount = regionRows(job.region);
+
+        // Allocating storage costs about as much as filling it (drivers clear
+        // it), so begin() is charged the region's size
+        if (job.begin) {
+            if (sent >= frameBudget) break;
+            std::function<void()> begin = std::move(job.begin);
+            job.begin = nullptr;
+            begin();
+            sent += rowBytes * rowCount;
+            continue;
+        }
+
+        if (rowBytes > SLOT_BYTES) {
+            submitDirect(job.region, job.pixels);
+            sent += rowBytes * rowCount;
+            job.nextRow = rowCount;
+        } else if (rowBytes > 0 && job.nextRow < rowCount) {
+            size_t budgetRows = sent < frameBudget ? (frameBudget - sent) / rowBytes : 0;
+            if (budgetRows == 0 && sent > 0) break;
+
+            GLsizei rows = std::min<GLsizei>(rowCount - job.nextRow,
+                                             static_cast<GLsizei>(std::max<size_t>(1, std::min(budgetRows, SLOT_BYTES / rowBytes))));
+            int slot = acquireSlot(false);
+            if (slot < 0) break;
+            submitRows(slot, job.region, job.pixels, job.nextRow, rows);
+            job.nextRow += rows;
+            sent += rowBytes * rows;
+        }
+
+        if (job.nextRow >= rowCount) {
+            // done() may queue more work, so it runs after the job is off the queue
+            std::function<void()> done = std::move(job.done);
+            jobs.pop_front();
+            if (done) done();
+        }
+    }
+
+    stats.bytesLastFrame = sent;
+}
+
+void PixelUploadRing::cancel(GLuint texture) {
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+                              [texture](const Job& job) { return job.region.texture == texture; }),
+               jobs.end());
+}
+
+void PixelUploadRing::shutdown() {
+    for (auto& slot : slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        GLStateCache::getInstance().deleteBuffers(1, &slot.buffer);
+    }
+    slots.clear();
+    nextSlot = 0;
+    jobs.clear();
+}
@@ -0,0 +1,194 @@
+#include "RectPacker.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <numeric>
+
+RectPacker::RectPacker(int pageWidth, int pageHeight, bool allowRotation)
+    : pageWidth(pageWidth), pageHeight(pageHeight), allowRotation(allowRotation) {}
+
+RectPacker::Page& RectPacker::openPage() {
+    Page page;
+    page.freeRects.push_back({0, 0, pageWidth, pageHeight});
+    pages.push_back(page);
+    return pages.back();
+}
+
+PackedRect RectPacker::insert(int width, int height) {
+    PackedRect result;
+    if (width <= 0 || height <= 0) return result;
+
+    bool fitsUpright = width <= pageWidth && height <= pageHeight;
+    bool fitsRotated = allowRotation && height <= pageWidth && width <= pageHeight;
+    if (!fitsUpright && !fitsRotated) return result;
+
+    for (size_t p = 0; p < pages.size(); ++p) {
+        if (findPosition(pages[p], width, height, result)) {
+            result.page = static_cast<int>(p);
+            place(pages[p], {result.x, result.y, result.width, result.height});
+            return result;
+        }
+    }
+
+    // Every open page is full: spill onto a new one
+    if (pageLimit > 0 && static_cast<int>(pages.size()) >= pageLimit) return result;
+    Page& page = openPage();
+    findPosition(page, width, height, result);
+    result.page = static_cast<int>(pages.size() - 1);
+    place(page, {result.x, result.y, result.width, result.height});
+    return result;
+}
+
+std::vector<PackedRect> RectPacker::pack(const std::vector<int>& widths, const std::vector<int>& heights) {
+    std::vector<size_t> order(widths.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // Longest side first, then area; stable so equal sprites keep their order
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        int sideA = std::max(widths[a], heights[a]);
+        int sideB = std::max(widths[b], heights[b]);
+        if (sideA != sideB) return sideA > sideB;
+        return widths[a] * heights[a] > widths[b] * heights[b];
+    });
+
+    std::vector<PackedRect> results(widths.size());
+    for (size_t index : order) {
+        results[index] = insert(widths[index], heights[index]);
+    }
+    return results;
+}
+
+// Best short side fit: the free rect that leaves the smallest leftover on its
+// tighter side, ties broken by the longer side
+bool RectPacker::findPosition(const Page& page, int width, int height, PackedRect& result) const {
+    int bestShortSide = INT_MAX;
+    int bestLongSide = INT_MAX;
+    bool found = false;
+
+    for (const Rect& freeRect : page.freeRects) {
+        for (int turn = 0; turn < (allowRotation ? 2 : 1); ++turn) {
+            int w = turn ? height : width;
+            int h = turn ? width : height;
+            if (w > freeRect.width || h > freeRect.height) continue;
+
+            int leftoverX = freeRect.width - w;
+            int leftoverY = freeRect.height - h;
+            int shortSide = std::min(leftoverX, leftoverY);
+            int longSide = std::max(leftoverX, leftoverY);
+            if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)) {
+                bestShortSide = shortSide;
+                bestLongSide = longSide;
+                result.x = freeRect.x;
+                result.y = freeRect.y;
+                result.width = w;
+                result.height = h;
+                result.rotated = turn == 1;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+void RectPacker::place(Page& page, const Rect& used) {
+    std::vector<Rect> splits;
+    for (size_t i = 0; i < page.freeRects.size();) {
+        if (splitFreeRect(page.freeRects[i], used, splits)) {
+            page.freeRects[i] = page.freeRects.back();
+            page.freeRects.pop_back();
+        } else {
+            ++i;
+        }
+    }
+    size_t firstNew = page.freeRects.size();
+    page.freeRects.insert(page.freeRects.end(), splits.begin(), splits.end());
+    pruneFreeRects(page.freeRects, firstNew);
+    page.usedArea += static_cast<long long>(used.width) * used.height;
+}
+
+// Replace a free rect that overlaps the used one by the (up to four) maximal
+// rects around it. Returns false when they do not overlap.
+bool RectPacker::splitFreeRect(const Rect& freeRect, const Rect& used, std::vector<Rect>& out) {
+    if (used.x >= freeRect.x + freeRect.width || used.x + used.width <= freeRect.x
+        || used.y >= freeRect.y + freeRect.height || used.y + used.height <= freeRect.y) {
+        return false;
+    }
+
+    if (used.x > freeRect.x) {
+        out.push_back({freeRect.x, freeRect.y, used.x - freeRect.x, freeRect.height});
+    }
+    if (used.x + used.width < freeRect.x + freeRect.width) {
+        int x = used.x + used.width;
+        out.push_back({x, freeRect.y, freeRect.x + freeRect.width - x, freeRect.height});
+    }
+    if (used.y > freeRect.y) {
+        out.push_back({freeRect.x, freeRect.y, freeRect.width, used.y - freeRect.y});
+    }
+    if (used.y + used.height < freeRect.y + freeRect.height) {
+        int y = used.y + used.height;
+        out.push_back({freeRect.x, y, freeRect.width, freeRect.y + freeRect.height - y});
+    }
+    return true;
+}
+
+// Drop free rects contained in another one. Rects before firstNew were
+// already pruned against each other, so only pairs with a new rect are checked.
+void RectPacker::pruneFreeRects(std::vector<Rect>& freeRects, size_t firstNew) {
+    auto contains = [](const Rect& outer, const Rect& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y
+            && inner.x + inner.width <= outer.x + outer.width
+            && inner.y + inner.height <= outer.y + outer.height;
+    };
+
+    std::vector<bool> removed(freeRects.size(), false);
+    for (size_t i = firstNew; i < freeRects.size(); ++i) {
+        if (removed[i]) continue;
+        for (size_t j = 0; j < freeRects.size(); ++j) {
+            if (j == i || removed[j]) continue;
+            if (contains(freeRects[j], freeRects[i])) {
+                removed[i] = true;
+                break;
+            }
+            if (contains(freeRects[i], freeRects[j])) removed[j] = true;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < freeRects.size(); ++i) {
+        if (!removed[i]) freeRects[kept++] = freeRects[i];
+    }
+    freeRects.resize(kept);
+}
+
+void RectPacker::release(const PackedRect& rect) {
+    if (!rect.isPacked() || rect.page >= static_cast<int>(pages.size())) return;
+
+    Page& page = pages[rect.page];
+    size_t firstNew = page.freeRects.size();
+    page.freeRects.push_back({rect.x, rect.y, rect.width, rect.height});
+    pruneFreeRects(page.freeRects, firstNew);
+    page.usedArea -= static_cast<long long>(rect.width) * rect.height;
+}
+
+double RectPacker::getFragmentation() const {
+    long long freeArea = 0, largest = 0;
+    for (const Page& page : pages) {
+        freeArea += static_cast<long long>(pageWidth) * pageHeight - page.usedArea;
+        for (const Rect& freeRect : page.freeRects) {
+            largest = std::max(largest, static_cast<long long>(freeRect.width) * freeRect.height);
+        }
+    }
+    return freeArea > 0 ? 1.0 - static_cast<double>(largest) / freeArea : 0.0;
+}
+
+double RectPacker::getOccupancy() const {
+    if (pages.empty()) return 0.0;
+    long long used = 0;
+    for (const Page& page : pages) used += page.usedArea;
+    return static_cast<double>(used) / (static_cast<double>(pageWidth) * pageHeight * pages.size());
+}
+
+double RectPacker::getPageOccupancy(int page) const {
+    if (page < 0 || page >= static_cast<int>(pages.size())) return 0.0;
+    return static_cast<double>(pages[page].usedArea) / (static_cast<double>(pageWidth) * pageHeight);
+}
@@ -0,0 +1,326 @@
+#include "RenderGraph.hpp"
+#include "GLStateCache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+RenderGraph& RenderGraph::getInstance() {
+    static RenderGraph instance;
+    return instance;
+}
+
+RenderGraph::RenderGraph() {
+    Resource backbuffer;
+    backbuffer.name = "backbuffer";
+    resources.push_back(backbuffer);
+}
+
+RenderResource RenderGraph::createTexture(const std::string& name, const RenderTextureDesc& desc) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resources.push_back(resource);
+    compiled = false;
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+int RenderGraph::addPass(const std::string& name, const std::vector<RenderResource>& reads,
+                         const std::vector<RenderResource>& writes) {
+    Pass pass;
+    pass.name = name;
+    pass.reads = reads;
+    pass.writes = writes;
+    passes.push_back(pass);
+    compiled = false;
+    return static_cast<int>(passes.size() - 1);
+}
+
+void RenderGraph::setClear(int pass, GLbitfield mask, const glm::vec4& color) {
+    passes[pass].clearMask = mask;
+    passes[pass].clearColor = color;
+}
+
+const DefaultRenderPasses& RenderGraph::createDefaultPasses(float lightMapScale) {
+    if (defaultPasses.world >= 0) return defaultPasses;
+
+    RenderTextureDesc lightMapDesc;
+    lightMapDesc.scale = lightMapScale;
+    lightMapDesc.internalFormat = GL_RGBA16F;
+    defaultPasses.lightMap = createTexture("lightMap", lightMapDesc);
+
+    defaultPasses.lighting = addPass("lighting", {}, {defaultPasses.lightMap});
+    defaultPasses.world = addPass("world", {defaultPasses.lightMap}, {BACKBUFFER});
+    defaultPasses.ui = addPass("ui", {}, {BACKBUFFER});
+    defaultPasses.post = addPass("post", {}, {BACKBUFFER});
+
+    // The one clear of the frame (same grey the window used to clear to)
+    setClear(defaultPasses.world, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, glm::vec4(0.8f, 0.8f, 0.8f, 1.0f));
+    return defaultPasses;
+}
+
+void RenderGraph::submit(int pass, std::function<void()> work) {
+    if (pass < 0 || pass >= static_cast<int>(passes.size())) return;
+    passes[pass].work.push_back(std::move(work));
+}
+
+void RenderGraph::compile() {
+    releaseTargets();
+    size_t passCount = passes.size();
+
+    // Edges: every writer of a resource runs before its readers, and writers
+    // of the same resource keep their declaration order
+    std::vector<std::vector<int>> successors(passCount);
+    std::vector<int> incoming(passCount, 0);
+    auto addEdge = [&](int from, int to) {
+        if (from == to) return;
+        if (std::find(successors[from].begin(), successors[from].end(), to) != successors[from].end()) return;
+        successors[from].push_back(to);
+        incoming[to]++;
+    };
+
+    for (size_t r = 0; r < resources.size(); ++r) {
+        int previousWriter = -1;
+        for (size_t p = 0; p < passCount; ++p) {
+            const auto& writes = passes[p].writes;
+            if (std::find(writes.begin(), writes.end(), static_cast<RenderResource>(r)) == writes.end()) continue;
+
+            if (previousWriter >= 0) addEdge(previousWriter, static_cast<int>(p));
+            previousWriter = static_cast<int>(p);
+
+            for (size_t reader = 0; reader < passCount; ++reader) {
+                const auto& reads = passes[reader].reads;
+                if (std::find(reads.begin(), reads.end(), static_cast<RenderResource>(r)) != reads.end()) {
+                    addEdge(static_cast<int>(p), static_cast<int>(reader));
+                }
+            }
+        }
+    }
+
+    // Kahn's algorithm, taking the earliest declared ready pass each time
+    std::vector<int> order;
+    std::vector<bool> done(passCount, false);
+    while (order.size() < passCount) {
+        int next = -1;
+        for (size_t p = 0; p < passCount; ++p) {
+            if (!done[p] && incoming[p] == 0) {
+                next = static_cast<int>(p);
+                break;
+            }
+        }
+        if (next < 0) {
+            std::cerr << "RenderGraph: pass dependencies form a cycle, using declaration order" << std::endl;
+            order.clear();
+            for (size_t p = 0; p < passCount; ++p) order.push_back(static_cast<int>(p));
+            break;
+        }
+        done[next] = true;
+        order.push_back(next);
+        for (int successor : successors[next]) incoming[successor]--;
+    }
+
+    // Keep passes that reach the backbuffer, directly or through what they write
+    std::vector<bool> resourceNeeded(resources.size(), false);
+    resourceNeeded[BACKBUFFER] = true;
+    std::vector<bool> passNeeded(passCount, false);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const Pass& pass = passes[*it];
+        for (RenderResource written : pass.writes) {
+            if (resourceNeeded[written]) passNeeded[*it] = true;
+        }
+        if (passNeeded[*it]) {
+            for (RenderResource read : pass.reads) resourceNeeded[read] = true;
+        }
+    }
+
+    passOrder.clear();
+    for (int p : order) {
+        if (passNeeded[p]) passOrder.push_back(p);
+        else std::cout << "RenderGraph: culled pass '" << passes[p].name << "' (output unused)" << std::endl;
+    }
+
+    // Transient lifetimes in compiled order: [first use, last use]
+    std::vector<int> firstUse(resources.size(), -1), lastUse(resources.size(), -1);
+    for (size_t position = 0; position < passOrder.size(); ++position) {
+        const Pass& pass = passes[passOrder[position]];
+        for (const auto* list : { &pass.reads, &pass.writes }) {
+            for (RenderResource r : *list) {
+                if (firstUse[r] < 0) firstUse[r] = static_cast<int>(position);
+                lastUse[r] = static_cast<int>(position);
+            }
+        }
+    }
+
+    // Alias: a resource takes over a physical texture of the same size and
+    // format whose previous owner is no longer used
+    std::vector<RenderResource> byFirstUse;
+    for (size_t r = 1; r < resources.size(); ++r) {
+        resources[r].physical = -1;
+        if (firstUse[r] >= 0) byFirstUse.push_back(static_cast<RenderResource>(r));
+    }
+    std::sort(byFirstUse.begin(), byFirstUse.end(),
+        [&](RenderResource a, RenderResource b) { return firstUse[a] < firstUse[b]; });
+
+    physicalTextures.clear();
+    std::vector<int> busyUntil;
+    for (RenderResource r : byFirstUse) {
+        const RenderTextureDesc& desc = resources[r].desc;
+        int chosen = -1;
+        for (size_t i = 0; i < physicalTextures.size(); ++i) {
+            const RenderTextureDesc& candidate = physicalTextures[i].desc;
+            if (busyUntil[i] < firstUse[r] && candidate.scale == desc.scale
+                && candidate.internalFormat == desc.internalFormat) {
+                chosen = static_cast<int>(i);
+                break;
+            }
+        }
+        if (chosen < 0) {
+            PhysicalTexture texture;
+            texture.desc = desc;
+            physicalTextures.push_back(texture);
+            busyUntil.push_back(-1);
+            chosen = static_cast<int>(physicalTextures.size() - 1);
+        }
+        busyUntil[chosen] = lastUse[r];
+        resources[r].physical = chosen;
+    }
+
+    compiled = true;
+}
+
+bool RenderGraph::isDepthFormat(GLenum internalFormat) {
+    return internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24
+        || internalFormat == GL_DEPTH_COMPONENT32F || internalFormat == GL_DEPTH24_STENCIL8;
+}
+
+void RenderGraph::allocate(int viewportWidth, int viewportHeight) {
+    releaseTargets();
+    auto& glState = GLStateCache::getInstance();
+
+    for (auto& physical : physicalTextures) {
+        physical.width = std::max(1, static_cast<int>(std::lround(viewportWidth * physical.desc.scale)));
+        physical.height = std::max(1, static_cast<int>(std::lround(viewportHeight * physical.desc.scale)));
+
+        GLenum internalFormat = physical.desc.internalFormat;
+        bool depth = isDepthFormat(internalFormat);
+        GLenum format = depth ? (internalFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL : GL_DEPTH_COMPONENT) : GL_RGBA;
+        GLenum type = depth ? (internalFormat == GL_DEPTH24_STENCIL8 ? GL_UNSIGNED_INT_24_8 : GL_FLOAT) : GL_UNSIGNED_BYTE;
+
+        glGenTextures(1, &physical.texture);
+        glState.bindTexture(GL_TEXTURE_2D, physical.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, physical.width, physical.height, 0, format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // One framebuffer per pass that renders offscreen
+    for (int p : passOrder) {
+        Pass& pass = passes[p];
+        if (std::find(pass.writes.begin(), pass.writes.end(), BACKBUFFER) != pass.writes.end()) continue;
+
+        glGenFramebuffers(1, &pass.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, pass.framebuffer);
+        std::vector<GLenum> drawBuffers;
+        for (RenderResource r : pass.writes) {
+            const PhysicalTexture& physical = physicalTextures[resources[r].physical];
+            GLenum internalFormat = physical.desc.internalFormat;
+            GLenum attachment = !isDepthFormat(internalFormat) ? GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(drawBuffers.size())
+                              : internalFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+            glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, physical.texture, 0);
+            if (!isDepthFormat(internalFormat)) drawBuffers.push_back(attachment);
+        }
+        glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "RenderGraph: framebuffer of pass '" << pass.name << "' is incomplete" << std::endl;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    allocatedWidth = viewportWidth;
+    allocatedHeight = viewportHeight;
+}
+
+void RenderGraph::releaseTargets() {
+    for (auto& pass : passes) {
+        if (pass.framebuffer) glDeleteFramebuffers(1, &pass.framebuffer);
+        pass.framebuffer = 0;
+    }
+    for (auto& physical : physicalTextures) {
+        if (physical.texture) GLStateCache::getInstance().deleteTextures(1, &physical.texture);
+        physical.texture = 0;
+    }
+    allocatedWidth = allocatedHeight = 0;
+}
+
+void RenderGraph::execute(int viewportWidth, int viewportHeight) {
+    recording = false;
+    if (!compiled) compile();
+    if (viewportWidth != allocatedWidth || viewportHeight != allocatedHeight) {
+        allocate(viewportWidth, viewportHeight);
+    }
+
+    for (int p : passOrder) {
+        Pass& pass = passes[p];
+        bool offscreen = pass.framebuffer != 0;
+
+        // Offscreen passes with nothing to draw are skipped; backbuffer clears always run
+        if (pass.work.empty() && (offscreen || pass.clearMask == 0)) continue;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, pass.framebuffer);
+        if (offscreen) {
+            const PhysicalTexture& target = physicalTextures[resources[pass.writes[0]].physical];
+            glViewport(0, 0, target.width, target.height);
+        } else {
+            glViewport(0, 0, viewportWidth, viewportHeight);
+        }
+
+        if (pass.clearMask) {
+            glClearColor(pass.clearColor.x, pass.clearColor.y, pass.clearColor.z, pass.clearColor.w);
+            glClear(pass.clearMask);
+        }
+
+        for (auto& work : pass.work) work();
+    }
+
+    // Culled passes don't run, but work submitted to them must not pile up
+    for (auto& pass : passes) pass.work.clear();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, viewportWidth, viewportHeight);
+}
+
+GLuint RenderGraph::getTexture(RenderResource resource) const {
+    if (resource <= BACKBUFFER || resource >= static_cast<RenderResource>(resources.size())) return 0;
+    int physical = resources[resource].physical;
+    return physical >= 0 ? physicalTextures[physical].texture : 0;
+}
+
+int RenderGraph::getWidth(RenderResource resource) const {
+    if (resource == BACKBUFFER) return allocatedWidth;
+    int physical = resources[resource].physical;
+    return physical >= 0 ? physicalTextures[physical].width : 0;
+}
+
+int RenderGraph::getHeight(RenderResource resource) const {
+    if (resource == BACKBUFFER) return allocatedHeight;
+    int physical = resources[resource].physical;
+    return physical >= 0 ? physicalTextures[physical].height : 0;
+}
+
+const std::vector<int>& RenderGraph::getPassOrder() {
+    if (!compiled) compile();
+    return passOrder;
+}
+
+size_t RenderGraph::getPhysicalTextureCount() {
+    if (!compiled) compile();
+    return physicalTextures.size();
+}
+
+void RenderGraph::shutdown() {
+    releaseTargets();
+    for (auto& pass : passes) pass.work.clear();
+    compiled = false;
+}
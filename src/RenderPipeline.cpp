@@ -0,0 +1,86 @@
+#include "RenderPipeline.hpp"
+#include <iostream>
+#include <chrono>
+
+RenderPipeline::RenderPipeline(size_t workerCount, int latency)
+    : buildIndex(0), frameLatency(latency > 0 ? 1 : 0)
+    , generation(0), pendingWorkers(0), shuttingDown(false) {
+
+    if (workerCount == 0) workerCount = 1;
+
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&RenderPipeline::workerLoop, this, i);
+    }
+
+    std::cout << "RenderPipeline started with " << workerCount << " worker(s), latency "
+              << frameLatency << " frame(s)" << std::endl;
+}
+
+RenderPipeline::~RenderPipeline() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Never tear down while a packet is still being written
+        workDone.wait(lock, [this] { return pendingWorkers == 0; });
+        shuttingDown = true;
+    }
+    workAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void RenderPipeline::beginBuild(const BuildJob& job) {
+    RenderFramePacket& packet = getBuildPacket();
+    packet.reset(workers.size());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentJob = job;
+        pendingWorkers = workers.size();
+        ++generation;
+    }
+    workAvailable.notify_all();
+}
+
+void RenderPipeline::waitForBuild() {
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return pendingWorkers == 0; });
+    getBuildPacket().ready = true;
+}
+
+void RenderPipeline::endFrame() {
+    // With no latency the same packet is built and drawn, so there is nothing to flip
+    if (frameLatency > 0) {
+        buildIndex = 1 - buildIndex;
+    }
+}
+
+void RenderPipeline::workerLoop(size_t workerIndex) {
+    unsigned long long seenGeneration = 0;
+
+    while (true) {
+        BuildJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&] { return shuttingDown || generation != seenGeneration; });
+            if (shuttingDown) return;
+            seenGeneration = generation;
+            job = currentJob;
+        }
+
+        RenderFramePacket& packet = packets[buildIndex];
+        auto startTime = std::chrono::high_resolution_clock::now();
+        job(packet, workerIndex, workers.size());
+        auto endTime = std::chrono::high_resolution_clock::now();
+        packet.slices[workerIndex].buildTime = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pendingWorkers == 0) {
+                workDone.notify_all();
+            }
+        }
+    }
+}
@@ -1,14 +1,20 @@
 #include "ResourceManager.hpp"
+#include "GLUploadQueue.hpp"
+#include "PixelUploadRing.hpp"
+#include "ThreadPool.hpp"
+#include "VirtualFileSystem.hpp"
 #include <iostream>
 #include <filesystem>
+#include <limits>
 
 inline bool fileExists(const std::string& path) {
-    return std::filesystem::exists(path);
+    return VirtualFileSystem::getInstance().exists(path);
 }
 
 template <typename Resource>
 bool ResourceManager<Resource>::isResourceLoaded(const std::string& key) const {
-    return resources.find(key) != resources.end();
+    auto it = keys.find(key);
+    return it != keys.end() && slots[it->second].resource != nullptr;
 }
 
 // Get the singleton instance
@@ -25,7 +31,7 @@ ResourceManager<Resource>::ResourceManager() {}
 // // Load a 2D texture resource
 template <>
 bool ResourceManager<Texture>::load(const std::string& key, const std::string& filepath) {
-    if (resources.find(key) != resources.end()) {
+    if (retakeLoadReference(key)) {
         std::cout << "Resource already loaded: " << key << std::endl;
         return false;
     }
@@ -36,7 +42,7 @@ bool ResourceManager<Texture>::load(const std::string& key, const std::string& f
         return false;
     }
 
-    resources[key] = resource;
+    store(key, resource, { filepath });
     std::cout << "Loaded resource: " << key << std::endl;
     return true;
 }
@@ -44,7 +50,7 @@ bool ResourceManager<Texture>::load(const std::string& key, const std::string& f
 // Overloaded load function for Shader resources
 template <>
 bool ResourceManager<Shader>::load(const std::string& key, const char* vertexPath, const char* fragmentPath) {
-    if (resources.find(key) != resources.end()) {
+    if (retakeLoadReference(key)) {
         std::cout << "Resource already loaded: " << key << std::endl;
         return false;
     }
@@ -53,7 +59,7 @@ bool ResourceManager<Shader>::load(const std::string& key, const char* vertexPat
         std::cerr << "Failed to load Shader resource: " << key << std::endl;
         return false;
     }
-    resources[key] = resource;
+    store(key, resource, { vertexPath, fragmentPath });
     std::cout << "Loaded Shader resource: " << key << std::endl;
     return true;
 }
@@ -63,7 +69,7 @@ bool ResourceManager<Shader>::load(const std::string& key, const char* vertexPat
 // Load a cubemap texture
 template <>
 bool ResourceManager<Texture>::loadCubemap(const std::string& key, const std::vector<std::string>& faces) {
-    if (resources.find(key) != resources.end()) {
+    if (retakeLoadReference(key)) {
         std::cout << "Resource already loaded: " << key << std::endl;
         return false;
     }
@@ -74,7 +80,7 @@ bool ResourceManager<Texture>::loadCubemap(const std::string& key, const std::ve
         return false;
     }
 
-    resources[key] = resource;
+    store(key, resource, faces);
     std::cout << "Loaded cubemap resource: " << key << std::endl;
     return true;
 }
@@ -82,7 +88,7 @@ bool ResourceManager<Texture>::loadCubemap(const std::string& key, const std::ve
 // Load a texture array
 template <>
 bool ResourceManager<Texture>::loadTextureArray(const std::string& key, const std::vector<std::string>& layers) {
-    if (resources.find(key) != resources.end()) {
+    if (retakeLoadReference(key)) {
         std::cout << "Resource already loaded: " << key << std::endl;
         return false;
     }
@@ -93,14 +99,14 @@ bool ResourceManager<Texture>::loadTextureArray(const std::string& key, const st
         return false;
     }
 
-    resources[key] = resource;
+    store(key, resource, layers);
     std::cout << "Loaded texture array resource: " << key << std::endl;
     return true;
 }
 
 template <>
 bool ResourceManager<Font>::load(const std::string& key, const std::string& filepath, unsigned int fontSize) {
-    if (isResourceLoaded(key)) {
+    if (retakeLoadReference(key)) {
         std::cout << "Resource already loaded: " << key << std::endl;
         return false;
     }
@@ -116,41 +122,382 @@ bool ResourceManager<Font>::load(const std::string& key, const std::string& file
         return false;
     }
 
-    resources[key] = resource;
+    store(key, resource, { filepath });
     std::cout << "Loaded font: " << key << std::endl;
     return true;
 }
 
+// Async loading
 
+template <typename Resource>
+bool ResourceManager<Resource>::isReady(const std::string& key) const {
+    return isResourceLoaded(key) && pending.find(key) == pending.end();
+}
 
+template <typename Resource>
+void ResourceManager<Resource>::waitForPending() {
+    auto& uploads = GLUploadQueue::getInstance();
+    auto& ring = PixelUploadRing::getInstance();
+    while (!pending.empty()) {
+        // Streamed pixels only move when the ring is processed
+        if (ring.getPendingCount() == 0) uploads.waitForWork(10);
+        uploads.process(std::numeric_limits<double>::infinity());
+        ring.process();
+    }
+}
+
+static std::shared_future<bool> finishedLoad(bool result) {
+    std::promise<bool> promise;
+    promise.set_value(result);
+    return promise.get_future().share();
+}
 
+// decode() runs on a worker; upload(decoded, finish) runs on the GL thread
+// and calls finish(result) once the resource is complete, which is some
+// frames later for pixels streamed through PixelUploadRing
+template <typename Resource>
+template <typename Decode, typename Upload>
+std::shared_future<bool> ResourceManager<Resource>::startAsync(const std::string& key, Decode decode, Upload upload) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::shared_future<bool> future = promise->get_future().share();
+    pending[key] = future;
+
+    ThreadPool::getInstance().submit([this, key, decode, upload, promise]() {
+        bool decoded = decode();
+        GLUploadQueue::getInstance().push([this, key, decoded, upload, promise]() {
+            upload(decoded, [this, key, promise](bool result) {
+                pending.erase(key);
+                promise->set_value(result);
+            });
+        });
+    });
+    return future;
+}
+
+template <>
+std::shared_future<bool> ResourceManager<Texture>::loadAsync(const std::string& key, const std::string& filepath) {
+    if (retakeLoadReference(key)) {
+        std::cout << "Resource already loaded: " << key << std::endl;
+        return finishedLoad(false);
+    }
+
+    auto resource = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+    resource->createPlaceholder();
+    store(key, resource, { filepath });
+
+    auto image = std::make_shared<TextureImage>();
+    return startAsync(key,
+        [filepath, image]() {
+            if (!Texture::decode(filepath, *image)) return false;
+            Texture::buildMips(*image);
+            return true;
+        },
+        [key, filepath, resource, image](bool decoded, std::function<void(bool)> finish) {
+            auto uploaded = [key, filepath, resource, finish](bool result) {
+                if (result) std::cout << "Loaded resource: " << key << std::endl;
+                else std::cerr << "Failed to load resource: " << filepath << std::endl;
+                finish(result);
+            };
+            if (!decoded) {
+                uploaded(false);
+                return;
+            }
+            resource->streamUpload(image, uploaded);
+        });
+}
+
+template <>
+std::shared_future<bool> ResourceManager<Shader>::loadAsync(const std::string& key, const char* vertexPath, const char* fragmentPath) {
+    if (retakeLoadReference(key)) {
+        std::cout << "Resource already loaded: " << key << std::endl;
+        return finishedLoad(false);
+    }
+
+    auto resource = std::make_shared<Shader>();
+    store(key, resource, { vertexPath, fragmentPath });
+
+    // Copy the paths, the caller's strings may not outlive the load
+    auto sources = std::make_shared<std::pair<std::string, std::string>>();
+    std::string vertexFile = vertexPath, fragmentFile = fragmentPath;
+    return startAsync(key,
+        [vertexFile, fragmentFile, sources]() {
+            return Shader::readSource(vertexFile.c_str(), sources->first)
+                && Shader::readSource(fragmentFile.c_str(), sources->second);
+        },
+        [key, resource, sources](bool read, std::function<void(bool)> finish) {
+            if (!read || !resource->loadFromSource(sources->first, sources->second)) {
+                std::cerr << "Failed to load Shader resource: " << key << std::endl;
+                finish(false);
+                return;
+            }
+            std::cout << "Loaded Shader resource: " << key << std::endl;
+            finish(true);
+        });
+}
 
+template <>
+std::shared_future<bool> ResourceManager<Texture>::loadCubemapAsync(const std::string& key, const std::vector<std::string>& faces) {
+    if (retakeLoadReference(key)) {
+        std::cout << "Resource already loaded: " << key << std::endl;
+        return finishedLoad(false);
+    }
+
+    auto resource = std::make_shared<Texture>(TextureType::CUBEMAP);
+    resource->createPlaceholder();
+    store(key, resource, faces);
+
+    auto images = std::make_shared<std::vector<TextureImage>>();
+    return startAsync(key,
+        [faces, images]() { return Texture::decodeLayers(faces, *images); },
+        [key, resource, images](bool decoded, std::function<void(bool)> finish) {
+            auto uploaded = [key, resource, finish](bool result) {
+                if (result) std::cout << "Loaded cubemap resource: " << key << std::endl;
+                else std::cerr << "Failed to load cubemap resource: " << key << std::endl;
+                finish(result);
+            };
+            if (!decoded) {
+                uploaded(false);
+                return;
+            }
+            resource->streamCubemap(images, uploaded);
+        });
+}
+
+template <>
+std::shared_future<bool> ResourceManager<Texture>::loadTextureArrayAsync(const std::string& key, const std::vector<std::string>& layers) {
+    if (retakeLoadReference(key)) {
+        std::cout << "Resource already loaded: " << key << std::endl;
+        return finishedLoad(false);
+    }
+    if (layers.empty()) {
+        std::cerr << "Error: No texture layers provided.\n";
+        return finishedLoad(false);
+    }
+
+    auto resource = std::make_shared<Texture>(TextureType::TEXTURE_ARRAY);
+    resource->createPlaceholder(static_cast<int>(layers.size()));
+    store(key, resource, layers);
+
+    auto images = std::make_shared<std::vector<TextureImage>>();
+    return startAsync(key,
+        [layers, images]() {
+            if (!Texture::decodeLayers(layers, *images)) return false;
+            for (auto& image : *images) Texture::buildMips(image);
+            return true;
+        },
+        [key, resource, images](bool decoded, std::function<void(bool)> finish) {
+            auto uploaded = [key, resource, finish](bool result) {
+                if (result) std::cout << "Loaded texture array resource: " << key << std::endl;
+                else std::cerr << "Failed to load texture array resource: " << key << std::endl;
+                finish(result);
+            };
+            if (!decoded) {
+                uploaded(false);
+                return;
+            }
+            resource->streamTextureArray(images, uploaded);
+        });
+}
+
+template <>
+std::shared_future<bool> ResourceManager<Font>::loadAsync(const std::string& key, const std::string& filepath, unsigned int fontSize) {
+    if (retakeLoadReference(key)) {
+        std::cout << "Resource already loaded: " << key << std::endl;
+        return finishedLoad(false);
+    }
+
+    if (!fileExists(filepath)) {
+        std::cerr << "File does not exist: " << filepath << std::endl;
+        return finishedLoad(false);
+    }
+
+    auto resource = std::make_shared<Font>();
+    store(key, resource, { filepath });
+
+    auto glyphs = std::make_shared<std::map<char, GlyphBitmap>>();
+    return startAsync(key,
+        [filepath, fontSize, glyphs]() { return Font::rasterize(filepath, fontSize, *glyphs); },
+        [key, filepath, resource, glyphs](bool rasterized, std::function<void(bool)> finish) {
+            if (!rasterized || !resource->upload(*glyphs)) {
+                std::cerr << "Failed to load texture resource: " << filepath << std::endl;
+                finish(false);
+                return;
+            }
+            glyphs->clear();
+            std::cout << "Loaded font: " << key << std::endl;
+            finish(true);
+        });
+}
 
 // Get a resource by key
 template <typename Resource>
 std::shared_ptr<Resource> ResourceManager<Resource>::get(const std::string& key) const {
-    auto it = resources.find(key);
-    if (it != resources.end()) {
-        return it->second;
+    auto it = keys.find(key);
+    if (it != keys.end() && slots[it->second].resource) {
+        return slots[it->second].resource;
     }
     std::cerr << "Resource not found: " << key << std::endl;
     return nullptr;
 }
 
-// Release a specific resource
+// Slot for key, created empty if the key is new
+template <typename Resource>
+uint32_t ResourceManager<Resource>::intern(const std::string& key) {
+    auto it = keys.find(key);
+    if (it != keys.end()) return it->second;
+
+    uint32_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+    slots[index].key = key;
+    keys[key] = index;
+    return index;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::store(const std::string& key, std::shared_ptr<Resource> resource,
+                                      const std::vector<std::string>& files) {
+    Slot& slot = slots[intern(key)];
+    slot.resource = std::move(resource);
+    slot.files.clear();
+    for (const auto& file : files) slot.files.push_back(std::filesystem::path(file).lexically_normal().string());
+    if (!slot.loadReference) {
+        slot.loadReference = true;
+        ++slot.refCount;
+    }
+}
+
+template <typename Resource>
+std::vector<std::string> ResourceManager<Resource>::findKeysForFile(const std::string& path) const {
+    std::string normalized = std::filesystem::path(path).lexically_normal().string();
+    std::vector<std::string> found;
+    for (const auto& slot : slots) {
+        if (!slot.resource) continue;
+        for (const auto& file : slot.files) {
+            if (file == normalized) {
+                found.push_back(slot.key);
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+template <typename Resource>
+std::vector<std::string> ResourceManager<Resource>::getSourceFiles(const std::string& key) const {
+    auto it = keys.find(key);
+    return it != keys.end() ? slots[it->second].files : std::vector<std::string>();
+}
+
+template <typename Resource>
+ResourceHandle<Resource> ResourceManager<Resource>::getHandle(const std::string& key) {
+    ResourceHandle<Resource> handle;
+    if (key.empty()) return handle;
+    handle.index = intern(key);
+    handle.generation = slots[handle.index].generation;
+    return handle;
+}
+
+template <typename Resource>
+ResourceHandle<Resource> ResourceManager<Resource>::acquire(const std::string& key) {
+    ResourceHandle<Resource> handle = getHandle(key);
+    if (handle.isValid()) ++slots[handle.index].refCount;
+    return handle;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::retain(ResourceHandle<Resource> handle) {
+    if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) return;
+    ++slots[handle.index].refCount;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::release(ResourceHandle<Resource> handle) {
+    if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) return;
+    dropReference(handle.index);
+}
+
+// Drop the reference loading took
 template <typename Resource>
 void ResourceManager<Resource>::release(const std::string& key) {
-    auto it = resources.find(key);
-    if (it != resources.end()) {
-        resources.erase(it);
-        std::cout << "Released resource: " << key << std::endl;
+    auto it = keys.find(key);
+    if (it == keys.end() || !slots[it->second].loadReference) return;
+    slots[it->second].loadReference = false;
+    dropReference(it->second);
+    std::cout << "Released resource: " << key << std::endl;
+}
+
+// Loading a key that is still loaded (even if released and waiting to
+// unload) holds it again instead of failing
+template <typename Resource>
+bool ResourceManager<Resource>::retakeLoadReference(const std::string& key) {
+    auto it = keys.find(key);
+    if (it == keys.end() || !slots[it->second].resource) return false;
+    Slot& slot = slots[it->second];
+    if (!slot.loadReference) {
+        slot.loadReference = true;
+        ++slot.refCount;
+    }
+    return true;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::dropReference(uint32_t index) {
+    Slot& slot = slots[index];
+    if (slot.refCount == 0 || --slot.refCount > 0) return;
+
+    // Queued once; a later drop only pushes the deadline back
+    if (slot.unloadFrame == 0) unloadQueue.push_back(index);
+    slot.unloadFrame = frame + UNLOAD_DELAY_FRAMES;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::processUnloads() {
+    ++frame;
+    size_t kept = 0;
+    for (uint32_t index : unloadQueue) {
+        Slot& slot = slots[index];
+        if (slot.refCount > 0) {
+            slot.unloadFrame = 0;    // Acquired again
+            continue;
+        }
+        // An async load still finishing into the slot waits for it
+        if (frame < slot.unloadFrame || pending.find(slot.key) != pending.end()) {
+            unloadQueue[kept++] = index;
+            continue;
+        }
+        unload(index);
     }
+    unloadQueue.resize(kept);
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::unload(uint32_t index) {
+    Slot& slot = slots[index];
+    if (slot.resource) std::cout << "Unloaded resource: " << slot.key << std::endl;
+    keys.erase(slot.key);
+    slot.resource.reset();
+    slot.key.clear();
+    slot.files.clear();
+    slot.refCount = 0;
+    slot.unloadFrame = 0;
+    slot.loadReference = false;
+    ++slot.generation;
+    freeSlots.push_back(index);
 }
 
 // Clear all loaded resources
 template <typename Resource>
 void ResourceManager<Resource>::clear() {
-    resources.clear();
+    for (uint32_t index = 0; index < slots.size(); ++index) {
+        if (!slots[index].key.empty()) unload(index);
+    }
+    unloadQueue.clear();
     std::cout << "All resources cleared." << std::endl;
 }
 
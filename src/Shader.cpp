@@ -1,6 +1,11 @@
 #include "Shader.hpp"
-#include <fstream>
-#include <sstream>
+#include "GLStateCache.hpp"
+#include "ShaderCache.hpp"
+#include "VirtualFileSystem.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 
 // Default constructor
@@ -11,153 +16,290 @@ bool Shader::loadFromFile(const char* vertexPath, const char* fragmentPath) {
     std::cout << "Initializing Shader..." << std::endl;
     std::string vertexCode;
     std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-
-    // Ensure ifstream objects can throw exceptions
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-    try {
-        // Open vertex and fragment shader files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-
-        // Read file contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-
-        // Close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-
-        // Convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-        std::cout << "Shader files read successfully." << std::endl;
-    }
-    catch (std::ifstream::failure& e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+    if (!readSource(vertexPath, vertexCode) || !readSource(fragmentPath, fragmentCode)) {
         return false;
     }
+    std::cout << "Shader files read successfully." << std::endl;
+
+    return compileAndLink(vertexCode.c_str(), fragmentCode.c_str(), vertexPath);
+}
 
+bool Shader::loadFromSource(const std::string& vertexCode, const std::string& fragmentCode) {
     return compileAndLink(vertexCode.c_str(), fragmentCode.c_str());
 }
 
+bool Shader::reload(const std::string& vertexCode, const std::string& fragmentCode, const std::string& name) {
+    GLuint program = ShaderCache::getInstance().acquire(vertexCode, fragmentCode, name);
+    if (!program) {
+        std::cerr << "Shader reload failed, keeping the previous program: " << name << std::endl;
+        return false;
+    }
+
+    ShaderCache::getInstance().release(ID);
+    ID = program;
+    reflectUniforms();
+    std::cout << "Reloaded shader: " << name << std::endl;
+    return true;
+}
+
+bool Shader::readSource(const char* path, std::string& code) {
+    FileBuffer file;
+    if (!VirtualFileSystem::getInstance().read(path, file)) {
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+        return false;
+    }
+    code.assign(reinterpret_cast<const char*>(file.data()), file.size());
+    return true;
+}
+
 // Activate the shader
 void Shader::use() const {
-    glUseProgram(ID);
+    GLStateCache::getInstance().useProgram(ID);
+}
+
+UniformHandle Shader::getUniform(const std::string& name) const {
+    UniformHandle handle;
+    auto it = std::find(handleNames.begin(), handleNames.end(), name);
+    if (it != handleNames.end()) {
+        handle.index = static_cast<int>(it - handleNames.begin());
+        return handle;
+    }
+
+    handle.index = static_cast<int>(handleNames.size());
+    handleNames.push_back(name);
+    handleLocations.push_back(findLocation(name));
+    return handle;
+}
+
+GLint Shader::handleLocation(UniformHandle handle) const {
+    if (handle.index < 0 || handle.index >= static_cast<int>(handleLocations.size())) return -1;
+    return handleLocations[handle.index];
+}
+
+GLint Shader::findLocation(const std::string& name) const {
+    auto it = std::lower_bound(uniforms.begin(), uniforms.end(), name,
+        [](const ShaderUniform& uniform, const std::string& key) { return uniform.name < key; });
+    if (it != uniforms.end() && it->name == name) return it->location;
+
+    // Array elements other than the first are not in the table
+    if (name.find('[') != std::string::npos) return glGetUniformLocation(ID, name.c_str());
+    return -1;
 }
 
 // Utility uniform functions (setting uniforms)
 void Shader::setBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(findLocation(name), (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(findLocation(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(findLocation(name), value);
 }
 
 void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform2fv(findLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec2(const std::string& name, float x, float y) const {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    glUniform2f(findLocation(name), x, y);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform3fv(findLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec3(const std::string& name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    glUniform3f(findLocation(name), x, y, z);
 }
 
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform4fv(findLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    glUniform4f(findLocation(name), x, y, z, w);
 }
 
 void Shader::setMat2(const std::string& name, const glm::mat2& mat) const {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(findLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(findLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(findLocation(name), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setBool(UniformHandle handle, bool value) const {
+    glUniform1i(handleLocation(handle), (int)value);
+}
+
+void Shader::setInt(UniformHandle handle, int value) const {
+    glUniform1i(handleLocation(handle), value);
+}
+
+void Shader::setFloat(UniformHandle handle, float value) const {
+    glUniform1f(handleLocation(handle), value);
+}
+
+void Shader::setVec2(UniformHandle handle, const glm::vec2& value) const {
+    glUniform2fv(handleLocation(handle), 1, &value[0]);
+}
+
+void Shader::setVec3(UniformHandle handle, const glm::vec3& value) const {
+    glUniform3fv(handleLocation(handle), 1, &value[0]);
+}
+
+void Shader::setVec4(UniformHandle handle, const glm::vec4& value) const {
+    glUniform4fv(handleLocation(handle), 1, &value[0]);
+}
+
+void Shader::setMat2(UniformHandle handle, const glm::mat2& mat) const {
+    glUniformMatrix2fv(handleLocation(handle), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat3(UniformHandle handle, const glm::mat3& mat) const {
+    glUniformMatrix3fv(handleLocation(handle), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat4(UniformHandle handle, const glm::mat4& mat) const {
+    glUniformMatrix4fv(handleLocation(handle), 1, GL_FALSE, &mat[0][0]);
 }
 
 // Compile and link shaders
-bool Shader::compileAndLink(const char* vertexCode, const char* fragmentCode) {
-    unsigned int vertex, fragment;
-
-    // Vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vertexCode, NULL);
-    glCompileShader(vertex);
-    if (!checkCompileErrors(vertex, "VERTEX")) {
-        std::cerr << "Vertex Shader compilation failed!" << std::endl;
+bool Shader::compileAndLink(const char* vertexCode, const char* fragmentCode, const std::string& name) {
+    // Shared with any other shader built from the same source, and loaded
+    // from the binary cache on a warm start
+    GLuint program = ShaderCache::getInstance().acquire(vertexCode, fragmentCode, name);
+    if (!program) {
+        std::cerr << "Shader Program linking failed!" << std::endl;
         return false;
     }
 
-    // Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fragmentCode, NULL);
-    glCompileShader(fragment);
-    if (!checkCompileErrors(fragment, "FRAGMENT")) {
-        std::cerr << "Fragment Shader compilation failed!" << std::endl;
-        return false;
+    ID = program;
+    reflectUniforms();
+    std::cout << "Shader Program ready. Program ID: " << ID << std::endl;
+
+    return true;
+}
+
+void Shader::reflectUniforms() {
+    uniforms.clear();
+
+    GLint count = 0, maxNameLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    std::vector<GLchar> nameBuffer(std::max(maxNameLength, 1));
+
+    for (GLint i = 0; i < count; ++i) {
+        ShaderUniform uniform;
+        GLsizei length = 0;
+        glGetActiveUniform(ID, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()),
+                           &length, &uniform.size, &uniform.type, nameBuffer.data());
+        uniform.name.assign(nameBuffer.data(), length);
+
+        // Block members have no location
+        uniform.location = glGetUniformLocation(ID, uniform.name.c_str());
+        if (uniform.location < 0) continue;
+
+        // "uTextures[0]" is listed under "uTextures"; both names resolve
+        size_t bracket = uniform.name.find('[');
+        if (bracket != std::string::npos) {
+            uniforms.push_back(uniform);
+            uniform.name.erase(bracket);
+        }
+        uniforms.push_back(uniform);
     }
 
-    // Shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    if (!checkCompileErrors(ID, "PROGRAM")) {
-        std::cerr << "Shader Program linking failed!" << std::endl;
-        return false;
+    std::sort(uniforms.begin(), uniforms.end(),
+        [](const ShaderUniform& a, const ShaderUniform& b) { return a.name < b.name; });
+
+    // Handles given out before a relink now point at the new locations
+    for (size_t i = 0; i < handleNames.size(); ++i) {
+        handleLocations[i] = findLocation(handleNames[i]);
     }
 
-    // Delete shaders as they are linked into the program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    std::cout << "Shader Program compiled and linked successfully. Program ID: " << ID << std::endl;
+    frameConstantsBlock = bindFrameConstantsBlock(ID);
+}
 
+bool bindFrameConstantsBlock(GLuint program) {
+    GLuint blockIndex = glGetUniformBlockIndex(program, "FrameConstants");
+    if (blockIndex == GL_INVALID_INDEX) return false;
+    glUniformBlockBinding(program, blockIndex, FRAME_CONSTANTS_BINDING);
     return true;
 }
 
-// Utility function for checking shader compilation/linking errors.
-bool Shader::checkCompileErrors(GLuint shader, const std::string& type) {
-    GLint success;
-    GLchar infoLog[1024];
+// FrameConstantBuffer
+FrameConstantBuffer& FrameConstantBuffer::getInstance() {
+    static FrameConstantBuffer instance;
+    return instance;
+}
 
-    if (type != "PROGRAM") {
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-            std::cerr << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-            return false;
-        }
+FrameConstantBuffer::FrameConstantBuffer() {
+    constants.view = glm::mat4(1.0f);
+    constants.projection = glm::mat4(1.0f);
+    constants.viewProjection = glm::mat4(1.0f);
+    constants.screenProjection = glm::mat4(1.0f);
+    constants.timeScreen = glm::vec4(0.0f);
+}
+
+void FrameConstantBuffer::beginFrame(float time, float deltaTime, int screenWidth, int screenHeight) {
+    ++frame;
+
+    bool resized = constants.timeScreen.z != screenWidth || constants.timeScreen.w != screenHeight;
+    constants.timeScreen = glm::vec4(time, deltaTime, static_cast<float>(screenWidth), static_cast<float>(screenHeight));
+
+    if (resized || buffer == 0) {
+        constants.screenProjection = glm::ortho(0.0f, static_cast<float>(screenWidth), 0.0f, static_cast<float>(screenHeight));
+        upload(offsetof(FrameConstants, screenProjection), sizeof(glm::mat4) + sizeof(glm::vec4));
     } else {
-        glGetProgramiv(shader, GL_LINK_STATUS, &success);
-        if (!success) {
-            glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-            std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-            return false;
-        }
+        upload(offsetof(FrameConstants, timeScreen), sizeof(glm::vec4));
     }
-    return true;
+}
+
+void FrameConstantBuffer::setCamera(const glm::mat4& view, const glm::mat4& projection) {
+    glm::mat4 viewProjection = projection * view;
+    if (buffer != 0 && std::memcmp(&constants.view, &view, sizeof(glm::mat4)) == 0
+        && std::memcmp(&constants.projection, &projection, sizeof(glm::mat4)) == 0
+        && std::memcmp(&constants.viewProjection, &viewProjection, sizeof(glm::mat4)) == 0) {
+        return;
+    }
+
+    constants.view = view;
+    constants.projection = projection;
+    constants.viewProjection = viewProjection;
+    upload(offsetof(FrameConstants, view), 3 * sizeof(glm::mat4));
+}
+
+void FrameConstantBuffer::useViewProjection(const glm::mat4& viewProjection) {
+    if (buffer != 0 && std::memcmp(&constants.viewProjection, &viewProjection, sizeof(glm::mat4)) == 0) {
+        return;
+    }
+
+    constants.viewProjection = viewProjection;
+    upload(offsetof(FrameConstants, viewProjection), sizeof(glm::mat4));
+}
+
+void FrameConstantBuffer::upload(size_t offset, size_t size) {
+    if (buffer == 0) {
+        // First use: allocate the whole block and bind it for the rest of the run
+        glGenBuffers(1, &buffer);
+        GLStateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), &constants, GL_DYNAMIC_DRAW);
+        GLStateCache::getInstance().bindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, buffer);
+        return;
+    }
+
+    GLStateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, reinterpret_cast<const char*>(&constants) + offset);
+}
+
+void FrameConstantBuffer::shutdown() {
+    if (buffer) GLStateCache::getInstance().deleteBuffers(1, &buffer);
+    buffer = 0;
 }
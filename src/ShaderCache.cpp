@@ -0,0 +1,251 @@
+#include "ShaderCache.hpp"
+#include "GLStateCache.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// On-disk layout: this header, then the program binary
+struct ProgramBinaryHeader {
+    char magic[4];           // "GLPB"
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t sourceLength;   // vertex + fragment bytes, a second check on the hash
+    uint64_t driverHash;     // vendor, renderer and version strings
+    uint32_t format;         // from glGetProgramBinary
+    uint32_t length;
+};
+
+static const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static uint64_t hashSources(const std::string& vertexCode, const std::string& fragmentCode) {
+    const char separator = 0;
+    uint64_t hash = hashShaderSource(vertexCode.data(), vertexCode.size());
+    hash = hashShaderSource(&separator, 1, hash);
+    return hashShaderSource(fragmentCode.data(), fragmentCode.size(), hash);
+}
+
+static bool compileStage(GLuint shader, const char* code, const std::string& name, const char* stage) {
+    glShaderSource(shader, 1, &code, NULL);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+        std::cerr << "ERROR::SHADER_COMPILATION_ERROR of type: " << stage << " (" << name << ")\n" << infoLog
+                  << "\n -- --------------------------------------------------- -- " << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ShaderCache& ShaderCache::getInstance() {
+    static ShaderCache instance;
+    return instance;
+}
+
+bool ShaderCache::isBinaryCacheSupported() {
+    if (binarySupport < 0) {
+        GLint formats = 0;
+        if (glGetProgramBinary && glProgramBinary && glProgramParameteri) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        binarySupport = formats > 0 ? 1 : 0;
+
+        // A binary is only valid for the driver build that wrote it
+        std::string driver;
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+            const GLubyte* value = glGetString(name);
+            if (value) driver += reinterpret_cast<const char*>(value);
+            driver += '\n';
+        }
+        driverHash = hashShaderSource(driver.data(), driver.size());
+    }
+    return binarySupport == 1;
+}
+
+GLuint ShaderCache::acquire(const std::string& vertexCode, const std::string& fragmentCode, const std::string& name) {
+    uint64_t hash = hashSources(vertexCode, fragmentCode);
+
+    auto it = programs.find(hash);
+    if (it != programs.end()) {
+        Entry& entry = it->second;
+        if (entry.vertexCode == vertexCode && entry.fragmentCode == fragmentCode) {
+            ++entry.users;
+            ++stats.shared;
+            return entry.program;
+        }
+        // Not shared and not cached; release() deletes it like any other
+        std::cerr << "Shader source hash collision, compiling separately: " << name << std::endl;
+        return compile(vertexCode, fragmentCode, name);
+    }
+
+    bool useDisk = !cacheDirectory.empty() && isBinaryCacheSupported();
+    GLuint program = 0;
+    if (useDisk) {
+        auto start = std::chrono::high_resolution_clock::now();
+        program = loadBinary(hash, vertexCode.size() + fragmentCode.size());
+        if (program) {
+            ++stats.loaded;
+            stats.loadTime += millisecondsSince(start);
+        }
+    }
+    if (!program) {
+        auto start = std::chrono::high_resolution_clock::now();
+        program = compile(vertexCode, fragmentCode, name);
+        if (!program) return 0;
+        ++stats.compiled;
+        stats.compileTime += millisecondsSince(start);
+        if (useDisk) saveBinary(hash, vertexCode.size() + fragmentCode.size(), program);
+    }
+
+    Entry& entry = programs[hash];
+    entry.program = program;
+    entry.users = 1;
+    entry.vertexCode = vertexCode;
+    entry.fragmentCode = fragmentCode;
+    sourceHashes[program] = hash;
+    return program;
+}
+
+void ShaderCache::release(GLuint program) {
+    if (!program) return;
+
+    auto it = sourceHashes.find(program);
+    if (it != sourceHashes.end()) {
+        auto entry = programs.find(it->second);
+        if (--entry->second.users > 0) return;
+        programs.erase(entry);
+        sourceHashes.erase(it);
+    }
+    GLStateCache::getInstance().deleteProgram(program);
+}
+
+std::string ShaderCache::binaryPath(uint64_t sourceHash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(sourceHash));
+    return cacheDirectory + "/" + name;
+}
+
+GLuint ShaderCache::loadBinary(uint64_t sourceHash, uint64_t sourceLength) {
+    std::ifstream file(binaryPath(sourceHash), std::ios::binary);
+    if (!file) return 0;    // Not cached yet
+
+    ProgramBinaryHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, "GLPB", 4) != 0
+        || header.version != PROGRAM_BINARY_VERSION || header.sourceHash != sourceHash
+        || header.sourceLength != sourceLength || header.driverHash != driverHash) {
+        ++stats.rejected;
+        return 0;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) {
+        ++stats.rejected;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // Drivers may refuse their own binaries after an update without changing the strings
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        glDeleteProgram(program);
+        ++stats.rejected;
+        return 0;
+    }
+    return program;
+}
+
+void ShaderCache::saveBinary(uint64_t sourceHash, uint64_t sourceLength, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    ProgramBinaryHeader header;
+    std::memcpy(header.magic, "GLPB", 4);
+    header.version = PROGRAM_BINARY_VERSION;
+    header.sourceHash = sourceHash;
+    header.sourceLength = sourceLength;
+    header.driverHash = driverHash;
+    header.format = format;
+    header.length = static_cast<uint32_t>(written);
+
+    // Written aside and renamed, so another instance never reads half a file
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    std::string path = binaryPath(sourceHash);
+    std::string partial = path + ".tmp";
+    {
+        std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) {
+            std::cerr << "Failed to write shader binary: " << partial << std::endl;
+            return;
+        }
+    }
+    std::filesystem::rename(partial, path, error);
+    if (error) {
+        std::cerr << "Failed to write shader binary: " << path << ": " << error.message() << std::endl;
+        std::filesystem::remove(partial, error);
+    }
+}
+
+GLuint ShaderCache::compile(const std::string& vertexCode, const std::string& fragmentCode, const std::string& name) {
+    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    if (!compileStage(vertex, vertexCode.c_str(), name, "VERTEX")
+        || !compileStage(fragment, fragmentCode.c_str(), name, "FRAGMENT")) {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    // Must be set before linking for glGetProgramBinary to return anything
+    if (isBinaryCacheSupported()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: PROGRAM (" << name << ")\n" << infoLog
+                  << "\n -- --------------------------------------------------- -- " << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ShaderCache::shutdown() {
+    for (auto& entry : programs) {
+        GLStateCache::getInstance().deleteProgram(entry.second.program);
+    }
+    programs.clear();
+    sourceHashes.clear();
+    binarySupport = -1;
+}
@@ -0,0 +1,600 @@
+#include "SpriteAnimation.hpp"
+#include "SpriteBatcher.hpp"
+#include "TextureAtlas.hpp"
+#include "GLStateCache.hpp"
+#include "ShaderCache.hpp"
+#include "Shader.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+// Shared with the batcher (SpriteBatcher.cpp): samples uTextures[vTextureIndex]
+extern const char* spriteFragmentShaderSource;
+
+// Quad corners come from gl_VertexID (triangle strip), everything else is per instance
+static const char* animatedSpriteVertexShaderSource = R"glsl(
+#version 330 core
+layout (location = 0) in vec3 aTranslation;   // xy + depth
+layout (location = 1) in vec4 aAxes;          // axisX.xy, axisY.xy
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in uint aClip;
+layout (location = 4) in vec3 aTiming;        // start time, speed, clip time at start
+
+layout(std140) uniform FrameConstants {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    mat4 uScreenProjection;
+    vec4 uTimeScreen;
+};
+uniform float uTime;
+uniform samplerBuffer uFrames;   // uv0.xy, uv1.xy per frame
+uniform samplerBuffer uClips;    // (first frame, frame count, fps, loop), (texture slot, -, -, -)
+
+out vec2 vTexCoord;
+out vec4 vColor;
+flat out int vTextureIndex;
+
+void main() {
+    vec4 clip = texelFetch(uClips, int(aClip) * 2);
+    int frameCount = int(clip.y);
+    if (frameCount == 0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);   // unresolved clip: outside the clip volume
+        return;
+    }
+
+    float clipTime = max(aTiming.z + (uTime - aTiming.x) * aTiming.y, 0.0);
+    int frame = int(clipTime * clip.z);
+    frame = clip.w > 0.5 ? frame % frameCount : min(frame, frameCount - 1);
+    vec4 uv = texelFetch(uFrames, int(clip.x) + frame);
+
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec2 position = aTranslation.xy + aAxes.xy * corner.x + aAxes.zw * corner.y;
+
+    gl_Position = uViewProjection * vec4(position, aTranslation.z, 1.0);
+    vTexCoord = mix(uv.xy, uv.zw, corner);
+    vColor = aColor;
+    vTextureIndex = int(texelFetch(uClips, int(aClip) * 2 + 1).x);
+}
+)glsl";
+
+// SpriteAnimationLibrary
+SpriteAnimationLibrary& SpriteAnimationLibrary::getInstance() {
+    static SpriteAnimationLibrary instance;
+    return instance;
+}
+
+float SpriteAnimationLibrary::advance(float deltaTime) {
+    time += deltaTime;
+    if (time < REBASE_INTERVAL) return 0.0f;
+
+    float shift = std::floor(time / REBASE_INTERVAL) * REBASE_INTERVAL;
+    time -= shift;
+    return shift;
+}
+
+float SpriteAnimationLibrary::foldClipTime(int clipId, float clipTime) const {
+    if (clipId < 0 || clipId >= static_cast<int>(clips.size())) return clipTime;
+    const SpriteAnimationClip& clip = clips[clipId];
+    if (clip.framesPerSecond <= 0.0f || clip.frameNames.empty()) return clipTime;
+
+    float duration = static_cast<float>(clip.frameNames.size()) / clip.framesPerSecond;
+    if (clip.loop) return std::fmod(std::max(clipTime, 0.0f), duration);
+    return std::min(clipTime, duration);
+}
+
+int SpriteAnimationLibrary::defineClip(const std::string& name, const std::string& atlasName,
+                                       const std::vector<std::string>& frameNames,
+                                       float framesPerSecond, bool loop) {
+    if (frameNames.empty()) {
+        std::cerr << "Animation clip has no frames: " << name << std::endl;
+        return -1;
+    }
+
+    SpriteAnimationClip clip;
+    clip.name = name;
+    clip.atlasName = atlasName;
+    clip.frameNames = frameNames;
+    clip.framesPerSecond = framesPerSecond;
+    clip.loop = loop;
+
+    // Redefining a name replaces the clip but keeps its id
+    auto it = clipIds.find(name);
+    int clipId = (it != clipIds.end()) ? it->second : static_cast<int>(clips.size());
+    if (clipId == static_cast<int>(clips.size())) {
+        clips.push_back(clip);
+        clipIds[name] = clipId;
+    } else {
+        clips[clipId] = clip;
+    }
+
+    clipsChanged = true;
+    return clipId;
+}
+
+int SpriteAnimationLibrary::findClip(const std::string& name) const {
+    auto it = clipIds.find(name);
+    return (it != clipIds.end()) ? it->second : -1;
+}
+
+void SpriteAnimationLibrary::buildTables() {
+    auto& atlasManager = TextureAtlasManager::getInstance();
+
+    std::vector<float> frames;
+    std::vector<float> clipData;
+    std::vector<int> atlasFrameBase(atlasManager.getAtlasCount(), -1);
+    std::vector<std::vector<int>> atlasPageSlot(atlasManager.getAtlasCount());   // texture slot per atlas page
+    slotTextures.clear();
+    builtAtlases.clear();
+    unresolvedClips = false;
+
+    for (auto& clip : clips) {
+        clip.firstFrame = -1;
+        clip.frameCount = 0;
+        clip.textureSlot = -1;
+        clip.atlasIndex = -1;
+        clip.firstSprite = -1;
+
+        SpriteHandle first = atlasManager.resolveSprite(clip.frameNames[0], clip.atlasName);
+        bool contiguous = first.isValid();
+        for (size_t i = 1; contiguous && i < clip.frameNames.size(); ++i) {
+            SpriteHandle frame = atlasManager.resolveSprite(clip.frameNames[i], clip.atlasName);
+            contiguous = frame.isValid() && frame.uvIndex == first.uvIndex + static_cast<int>(i);
+        }
+
+        // The clip table holds one texture per clip, so frames must share a page and be upright
+        bool samePage = contiguous;
+        if (contiguous) {
+            auto atlas = atlasManager.getAtlasByIndex(first.atlasIndex);
+            int page = atlas->getSpriteUV(first.uvIndex).page;
+            for (size_t i = 0; samePage && i < clip.frameNames.size(); ++i) {
+                const SpriteUV& uv = atlas->getSpriteUV(first.uvIndex + static_cast<int>(i));
+                samePage = uv.page == page && !uv.rotated;
+            }
+        }
+
+        if (!contiguous) {
+            // Either the atlas isn't generated yet or the frames weren't added in order
+            unresolvedClips = true;
+            if (first.isValid()) {
+                std::cerr << "Animation clip frames are not contiguous in atlas " << clip.atlasName
+                          << ": " << clip.name << std::endl;
+            }
+        } else if (!samePage) {
+            std::cerr << "Animation clip frames span atlas pages or are rotated in atlas " << clip.atlasName
+                      << ": " << clip.name << std::endl;
+        } else {
+            auto atlas = atlasManager.getAtlasByIndex(first.atlasIndex);
+            int page = atlas->getSpriteUV(first.uvIndex).page;
+            std::vector<int>& pageSlot = atlasPageSlot[first.atlasIndex];
+            if (pageSlot.empty()) pageSlot.assign(atlas->getPageCount(), -1);
+
+            // Each atlas's whole UV table is appended once, so clips index straight into it
+            if (atlasFrameBase[first.atlasIndex] < 0) {
+                atlasFrameBase[first.atlasIndex] = static_cast<int>(frames.size() / 4);
+                builtAtlases.push_back({first.atlasIndex, atlas->getUVGeneration()});
+                for (int i = 0; i < atlas->getSpriteCount(); ++i) {
+                    const SpriteUV& uv = atlas->getSpriteUV(i);
+                    frames.insert(frames.end(), {uv.uv0.x, uv.uv0.y, uv.uv1.x, uv.uv1.y});
+                }
+            }
+            if (pageSlot[page] < 0 && static_cast<int>(slotTextures.size()) < SPRITE_SHADER_TEXTURE_UNITS) {
+                pageSlot[page] = static_cast<int>(slotTextures.size());
+                slotTextures.push_back(atlas->getPageTextureID(page));
+            }
+
+            if (pageSlot[page] >= 0) {
+                clip.firstFrame = atlasFrameBase[first.atlasIndex] + first.uvIndex;
+                clip.frameCount = static_cast<int>(clip.frameNames.size());
+                clip.textureSlot = pageSlot[page];
+                clip.atlasIndex = first.atlasIndex;
+                clip.firstSprite = first.uvIndex;
+            } else {
+                std::cerr << "Too many atlas pages with animation clips, skipping: " << clip.name << std::endl;
+            }
+        }
+
+        clipData.insert(clipData.end(), {
+            static_cast<float>(std::max(clip.firstFrame, 0)), static_cast<float>(clip.frameCount),
+            clip.framesPerSecond, clip.loop ? 1.0f : 0.0f,
+            static_cast<float>(std::max(clip.textureSlot, 0)), 0.0f, 0.0f, 0.0f
+        });
+    }
+
+    // Buffer textures may not be empty
+    if (frames.empty()) frames.assign(4, 0.0f);
+    if (clipData.empty()) clipData.assign(8, 0.0f);
+
+    if (!frameBuffer) {
+        glGenBuffers(1, &frameBuffer);
+        glGenTextures(1, &frameTexture);
+        glGenBuffers(1, &clipBuffer);
+        glGenTextures(1, &clipTexture);
+    }
+
+    GLStateCache::getInstance().bindBuffer(GL_TEXTURE_BUFFER, frameBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, frames.size() * sizeof(float), frames.data(), GL_STATIC_DRAW);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_BUFFER, frameTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, frameBuffer);
+
+    GLStateCache::getInstance().bindBuffer(GL_TEXTURE_BUFFER, clipBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, clipData.size() * sizeof(float), clipData.data(), GL_STATIC_DRAW);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_BUFFER, clipTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, clipBuffer);
+
+    GLStateCache::getInstance().bindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    builtGeneration = atlasManager.getGeneration();
+    clipsChanged = false;
+}
+
+// Inserting sprites only matters to clips that didn't resolve; the tables of
+// resolved clips go stale only when their atlas's UVs change
+bool SpriteAnimationLibrary::tablesStale() const {
+    if (clipsChanged) return true;
+
+    auto& atlasManager = TextureAtlasManager::getInstance();
+    if (unresolvedClips && builtGeneration != atlasManager.getGeneration()) return true;
+    for (const auto& built : builtAtlases) {
+        if (atlasManager.getAtlasByIndex(built.first)->getUVGeneration() != built.second) return true;
+    }
+    return false;
+}
+
+void SpriteAnimationLibrary::bindTables() {
+    if (tablesStale()) {
+        buildTables();
+    }
+
+    auto& glState = GLStateCache::getInstance();
+    for (size_t i = 0; i < slotTextures.size(); ++i) {
+        glState.bindTextureUnit(static_cast<GLuint>(i), GL_TEXTURE_2D, slotTextures[i]);
+    }
+
+    glState.bindTextureUnit(FRAME_TABLE_UNIT, GL_TEXTURE_BUFFER, frameTexture);
+    glState.bindTextureUnit(CLIP_TABLE_UNIT, GL_TEXTURE_BUFFER, clipTexture);
+}
+
+void SpriteAnimationLibrary::markClipUsed(int clipId) {
+    if (clipId >= getClipCount() || clips[clipId].firstFrame < 0) return;
+    const SpriteAnimationClip& clip = clips[clipId];
+
+    // Tables not yet rebuilt may point past a recreated atlas's slots
+    auto atlas = TextureAtlasManager::getInstance().getAtlasByIndex(clip.atlasIndex);
+    if (!atlas->isDynamic()) return;
+    int end = std::min(clip.firstSprite + clip.frameCount, atlas->getSpriteCount());
+    for (int i = clip.firstSprite; i < end; ++i) atlas->markUsed(i);
+}
+
+void SpriteAnimationLibrary::shutdown() {
+    if (frameBuffer) GLStateCache::getInstance().deleteBuffers(1, &frameBuffer);
+    if (clipBuffer) GLStateCache::getInstance().deleteBuffers(1, &clipBuffer);
+    if (frameTexture) GLStateCache::getInstance().deleteTextures(1, &frameTexture);
+    if (clipTexture) GLStateCache::getInstance().deleteTextures(1, &clipTexture);
+    frameBuffer = clipBuffer = frameTexture = clipTexture = 0;
+    clipsChanged = true;
+}
+
+// AnimatedSpriteInstance
+static GLubyte toColorByte(float value) {
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return static_cast<GLubyte>(value * 255.0f + 0.5f);
+}
+
+AnimatedSpriteInstance AnimatedSpriteInstance::make(const SpriteAffine2D& transform, const glm::vec4& color,
+                                                    int clipId, float startTime, float speed, float timeOffset) {
+    AnimatedSpriteInstance instance;
+    instance.translation[0] = transform.translation.x;
+    instance.translation[1] = transform.translation.y;
+    instance.translation[2] = transform.z;
+    instance.axes[0] = transform.axisX.x;
+    instance.axes[1] = transform.axisX.y;
+    instance.axes[2] = transform.axisY.x;
+    instance.axes[3] = transform.axisY.y;
+    instance.color[0] = toColorByte(color.x);
+    instance.color[1] = toColorByte(color.y);
+    instance.color[2] = toColorByte(color.z);
+    instance.color[3] = toColorByte(color.w);
+    instance.clip = static_cast<GLuint>(clipId);
+    instance.timing[0] = startTime;
+    instance.timing[1] = speed;
+    instance.timing[2] = timeOffset;
+    return instance;
+}
+
+static_assert(sizeof(AnimatedSpriteInstance) == 48, "AnimatedSpriteInstance must stay 48 bytes");
+
+// AnimatedSpriteRenderer
+AnimatedSpriteRenderer& AnimatedSpriteRenderer::getInstance() {
+    static AnimatedSpriteRenderer instance;
+    return instance;
+}
+
+void AnimatedSpriteRenderer::init() {
+    if (initialized) return;
+
+    shaderProgram = ShaderCache::getInstance().acquire(animatedSpriteVertexShaderSource, spriteFragmentShaderSource,
+                                                       "animated sprite");
+
+    GLStateCache::getInstance().useProgram(shaderProgram);
+    for (int i = 0; i < SPRITE_SHADER_TEXTURE_UNITS; ++i) {
+        std::string uniformName = "uTextures[" + std::to_string(i) + "]";
+        glUniform1i(glGetUniformLocation(shaderProgram, uniformName.c_str()), i);
+    }
+    glUniform1i(glGetUniformLocation(shaderProgram, "uFrames"), SpriteAnimationLibrary::FRAME_TABLE_UNIT);
+    glUniform1i(glGetUniformLocation(shaderProgram, "uClips"), SpriteAnimationLibrary::CLIP_TABLE_UNIT);
+    bindFrameConstantsBlock(shaderProgram);
+    timeLocation = glGetUniformLocation(shaderProgram, "uTime");
+    lightMap.locate(shaderProgram);
+
+    // No per-vertex data: every attribute advances once per instance
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &instanceVBO);
+    GLStateCache::getInstance().bindVertexArray(VAO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    GLsizei stride = sizeof(AnimatedSpriteInstance);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(AnimatedSpriteInstance, translation));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(AnimatedSpriteInstance, axes));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(AnimatedSpriteInstance, color));
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, stride, (void*)offsetof(AnimatedSpriteInstance, clip));
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(AnimatedSpriteInstance, timing));
+    for (GLuint location = 0; location <= 4; ++location) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    GLStateCache::getInstance().bindVertexArray(0);
+    initialized = true;
+}
+
+void AnimatedSpriteRenderer::shutdown() {
+    if (VAO) GLStateCache::getInstance().deleteVertexArrays(1, &VAO);
+    if (instanceVBO) GLStateCache::getInstance().deleteBuffers(1, &instanceVBO);
+    ShaderCache::getInstance().release(shaderProgram);
+    VAO = instanceVBO = shaderProgram = 0;
+    bufferCapacity = capturedCapacity = 0;
+    boundFirstInstance = 0;
+    uploadedSequence = 0;
+    preparedFrame = nullptr;
+    initialized = false;
+    SpriteAnimationLibrary::getInstance().shutdown();
+}
+
+void AnimatedSpriteRenderer::markDirty(size_t index) {
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = index;
+        dirtyEnd = index + 1;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, index);
+        dirtyEnd = std::max(dirtyEnd, index + 1);
+    }
+}
+
+void AnimatedSpriteRenderer::countClip(GLuint clip, int delta) {
+    if (clip >= clipInstances.size()) clipInstances.resize(clip + 1, 0);
+    clipInstances[clip] += delta;
+}
+
+void AnimatedSpriteRenderer::moveInstance(size_t from, size_t to) {
+    instances[to] = instances[from];
+    instanceLayers[to] = instanceLayers[from];
+    indexToSlot[to] = indexToSlot[from];
+    slotToIndex[indexToSlot[to]] = static_cast<int>(to);
+    markDirty(to);
+}
+
+// Open a hole at the end of the slot's layer by moving the first instance of
+// every higher layer to the end of that layer: one move per layer, not per instance
+void AnimatedSpriteRenderer::insertAt(int slot, const AnimatedSpriteInstance& instance, int layer) {
+    size_t target = std::upper_bound(instanceLayers.begin(), instanceLayers.end(), layer) - instanceLayers.begin();
+    size_t hole = instances.size();
+    instances.push_back(instance);
+    instanceLayers.push_back(layer);
+    indexToSlot.push_back(slot);
+
+    while (hole > target) {
+        size_t groupStart = std::lower_bound(instanceLayers.begin() + target, instanceLayers.begin() + hole,
+                                             instanceLayers[hole - 1]) - instanceLayers.begin();
+        moveInstance(groupStart, hole);
+        hole = groupStart;
+    }
+
+    instances[hole] = instance;
+    instanceLayers[hole] = layer;
+    indexToSlot[hole] = slot;
+    slotToIndex[slot] = static_cast<int>(hole);
+    markDirty(hole);
+    layersChanged = true;
+    countClip(instance.clip, 1);
+}
+
+// Close the slot's hole by moving the last instance of its layer and of every
+// higher layer down one place
+void AnimatedSpriteRenderer::detach(int slot) {
+    size_t hole = static_cast<size_t>(slotToIndex[slot]);
+    size_t last = instances.size() - 1;
+    countClip(instances[hole].clip, -1);
+
+    while (hole < last) {
+        size_t groupEnd = std::upper_bound(instanceLayers.begin() + hole, instanceLayers.end(),
+                                           instanceLayers[hole]) - instanceLayers.begin();
+        if (groupEnd - 1 == hole) {
+            // The hole is the last of its layer: take the next layer's last instance
+            groupEnd = std::upper_bound(instanceLayers.begin() + hole + 1, instanceLayers.end(),
+                                        instanceLayers[hole + 1]) - instanceLayers.begin();
+        }
+        moveInstance(groupEnd - 1, hole);
+        hole = groupEnd - 1;
+    }
+
+    instances.pop_back();
+    instanceLayers.pop_back();
+    indexToSlot.pop_back();
+    slotToIndex[slot] = -1;
+    layersChanged = true;
+}
+
+int AnimatedSpriteRenderer::addInstance(const AnimatedSpriteInstance& instance, int layer) {
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<int>(slotToIndex.size());
+        slotToIndex.push_back(-1);
+    }
+
+    insertAt(slot, instance, layer);
+    return slot;
+}
+
+void AnimatedSpriteRenderer::updateInstance(int slot, const AnimatedSpriteInstance& instance, int layer) {
+    int index = slotToIndex[slot];
+    if (instanceLayers[index] != layer) {
+        detach(slot);
+        insertAt(slot, instance, layer);
+        return;
+    }
+
+    countClip(instances[index].clip, -1);
+    countClip(instance.clip, 1);
+    instances[index] = instance;
+    markDirty(index);
+}
+
+void AnimatedSpriteRenderer::removeInstance(int slot) {
+    detach(slot);
+    freeSlots.push_back(slot);
+}
+
+void AnimatedSpriteRenderer::updateLayerRanges() {
+    if (!layersChanged) return;
+
+    layerRanges.clear();
+    for (size_t i = 0; i < instanceLayers.size(); ++i) {
+        if (layerRanges.empty() || layerRanges.back().layer != instanceLayers[i]) {
+            layerRanges.push_back({instanceLayers[i], i, 0});
+        }
+        layerRanges.back().count++;
+    }
+    layersChanged = false;
+}
+
+void AnimatedSpriteRenderer::capture(AnimatedSpriteFrame& frame) {
+    updateLayerRanges();
+
+    // The shader picks the frame, so every frame of a playing clip counts as drawn
+    auto& library = SpriteAnimationLibrary::getInstance();
+    for (size_t clip = 0; clip < clipInstances.size(); ++clip) {
+        if (clipInstances[clip] > 0) library.markClipUsed(static_cast<int>(clip));
+    }
+
+    // A bigger buffer starts empty, so the frame that grows it carries everything
+    if (instances.size() > capturedCapacity) {
+        capturedCapacity = std::max(instances.size(), std::max(capturedCapacity * 2, static_cast<size_t>(256)));
+        dirtyBegin = 0;
+        dirtyEnd = instances.size();
+    }
+
+    dirtyEnd = std::min(dirtyEnd, instances.size());
+    frame.changed.clear();
+    frame.changedBegin = dirtyBegin;
+    if (dirtyEnd > dirtyBegin) {
+        frame.changed.assign(instances.begin() + dirtyBegin, instances.begin() + dirtyEnd);
+    }
+    dirtyBegin = dirtyEnd = 0;
+
+    frame.instanceCount = instances.size();
+    frame.capacity = capturedCapacity;
+    frame.layers = layerRanges;
+    frame.time = SpriteAnimationLibrary::getInstance().getTime();
+    frame.sequence = ++captureSequence;
+}
+
+const AnimatedSpriteFrame* AnimatedSpriteRenderer::prepare(const AnimatedSpriteFrame& frame,
+                                                           const glm::mat4& viewProjection) {
+    bytesUploaded = 0;
+    preparedFrame = nullptr;
+    if (!initialized || frame.sequence == 0) return nullptr;
+
+    const AnimatedSpriteFrame* source = &frame;
+    if (frame.sequence != uploadedSequence && frame.sequence != uploadedSequence + 1) {
+        // A frame was skipped or is drawn again after newer ones were uploaded.
+        // Send everything as it is now; that covers every capture so far, so
+        // frames still in flight are treated as uploaded.
+        updateLayerRanges();
+        capturedCapacity = std::max(capturedCapacity, instances.size());
+        currentFrame.changed = instances;
+        currentFrame.changedBegin = 0;
+        currentFrame.instanceCount = instances.size();
+        currentFrame.capacity = capturedCapacity;
+        currentFrame.layers = layerRanges;
+        currentFrame.time = SpriteAnimationLibrary::getInstance().getTime();
+        currentFrame.sequence = captureSequence;
+        source = &currentFrame;
+        uploadedSequence = 0;
+    }
+
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (source->capacity > bufferCapacity) {
+        bufferCapacity = source->capacity;
+        glBufferData(GL_ARRAY_BUFFER, bufferCapacity * sizeof(AnimatedSpriteInstance), nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    // Only instances touched since the previous frame go over the bus
+    if (source->sequence != uploadedSequence && !source->changed.empty()) {
+        bytesUploaded = source->changed.size() * sizeof(AnimatedSpriteInstance);
+        glBufferSubData(GL_ARRAY_BUFFER, source->changedBegin * sizeof(AnimatedSpriteInstance), bytesUploaded,
+                        source->changed.data());
+    }
+    uploadedSequence = source->sequence;
+
+    preparedFrame = source;
+    preparedViewProjection = viewProjection;
+    return preparedFrame;
+}
+
+// GL 3.3 has no base instance for glDrawArraysInstanced, so a layer that doesn't
+// start at instance 0 points the attributes at its first instance instead
+void AnimatedSpriteRenderer::bindInstanceRange(size_t first) {
+    if (first == boundFirstInstance) return;
+
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    GLsizei stride = sizeof(AnimatedSpriteInstance);
+    size_t base = first * sizeof(AnimatedSpriteInstance);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(AnimatedSpriteInstance, translation)));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(AnimatedSpriteInstance, axes)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(base + offsetof(AnimatedSpriteInstance, color)));
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, stride, (void*)(base + offsetof(AnimatedSpriteInstance, clip)));
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(AnimatedSpriteInstance, timing)));
+    boundFirstInstance = first;
+}
+
+void AnimatedSpriteRenderer::drawLayer(size_t rangeIndex) {
+    if (!preparedFrame || rangeIndex >= preparedFrame->layers.size()) return;
+    const AnimatedLayerRange& range = preparedFrame->layers[rangeIndex];
+    if (range.count == 0) return;
+
+    // Texture units 0..n may hold the batcher's textures, so the clip atlases are rebound
+    SpriteAnimationLibrary::getInstance().bindTables();
+
+    FrameConstantBuffer::getInstance().useViewProjection(preparedViewProjection);
+    GLStateCache::getInstance().useProgram(shaderProgram);
+    glUniform1f(timeLocation, preparedFrame->time);
+    lightMap.apply();
+
+    GLStateCache::getInstance().bindVertexArray(VAO);
+    bindInstanceRange(range.first);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(range.count));
+}
+
+void AnimatedSpriteRenderer::render(const glm::mat4& viewProjection) {
+    capture(currentFrame);
+    const AnimatedSpriteFrame* prepared = prepare(currentFrame, viewProjection);
+    if (!prepared) return;
+    for (size_t i = 0; i < prepared->layers.size(); ++i) {
+        drawLayer(i);
+    }
+}
@@ -1,38 +1,29 @@
 #include "SpriteBatcher.hpp"
 #include "TextureAtlas.hpp"
+#include "RenderPipeline.hpp"
+#include "SpriteAnimation.hpp"
+#include "GLStateCache.hpp"
+#include "ShaderCache.hpp"
+#include "Shader.hpp"
 #include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
 
-// Shader source code for sprite batching
-const char* vertexShaderSource = R"glsl(
-#version 330 core
-layout (location = 0) in vec3 aPosition;
-layout (location = 1) in vec2 aTexCoord;
-layout (location = 2) in vec4 aColor;
-layout (location = 3) in float aTextureIndex;
-
-uniform mat4 uViewProjection;
-
-out vec2 vTexCoord;
-out vec4 vColor;
-flat out int vTextureIndex;
-
-void main() {
-    gl_Position = uViewProjection * vec4(aPosition, 1.0);
-    vTexCoord = aTexCoord;
-    vColor = aColor;
-    vTextureIndex = int(aTextureIndex);
-}
-)glsl";
-
-const char* fragmentShaderSource = R"glsl(
+// Fragment shader shared by every sprite vertex layout (vertex shaders are in SpriteVertex.cpp)
+const char* spriteFragmentShaderSource = R"glsl(
 #version 330 core
 in vec2 vTexCoord;
 in vec4 vColor;
 flat in int vTextureIndex;
 
-uniform sampler2D uTextures[8];
+uniform sampler2D uTextures[15];
+
+// Light map from LightRenderer2D, multiplied in at this pixel when enabled
+uniform sampler2D uLightMap;
+uniform int uLightingEnabled;
+uniform vec2 uInverseViewport;
 
 out vec4 FragColor;
 
@@ -48,8 +39,18 @@ void main() {
     else if (vTextureIndex == 5) texColor = texture(uTextures[5], vTexCoord);
     else if (vTextureIndex == 6) texColor = texture(uTextures[6], vTexCoord);
     else if (vTextureIndex == 7) texColor = texture(uTextures[7], vTexCoord);
+    else if (vTextureIndex == 8) texColor = texture(uTextures[8], vTexCoord);
+    else if (vTextureIndex == 9) texColor = texture(uTextures[9], vTexCoord);
+    else if (vTextureIndex == 10) texColor = texture(uTextures[10], vTexCoord);
+    else if (vTextureIndex == 11) texColor = texture(uTextures[11], vTexCoord);
+    else if (vTextureIndex == 12) texColor = texture(uTextures[12], vTexCoord);
+    else if (vTextureIndex == 13) texColor = texture(uTextures[13], vTexCoord);
+    else if (vTextureIndex == 14) texColor = texture(uTextures[14], vTexCoord);
     
     FragColor = texColor * vColor;
+    if (uLightingEnabled != 0) {
+        FragColor.rgb *= texture(uLightMap, gl_FragCoord.xy * uInverseViewport).rgb;
+    }
     
     // Discard fully transparent pixels
     if (FragColor.a < 0.01) {
@@ -58,120 +59,142 @@ void main() {
 }
 )glsl";
 
-SpriteBatcher::SpriteBatcher(int maxSprites, int maxTextures) 
+static float millisecondsSince(std::chrono::high_resolution_clock::time_point start,
+                               std::chrono::high_resolution_clock::time_point& now) {
+    now = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<float, std::milli>(now - start).count();
+}
+
+template <typename Vertex>
+BasicSpriteBatcher<Vertex>::BasicSpriteBatcher(int maxSprites, int maxTextures) 
     : VAO(0), VBO(0), EBO(0), shaderProgram(0)
+    , indirectBuffer(0), drawTextureBaseBuffer(0)
+    , multiDrawSupported(false), multiDrawEnabled(true), textureUnitBudget(SPRITE_SHADER_TEXTURE_UNITS)
     , maxSpritesPerBatch(maxSprites), maxTexturesPerBatch(maxTextures)
     , frustumCullingEnabled(false)
-    , frustumMin(-1000.0f), frustumMax(1000.0f), frustumSize(2000.0f) {
+    , frustumMin(-1000.0f), frustumMax(1000.0f), frustumSize(2000.0f)
+    , gpuQueryIndex(0), lastGpuTime(-1.0f), bufferCapacity(0)
+    , kernelPath(detectSpriteKernelPath()) {
+    
+    for (int i = 0; i < GPU_QUERY_COUNT; ++i) {
+        gpuQueries[i] = 0;
+        gpuQueryPending[i] = false;
+    }
     
     // Pre-allocate vectors for performance
-    vertices.reserve(maxSprites * 4); // 4 vertices per sprite
-    indices.reserve(maxSprites * 6);  // 6 indices per sprite (2 triangles)
+    quadStream.reserve(maxSprites);
     batches.reserve(10); // Reasonable number of batches
 }
 
-SpriteBatcher::~SpriteBatcher() {
-    if (VAO) glDeleteVertexArrays(1, &VAO);
-    if (VBO) glDeleteBuffers(1, &VBO);
-    if (EBO) glDeleteBuffers(1, &EBO);
-    if (shaderProgram) glDeleteProgram(shaderProgram);
+template <typename Vertex>
+BasicSpriteBatcher<Vertex>::~BasicSpriteBatcher() {
+    if (VAO) GLStateCache::getInstance().deleteVertexArrays(1, &VAO);
+    if (VBO) GLStateCache::getInstance().deleteBuffers(1, &VBO);
+    if (EBO) GLStateCache::getInstance().deleteBuffers(1, &EBO);
+    if (indirectBuffer) GLStateCache::getInstance().deleteBuffers(1, &indirectBuffer);
+    if (drawTextureBaseBuffer) GLStateCache::getInstance().deleteBuffers(1, &drawTextureBaseBuffer);
+    ShaderCache::getInstance().release(shaderProgram);
+    if (gpuQueries[0]) glDeleteQueries(GPU_QUERY_COUNT, gpuQueries);
 }
 
-void SpriteBatcher::init() {
-    createShader();
-    setupBuffers();
-    std::cout << "SpriteBatcher initialized successfully" << std::endl;
-}
-
-void SpriteBatcher::createShader() {
-    // Compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
-    
-    // Check vertex shader compilation
-    GLint success;
-    GLchar infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
-        std::cerr << "Vertex shader compilation failed: " << infoLog << std::endl;
-    }
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::init() {
+    // A batch must fit in the texture units the shader can sample
+    GLint textureUnits = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureUnits);
+    textureUnitBudget = std::min(static_cast<int>(textureUnits) - 1, SPRITE_SHADER_TEXTURE_UNITS);
+    maxTexturesPerBatch = std::min(maxTexturesPerBatch, textureUnitBudget);
     
-    // Compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
+    // glMultiDrawElementsIndirect and baseInstance are core since GL 4.3
+    multiDrawSupported = GLAD_GL_VERSION_4_3 && glMultiDrawElementsIndirect != nullptr;
     
-    // Check fragment shader compilation
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, nullptr, infoLog);
-        std::cerr << "Fragment shader compilation failed: " << infoLog << std::endl;
-    }
+    createShader();
+    setupBuffers();
     
-    // Link shader program
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    
-    // Check program linking
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-        std::cerr << "Shader program linking failed: " << infoLog << std::endl;
+    // Timer queries are core since GL 3.3
+    if (GLAD_GL_VERSION_3_3) {
+        glGenQueries(GPU_QUERY_COUNT, gpuQueries);
     }
     
-    // Clean up individual shaders
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    std::cout << "SpriteBatcher initialized successfully"
+              << (multiDrawSupported ? " (multi-draw indirect)" : "") << std::endl;
+}
+
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::createShader() {
+    // Batchers of the same vertex type share one program
+    shaderProgram = ShaderCache::getInstance().acquire(Vertex::vertexShaderSource(), spriteFragmentShaderSource, "sprite batcher");
     
     // Set up texture uniforms
-    glUseProgram(shaderProgram);
-    for (int i = 0; i < maxTexturesPerBatch; ++i) {
+    GLStateCache::getInstance().useProgram(shaderProgram);
+    for (int i = 0; i < SPRITE_SHADER_TEXTURE_UNITS; ++i) {
         std::string uniformName = "uTextures[" + std::to_string(i) + "]";
         glUniform1i(glGetUniformLocation(shaderProgram, uniformName.c_str()), i);
     }
+    bindFrameConstantsBlock(shaderProgram);
+    lightMap.locate(shaderProgram);
 }
 
-void SpriteBatcher::setupBuffers() {
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::setupBuffers() {
     // Generate buffers
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
     
-    glBindVertexArray(VAO);
+    GLStateCache::getInstance().bindVertexArray(VAO);
     
-    // Set up VBO (dynamic buffer for sprite vertices)
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, maxSpritesPerBatch * 4 * sizeof(SpriteVertex), nullptr, GL_DYNAMIC_DRAW);
+    // Attribute layout comes from the vertex type
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, VBO);
+    Vertex::setupAttributes();
     
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, position));
-    glEnableVertexAttribArray(0);
+    // EBO binding is VAO state, so bind it while the VAO is bound
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    resizeBuffers(maxSpritesPerBatch);
     
-    // Texture coordinate attribute
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, texCoord));
-    glEnableVertexAttribArray(1);
+    // Per-draw texture base (attribute 5). Plain glDrawElements reads entry 0,
+    // which is always 0, so the one-draw-per-batch path needs no extra work.
+    GLuint zeroBase = 0;
+    glGenBuffers(1, &drawTextureBaseBuffer);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, drawTextureBaseBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint), &zeroBase, GL_STREAM_DRAW);
+    glVertexAttribIPointer(5, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+    glVertexAttribDivisor(5, 1);
+    glEnableVertexAttribArray(5);
     
-    // Color attribute
-    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, color));
-    glEnableVertexAttribArray(2);
-    
-    // Texture index attribute
-    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, textureIndex));
-    glEnableVertexAttribArray(3);
-    
-    // Set up EBO (index buffer for quad indices)
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxSpritesPerBatch * 6 * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+    if (multiDrawSupported) {
+        glGenBuffers(1, &indirectBuffer);
+    }
     
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindVertexArray(0);
 }
 
-void SpriteBatcher::begin(const glm::mat4& viewProjection) {
-    auto startTime = std::chrono::high_resolution_clock::now();
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::resizeBuffers(int spriteCapacity) {
+    bufferCapacity = spriteCapacity;
+    
+    // VBO is rewritten every frame through glMapBufferRange
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, bufferCapacity * 4 * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+    
+    // Every quad uses the same index pattern, so the EBO is filled once here
+    std::vector<GLuint> quadIndices(bufferCapacity * 6);
+    for (int i = 0; i < bufferCapacity; ++i) {
+        GLuint base = i * 4;
+        quadIndices[i * 6 + 0] = base + 0;
+        quadIndices[i * 6 + 1] = base + 1;
+        quadIndices[i * 6 + 2] = base + 2;
+        quadIndices[i * 6 + 3] = base + 2;
+        quadIndices[i * 6 + 4] = base + 3;
+        quadIndices[i * 6 + 5] = base + 0;
+    }
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, quadIndices.size() * sizeof(GLuint), quadIndices.data(), GL_STATIC_DRAW);
+}
+
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::begin(const glm::mat4& viewProjection) {
+    frameStartTime = std::chrono::high_resolution_clock::now();
     
     viewProjectionMatrix = viewProjection;
     
@@ -180,28 +203,30 @@ void SpriteBatcher::begin(const glm::mat4& viewProjection) {
         batch.clear();
     }
     batches.clear();
-    vertices.clear();
-    indices.clear();
+    quadStream.clear();
     
     // Reset stats
     stats.drawCalls = 0;
     stats.spritesRendered = 0;
     stats.spritesCulled = 0;
     stats.batchesCreated = 0;
-    
-    auto endTime = std::chrono::high_resolution_clock::now();
-    stats.lastFrameTime = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+    stats.commandBuildTime = 0.0f;
+    stats.sortTime = 0.0f;
+    stats.vertexGenTime = 0.0f;
+    stats.uploadTime = 0.0f;
+    stats.submitTime = 0.0f;
+    stats.lastFrameTime = 0.0f;
+    stats.bytesUploaded = 0;
+    
+    commandStartTime = std::chrono::high_resolution_clock::now();
 }
 
-void SpriteBatcher::addSprite(const glm::mat4& transform, const glm::vec4& color, GLuint textureID, 
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::addSprite(const SpriteAffine2D& transform, const glm::vec4& color, GLuint textureID, 
                               const glm::vec2& uvMin, const glm::vec2& uvMax, int layer) {
     
-    // Extract position and size from transform for culling
-    glm::vec3 position = glm::vec3(transform[3]);
-    glm::vec3 scale = glm::vec3(glm::length(transform[0]), glm::length(transform[1]), glm::length(transform[2]));
-    
-    // Frustum culling check
-    if (frustumCullingEnabled && !isInFrustum(position, glm::vec2(scale))) {
+    // Frustum culling check against the rotated quad's bounding box
+    if (frustumCullingEnabled && !isInFrustum(transform.center(), transform.extent())) {
         stats.spritesCulled++;
         return;
     }
@@ -238,89 +263,145 @@ void SpriteBatcher::addSprite(const glm::mat4& transform, const glm::vec4& color
     stats.spritesRendered++;
 }
 
-void SpriteBatcher::end() {
-    if (batches.empty()) return;
-    
-    // Sort batches by layer for proper depth ordering
-    for (auto& batch : batches) {
-        std::sort(batch.commands.begin(), batch.commands.end(),
-            [](const SpriteRenderCommand& a, const SpriteRenderCommand& b) {
-                return a.layer < b.layer;
-            });
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::end(const std::vector<int>& layers, const LayerCallback& callback) {
+    interleavedLayers = &layers;
+    drawInterleaved = &callback;
+    end();
+    interleavedLayers = nullptr;
+    drawInterleaved = nullptr;
+}
+
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::end() {
+    auto stageEnd = std::chrono::high_resolution_clock::now();
+    stats.commandBuildTime += millisecondsSince(commandStartTime, stageEnd);
+    
+    collectGpuTime();
+    
+    if (!batches.empty()) {
+        // Sort batches by layer for proper depth ordering
+        auto stageStart = stageEnd;
+        for (auto& batch : batches) {
+            std::sort(batch.commands.begin(), batch.commands.end(),
+                [](const SpriteRenderCommand& a, const SpriteRenderCommand& b) {
+                    return a.layer < b.layer;
+                });
+        }
+        stats.sortTime = millisecondsSince(stageStart, stageEnd);
+        
+        stageStart = stageEnd;
+        createBatches();
+        stats.vertexGenTime = millisecondsSince(stageStart, stageEnd);
+        
+        // Skip timing this frame if the slot's previous query still hasn't resolved
+        GLuint query = gpuQueries[gpuQueryIndex];
+        bool timed = query != 0 && !gpuQueryPending[gpuQueryIndex];
+        if (timed) glBeginQuery(GL_TIME_ELAPSED, query);
+        
+        renderBatches();
+        
+        if (timed) {
+            glEndQuery(GL_TIME_ELAPSED);
+            gpuQueryPending[gpuQueryIndex] = true;
+            gpuQueryIndex = (gpuQueryIndex + 1) % GPU_QUERY_COUNT;
+        }
+    } else if (interleavedLayers) {
+        for (size_t i = 0; i < interleavedLayers->size(); ++i) (*drawInterleaved)(i);
     }
     
-    createBatches();
-    renderBatches();
+    stats.lastFrameTime = millisecondsSince(frameStartTime, stageEnd);
 }
 
-void SpriteBatcher::createBatches() {
-    vertices.clear();
-    indices.clear();
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::collectGpuTime() {
+    // Oldest to newest, so the most recent finished frame wins. Never blocks.
+    for (int i = GPU_QUERY_COUNT; i >= 1; --i) {
+        int slot = (gpuQueryIndex + GPU_QUERY_COUNT - i) % GPU_QUERY_COUNT;
+        if (!gpuQueryPending[slot]) continue;
+        
+        GLint available = 0;
+        glGetQueryObjectiv(gpuQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(gpuQueries[slot], GL_QUERY_RESULT, &elapsedNs);
+        lastGpuTime = static_cast<float>(elapsedNs / 1.0e6);
+        gpuQueryPending[slot] = false;
+    }
     
-    int vertexIndex = 0;
+    stats.gpuTime = lastGpuTime;
+}
+
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::createBatches() {
+    quadStream.clear();
     
     for (const auto& batch : batches) {
         for (const auto& cmd : batch.commands) {
-            // Generate quad vertices for this sprite
-            generateQuadVertices(cmd, vertexIndex, cmd.textureIndex);
-            
-            // Generate indices for this quad (2 triangles)
-            int baseIndex = vertexIndex;
-            indices.insert(indices.end(), {
-                baseIndex + 0, baseIndex + 1, baseIndex + 2,  // First triangle
-                baseIndex + 2, baseIndex + 3, baseIndex + 0   // Second triangle
-            });
-            
-            vertexIndex += 4; // 4 vertices per quad
+            quadStream.push(cmd.transform, cmd.uvMin, cmd.uvMax, cmd.color, static_cast<int>(cmd.textureIndex));
         }
     }
 }
 
-void SpriteBatcher::generateQuadVertices(const SpriteRenderCommand& cmd, int vertexIndex, float textureIndex) {
-    // Define unit quad vertices (centered at origin)
-    glm::vec3 quadVertices[4] = {
-        glm::vec3(-0.5f, -0.5f, 0.0f), // Bottom-left
-        glm::vec3( 0.5f, -0.5f, 0.0f), // Bottom-right  
-        glm::vec3( 0.5f,  0.5f, 0.0f), // Top-right
-        glm::vec3(-0.5f,  0.5f, 0.0f)  // Top-left
-    };
-    
-    // UV coordinates for the quad
-    glm::vec2 uvCoords[4] = {
-        glm::vec2(cmd.uvMin.x, cmd.uvMin.y), // Bottom-left
-        glm::vec2(cmd.uvMax.x, cmd.uvMin.y), // Bottom-right
-        glm::vec2(cmd.uvMax.x, cmd.uvMax.y), // Top-right
-        glm::vec2(cmd.uvMin.x, cmd.uvMax.y)  // Top-left
-    };
-    
-    // Transform vertices and create sprite vertices
-    for (int i = 0; i < 4; ++i) {
-        glm::vec3 worldPos = glm::vec3(cmd.transform * glm::vec4(quadVertices[i], 1.0f));
-        
-        vertices.emplace_back(
-            worldPos,
-            uvCoords[i],
-            cmd.color,
-            textureIndex
-        );
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::renderBatches() {
+    // Program, VAO and textures stay bound afterwards so the next frame's binds are skipped
+    auto& glState = GLStateCache::getInstance();
+    glState.useProgram(shaderProgram);
+    glState.bindVertexArray(VAO);
+    
+    auto stageStart = std::chrono::high_resolution_clock::now();
+    auto stageEnd = stageStart;
+    
+    // Camera comes from the FrameConstants block; re-uploaded only for a lagged packet
+    FrameConstantBuffer::getInstance().useViewProjection(viewProjectionMatrix);
+    lightMap.apply();
+    
+    // Grow both buffers when the frame holds more sprites than they were sized for
+    int spriteCount = static_cast<int>(quadStream.size());
+    if (spriteCount > bufferCapacity) {
+        resizeBuffers(std::max(spriteCount, bufferCapacity * 2));
     }
-}
-
-void SpriteBatcher::renderBatches() {
-    glUseProgram(shaderProgram);
-    glBindVertexArray(VAO);
     
-    // Upload view-projection matrix
-    GLint vpLocation = glGetUniformLocation(shaderProgram, "uViewProjection");
-    glUniformMatrix4fv(vpLocation, 1, GL_FALSE, &viewProjectionMatrix[0][0]);
+    // Expand quads straight into the VBO; invalidating lets the driver hand
+    // back fresh storage instead of waiting on last frame's draws
+    size_t vertexBytes = spriteCount * 4 * sizeof(Vertex);
+    glState.bindBuffer(GL_ARRAY_BUFFER, VBO);
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexBytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped) {
+        std::cerr << "SpriteBatcher: failed to map vertex buffer" << std::endl;
+        return;
+    }
     
-    // Upload vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(SpriteVertex), vertices.data());
+    auto kernelStart = std::chrono::high_resolution_clock::now();
+    expandSpriteQuads(quadStream, static_cast<Vertex*>(mapped), kernelPath);
+    auto kernelEnd = kernelStart;
+    float kernelTime = millisecondsSince(kernelStart, kernelEnd);
     
-    // Upload index data
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
+    if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) {
+        // Buffer contents were lost (e.g. mode switch); skip this frame's draw
+        std::cerr << "SpriteBatcher: vertex buffer corrupted during upload" << std::endl;
+        return;
+    }
+    
+    stats.bytesUploaded += vertexBytes;
+    stats.vertexGenTime += kernelTime;
+    stats.uploadTime = millisecondsSince(stageStart, stageEnd) - kernelTime;
+    stageStart = stageEnd;
+    
+    if (interleavedLayers && !interleavedLayers->empty()) {
+        renderBatchesInterleaved();
+        stats.submitTime = millisecondsSince(stageStart, stageEnd);
+        return;
+    }
+    
+    if (multiDrawSupported && multiDrawEnabled) {
+        renderBatchesIndirect();
+        stats.submitTime = millisecondsSince(stageStart, stageEnd);
+        return;
+    }
     
     // Render each batch
     int indexOffset = 0;
@@ -335,26 +416,128 @@ void SpriteBatcher::renderBatches() {
         stats.drawCalls++;
     }
     
-    glBindVertexArray(0);
+    stats.submitTime = millisecondsSince(stageStart, stageEnd);
+}
+
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::renderBatchesIndirect() {
+    indirectCommands.clear();
+    drawTextureBases.clear();
+    drawTextures.clear();
+    multiDrawGroups.clear();
+    
+    // Every batch becomes one indirect command. Batches share a group (and a
+    // single multi-draw) while their textures fit in the unit budget; each
+    // draw's texture base shifts its batch-local indices to its group slot.
+    GLuint firstIndex = 0;
+    for (const auto& batch : batches) {
+        size_t groupTextures = multiDrawGroups.empty() ? 0 : drawTextures.size() - multiDrawGroups.back().firstTexture;
+        if (multiDrawGroups.empty() || groupTextures + batch.textureIDs.size() > static_cast<size_t>(textureUnitBudget)) {
+            multiDrawGroups.push_back({indirectCommands.size(), drawTextures.size()});
+            groupTextures = 0;
+        }
+        
+        DrawElementsIndirectCommand command;
+        command.count = static_cast<GLuint>(batch.commands.size() * 6);
+        command.instanceCount = 1;
+        command.firstIndex = firstIndex;
+        command.baseVertex = 0;
+        command.baseInstance = static_cast<GLuint>(indirectCommands.size());
+        indirectCommands.push_back(command);
+        
+        drawTextureBases.push_back(static_cast<GLuint>(groupTextures));
+        drawTextures.insert(drawTextures.end(), batch.textureIDs.begin(), batch.textureIDs.end());
+        firstIndex += command.count;
+    }
+    
+    auto& glState = GLStateCache::getInstance();
+    size_t baseBytes = drawTextureBases.size() * sizeof(GLuint);
+    glState.bindBuffer(GL_ARRAY_BUFFER, drawTextureBaseBuffer);
+    glBufferData(GL_ARRAY_BUFFER, baseBytes, drawTextureBases.data(), GL_STREAM_DRAW);
+    
+    size_t commandBytes = indirectCommands.size() * sizeof(DrawElementsIndirectCommand);
+    glState.bindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commandBytes, indirectCommands.data(), GL_STREAM_DRAW);
+    stats.bytesUploaded += baseBytes + commandBytes;
+    
+    for (size_t group = 0; group < multiDrawGroups.size(); ++group) {
+        bool last = group + 1 == multiDrawGroups.size();
+        size_t firstCommand = multiDrawGroups[group].firstCommand;
+        size_t commandEnd = last ? indirectCommands.size() : multiDrawGroups[group + 1].firstCommand;
+        size_t firstTexture = multiDrawGroups[group].firstTexture;
+        size_t textureEnd = last ? drawTextures.size() : multiDrawGroups[group + 1].firstTexture;
+        
+        for (size_t i = firstTexture; i < textureEnd; ++i) {
+            glState.bindTextureUnit(static_cast<GLuint>(i - firstTexture), GL_TEXTURE_2D, drawTextures[i]);
+        }
+        
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                    (void*)(firstCommand * sizeof(DrawElementsIndirectCommand)),
+                                    static_cast<GLsizei>(commandEnd - firstCommand), 0);
+        stats.drawCalls++;
+    }
+}
+
+// Each batch is sorted by layer, so its sprites between two interleaved layers
+// are one index range: one draw per batch and gap, then the callback. This
+// path doesn't use multi-draw, since the callback has to run between draws.
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::renderBatchesInterleaved() {
+    auto& glState = GLStateCache::getInstance();
+    const std::vector<int>& layers = *interleavedLayers;
+    interleaveCursors.assign(batches.size(), 0);
+    
+    for (size_t gap = 0; gap <= layers.size(); ++gap) {
+        int indexOffset = 0;
+        for (size_t b = 0; b < batches.size(); ++b) {
+            const auto& commands = batches[b].commands;
+            size_t first = interleaveCursors[b];
+            size_t last = commands.size();
+            if (gap < layers.size()) {
+                last = std::upper_bound(commands.begin() + first, commands.end(), layers[gap],
+                    [](int layer, const SpriteRenderCommand& cmd) { return layer < cmd.layer; }) - commands.begin();
+            }
+            
+            if (last > first) {
+                // The callback may have switched program and VAO
+                glState.useProgram(shaderProgram);
+                glState.bindVertexArray(VAO);
+                flushBatch(batches[b]);
+                
+                int indexStart = indexOffset + static_cast<int>(first) * 6;
+                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(last - first) * 6, GL_UNSIGNED_INT,
+                               (void*)(indexStart * sizeof(GLuint)));
+                stats.drawCalls++;
+            }
+            
+            interleaveCursors[b] = last;
+            indexOffset += static_cast<int>(commands.size()) * 6;
+        }
+        
+        if (gap < layers.size()) (*drawInterleaved)(gap);
+    }
 }
 
-void SpriteBatcher::flushBatch(const SpriteBatch& batch) {
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::flushBatch(const SpriteBatch& batch) {
     // Bind all textures used in this batch
+    auto& glState = GLStateCache::getInstance();
     for (size_t i = 0; i < batch.textureIDs.size(); ++i) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, batch.textureIDs[i]);
+        glState.bindTextureUnit(static_cast<GLuint>(i), GL_TEXTURE_2D, batch.textureIDs[i]);
     }
 }
 
-void SpriteBatcher::setFrustumBounds(const glm::vec2& min, const glm::vec2& max, const glm::vec2& size) {
+template <typename Vertex>
+void BasicSpriteBatcher<Vertex>::setFrustumBounds(const glm::vec2& min, const glm::vec2& max, const glm::vec2& size) {
     frustumMin = min;
     frustumMax = max;
     frustumSize = size;
 }
 
-bool SpriteBatcher::isInFrustum(const glm::vec3& position, const glm::vec2& size) const {
+template <typename Vertex>
+bool BasicSpriteBatcher<Vertex>::isInFrustum(const glm::vec2& center, const glm::vec2& size) const {
     // Simple AABB frustum culling
-    glm::vec2 pos2D = glm::vec2(position);
+    glm::vec2 pos2D = center;
     glm::vec2 halfSize = size * 0.5f;
     
     return !(pos2D.x + halfSize.x < frustumMin.x || 
@@ -363,6 +546,10 @@ bool SpriteBatcher::isInFrustum(const glm::vec3& position, const glm::vec2& size
              pos2D.y - halfSize.y > frustumMax.y);
 }
 
+// Explicit template instantiation for both vertex layouts
+template class BasicSpriteBatcher<SpriteVertex>;
+template class BasicSpriteBatcher<PackedSpriteVertex>;
+
 // SpriteRenderManager implementation
 SpriteRenderManager& SpriteRenderManager::getInstance() {
     static SpriteRenderManager instance;
@@ -386,6 +573,7 @@ void SpriteRenderManager::shutdown() {
 
 void SpriteRenderManager::beginFrame(const glm::mat4& viewProjectionMatrix) {
     if (!initialized) return;
+    frameViewProjection = viewProjectionMatrix;
     batcher->begin(viewProjectionMatrix);
 }
 
@@ -394,41 +582,90 @@ void SpriteRenderManager::endFrame() {
     batcher->end();
 }
 
-void SpriteRenderManager::renderSprite(const std::string& spriteName, const glm::mat4& transform, 
-                                       const glm::vec4& color, int layer) {
+void SpriteRenderManager::endFrame(const AnimatedSpriteFrame& animated) {
     if (!initialized) return;
-    
-    // Find atlas containing the sprite
-    auto atlas = TextureAtlasManager::getInstance().findAtlasForSprite(spriteName);
-    if (!atlas) {
-        std::cerr << "Sprite not found in any atlas: " << spriteName << std::endl;
+    endFrameInterleaved(animated, frameViewProjection);
+}
+
+void SpriteRenderManager::endFrameInterleaved(const AnimatedSpriteFrame& animated, const glm::mat4& viewProjection) {
+    // Prepared even when empty so the renderer sees every captured frame in order
+    auto& animatedRenderer = AnimatedSpriteRenderer::getInstance();
+    const AnimatedSpriteFrame* prepared = animatedRenderer.prepare(animated, viewProjection);
+    if (!prepared || prepared->layers.empty()) {
+        batcher->end();
         return;
     }
     
-    // Get sprite UV coordinates
-    const SpriteUV* spriteUV = atlas->getSpriteUV(spriteName);
-    if (!spriteUV) {
-        std::cerr << "Sprite UV data not found: " << spriteName << std::endl;
+    std::vector<int> layers;
+    layers.reserve(prepared->layers.size());
+    for (const auto& range : prepared->layers) layers.push_back(range.layer);
+    
+    batcher->end(layers, [&animatedRenderer](size_t index) { animatedRenderer.drawLayer(index); });
+}
+
+void SpriteRenderManager::renderSprite(const SpriteHandle& sprite, const SpriteAffine2D& transform,
+                                       const glm::vec4& color, int layer) {
+    if (!initialized || !sprite.isValid()) return;
+    
+    auto& atlasManager = TextureAtlasManager::getInstance();
+    atlasManager.markUsed(sprite);
+    const SpriteUV& spriteUV = atlasManager.getSpriteUV(sprite);
+    batcher->addSprite(spriteUV.rotated ? transform.forRotatedUV() : transform, color,
+                       atlasManager.getTextureID(sprite), spriteUV.uv0, spriteUV.uv1, layer);
+}
+
+void SpriteRenderManager::renderSprite(const std::string& spriteName, const SpriteAffine2D& transform, 
+                                       const glm::vec4& color, int layer) {
+    if (!initialized) return;
+    
+    SpriteHandle sprite = TextureAtlasManager::getInstance().resolveSprite(spriteName);
+    if (!sprite.isValid()) {
+        std::cerr << "Sprite not found in any atlas: " << spriteName << std::endl;
         return;
     }
     
-    // Render using atlas texture
-    batcher->addSprite(transform, color, atlas->getTextureID(), 
-                       spriteUV->uv0, spriteUV->uv1, layer);
+    renderSprite(sprite, transform, color, layer);
 }
 
-void SpriteRenderManager::renderSprite(GLuint textureID, const glm::mat4& transform, 
+void SpriteRenderManager::renderSprite(GLuint textureID, const SpriteAffine2D& transform, 
                                        const glm::vec4& color, const glm::vec2& uvMin, 
                                        const glm::vec2& uvMax, int layer) {
     if (!initialized) return;
     batcher->addSprite(transform, color, textureID, uvMin, uvMax, layer);
 }
 
+void SpriteRenderManager::submitPacket(const RenderFramePacket& packet) {
+    if (!initialized) return;
+    
+    batcher->begin(packet.viewProjection);
+    
+    // Workers already culled against the packet's frustum
+    bool cullingEnabled = batcher->isFrustumCullingEnabled();
+    batcher->setFrustumCullingEnabled(false);
+    
+    for (const auto& slice : packet.slices) {
+        for (const auto& sprite : slice.sprites) {
+            batcher->addSprite(sprite.transform, sprite.color, sprite.textureID,
+                               sprite.uvMin, sprite.uvMax, sprite.layer);
+        }
+    }
+    
+    batcher->setFrustumCullingEnabled(cullingEnabled);
+    batcher->addCulledSprites(packet.spritesCulled());
+    batcher->addCommandBuildTime(packet.buildTime());
+    endFrameInterleaved(packet.animated, packet.viewProjection);
+}
+
 void SpriteRenderManager::setFrustumCullingEnabled(bool enabled) {
     if (!initialized) return;
     batcher->setFrustumCullingEnabled(enabled);
 }
 
+void SpriteRenderManager::setMultiDrawEnabled(bool enabled) {
+    if (!initialized) return;
+    batcher->setMultiDrawEnabled(enabled);
+}
+
 void SpriteRenderManager::updateFrustum(const glm::vec2& cameraPos, const glm::vec2& viewSize, float zoom) {
     if (!initialized) return;
     
@@ -439,8 +676,8 @@ void SpriteRenderManager::updateFrustum(const glm::vec2& cameraPos, const glm::v
     batcher->setFrustumBounds(min, max, viewSize);
 }
 
-const SpriteBatcher::RenderStats& SpriteRenderManager::getStats() const {
-    static SpriteBatcher::RenderStats emptyStats;
+const SpriteRenderStats& SpriteRenderManager::getStats() const {
+    static SpriteRenderStats emptyStats;
     return initialized ? batcher->getStats() : emptyStats;
 }
 
@@ -0,0 +1,148 @@
+#include "SpriteVertex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Vertex shaders for each sprite layout; the fragment shader is shared (SpriteBatcher.cpp)
+static const char* spriteVertexShaderSource = R"glsl(
+#version 330 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in float aTextureIndex;
+layout (location = 5) in uint aTextureBase;   // per draw, set by the batcher
+
+layout(std140) uniform FrameConstants {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    mat4 uScreenProjection;
+    vec4 uTimeScreen;
+};
+
+out vec2 vTexCoord;
+out vec4 vColor;
+flat out int vTextureIndex;
+
+void main() {
+    gl_Position = uViewProjection * vec4(aPosition, 1.0);
+    vTexCoord = aTexCoord;
+    vColor = aColor;
+    vTextureIndex = int(aTextureIndex) + int(aTextureBase);
+}
+)glsl";
+
+static const char* packedSpriteVertexShaderSource = R"glsl(
+#version 330 core
+layout (location = 0) in vec2 aPosition;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in uint aTextureIndex;
+layout (location = 4) in float aDepth;
+layout (location = 5) in uint aTextureBase;   // per draw, set by the batcher
+
+layout(std140) uniform FrameConstants {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    mat4 uScreenProjection;
+    vec4 uTimeScreen;
+};
+
+out vec2 vTexCoord;
+out vec4 vColor;
+flat out int vTextureIndex;
+
+void main() {
+    gl_Position = uViewProjection * vec4(aPosition, aDepth, 1.0);
+    vTexCoord = aTexCoord;
+    vColor = aColor;
+    vTextureIndex = int(aTextureIndex + aTextureBase);
+}
+)glsl";
+
+// SpriteVertex: everything as float
+SpriteVertex SpriteVertex::make(const glm::vec3& position, const glm::vec2& uv,
+                                const glm::vec4& color, int textureIndex) {
+    return SpriteVertex(position, uv, color, static_cast<float>(textureIndex));
+}
+
+void SpriteVertex::setupAttributes() {
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, position));
+    glEnableVertexAttribArray(0);
+    
+    // Texture coordinate attribute
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, texCoord));
+    glEnableVertexAttribArray(1);
+    
+    // Color attribute
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, color));
+    glEnableVertexAttribArray(2);
+    
+    // Texture index attribute
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, textureIndex));
+    glEnableVertexAttribArray(3);
+}
+
+const char* SpriteVertex::vertexShaderSource() {
+    return spriteVertexShaderSource;
+}
+
+// PackedSpriteVertex: quantize on the CPU, let the attribute formats expand on the GPU
+static GLushort toUnorm16(float value) {
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return static_cast<GLushort>(value * 65535.0f + 0.5f);
+}
+
+static GLubyte toUnorm8(float value) {
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return static_cast<GLubyte>(value * 255.0f + 0.5f);
+}
+
+static GLshort toSnorm16(float value) {
+    value = std::min(std::max(value, -1.0f), 1.0f);
+    return static_cast<GLshort>(std::lround(value * 32767.0f));
+}
+
+PackedSpriteVertex PackedSpriteVertex::make(const glm::vec3& position, const glm::vec2& uv,
+                                            const glm::vec4& color, int textureIndex) {
+    PackedSpriteVertex vertex;
+    vertex.x = position.x;
+    vertex.y = position.y;
+    vertex.u = toUnorm16(uv.x);
+    vertex.v = toUnorm16(uv.y);
+    vertex.color[0] = toUnorm8(color.x);
+    vertex.color[1] = toUnorm8(color.y);
+    vertex.color[2] = toUnorm8(color.z);
+    vertex.color[3] = toUnorm8(color.w);
+    vertex.z = toSnorm16(position.z);
+    vertex.textureIndex = static_cast<GLushort>(textureIndex);
+    return vertex;
+}
+
+void PackedSpriteVertex::setupAttributes() {
+    // Position attribute (xy)
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(PackedSpriteVertex), (void*)offsetof(PackedSpriteVertex, x));
+    glEnableVertexAttribArray(0);
+    
+    // Texture coordinate attribute, normalized to [0, 1]
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedSpriteVertex), (void*)offsetof(PackedSpriteVertex, u));
+    glEnableVertexAttribArray(1);
+    
+    // Color attribute, normalized to [0, 1]
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedSpriteVertex), (void*)offsetof(PackedSpriteVertex, color));
+    glEnableVertexAttribArray(2);
+    
+    // Texture index attribute, read as an integer (no float conversion)
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_SHORT, sizeof(PackedSpriteVertex), (void*)offsetof(PackedSpriteVertex, textureIndex));
+    glEnableVertexAttribArray(3);
+    
+    // Depth attribute, normalized to [-1, 1]
+    glVertexAttribPointer(4, 1, GL_SHORT, GL_TRUE, sizeof(PackedSpriteVertex), (void*)offsetof(PackedSpriteVertex, z));
+    glEnableVertexAttribArray(4);
+}
+
+const char* PackedSpriteVertex::vertexShaderSource() {
+    return packedSpriteVertexShaderSource;
+}
@@ -0,0 +1,267 @@
+#include "SpriteVertexKernel.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SPRITE_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+// AVX2 is compiled per function (no -mavx2 needed) and picked at runtime
+#if defined(SPRITE_KERNEL_X86) && defined(__GNUC__)
+#define SPRITE_KERNEL_AVX2 1
+#define SPRITE_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/*
+ * Corner math shared by every path, with t = translation, x/y = the axes:
+ *   bottom-left  = t
+ *   bottom-right = t + x
+ *   top-right    = t + x + y
+ *   top-left     = t + y
+ */
+
+// SpriteAffine2D
+SpriteAffine2D SpriteAffine2D::fromComponents(const glm::vec3& position, const glm::vec2& scale,
+                                              float sinRotation, float cosRotation, const glm::vec2& pivot) {
+    SpriteAffine2D affine;
+    affine.axisX = glm::vec2(cosRotation * scale.x, sinRotation * scale.x);
+    affine.axisY = glm::vec2(-sinRotation * scale.y, cosRotation * scale.y);
+    affine.translation = glm::vec2(position.x, position.y) - affine.axisX * pivot.x - affine.axisY * pivot.y;
+    affine.z = position.z;
+    return affine;
+}
+
+SpriteAffine2D SpriteAffine2D::fromDegrees(const glm::vec3& position, const glm::vec2& scale,
+                                           float rotationDegrees, const glm::vec2& pivot) {
+    if (rotationDegrees == 0.0f) {
+        return fromComponents(position, scale, 0.0f, 1.0f, pivot);
+    }
+    float radians = glm::radians(rotationDegrees);
+    return fromComponents(position, scale, std::sin(radians), std::cos(radians), pivot);
+}
+
+SpriteAffine2D SpriteAffine2D::fromMatrix(const glm::mat4& transform) {
+    SpriteAffine2D affine;
+    affine.axisX = glm::vec2(transform[0][0], transform[0][1]);
+    affine.axisY = glm::vec2(transform[1][0], transform[1][1]);
+    affine.translation = glm::vec2(transform[3][0], transform[3][1]) - (affine.axisX + affine.axisY) * 0.5f;
+    affine.z = transform[3][2];
+    return affine;
+}
+
+SpriteAffine2D SpriteAffine2D::forRotatedUV() const {
+    // The region holds the image turned clockwise, so walk the quad's corners
+    // the other way: same parallelogram, texture turned back upright
+    SpriteAffine2D affine = *this;
+    affine.translation = translation + axisX;
+    affine.axisX = axisY;
+    affine.axisY = -axisX;
+    return affine;
+}
+
+glm::mat4 SpriteAffine2D::toMatrix() const {
+    glm::vec2 origin = center();
+    glm::mat4 model(1.0f);
+    model[0] = glm::vec4(axisX.x, axisX.y, 0.0f, 0.0f);
+    model[1] = glm::vec4(axisY.x, axisY.y, 0.0f, 0.0f);
+    model[3] = glm::vec4(origin.x, origin.y, z, 1.0f);
+    return model;
+}
+
+SpriteKernelPath detectSpriteKernelPath() {
+    static const SpriteKernelPath path = [] {
+#if defined(SPRITE_KERNEL_AVX2)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SpriteKernelPath::AVX2;
+#endif
+#if defined(SPRITE_KERNEL_X86)
+        return SpriteKernelPath::SSE;   // SSE2 is baseline on x86-64
+#else
+        return SpriteKernelPath::Scalar;
+#endif
+    }();
+    return path;
+}
+
+const char* spriteKernelPathName(SpriteKernelPath path) {
+    switch (path) {
+        case SpriteKernelPath::AVX2: return "AVX2";
+        case SpriteKernelPath::SSE: return "SSE";
+        default: return "Scalar";
+    }
+}
+
+bool isSpriteKernelPathSupported(SpriteKernelPath path) {
+    return static_cast<int>(path) <= static_cast<int>(detectSpriteKernelPath());
+}
+
+// SpriteQuadStream
+template <typename Vertex>
+void SpriteQuadStream<Vertex>::clear() {
+    translationX.clear();
+    translationY.clear();
+    axisXx.clear();
+    axisXy.clear();
+    axisYx.clear();
+    axisYy.clear();
+    corners.clear();
+}
+
+template <typename Vertex>
+void SpriteQuadStream<Vertex>::reserve(size_t count) {
+    translationX.reserve(count);
+    translationY.reserve(count);
+    axisXx.reserve(count);
+    axisXy.reserve(count);
+    axisYx.reserve(count);
+    axisYy.reserve(count);
+    corners.reserve(count * 4);
+}
+
+template <typename Vertex>
+void SpriteQuadStream<Vertex>::push(const SpriteAffine2D& transform,
+                                    const glm::vec2& uvMin, const glm::vec2& uvMax,
+                                    const glm::vec4& color, int textureIndex) {
+    translationX.push_back(transform.translation.x);
+    translationY.push_back(transform.translation.y);
+    axisXx.push_back(transform.axisX.x);
+    axisXy.push_back(transform.axisX.y);
+    axisYx.push_back(transform.axisY.x);
+    axisYy.push_back(transform.axisY.y);
+
+    // xy is filled in by the kernel; depth does not change across the quad
+    glm::vec3 depth(0.0f, 0.0f, transform.z);
+    corners.push_back(Vertex::make(depth, glm::vec2(uvMin.x, uvMin.y), color, textureIndex));
+    corners.push_back(Vertex::make(depth, glm::vec2(uvMax.x, uvMin.y), color, textureIndex));
+    corners.push_back(Vertex::make(depth, glm::vec2(uvMax.x, uvMax.y), color, textureIndex));
+    corners.push_back(Vertex::make(depth, glm::vec2(uvMin.x, uvMax.y), color, textureIndex));
+}
+
+// Kernels
+template <typename Vertex>
+static void expandScalar(const SpriteQuadStream<Vertex>& stream, size_t first, Vertex* out) {
+    size_t count = stream.size();
+    for (size_t i = first; i < count; ++i) {
+        float tx = stream.translationX[i];
+        float ty = stream.translationY[i];
+        float rx = tx + stream.axisXx[i];   // bottom-right
+        float ry = ty + stream.axisXy[i];
+
+        const Vertex* src = &stream.corners[i * 4];
+        Vertex* dst = out + i * 4;
+        dst[0] = src[0]; dst[0].setPosition(tx, ty);
+        dst[1] = src[1]; dst[1].setPosition(rx, ry);
+        dst[2] = src[2]; dst[2].setPosition(rx + stream.axisYx[i], ry + stream.axisYy[i]);
+        dst[3] = src[3]; dst[3].setPosition(tx + stream.axisYx[i], ty + stream.axisYy[i]);
+    }
+}
+
+// Write one block of up to 8 sprites whose corner positions are already computed.
+// Scalar: each corner vertex is copied and its xy set one at a time; only the
+// position adds above it are SIMD
+template <typename Vertex>
+static inline void storeBlock(const SpriteQuadStream<Vertex>& stream, size_t first, size_t lanes,
+                              const float cornerX[4][8], const float cornerY[4][8], Vertex* out) {
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        const Vertex* src = &stream.corners[(first + lane) * 4];
+        Vertex* dst = out + (first + lane) * 4;
+        for (int corner = 0; corner < 4; ++corner) {
+            dst[corner] = src[corner];
+            dst[corner].setPosition(cornerX[corner][lane], cornerY[corner][lane]);
+        }
+    }
+}
+
+#if defined(SPRITE_KERNEL_X86)
+template <typename Vertex>
+static void expandSSE(const SpriteQuadStream<Vertex>& stream, Vertex* out) {
+    size_t count = stream.size();
+    size_t i = 0;
+    alignas(16) float cornerX[4][8];
+    alignas(16) float cornerY[4][8];
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 tx = _mm_loadu_ps(&stream.translationX[i]);
+        __m128 ty = _mm_loadu_ps(&stream.translationY[i]);
+        __m128 rx = _mm_add_ps(tx, _mm_loadu_ps(&stream.axisXx[i]));
+        __m128 ry = _mm_add_ps(ty, _mm_loadu_ps(&stream.axisXy[i]));
+        __m128 yx = _mm_loadu_ps(&stream.axisYx[i]);
+        __m128 yy = _mm_loadu_ps(&stream.axisYy[i]);
+
+        _mm_store_ps(cornerX[0], tx);
+        _mm_store_ps(cornerY[0], ty);
+        _mm_store_ps(cornerX[1], rx);
+        _mm_store_ps(cornerY[1], ry);
+        _mm_store_ps(cornerX[2], _mm_add_ps(rx, yx));
+        _mm_store_ps(cornerY[2], _mm_add_ps(ry, yy));
+        _mm_store_ps(cornerX[3], _mm_add_ps(tx, yx));
+        _mm_store_ps(cornerY[3], _mm_add_ps(ty, yy));
+
+        storeBlock(stream, i, 4, cornerX, cornerY, out);
+    }
+
+    expandScalar(stream, i, out);
+}
+#endif
+
+#if defined(SPRITE_KERNEL_AVX2)
+template <typename Vertex>
+SPRITE_KERNEL_TARGET_AVX2
+static void expandAVX2(const SpriteQuadStream<Vertex>& stream, Vertex* out) {
+    size_t count = stream.size();
+    size_t i = 0;
+    alignas(32) float cornerX[4][8];
+    alignas(32) float cornerY[4][8];
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 tx = _mm256_loadu_ps(&stream.translationX[i]);
+        __m256 ty = _mm256_loadu_ps(&stream.translationY[i]);
+        __m256 rx = _mm256_add_ps(tx, _mm256_loadu_ps(&stream.axisXx[i]));
+        __m256 ry = _mm256_add_ps(ty, _mm256_loadu_ps(&stream.axisXy[i]));
+        __m256 yx = _mm256_loadu_ps(&stream.axisYx[i]);
+        __m256 yy = _mm256_loadu_ps(&stream.axisYy[i]);
+
+        _mm256_store_ps(cornerX[0], tx);
+        _mm256_store_ps(cornerY[0], ty);
+        _mm256_store_ps(cornerX[1], rx);
+        _mm256_store_ps(cornerY[1], ry);
+        _mm256_store_ps(cornerX[2], _mm256_add_ps(rx, yx));
+        _mm256_store_ps(cornerY[2], _mm256_add_ps(ry, yy));
+        _mm256_store_ps(cornerX[3], _mm256_add_ps(tx, yx));
+        _mm256_store_ps(cornerY[3], _mm256_add_ps(ty, yy));
+
+        storeBlock(stream, i, 8, cornerX, cornerY, out);
+    }
+
+    expandScalar(stream, i, out);
+}
+#endif
+
+template <typename Vertex>
+void expandSpriteQuads(const SpriteQuadStream<Vertex>& stream, Vertex* out, SpriteKernelPath path) {
+    // Never run a path the CPU can't execute, whatever the caller asked for
+    if (!isSpriteKernelPathSupported(path)) {
+        path = detectSpriteKernelPath();
+    }
+
+    switch (path) {
+#if defined(SPRITE_KERNEL_AVX2)
+        case SpriteKernelPath::AVX2:
+            expandAVX2(stream, out);
+            return;
+#endif
+#if defined(SPRITE_KERNEL_X86)
+        case SpriteKernelPath::SSE:
+            expandSSE(stream, out);
+            return;
+#endif
+        default:
+            expandScalar(stream, 0, out);
+            return;
+    }
+}
+
+// Explicit template instantiation for both vertex layouts
+template struct SpriteQuadStream<SpriteVertex>;
+template struct SpriteQuadStream<PackedSpriteVertex>;
+template void expandSpriteQuads<SpriteVertex>(const SpriteQuadStream<SpriteVertex>&, SpriteVertex*, SpriteKernelPath);
+template void expandSpriteQuads<PackedSpriteVertex>(const SpriteQuadStream<PackedSpriteVertex>&, PackedSpriteVertex*, SpriteKernelPath);
@@ -1,15 +1,24 @@
 #include "Texture.hpp"
+#include "GLStateCache.hpp"
+#include "PixelUploadRing.hpp"
+#include "AtlasFile.hpp"
+#include "VirtualFileSystem.hpp"
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <stb_image.h>
 #include <iostream>
 
 Texture::Texture(TextureType type) : textureType(type), textureID(0) {
     glGenTextures(1, &textureID);
+
+    // Textures are created on the GL thread before any decode is queued
+    queryBlockFormatSupport();
 }
 
 Texture::~Texture() {
     if (textureID) {
-        glDeleteTextures(1, &textureID);
+        GLStateCache::getInstance().deleteTextures(1, &textureID);
     }
 }
 
@@ -20,21 +29,12 @@ bool Texture::loadFromFile(const std::string& filepath) {
         return false;
     }
 
-    int width, height, channels;
-    unsigned char* data = stbi_load(filepath.c_str(), &width, &height, &channels, 0);
-    if (!data) {
+    TextureImage image;
+    if (!decode(filepath, image)) {
         std::cerr << "Failed to load texture: " << filepath << std::endl;
         return false;
     }
-
-    GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    configureParameters();
-    stbi_image_free(data);
-    return true;
+    return upload(image);
 }
 
 bool Texture::loadCubemap(const std::vector<std::string>& faces) {
@@ -43,23 +43,12 @@ bool Texture::loadCubemap(const std::vector<std::string>& faces) {
         return false;
     }
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-    int width, height, channels;
-
-    for (size_t i = 0; i < faces.size(); ++i) {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &channels, 0);
-        if (!data) {
-            std::cerr << "Failed to load cubemap face: " << faces[i] << std::endl;
-            return false;
-        }
-
-        GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
+    std::vector<TextureImage> images;
+    if (!decodeLayers(faces, images)) {
+        std::cerr << "Failed to load cubemap faces" << std::endl;
+        return false;
     }
-
-    configureParameters();
-    return true;
+    return uploadCubemap(images);
 }
 
 bool Texture::loadTextureArray(const std::vector<std::string>& layers) {
@@ -75,73 +64,480 @@ bool Texture::loadTextureArray(const std::vector<std::string>& layers) {
         return false;
     }
 
-    int width, height, channels;
-
-    // Load first image to determine size and format
-    unsigned char* firstData = stbi_load(layers[0].c_str(), &width, &height, &channels, 0);
-    if (!firstData) {
-        std::cerr << "Failed to load texture array layer: " << layers[0] << std::endl;
+    std::vector<TextureImage> images;
+    if (!decodeLayers(layers, images)) {
+        std::cerr << "Failed to load texture array layers" << std::endl;
         return false;
     }
+    return uploadTextureArray(images);
+}
 
-    GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
-    GLenum internalFormat = (channels == 4) ? GL_RGBA8 : GL_RGB8;
+bool Texture::decode(const std::string& filepath, TextureImage& image, bool allowCompressed) {
+    if (allowCompressed) {
+        std::string compressedPath = findCompressedVariant(filepath);
+        if (!compressedPath.empty() && readCompressedTexture(compressedPath, image.blocks)) {
+            image.compressed = true;
+            image.width = image.blocks.width;
+            image.height = image.blocks.height;
+            image.channels = 4;
+            return true;
+        }
+    }
 
-    int mipLevels = static_cast<int>(std::floor(std::log2(std::max(width, height)))) + 1;
+    FileBuffer file;
+    if (!VirtualFileSystem::getInstance().read(filepath, file)) return false;
+    unsigned char* data = stbi_load_from_memory(file.data(), static_cast<int>(file.size()),
+                                                &image.width, &image.height, &image.channels, 0);
+    image.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(data, stbi_image_free);
+    return data != nullptr;
+}
 
-    // Generate and bind texture
-    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+bool Texture::decodeLayers(const std::vector<std::string>& filepaths, std::vector<TextureImage>& images,
+                           bool allowCompressed) {
+    images = std::vector<TextureImage>(filepaths.size());
+    size_t compressedCount = 0;
+    for (size_t i = 0; i < filepaths.size(); ++i) {
+        if (!decode(filepaths[i], images[i], allowCompressed)) {
+            std::cerr << "Failed to load texture layer: " << filepaths[i] << std::endl;
+            return false;
+        }
+        if (images[i].compressed) ++compressedCount;
+    }
 
-    // Allocate storage with mipmaps
-    glTexStorage3D(GL_TEXTURE_2D_ARRAY, mipLevels, internalFormat, width, height, layers.size());
+    bool mixed = compressedCount > 0 && compressedCount < images.size();
+    for (size_t i = 1; i < images.size() && !mixed; ++i) {
+        mixed = images[i].compressed && images[i].blocks.format != images[0].blocks.format;
+    }
+    if (!mixed) return true;
+
+    std::cout << "Texture layers are not all compressed the same way, loading the source images" << std::endl;
+    for (size_t i = 0; i < filepaths.size(); ++i) {
+        if (!images[i].compressed) continue;
+        images[i] = TextureImage();
+        if (!decode(filepaths[i], images[i], false)) {
+            std::cerr << "Failed to load texture layer: " << filepaths[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
 
-    // Upload first layer
-    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, width, height, 1, format, GL_UNSIGNED_BYTE, firstData);
-    stbi_image_free(firstData);
+void Texture::createPlaceholder(int layers) {
+    // 2x2 magenta/black, loud enough to spot anything drawn before its load finished
+    const unsigned char checker[16] = {
+        255, 0, 255, 255,   0, 0, 0, 255,
+        0, 0, 0, 255,       255, 0, 255, 255
+    };
 
-    // Upload remaining layers
-    for (size_t i = 1; i < layers.size(); ++i) {
-        int w, h, ch;
-        unsigned char* data = stbi_load(layers[i].c_str(), &w, &h, &ch, 0);
-        if (!data || w != width || h != height || ch != channels) {
-            std::cerr << "Failed to load or mismatch in layer: " << layers[i] << std::endl;
-            stbi_image_free(data);
-            return false;
+    switch (textureType) {
+        case TextureType::TEXTURE_2D:
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+            break;
+        case TextureType::CUBEMAP:
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+            for (int face = 0; face < 6; ++face) {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+            }
+            break;
+        case TextureType::TEXTURE_ARRAY: {
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+            std::vector<unsigned char> pixels;
+            for (int layer = 0; layer < layers; ++layer) pixels.insert(pixels.end(), checker, checker + 16);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 2, 2, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+            break;
+        }
+    }
+    configureParameters();
+}
+
+void Texture::buildMips(TextureImage& image) {
+    image.mips.clear();
+    if (image.compressed || !image.pixels) return;
+
+    int levels = atlasLevelCount(image.width, image.height);
+    int width = image.width, height = image.height;
+    const unsigned char* source = image.pixels.get();
+    for (int level = 1; level < levels; ++level) {
+        image.mips.emplace_back();
+        downsampleAtlasLevel(source, width, height, image.mips.back(), image.channels);
+        source = image.mips.back().data();
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+}
+
+// A level of an uncompressed image as a ring upload
+struct LevelUpload {
+    PixelRegion region;
+    const unsigned char* pixels;
+    std::function<void()> allocate; // optional, before the level's first rows
+    std::function<void()> landed;   // optional, after the level's last rows
+};
+
+static LevelUpload imageLevel(GLenum target, GLuint texture, const TextureImage& image, int level) {
+    LevelUpload upload;
+    upload.region.target = target;
+    upload.region.texture = texture;
+    upload.region.level = level;
+    upload.region.width = std::max(1, image.width >> level);
+    upload.region.height = std::max(1, image.height >> level);
+    upload.region.format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+    upload.pixels = level == 0 ? image.pixels.get() : image.mips[level - 1].data();
+    return upload;
+}
+
+// A level of a compressed image as a ring upload. Its storage is not
+// allocated here: specifying compressed levels smallest first trips drivers
+// that size the texture from the first level seen (Mesa), so callers
+// allocate the whole chain, largest first, up front.
+static LevelUpload compressedLevel(GLenum target, GLuint texture, const CompressedTextureData& blocks, int level) {
+    const CompressedLevel& data = blocks.levels[level];
+    LevelUpload upload;
+    upload.region.target = target;
+    upload.region.texture = texture;
+    upload.region.level = level;
+    upload.region.width = data.width;
+    upload.region.height = data.height;
+    upload.region.compressedFormat = blockFormatGLEnum(blocks.format);
+    upload.region.blockBytes = blockFormatBlockBytes(blocks.format);
+    upload.pixels = blocks.data.data() + data.offset;
+    return upload;
+}
+
+// Submit the levels through PixelUploadRing in order and run finish after the
+// last one: here when not streamed, else from PixelUploadRing::process()
+static void sendLevels(const std::vector<LevelUpload>& uploads, bool streamed, std::function<void()> finish) {
+    auto& ring = PixelUploadRing::getInstance();
+    if (!streamed || uploads.empty()) {
+        for (const auto& upload : uploads) {
+            if (upload.allocate) upload.allocate();
+            ring.upload(upload.region, upload.pixels);
+            if (upload.landed) upload.landed();
         }
+        finish();
+        return;
+    }
 
-        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, format, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
+    auto remaining = std::make_shared<size_t>(uploads.size());
+    for (const auto& upload : uploads) {
+        std::function<void()> landed = upload.landed;
+        ring.stream(upload.region, upload.pixels, [remaining, landed, finish]() {
+            if (landed) landed();
+            if (--*remaining == 0) finish();
+        }, upload.allocate);
     }
+}
 
-    // Set filtering and wrap parameters
+bool Texture::upload(const TextureImage& image) {
+    return uploadImage(image, nullptr);
+}
+
+bool Texture::uploadCubemap(const std::vector<TextureImage>& faces) {
+    return uploadFaces(faces, nullptr);
+}
+
+bool Texture::uploadTextureArray(const std::vector<TextureImage>& layers) {
+    return uploadLayers(layers, nullptr);
+}
+
+void Texture::streamUpload(std::shared_ptr<const TextureImage> image, std::function<void(bool)> done) {
+    uploadImage(*image, [image, done](bool uploaded) { done(uploaded); });
+}
+
+void Texture::streamCubemap(std::shared_ptr<const std::vector<TextureImage>> faces, std::function<void(bool)> done) {
+    uploadFaces(*faces, [faces, done](bool uploaded) { done(uploaded); });
+}
+
+void Texture::streamTextureArray(std::shared_ptr<const std::vector<TextureImage>> layers, std::function<void(bool)> done) {
+    uploadLayers(*layers, [layers, done](bool uploaded) { done(uploaded); });
+}
+
+bool Texture::uploadImage(const TextureImage& image, std::function<void(bool)> done) {
+    auto finish = [&done](bool result) {
+        if (done) done(result);
+        return result;
+    };
+    if (textureType != TextureType::TEXTURE_2D) return finish(false);
+
+    // Stored mips, no glGenerateMipmap (it can't write compressed levels).
+    // Uploaded smallest first, BASE_LEVEL following them down, as for
+    // buildMips() below; the storage is allocated here (see compressedLevel)
+    if (image.compressed) {
+        GLint levelCount = static_cast<GLint>(image.blocks.levels.size());
+        GLenum format = blockFormatGLEnum(image.blocks.format);
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+        for (GLint level = 0; level < levelCount; ++level) {
+            const CompressedLevel& data = image.blocks.levels[level];
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, format, data.width, data.height, 0,
+                                   static_cast<GLsizei>(data.size), nullptr);
+        }
+
+        std::vector<LevelUpload> uploads;
+        for (GLint level = levelCount - 1; level >= 0; --level) {
+            LevelUpload upload = compressedLevel(GL_TEXTURE_2D, textureID, image.blocks, level);
+            upload.landed = [this, level]() {
+                GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+            };
+            uploads.push_back(upload);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelCount);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        sendLevels(uploads, static_cast<bool>(done), [done]() {
+            if (done) done(true);
+        });
+        return true;
+    }
+
+    if (!image.pixels) return finish(false);
+
+    GLenum format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+
+    if (image.mips.empty()) {
+        // The new level 0 doesn't match the old level 1, so while rows stream
+        // in the texture is mipmap incomplete and samples black
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        sendLevels({ imageLevel(GL_TEXTURE_2D, textureID, image, 0) }, static_cast<bool>(done), [this, done]() {
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+            configureParameters();
+            if (done) done(true);
+        });
+        return true;
+    }
+
+    // Levels from buildMips(), smallest first, each allocated just before
+    // its rows. BASE_LEVEL starts past the last level so the texture samples
+    // black, then drops to each level as it lands: the texture sharpens as it
+    // streams in, with no glGenerateMipmap
+    GLint levelCount = static_cast<GLint>(image.mips.size()) + 1;
+    std::vector<LevelUpload> uploads;
+    for (GLint level = levelCount - 1; level >= 0; --level) {
+        LevelUpload upload = imageLevel(GL_TEXTURE_2D, textureID, image, level);
+        GLsizei width = upload.region.width, height = upload.region.height;
+        upload.allocate = [this, level, format, width, height]() {
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+            glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        };
+        upload.landed = [this, level]() {
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+        };
+        uploads.push_back(upload);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelCount);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    sendLevels(uploads, static_cast<bool>(done), [done]() {
+        if (done) done(true);
+    });
+    return true;
+}
+
+bool Texture::uploadFaces(const std::vector<TextureImage>& faces, std::function<void(bool)> done) {
+    auto finish = [&done](bool result) {
+        if (done) done(result);
+        return result;
+    };
+    if (textureType != TextureType::CUBEMAP) return finish(false);
+    for (const auto& face : faces) {
+        if (!face.compressed && !face.pixels) return finish(false);
+    }
+
+    std::vector<LevelUpload> uploads;
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    for (size_t i = 0; i < faces.size(); ++i) {
+        const TextureImage& face = faces[i];
+        GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i);
+
+        // The skybox samples without mips (see configureParameters), so only the base level goes up
+        if (face.compressed) {
+            LevelUpload upload = compressedLevel(target, textureID, face.blocks, 0);
+            PixelRegion region = upload.region;
+            GLsizei size = static_cast<GLsizei>(face.blocks.levels[0].size);
+            upload.allocate = [this, region, size]() {
+                GLStateCache::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+                glCompressedTexImage2D(region.target, 0, region.compressedFormat, region.width, region.height, 0,
+                                       size, nullptr);
+            };
+            uploads.push_back(upload);
+            continue;
+        }
+        GLenum format = (face.channels == 4) ? GL_RGBA : GL_RGB;
+        LevelUpload upload = imageLevel(target, textureID, face, 0);
+        GLsizei width = face.width, height = face.height;
+        upload.allocate = [this, target, format, width, height]() {
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+            glTexImage2D(target, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        };
+        uploads.push_back(upload);
+    }
+
+    // The faces have no mips, so a mipmapped filter keeps the cube map
+    // incomplete (black) until every row has arrived
+    if (done && !uploads.empty()) glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    sendLevels(uploads, static_cast<bool>(done), [this, done]() {
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+        configureParameters();
+        if (done) done(true);
+    });
+    return true;
+}
+
+bool Texture::uploadLayers(const std::vector<TextureImage>& layers, std::function<void(bool)> done) {
+    auto finish = [&done](bool result) {
+        if (done) done(result);
+        return result;
+    };
+    if (textureType != TextureType::TEXTURE_ARRAY || layers.empty()) return finish(false);
+
+    if (layers[0].compressed) {
+        const CompressedTextureData& first = layers[0].blocks;
+        for (size_t i = 1; i < layers.size(); ++i) {
+            const CompressedTextureData& layer = layers[i].blocks;
+            if (!layers[i].compressed || layer.format != first.format || layer.width != first.width
+                || layer.height != first.height || layer.levels.size() != first.levels.size()) {
+                std::cerr << "Texture array layer " << i << " does not match the first layer" << std::endl;
+                return finish(false);
+            }
+        }
+
+        // The chain is allocated up front (see compressedLevel), each level
+        // sized for every layer back to back. Levels then go up smallest
+        // first, BASE_LEVEL following them down as in the uncompressed path below.
+        GLint levelCount = static_cast<GLint>(first.levels.size());
+        GLsizei layerCount = static_cast<GLsizei>(layers.size());
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+        for (GLint level = 0; level < levelCount; ++level) {
+            const CompressedLevel& data = first.levels[level];
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, blockFormatGLEnum(first.format), data.width, data.height,
+                                   layerCount, 0, static_cast<GLsizei>(data.size) * layerCount, nullptr);
+        }
+
+        std::vector<LevelUpload> uploads;
+        for (GLint level = levelCount - 1; level >= 0; --level) {
+            for (GLsizei i = 0; i < layerCount; ++i) {
+                LevelUpload upload = compressedLevel(GL_TEXTURE_2D_ARRAY, textureID, layers[i].blocks, level);
+                upload.region.layer = i;
+                if (i == layerCount - 1) {
+                    upload.landed = [this, level]() {
+                        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+                        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, level);
+                    };
+                }
+                uploads.push_back(upload);
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, levelCount);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        sendLevels(uploads, static_cast<bool>(done), [levelCount, format = first.format, done]() {
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            std::cout << "Texture array loaded " << blockFormatName(format) << " compressed with "
+                      << levelCount << " mip levels.\n";
+            if (done) done(true);
+        });
+        return true;
+    }
+
+    if (!layers[0].pixels) return finish(false);
+
+    int width = layers[0].width;
+    int height = layers[0].height;
+    int channels = layers[0].channels;
+    for (size_t i = 1; i < layers.size(); ++i) {
+        if (!layers[i].pixels || layers[i].width != width || layers[i].height != height || layers[i].channels != channels) {
+            std::cerr << "Texture array layer " << i << " does not match the first layer" << std::endl;
+            return finish(false);
+        }
+    }
+
+    GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
+    GLenum internalFormat = (channels == 4) ? GL_RGBA8 : GL_RGB8;
+
+    int mipLevels = static_cast<int>(std::floor(std::log2(std::max(width, height)))) + 1;
+    GLsizei layerCount = static_cast<GLsizei>(layers.size());
+    bool storedMips = static_cast<int>(layers[0].mips.size()) == mipLevels - 1;
+
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+    // Set filtering and wrap parameters. Until every level is in the array
+    // is incomplete, so a streamed one samples black meanwhile.
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    // Generate mipmaps once
-    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    // With stored mips (buildMips) every level is uploaded, smallest first,
+    // and BASE_LEVEL follows them down as they land, as in uploadImage().
+    // Each level is allocated with its first layer. Mutable storage (not
+    // glTexStorage3D) so the name a placeholder was created under can be
+    // respecified at full size.
+    std::vector<LevelUpload> uploads;
+    int firstLevel = storedMips ? mipLevels - 1 : 0;
+    for (int level = firstLevel; level >= 0; --level) {
+        for (GLsizei i = 0; i < layerCount; ++i) {
+            LevelUpload upload = imageLevel(GL_TEXTURE_2D_ARRAY, textureID, layers[i], level);
+            upload.region.layer = i;
+            if (i == 0) {
+                GLsizei levelWidth = upload.region.width, levelHeight = upload.region.height;
+                upload.allocate = [this, level, internalFormat, format, levelWidth, levelHeight, layerCount]() {
+                    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, levelWidth, levelHeight, layerCount, 0,
+                                 format, GL_UNSIGNED_BYTE, nullptr);
+                };
+            }
+            if (storedMips && i == layerCount - 1) {
+                upload.landed = [this, level]() {
+                    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+                    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, level);
+                };
+            }
+            uploads.push_back(upload);
+        }
+    }
+    if (storedMips) glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, mipLevels);
+
+    sendLevels(uploads, static_cast<bool>(done), [this, mipLevels, storedMips, done]() {
+        // Generate mipmaps once
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+        if (!storedMips) glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
 
-    // Unbind
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        // Unbind
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
-    std::cout << "Texture array loaded successfully with " << mipLevels << " mip levels.\n";
+        std::cout << "Texture array loaded successfully with " << mipLevels << " mip levels.\n";
+        if (done) done(true);
+    });
     return true;
 }
 
 
 
 void Texture::bind(GLenum textureUnit) const {
-    glActiveTexture(textureUnit);
+    GLStateCache::getInstance().activeTexture(textureUnit);
     switch (textureType) {
         case TextureType::TEXTURE_2D:
-            glBindTexture(GL_TEXTURE_2D, textureID);
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
             break;
         case TextureType::CUBEMAP:
-            glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
             break;
         case TextureType::TEXTURE_ARRAY:
-            glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
             break;
     }
 }
@@ -151,6 +547,48 @@ GLuint Texture::getID() const {
     return textureID;
 }
 
+bool Texture::copyLevelsFrom(const Texture& source) {
+    if (textureType != source.textureType || !glCopyImageSubData) return false;
+
+    // Cube map faces are copied as six layers of GL_TEXTURE_CUBE_MAP
+    GLenum target = GL_TEXTURE_2D, queryTarget = GL_TEXTURE_2D;
+    if (textureType == TextureType::CUBEMAP) {
+        target = GL_TEXTURE_CUBE_MAP;
+        queryTarget = GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+    } else if (textureType == TextureType::TEXTURE_ARRAY) {
+        target = queryTarget = GL_TEXTURE_2D_ARRAY;
+    }
+
+    // Compare the whole chain first so a mismatch leaves this texture untouched
+    auto& glState = GLStateCache::getInstance();
+    std::vector<std::array<GLint, 3>> levels;
+    for (GLint level = 0;; ++level) {
+        GLint size[2][4] = {};
+        const GLuint textures[2] = { source.textureID, textureID };
+        for (int i = 0; i < 2; ++i) {
+            glState.bindTexture(target, textures[i]);
+            glGetTexLevelParameteriv(queryTarget, level, GL_TEXTURE_WIDTH, &size[i][0]);
+            glGetTexLevelParameteriv(queryTarget, level, GL_TEXTURE_HEIGHT, &size[i][1]);
+            glGetTexLevelParameteriv(queryTarget, level, GL_TEXTURE_DEPTH, &size[i][2]);
+            glGetTexLevelParameteriv(queryTarget, level, GL_TEXTURE_INTERNAL_FORMAT, &size[i][3]);
+        }
+        if (size[0][0] == 0 && size[1][0] == 0) break;
+        for (int j = 0; j < 4; ++j) {
+            if (size[0][j] != size[1][j]) return false;
+        }
+        GLint depth = textureType == TextureType::CUBEMAP ? 6 : size[0][2];
+        levels.push_back({ size[0][0], size[0][1], depth });
+    }
+    if (levels.empty()) return false;
+
+    for (size_t level = 0; level < levels.size(); ++level) {
+        glCopyImageSubData(source.textureID, target, static_cast<GLint>(level), 0, 0, 0,
+                           textureID, target, static_cast<GLint>(level), 0, 0, 0,
+                           levels[level][0], levels[level][1], levels[level][2]);
+    }
+    return true;
+}
+
 void Texture::configureParameters() {
     std::cout << "configureParameters\n";
     switch (textureType) {
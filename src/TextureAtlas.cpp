@@ -1,29 +1,78 @@
 #include "TextureAtlas.hpp"
+#include "GLStateCache.hpp"
+#include "PixelUploadRing.hpp"
+#include "VirtualFileSystem.hpp"
 #include "stb_image.h"
 #include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <cstring>
 
+// Shared by every atlas so TextureAtlasManager::getGeneration() also sees
+// atlases generated directly rather than through generateAllAtlases()
+static unsigned int atlasGeneration = 1;
+
+// Slot and UV generations are stamps from one counter, so an atlas that
+// replaces another under the same name never repeats the old one's values
+static unsigned int nextStamp() {
+    static unsigned int stamp = 0;
+    return ++stamp;
+}
+
 TextureAtlas::TextureAtlas(int width, int height) 
-    : textureID(0), atlasWidth(width), atlasHeight(height), isGenerated(false) {
-    rootNode = std::make_unique<AtlasNode>(0, 0, width, height);
-    
-    // Generate OpenGL texture
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    : textureID(0), atlasWidth(width), atlasHeight(height), isGenerated(false),
+      slotGeneration(nextStamp()), uvGeneration(nextStamp()) {
+    // Generate OpenGL texture for the first page
+    textureID = createPageTexture();
+    pageTextures.push_back(textureID);
+}
+
+TextureAtlas::~TextureAtlas() {
+    // Queued rects would land in whatever texture reuses these names
+    if (pendingUploads > 0) {
+        for (GLuint texture : pageTextures) PixelUploadRing::getInstance().cancel(texture);
+    }
+    if (!pageTextures.empty()) {
+        GLStateCache::getInstance().deleteTextures(static_cast<GLsizei>(pageTextures.size()), pageTextures.data());
+    }
+    for (const auto& retired : retiredTextures) {
+        GLStateCache::getInstance().deleteTextures(1, &retired.texture);
+    }
+}
+
+GLuint TextureAtlas::createPageTexture() {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texture;
 }
 
-TextureAtlas::~TextureAtlas() {
-    if (textureID != 0) {
-        glDeleteTextures(1, &textureID);
-    }
+// RGBA pixels of an image file (free with stbi_image_free), nullptr if unreadable
+static unsigned char* loadSpritePixels(const std::string& filePath, int& width, int& height, int& channels) {
+    FileBuffer file;
+    if (!VirtualFileSystem::getInstance().read(filePath, file)) return nullptr;
+    return stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 4);
 }
 
 bool TextureAtlas::addSprite(const std::string& spriteName, const std::string& filePath) {
+    if (dynamic) {
+        int width, height, channels;
+        unsigned char* data = loadSpritePixels(filePath, width, height, channels);
+        if (!data) {
+            std::cerr << "Failed to load sprite: " << filePath << std::endl;
+            return false;
+        }
+        int index = insertDynamicSprite(spriteName, data, width, height, 4);
+        stbi_image_free(data);
+        if (index < 0) return false;
+        spriteFiles[spriteName] = std::filesystem::path(filePath).lexically_normal().string();
+        return true;
+    }
+    
     if (isGenerated) {
         std::cerr << "Cannot add sprite to already generated atlas: " << spriteName << std::endl;
         return false;
@@ -35,7 +84,7 @@ bool TextureAtlas::addSprite(const std::string& spriteName, const std::string& f
     }
     
     auto spriteData = std::make_unique<SpriteData>();
-    spriteData->data = stbi_load(filePath.c_str(), &spriteData->width, &spriteData->height, &spriteData->channels, 4); // Force RGBA
+    spriteData->data = loadSpritePixels(filePath, spriteData->width, spriteData->height, spriteData->channels); // Force RGBA
     spriteData->allocated = true;
     
     if (!spriteData->data) {
@@ -47,10 +96,16 @@ bool TextureAtlas::addSprite(const std::string& spriteName, const std::string& f
     spriteData->channels = 4;
     
     spriteDataMap[spriteName] = std::move(spriteData);
+    spriteOrder.push_back(spriteName);
+    spriteFiles[spriteName] = std::filesystem::path(filePath).lexically_normal().string();
     return true;
 }
 
 bool TextureAtlas::addSprite(const std::string& spriteName, unsigned char* data, int width, int height, int channels) {
+    if (dynamic) {
+        return insertDynamicSprite(spriteName, data, width, height, channels) >= 0;
+    }
+    
     if (isGenerated) {
         std::cerr << "Cannot add sprite to already generated atlas: " << spriteName << std::endl;
         return false;
@@ -69,12 +124,22 @@ bool TextureAtlas::addSprite(const std::string& spriteName, unsigned char* data,
     spriteData->allocated = false; // Caller manages memory
     
     spriteDataMap[spriteName] = std::move(spriteData);
+    spriteOrder.push_back(spriteName);
     return true;
 }
 
 const SpriteUV* TextureAtlas::getSpriteUV(const std::string& spriteName) const {
-    auto it = spriteUVs.find(spriteName);
-    return (it != spriteUVs.end()) ? &it->second : nullptr;
+    int index = getSpriteIndex(spriteName);
+    return (index >= 0) ? &uvTable[index] : nullptr;
+}
+
+int TextureAtlas::getSpriteIndex(const std::string& spriteName) const {
+    if (bakedFile) return bakedFile->findSprite(spriteName);
+    auto it = spriteIndices.find(spriteName);
+    if (it == spriteIndices.end()) return -1;
+    
+    // A dynamic sprite whose rows are still queued isn't drawable yet
+    return (!dynamic || slotLanded[it->second]) ? it->second : -1;
 }
 
 bool TextureAtlas::generateAtlas() {
@@ -87,137 +152,558 @@ bool TextureAtlas::generateAtlas() {
     
     generateTexture();
     isGenerated = true;
+    uvGeneration = nextStamp();
+    ++atlasGeneration;
     
     // Clear sprite data after generating texture to save memory
     spriteDataMap.clear();
+    spriteOrder.clear();
     
     return true;
 }
 
 std::vector<std::string> TextureAtlas::getSpriteNames() const {
     std::vector<std::string> names;
-    for (const auto& pair : spriteUVs) {
+    if (bakedFile) {
+        for (int i = 0; i < getSpriteCount(); ++i) names.push_back(bakedFile->spriteName(i));
+        return names;
+    }
+    for (const auto& pair : spriteIndices) {
         names.push_back(pair.first);
     }
     return names;
 }
 
-TextureAtlas::AtlasNode* TextureAtlas::insertSprite(AtlasNode* node, int width, int height) {
-    if (!node) return nullptr;
+bool TextureAtlas::packSprites() {
+    // UV slots follow insertion order; packing order only decides placement
+    uvTable.assign(spriteOrder.size(), SpriteUV());
+    spriteIndices.clear();
     
-    // If we have children, try to insert in them
-    if (node->left && node->right) {
-        AtlasNode* result = insertSprite(node->left.get(), width, height);
-        if (result) return result;
-        return insertSprite(node->right.get(), width, height);
+    // Add 1 pixel border to prevent bleeding
+    std::vector<int> paddedWidths, paddedHeights;
+    for (const auto& name : spriteOrder) {
+        const SpriteData* sprite = spriteDataMap[name].get();
+        paddedWidths.push_back(sprite->width + 2);
+        paddedHeights.push_back(sprite->height + 2);
     }
     
-    // If this node is occupied, can't use it
-    if (node->occupied) return nullptr;
+    RectPacker packer(atlasWidth, atlasHeight, allowRotation);
+    placements = packer.pack(paddedWidths, paddedHeights);
+    occupancy = packer.getOccupancy();
+    
+    for (size_t i = 0; i < spriteOrder.size(); ++i) {
+        const std::string& name = spriteOrder[i];
+        const SpriteData* sprite = spriteDataMap[name].get();
+        const PackedRect& rect = placements[i];
+        
+        // Only a sprite larger than a page can't be placed; the rest of the atlas still builds
+        if (!rect.isPacked()) {
+            std::cerr << "Failed to pack sprite: " << name << " (size: " << sprite->width << "x" << sprite->height
+                      << ", page: " << atlasWidth << "x" << atlasHeight << ")" << std::endl;
+            continue;
+        }
+        
+        // Calculate UV coordinates (accounting for 1-pixel border)
+        float uv0[2], uv1[2];
+        atlasRegionUV(rect, atlasWidth, atlasHeight, uv0, uv1);
+        
+        SpriteUV& uv = uvTable[i];
+        uv = SpriteUV(glm::vec2(uv0[0], uv0[1]), glm::vec2(uv1[0], uv1[1]), glm::vec2(sprite->width, sprite->height));
+        uv.page = rect.page;
+        uv.rotated = rect.rotated;
+        spriteIndices[name] = static_cast<int>(i);
+    }
+    
+    return !spriteIndices.empty() || spriteOrder.empty();
+}
+
+void TextureAtlas::generateTexture() {
+    int pageCount = 1;
+    for (const auto& rect : placements) {
+        pageCount = std::max(pageCount, rect.page + 1);
+    }
+    while (static_cast<int>(pageTextures.size()) < pageCount) {
+        pageTextures.push_back(createPageTexture());
+    }
     
-    // If sprite doesn't fit, can't use this node
-    if (width > node->width || height > node->height) return nullptr;
+    std::vector<AtlasSourceImage> images;
+    for (const auto& name : spriteOrder) {
+        const SpriteData* sprite = spriteDataMap[name].get();
+        AtlasSourceImage image;
+        image.data = sprite->data;
+        image.width = sprite->width;
+        image.height = sprite->height;
+        image.channels = sprite->channels;
+        images.push_back(image);
+    }
     
-    // If sprite fits exactly, use this node
-    if (width == node->width && height == node->height) {
-        node->occupied = true;
-        return node;
+    std::vector<unsigned char> atlasData;
+    for (int page = 0; page < pageCount; ++page) {
+        composeAtlasPage(page, atlasWidth, atlasHeight, images, placements, atlasData);
+        
+        // Upload to GPU. Blocking: generateAtlas() is a load step, and its
+        // callers look the sprites up right after
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, pageTextures[page]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        PixelRegion region;
+        region.texture = pageTextures[page];
+        region.width = atlasWidth;
+        region.height = atlasHeight;
+        PixelUploadRing::getInstance().upload(region, atlasData.data());
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, pageTextures[page]);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+bool TextureAtlas::loadFromFile(const std::string& filePath) {
+    if (isGenerated || !spriteOrder.empty()) {
+        std::cerr << "Can only load a baked atlas into an empty atlas: " << filePath << std::endl;
+        return false;
     }
     
-    // Split the node
-    int dw = node->width - width;
-    int dh = node->height - height;
+    auto file = std::make_unique<MappedAtlasFile>();
+    if (!file->open(filePath)) return false;
     
-    if (dw > dh) {
-        // Split vertically
-        node->left = std::make_unique<AtlasNode>(node->x, node->y, width, node->height);
-        node->right = std::make_unique<AtlasNode>(node->x + width, node->y, node->width - width, node->height);
-    } else {
-        // Split horizontally  
-        node->left = std::make_unique<AtlasNode>(node->x, node->y, node->width, height);
-        node->right = std::make_unique<AtlasNode>(node->x, node->y + height, node->width, node->height - height);
+    const AtlasFileHeader& header = file->header();
+    atlasWidth = static_cast<int>(header.pageWidth);
+    atlasHeight = static_cast<int>(header.pageHeight);
+    
+    uvTable.resize(header.spriteCount);
+    for (uint32_t i = 0; i < header.spriteCount; ++i) {
+        const AtlasFileSprite& entry = file->sprite(i);
+        SpriteUV& uv = uvTable[i];
+        uv = SpriteUV(glm::vec2(entry.uv0[0], entry.uv0[1]), glm::vec2(entry.uv1[0], entry.uv1[1]),
+                      glm::vec2(entry.size[0], entry.size[1]));
+        uv.page = static_cast<int>(entry.page);
+        uv.rotated = entry.rotated != 0;
+    }
+    
+    // Levels come straight out of the mapping, rows already bottom-up. Blocking,
+    // like generateAtlas(): the mapping's pixels are released right after
+    while (pageTextures.size() < header.pageCount) {
+        pageTextures.push_back(createPageTexture());
     }
+    for (uint32_t page = 0; page < header.pageCount; ++page) {
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, pageTextures[page]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(header.levelCount) - 1);
+        for (uint32_t level = 0; level < header.levelCount; ++level) {
+            PixelRegion region;
+            region.texture = pageTextures[page];
+            region.level = static_cast<GLint>(level);
+            region.width = file->levelWidth(level);
+            region.height = file->levelHeight(level);
+            GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, pageTextures[page]);
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, region.width, region.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            PixelUploadRing::getInstance().upload(region, file->levelPixels(page, level));
+        }
+    }
+    file->releasePixels();
+    
+    // Names stay in the mapping; lookups go through its hash table
+    bakedFile = std::move(file);
+    occupancy = 0.0;
+    isGenerated = true;
+    uvGeneration = nextStamp();
+    ++atlasGeneration;
+    return true;
+}
+
+void TextureAtlas::makeDynamic() {
+    dynamic = true;
+    dynamicPacker = std::make_unique<RectPacker>(atlasWidth, atlasHeight);
+    dynamicPacker->setPageLimit(1);
     
-    return insertSprite(node->left.get(), width, height);
+    // Storage for the one page; sprites arrive with glTexSubImage2D
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    isGenerated = true;
+    ++atlasGeneration;
 }
 
-bool TextureAtlas::packSprites() {
-    // Sort sprites by area (largest first) for better packing
-    std::vector<std::pair<std::string, SpriteData*>> sortedSprites;
-    for (auto& pair : spriteDataMap) {
-        sortedSprites.emplace_back(pair.first, pair.second.get());
+int TextureAtlas::insertDynamicSprite(const std::string& spriteName, const unsigned char* data,
+                                      int width, int height, int channels) {
+    if (spriteIndices.count(spriteName)) {
+        std::cerr << "Sprite already exists in atlas: " << spriteName << std::endl;
+        return -1;
     }
     
-    std::sort(sortedSprites.begin(), sortedSprites.end(),
-        [](const auto& a, const auto& b) {
-            return (a.second->width * a.second->height) > (b.second->width * b.second->height);
-        });
+    // Add 1 pixel border to prevent bleeding
+    int paddedWidth = width + 2;
+    int paddedHeight = height + 2;
+    if (paddedWidth > atlasWidth || paddedHeight > atlasHeight) {
+        std::cerr << "Sprite larger than dynamic atlas: " << spriteName << " (size: " << width << "x" << height << ")" << std::endl;
+        return -1;
+    }
     
-    // Pack each sprite
-    for (const auto& pair : sortedSprites) {
-        const std::string& name = pair.first;
-        const SpriteData* sprite = pair.second;
-        
-        // Add 1 pixel border to prevent bleeding
-        int paddedWidth = sprite->width + 2;
-        int paddedHeight = sprite->height + 2;
+    double pageArea = static_cast<double>(atlasWidth) * atlasHeight;
+    double neededArea = static_cast<double>(paddedWidth) * paddedHeight;
+    
+    PackedRect rect = dynamicPacker->insert(paddedWidth, paddedHeight);
+    while (!rect.isPacked()) {
+        // Enough room in total but in pieces: repack, which merges freed space.
+        // Otherwise (or if already packed tight) evict the least recently used.
+        bool roomInTotal = pageArea * (1.0 - dynamicPacker->getOccupancy()) >= neededArea;
+        if (!(roomInTotal && releasedSinceDefragment && defragment()) && !evictLeastRecentlyUsed()) {
+            std::cerr << "Dynamic atlas full, every sprite is used by a pending draw: " << spriteName << std::endl;
+            return -1;
+        }
+        rect = dynamicPacker->insert(paddedWidth, paddedHeight);
+    }
+    
+    int index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = static_cast<int>(uvTable.size());
+        uvTable.emplace_back();
+        dynamicRects.emplace_back();
+        slotNames.emplace_back();
+        lastUsedFrame.push_back(0);
+        slotGenerations.push_back(0);
+        slotLanded.push_back(false);
+    }
+    
+    float uv0[2], uv1[2];
+    atlasRegionUV(rect, atlasWidth, atlasHeight, uv0, uv1);
+    uvTable[index] = SpriteUV(glm::vec2(uv0[0], uv0[1]), glm::vec2(uv1[0], uv1[1]), glm::vec2(width, height));
+    dynamicRects[index] = rect;
+    slotNames[index] = spriteName;
+    lastUsedFrame[index] = currentFrame;
+    slotGenerations[index] = nextStamp();
+    slotLanded[index] = false;
+    spriteIndices[spriteName] = index;
+    occupancy = dynamicPacker->getOccupancy();
+    
+    // Stream the padded rect so a reused area's old border pixels are cleared
+    // too. Rows go out in queue order, so one queued for a rect that is freed
+    // and reused meanwhile is overwritten by the newer sprite's.
+    AtlasSourceImage image;
+    image.data = data;
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    unsigned int stamp = slotGenerations[index];
+    uploadSpriteRect(textureID, rect, image, [this, index, stamp]() {
+        if (slotGenerations[index] != stamp) return;  // removed or evicted while queued
+        slotLanded[index] = true;
         
-        AtlasNode* node = insertSprite(rootNode.get(), paddedWidth, paddedHeight);
-        if (!node) {
-            std::cerr << "Failed to pack sprite: " << name << " (size: " << sprite->width << "x" << sprite->height << ")" << std::endl;
+        // New names may resolve now where they didn't before; resolved handles stay current
+        ++atlasGeneration;
+    });
+    return index;
+}
+
+bool TextureAtlas::removeSprite(const std::string& spriteName) {
+    if (!dynamic) {
+        std::cerr << "Only dynamic atlases can remove sprites: " << spriteName << std::endl;
+        return false;
+    }
+    
+    auto it = spriteIndices.find(spriteName);
+    if (it == spriteIndices.end()) return false;
+    releaseSlot(it->second);
+    return true;
+}
+
+void TextureAtlas::releaseSlot(int index) {
+    dynamicPacker->release(dynamicRects[index]);
+    spriteIndices.erase(slotNames[index]);
+    spriteFiles.erase(slotNames[index]);
+    dynamicRects[index] = PackedRect();
+    slotNames[index].clear();
+    uvTable[index] = SpriteUV(glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(0.0f));
+    freeSlots.push_back(index);
+    occupancy = dynamicPacker->getOccupancy();
+    releasedSinceDefragment = true;
+    
+    // Handles to this slot and UV tables that include it are stale
+    slotGenerations[index] = nextStamp();
+    uvGeneration = nextStamp();
+}
+
+// Evict the sprite drawn longest ago. Sprites used in the last frameLatency + 1
+// frames are never evicted: a draw built with their rect may not be submitted yet
+bool TextureAtlas::evictLeastRecentlyUsed() {
+    int oldest = -1;
+    for (int i = 0; i < static_cast<int>(dynamicRects.size()); ++i) {
+        if (!dynamicRects[i].isPacked() || lastUsedFrame[i] + frameLatency >= currentFrame) continue;
+        if (oldest < 0 || lastUsedFrame[i] < lastUsedFrame[oldest]) oldest = i;
+    }
+    if (oldest < 0) return false;
+    
+    releaseSlot(oldest);
+    ++evictionCount;
+    return true;
+}
+
+void TextureAtlas::beginFrame() {
+    if (!dynamic) return;
+    ++currentFrame;
+    
+    // Every draw built while these were current has been submitted
+    auto expired = std::partition(retiredTextures.begin(), retiredTextures.end(),
+        [this](const RetiredTexture& retired) { return retired.lastFrame >= currentFrame; });
+    for (auto it = expired; it != retiredTextures.end(); ++it) {
+        GLStateCache::getInstance().deleteTextures(1, &it->texture);
+    }
+    retiredTextures.erase(expired, retiredTextures.end());
+    
+    // Only releases fragment the free space; a fresh packing may be over the threshold too
+    if (releasedSinceDefragment && getFragmentation() > defragmentThreshold) defragment();
+}
+
+double TextureAtlas::getFragmentation() const {
+    return dynamicPacker ? dynamicPacker->getFragmentation() : 0.0;
+}
+
+// Repack the live sprites into a new texture, copying their pixels on the GPU
+bool TextureAtlas::defragment() {
+    if (!dynamic) return false;
+    
+    // Queued rows target the current texture and would miss the new one;
+    // releasedSinceDefragment stays set, so beginFrame() tries again
+    if (pendingUploads > 0) return false;
+    
+    std::vector<int> live;
+    std::vector<int> widths, heights;
+    for (int i = 0; i < static_cast<int>(dynamicRects.size()); ++i) {
+        if (!dynamicRects[i].isPacked()) continue;
+        live.push_back(i);
+        widths.push_back(dynamicRects[i].width);
+        heights.push_back(dynamicRects[i].height);
+    }
+    
+    auto packer = std::make_unique<RectPacker>(atlasWidth, atlasHeight);
+    packer->setPageLimit(1);
+    std::vector<PackedRect> placements = packer->pack(widths, heights);
+    for (const auto& rect : placements) {
+        if (!rect.isPacked()) {
+            // Keep the old layout; don't retry until something else is released
+            releasedSinceDefragment = false;
             return false;
         }
-        
-        // Calculate UV coordinates (accounting for 1-pixel border)
-        float u0 = (float)(node->x + 1) / atlasWidth;
-        float v0 = (float)(node->y + 1) / atlasHeight;
-        float u1 = (float)(node->x + 1 + sprite->width) / atlasWidth;
-        float v1 = (float)(node->y + 1 + sprite->height) / atlasHeight;
-        
-        spriteUVs[name] = SpriteUV(
-            glm::vec2(u0, v0),
-            glm::vec2(u1, v1),
-            glm::vec2(sprite->width, sprite->height)
-        );
     }
     
+    GLuint newTexture = createPageTexture();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    
+    std::vector<PackedRect> from;
+    for (int index : live) from.push_back(dynamicRects[index]);
+    blitRects(textureID, newTexture, from, placements);
+    
+    // Draws built this frame or the frameLatency before it still sample the old
+    // page with the old UVs; it is left untouched and deleted after they're submitted
+    retiredTextures.push_back({textureID, currentFrame + frameLatency});
+    textureID = newTexture;
+    pageTextures[0] = newTexture;
+    
+    for (size_t i = 0; i < live.size(); ++i) {
+        int index = live[i];
+        dynamicRects[index] = placements[i];
+        float uv0[2], uv1[2];
+        atlasRegionUV(placements[i], atlasWidth, atlasHeight, uv0, uv1);
+        uvTable[index].uv0 = glm::vec2(uv0[0], uv0[1]);
+        uvTable[index].uv1 = glm::vec2(uv1[0], uv1[1]);
+    }
+    dynamicPacker = std::move(packer);
+    occupancy = dynamicPacker->getOccupancy();
+    releasedSinceDefragment = false;
+    
+    // Indices are unchanged, but cached UVs (animation tables) and the texture are not
+    uvGeneration = nextStamp();
     return true;
 }
 
-void TextureAtlas::generateTexture() {
-    // Create empty atlas texture
-    std::vector<unsigned char> atlasData(atlasWidth * atlasHeight * 4, 0);
-    
-    // Copy sprite data to atlas
-    for (const auto& pair : spriteDataMap) {
-        const std::string& name = pair.first;
-        const SpriteData* sprite = pair.second.get();
-        const SpriteUV& uv = spriteUVs[name];
-        
-        // Calculate pixel positions from UV coordinates  
-        int x = (int)(uv.uv0.x * atlasWidth);
-        int y = (int)(uv.uv0.y * atlasHeight);
+// Clear level 0 of destination, then copy each from rect of source's level 0
+// to the matching to rect with framebuffer blits, all on the GPU
+void TextureAtlas::blitRects(GLuint source, GLuint destination, const std::vector<PackedRect>& from,
+                             const std::vector<PackedRect>& to) {
+    GLint previousRead = 0, previousDraw = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+    bool scissor = GLStateCache::getInstance().isEnabled(GL_SCISSOR_TEST);
+    GLStateCache::getInstance().disable(GL_SCISSOR_TEST);
+    
+    GLuint framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, destination, 0);
+    
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    
+    for (size_t i = 0; i < from.size(); ++i) {
+        glBlitFramebuffer(from[i].x, from[i].y, from[i].x + from[i].width, from[i].y + from[i].height,
+                          to[i].x, to[i].y, to[i].x + to[i].width, to[i].y + to[i].height,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+    glDeleteFramebuffers(2, framebuffers);
+    GLStateCache::getInstance().setEnabled(GL_SCISSOR_TEST, scissor);
+}
+
+void TextureAtlas::uploadSpriteRect(GLuint texture, const PackedRect& rect, const AtlasSourceImage& image,
+                                    std::function<void()> landed) {
+    PackedRect local = rect;
+    local.x = local.y = 0;
+    local.page = 0;
+    auto pixels = std::make_shared<std::vector<unsigned char>>();
+    composeAtlasPage(0, rect.width, rect.height, {image}, {local}, *pixels);
+    
+    // Inside the ring's frame budget; the destructor cancels what's still queued
+    PixelRegion region;
+    region.texture = texture;
+    region.x = rect.x;
+    region.y = rect.y;
+    region.width = rect.width;
+    region.height = rect.height;
+    ++pendingUploads;
+    PixelUploadRing::getInstance().stream(region, pixels->data(), [this, pixels, landed]() {
+        --pendingUploads;
+        if (landed) landed();
+    });
+}
+
+bool TextureAtlas::replaceSprite(const std::string& spriteName, const unsigned char* rgba, int width, int height) {
+    if (bakedFile) {
+        std::cerr << "Sprites of a baked atlas can't be replaced, bake it again: " << spriteName << std::endl;
+        return false;
+    }
+    // A dynamic sprite still streaming in can be replaced too
+    auto slot = dynamic ? spriteIndices.find(spriteName) : spriteIndices.end();
+    int index = slot != spriteIndices.end() ? slot->second : getSpriteIndex(spriteName);
+    if (!isGenerated || index < 0) {
+        std::cerr << "Sprite not in a generated atlas: " << spriteName << std::endl;
+        return false;
+    }
+    
+    AtlasSourceImage image;
+    image.data = rgba;
+    image.width = width;
+    image.height = height;
+    image.channels = 4;
+    
+    if (dynamic) {
+        const PackedRect& rect = dynamicRects[index];
+        if (rect.width == width + 2 && rect.height == height + 2) {
+            // The old pixels are drawn until the new ones land
+            uploadSpriteRect(textureID, rect, image);
+            return true;
+        }
         
-        // Copy sprite pixels to atlas
-        for (int row = 0; row < sprite->height; ++row) {
-            for (int col = 0; col < sprite->width; ++col) {
-                int srcIndex = ((sprite->height - 1 - row) * sprite->width + col) * sprite->channels;
-                int dstIndex = ((y + row) * atlasWidth + (x + col)) * 4;
-                
-                if (dstIndex + 3 < atlasData.size() && srcIndex + 3 < sprite->width * sprite->height * sprite->channels) {
-                    atlasData[dstIndex + 0] = sprite->data[srcIndex + 0]; // R
-                    atlasData[dstIndex + 1] = sprite->data[srcIndex + 1]; // G  
-                    atlasData[dstIndex + 2] = sprite->data[srcIndex + 2]; // B
-                    atlasData[dstIndex + 3] = (sprite->channels == 4) ? sprite->data[srcIndex + 3] : 255; // A
-                }
-            }
+        // Resized: give the rect back and insert again (usually into the same
+        // slot); the name resolves again once the new rect lands
+        auto file = spriteFiles.find(spriteName);
+        std::string filePath = file != spriteFiles.end() ? file->second : std::string();
+        releaseSlot(index);
+        if (insertDynamicSprite(spriteName, rgba, width, height, 4) < 0) return false;
+        if (!filePath.empty()) spriteFiles[spriteName] = filePath;
+        return true;
+    }
+    
+    // The page's mips are rebuilt once the new pixels land
+    const PackedRect& rect = placements[index];
+    GLuint texture = pageTextures[rect.page];
+    auto rebuildMips = [texture]() {
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    };
+    int placedWidth = rect.rotated ? height : width;
+    int placedHeight = rect.rotated ? width : height;
+    if (rect.width == placedWidth + 2 && rect.height == placedHeight + 2) {
+        uploadSpriteRect(texture, rect, image, rebuildMips);
+    } else if (!repackPage(index, image, rebuildMips)) {
+        std::cerr << "Failed to replace sprite: " << spriteName << std::endl;
+        return false;
+    }
+    uvTable[index].size = glm::vec2(width, height);
+    return true;
+}
+
+// Repack the page holding a resized sprite; the page's other sprites keep
+// their pixels (and rotation) and are moved on the GPU
+bool TextureAtlas::repackPage(int index, const AtlasSourceImage& image, std::function<void()> landed) {
+    int page = placements[index].page;
+    std::vector<int> members;
+    std::vector<int> widths, heights;
+    for (int i = 0; i < static_cast<int>(placements.size()); ++i) {
+        if (placements[i].page != page) continue;
+        members.push_back(i);
+        widths.push_back(i == index ? image.width + 2 : placements[i].width);
+        heights.push_back(i == index ? image.height + 2 : placements[i].height);
+    }
+    
+    RectPacker packer(atlasWidth, atlasHeight);
+    packer.setPageLimit(1);
+    std::vector<PackedRect> packed = packer.pack(widths, heights);
+    for (const auto& rect : packed) {
+        if (!rect.isPacked()) {
+            std::cerr << "Sprites no longer fit on atlas page " << page << std::endl;
+            return false;
         }
     }
     
-    // Upload to GPU
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlasData.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // The page is copied aside on the GPU, then the other sprites are blitted
+    // back to their new rects, so nothing is read back to the CPU
+    std::vector<PackedRect> from, to;
+    PackedRect whole;
+    whole.x = whole.y = 0;
+    whole.width = atlasWidth;
+    whole.height = atlasHeight;
+    for (size_t m = 0; m < members.size(); ++m) {
+        if (members[m] == index) continue;
+        from.push_back(placements[members[m]]);
+        to.push_back(packed[m]);
+    }
+    
+    GLuint previous = createPageTexture();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    blitRects(pageTextures[page], previous, {whole}, {whole});
+    blitRects(previous, pageTextures[page], from, to);
+    GLStateCache::getInstance().deleteTextures(1, &previous);
+    
+    // Only the resized sprite is uploaded
+    for (size_t m = 0; m < members.size(); ++m) {
+        if (members[m] == index) uploadSpriteRect(pageTextures[page], packed[m], image, landed);
+    }
+    
+    for (size_t m = 0; m < members.size(); ++m) {
+        int i = members[m];
+        PackedRect rect = packed[m];
+        rect.page = page;
+        rect.rotated = i != index && placements[i].rotated;
+        placements[i] = rect;
+        
+        float uv0[2], uv1[2];
+        atlasRegionUV(rect, atlasWidth, atlasHeight, uv0, uv1);
+        uvTable[i].uv0 = glm::vec2(uv0[0], uv0[1]);
+        uvTable[i].uv1 = glm::vec2(uv1[0], uv1[1]);
+        uvTable[i].rotated = rect.rotated;
+    }
+    
+    // Same indices, new UVs: cached copies must be refreshed
+    uvGeneration = nextStamp();
+    return true;
+}
+
+std::vector<std::string> TextureAtlas::getSpritesForFile(const std::string& filePath) const {
+    std::string normalized = std::filesystem::path(filePath).lexically_normal().string();
+    std::vector<std::string> names;
+    for (const auto& pair : spriteFiles) {
+        if (pair.second == normalized) names.push_back(pair.first);
+    }
+    return names;
 }
 
 // TextureAtlasManager implementation
@@ -228,13 +714,55 @@ TextureAtlasManager& TextureAtlasManager::getInstance() {
 
 std::shared_ptr<TextureAtlas> TextureAtlasManager::createAtlas(const std::string& name, int width, int height) {
     auto atlas = std::make_shared<TextureAtlas>(width, height);
-    atlases[name] = atlas;
+    atlas->setFrameLatency(frameLatency);
+    
+    // Recreating a name reuses its slot; the generation bump makes old handles re-resolve
+    auto it = atlases.find(name);
+    if (it != atlases.end()) {
+        atlasList[it->second] = atlas;
+    } else {
+        atlases[name] = static_cast<int>(atlasList.size());
+        atlasList.push_back(atlas);
+    }
+    ++atlasGeneration;
     return atlas;
 }
 
 std::shared_ptr<TextureAtlas> TextureAtlasManager::getAtlas(const std::string& name) {
     auto it = atlases.find(name);
-    return (it != atlases.end()) ? it->second : nullptr;
+    return (it != atlases.end()) ? atlasList[it->second] : nullptr;
+}
+
+std::shared_ptr<TextureAtlas> TextureAtlasManager::createDynamicAtlas(const std::string& name, int width, int height) {
+    auto atlas = createAtlas(name, width, height);
+    atlas->makeDynamic();
+    return atlas;
+}
+
+void TextureAtlasManager::beginFrame() {
+    for (auto& atlas : atlasList) {
+        atlas->beginFrame();
+    }
+}
+
+void TextureAtlasManager::setFrameLatency(int latency) {
+    frameLatency = latency;
+    for (auto& atlas : atlasList) {
+        atlas->setFrameLatency(latency);
+    }
+}
+
+std::shared_ptr<TextureAtlas> TextureAtlasManager::loadAtlasFile(const std::string& name, const std::string& filePath) {
+    auto atlas = createAtlas(name);
+    if (!atlas->loadFromFile(filePath)) {
+        std::cerr << "Failed to load baked atlas: " << name << std::endl;
+        return nullptr;
+    }
+    
+    for (const auto& spriteName : atlas->getSpriteNames()) {
+        spriteToAtlasMap[spriteName] = name;
+    }
+    return atlas;
 }
 
 bool TextureAtlasManager::loadSpriteToAtlas(const std::string& atlasName, const std::string& spriteName, const std::string& filePath) {
@@ -259,8 +787,47 @@ std::shared_ptr<TextureAtlas> TextureAtlasManager::findAtlasForSprite(const std:
     return nullptr;
 }
 
+std::vector<std::pair<std::shared_ptr<TextureAtlas>, std::string>>
+TextureAtlasManager::findSpritesForFile(const std::string& filePath) {
+    std::vector<std::pair<std::shared_ptr<TextureAtlas>, std::string>> found;
+    for (const auto& atlas : atlasList) {
+        for (const auto& name : atlas->getSpritesForFile(filePath)) found.emplace_back(atlas, name);
+    }
+    return found;
+}
+
+SpriteHandle TextureAtlasManager::resolveSprite(const std::string& spriteName, const std::string& atlasName) {
+    SpriteHandle handle;
+    
+    const std::string* name = &atlasName;
+    if (atlasName.empty()) {
+        auto sprite = spriteToAtlasMap.find(spriteName);
+        if (sprite == spriteToAtlasMap.end()) return handle;
+        name = &sprite->second;
+    }
+    
+    auto it = atlases.find(*name);
+    if (it == atlases.end()) return handle;
+    
+    int uvIndex = atlasList[it->second]->getSpriteIndex(spriteName);
+    if (uvIndex < 0) return handle;
+    
+    handle.atlasIndex = it->second;
+    handle.uvIndex = uvIndex;
+    return handle;
+}
+
+unsigned int TextureAtlasManager::getGeneration() const {
+    return atlasGeneration;
+}
+
+unsigned int TextureAtlas::getSlotGeneration(int index) const {
+    if (index < 0 || index >= getSpriteCount()) return 0;
+    return dynamic ? slotGenerations[index] : slotGeneration;
+}
+
 void TextureAtlasManager::generateAllAtlases() {
-    for (auto& pair : atlases) {
-        pair.second->generateAtlas();
+    for (auto& atlas : atlasList) {
+        atlas->generateAtlas();
     }
 }
\ No newline at end of file
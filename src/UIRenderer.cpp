@@ -1,21 +1,26 @@
 #include "UIRenderer.hpp"
+#include "GLStateCache.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 
-UIRenderer::UIRenderer() : windowWidth(1200), windowHeight(800) {
+UIRenderer::UIRenderer() {
     uiShader = ResourceManager<Shader>::getInstance().get("uiShader");
     textShader = ResourceManager<Shader>::getInstance().get("textShader");
 
-    setupMatrices();
+    // Resolved once; render() sets these per element. The screen projection
+    // comes from the FrameConstants block.
+    if (uiShader) {
+        uiModel = uiShader->getUniform("model");
+        uiColor = uiShader->getUniform("color");
+    }
+    if (textShader) {
+        textColor = textShader->getUniform("textColor");
+    }
+
     initializeQuadBuffers();
     initializeTextBuffers();
 }
 
-void UIRenderer::setupMatrices() {
-    projectionMatrix = glm::ortho(0.0f, static_cast<float>(windowWidth), 0.0f, static_cast<float>(windowHeight));
-    viewMatrix = glm::mat4(1.0f);
-}
-
 void UIRenderer::initializeQuadBuffers() {
     float quadVertices[] = {
         -0.5f,  0.5f,  0.0f, 1.0f,
@@ -29,11 +34,11 @@ void UIRenderer::initializeQuadBuffers() {
     glGenBuffers(1, &quadVBO);
     glGenBuffers(1, &quadEBO);
 
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    GLStateCache::getInstance().bindVertexArray(quadVAO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
@@ -41,31 +46,39 @@ void UIRenderer::initializeQuadBuffers() {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::getInstance().bindVertexArray(0);
 }
 
 void UIRenderer::initializeTextBuffers() {
     glGenVertexArrays(1, &textVAO);
     glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+    GLStateCache::getInstance().bindVertexArray(textVAO);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, textVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::getInstance().bindVertexArray(0);
 }
 
 void UIRenderer::drawQuad() {
+    // Left bound: consecutive quads skip the program and VAO binds
     uiShader->use();
-    glBindVertexArray(quadVAO);
+    GLStateCache::getInstance().bindVertexArray(quadVAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
 void UIRenderer::render(const std::vector<size_t>& uiEntities, ECS* ecs) {
-    glDisable(GL_CULL_FACE);
+    auto& glState = GLStateCache::getInstance();
+    glState.disable(GL_CULL_FACE);
+    auto& textures = ResourceManager<Texture>::getInstance();
+    auto& fonts = ResourceManager<Font>::getInstance();
+
+    // Uniforms that are the same for every element are set once per frame
+    uiShader->use();
+    uiShader->setVec4(uiColor, glm::vec4(1.0f)); // Default tint color
+
     for (const auto& entityID : uiEntities) {
         // Retrieve the UITransformComponent for positioning
         auto transform = ecs->getComponent<UITransform>(entityID);
@@ -80,11 +93,9 @@ void UIRenderer::render(const std::vector<size_t>& uiEntities, ECS* ecs) {
         
         if (imageComponent.isImageVisible) {
             uiShader->use();
-            uiShader->setMat4("projection", projectionMatrix);
-            uiShader->setMat4("model", modelMatrix);
-            uiShader->setVec4("color", glm::vec4(1.0f)); // Default tint color
+            uiShader->setMat4(uiModel, modelMatrix);
 
-            auto texture = ResourceManager<Texture>::getInstance().get(imageComponent.textureCode);
+            Texture* texture = textures.get(imageComponent.texture);
             if (texture) {
                 texture->bind(GL_TEXTURE0);
                 drawQuad();
@@ -93,40 +104,46 @@ void UIRenderer::render(const std::vector<size_t>& uiEntities, ECS* ecs) {
 
         // Render UITextComponent if it exists
         if (textComponent.isTextVisible) {
-            
-            renderText(
-                textComponent.text,
-                textComponent.fontCode,
-                transform.position.x,
-                transform.position.y,
-                transform.scale.x,
-                textComponent.color
-            );
+            // Skipped while the font is not loaded
+            if (const Font* font = fonts.get(textComponent.font)) {
+                renderText(
+                    textComponent.text,
+                    *font,
+                    transform.position.x,
+                    transform.position.y,
+                    transform.scale.x,
+                    textComponent.color
+                );
+            }
         }
     }
     glFrontFace(GL_CCW);
-    glEnable(GL_CULL_FACE);
+    glState.enable(GL_CULL_FACE);
     glCullFace(GL_BACK);
 }
 
 void UIRenderer::renderText(const std::string& text, const std::string& fontKey, float x, float y, float scale, const glm::vec3& color) {
-    
-    glDisable(GL_DEPTH_TEST); // Disable depth test for text rendering
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    textShader -> use();
-    textShader->setVec3("textColor", color);
-    textShader->setMat4("projection", projectionMatrix);
-
-    auto fontOpt = ResourceManager<Font>::getInstance().get(fontKey);
-    if (!fontOpt) {
+    auto font = ResourceManager<Font>::getInstance().get(fontKey);
+    if (!font) {
         std::cerr << "Font not found for key: " << fontKey << std::endl;
         return;
     }
-    auto font = fontOpt;
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(textVAO);
+    renderText(text, *font, x, y, scale, color);
+}
+
+void UIRenderer::renderText(const std::string& text, const Font& font, float x, float y, float scale, const glm::vec3& color) {
+    // Redundant with the previous text element's state, so mostly elided by the cache
+    auto& glState = GLStateCache::getInstance();
+    glState.disable(GL_DEPTH_TEST); // Disable depth test for text rendering
+    glState.enable(GL_BLEND);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    textShader -> use();
+    textShader->setVec3(textColor, color);
+
+    glState.activeTexture(GL_TEXTURE0);
+    glState.bindVertexArray(textVAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, textVBO);
     
     float initialX = x;
     float lineSpacing = 2.0f;
@@ -136,8 +153,8 @@ void UIRenderer::renderText(const std::string& text, const std::string& fontKey,
     float maxDescent = 0.0f;
 
     for (const char c : text) {
-        if (font->Characters.find(c) == font->Characters.end()) continue;
-        const Character& ch = font->Characters.at(c);
+        if (font.Characters.find(c) == font.Characters.end()) continue;
+        const Character& ch = font.Characters.at(c);
         textWidth += (ch.Advance >> 6) * scale;
     }
 
@@ -150,12 +167,13 @@ void UIRenderer::renderText(const std::string& text, const std::string& fontKey,
     for (const char c : text) {
         if (c == '\n') {
             x = x - textWidth / 2.0f; // Reset X for new line
-            y -= font->Characters['H'].Size.y * 1.2f;  // Move down by line height
+            auto lineHeight = font.Characters.find('H');
+            if (lineHeight != font.Characters.end()) y -= lineHeight->second.Size.y * 1.2f;  // Move down by line height
             continue;
         }
-        if (font->Characters.find(c) == font->Characters.end()) continue;
+        if (font.Characters.find(c) == font.Characters.end()) continue;
 
-        const Character& ch = font->Characters[c];
+        const Character& ch = font.Characters.at(c);
 
         float xpos = x + ch.Bearing.x * scale;
         float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
@@ -173,16 +191,12 @@ void UIRenderer::renderText(const std::string& text, const std::string& fontKey,
             { xpos + w, ypos + h,   1.0f, 0.0f }
         };
 
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+        glState.bindTexture(GL_TEXTURE_2D, ch.TextureID);
         glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        
+
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
         x += (ch.Advance >> 6) * scale; // Advance cursor
     }
-    glBindVertexArray(0);
-
-    glEnable(GL_DEPTH_TEST); // Re-enable depth test
+    glState.enable(GL_DEPTH_TEST); // Re-enable depth test
 }
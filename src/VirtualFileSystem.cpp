@@ -0,0 +1,160 @@
+#include "VirtualFileSystem.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+VirtualFileSystem& VirtualFileSystem::getInstance() {
+    static VirtualFileSystem instance;
+    return instance;
+}
+
+VirtualFileSystem::MountedPack::~MountedPack() {
+    if (data) munmap(data, size);
+}
+
+const PackFileEntry* VirtualFileSystem::MountedPack::find(const std::string& normalizedPath) const {
+    uint64_t hash = hashPackPath(normalizedPath.data(), normalizedPath.size());
+    const PackFileEntry* begin = entries();
+    const PackFileEntry* end = begin + header().entryCount;
+    const PackFileEntry* entry = std::lower_bound(begin, end, hash,
+        [](const PackFileEntry& e, uint64_t value) { return e.pathHash < value; });
+    if (entry == end || entry->pathHash != hash) return nullptr;
+
+    // The hash only narrows it down; the path decides
+    if (entry->nameLength != normalizedPath.size()
+        || std::memcmp(name(*entry), normalizedPath.data(), normalizedPath.size()) != 0) return nullptr;
+    return entry;
+}
+
+bool VirtualFileSystem::mount(const std::string& packPath) {
+    int fd = ::open(packPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open pack file: " << packPath << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(PackFileHeader)) {
+        std::cerr << "Pack file is too small: " << packPath << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map pack file: " << packPath << std::endl;
+        return false;
+    }
+
+    auto pack = std::make_unique<MountedPack>();
+    pack->path = packPath;
+    pack->data = static_cast<unsigned char*>(mapping);
+    pack->size = static_cast<size_t>(info.st_size);
+
+    const PackFileHeader& h = pack->header();
+    bool valid = std::memcmp(h.magic, "PACK", 4) == 0 && h.version == PACK_FILE_VERSION
+        && h.fileSize == pack->size
+        && h.entryOffset + uint64_t(h.entryCount) * sizeof(PackFileEntry) <= h.nameOffset
+        && h.nameOffset <= h.dataOffset && h.dataOffset <= pack->size;
+    for (uint32_t i = 0; valid && i < h.entryCount; ++i) {
+        const PackFileEntry& entry = pack->entries()[i];
+        valid = entry.offset >= h.dataOffset && entry.offset + entry.storedSize <= pack->size
+            && h.nameOffset + entry.nameOffset + entry.nameLength <= h.dataOffset
+            && (entry.compression == PACK_STORED ? entry.storedSize == entry.size : entry.compression == PACK_LZ4)
+            && (i == 0 || pack->entries()[i - 1].pathHash < entry.pathHash);
+    }
+    if (!valid) {
+        std::cerr << "Not a valid pack file (version " << PACK_FILE_VERSION << "): " << packPath << std::endl;
+        return false;
+    }
+
+    // Lookups touch the table at random; file reads are sequential within a file
+    madvise(pack->data, static_cast<size_t>(h.dataOffset), MADV_WILLNEED);
+    std::cout << "Mounted " << packPath << " (" << h.entryCount << " files)" << std::endl;
+    packs.push_back(std::move(pack));
+    return true;
+}
+
+void VirtualFileSystem::unmountAll() {
+    packs.clear();
+}
+
+const PackFileEntry* VirtualFileSystem::find(const std::string& path, const MountedPack*& pack) const {
+    if (packs.empty()) return nullptr;
+    std::string normalized = normalizePackPath(path);
+    for (auto it = packs.rbegin(); it != packs.rend(); ++it) {
+        if (const PackFileEntry* entry = (*it)->find(normalized)) {
+            pack = it->get();
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+bool VirtualFileSystem::read(const std::string& path, FileBuffer& buffer, size_t limit) const {
+    buffer = FileBuffer();
+
+    const MountedPack* pack = nullptr;
+    if (const PackFileEntry* entry = find(path, pack)) {
+        const unsigned char* stored = pack->data + entry->offset;
+        size_t size = static_cast<size_t>(std::min<uint64_t>(entry->size, limit));
+        if (entry->compression == PACK_STORED) {
+            buffer.view = stored;
+            buffer.viewSize = size;
+            return true;
+        }
+        buffer.owned.resize(size);
+        if (!lz4Decompress(stored, static_cast<size_t>(entry->storedSize), buffer.owned.data(), size)) {
+            std::cerr << "Corrupt file in " << pack->path << ": " << path << std::endl;
+            buffer.owned.clear();
+            return false;
+        }
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamsize size = std::min<std::streamsize>(file.tellg(), static_cast<std::streamsize>(
+        std::min<size_t>(limit, static_cast<size_t>(std::numeric_limits<std::streamsize>::max()))));
+    file.seekg(0);
+    buffer.owned.resize(static_cast<size_t>(size));
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(buffer.owned.data()), size));
+}
+
+bool VirtualFileSystem::exists(const std::string& path) const {
+    if (isPacked(path)) return true;
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+bool VirtualFileSystem::isPacked(const std::string& path) const {
+    const MountedPack* pack = nullptr;
+    return find(path, pack) != nullptr;
+}
+
+void VirtualFileSystem::prefetch(const std::string& directory) const {
+    std::string prefix = normalizePackPath(directory);
+    if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    for (const auto& pack : packs) {
+        uint64_t begin = pack->size, end = 0;
+        for (uint32_t i = 0; i < pack->header().entryCount; ++i) {
+            const PackFileEntry& entry = pack->entries()[i];
+            if (entry.nameLength < prefix.size() || std::memcmp(pack->name(entry), prefix.data(), prefix.size()) != 0) continue;
+            begin = std::min(begin, entry.offset);
+            end = std::max(end, entry.offset + entry.storedSize);
+        }
+        if (begin >= end) continue;
+
+        // madvise wants a page-aligned start
+        begin -= begin % static_cast<uint64_t>(pageSize);
+        madvise(pack->data + begin, static_cast<size_t>(end - begin), MADV_WILLNEED);
+    }
+}
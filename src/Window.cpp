@@ -1,11 +1,12 @@
 #include "Window.hpp"
+#include "GLStateCache.hpp"
 
 
 
 
 std::vector<InputEvent> Window::eventBuffer; 
-Window::Window(int width, int height)
-    : width(width), height(height), title("OpenGL Window"), window(nullptr), mousePosX(0.0), mousePosY(0.0) {
+Window::Window(int width, int height, bool vsync)
+    : width(width), height(height), title("OpenGL Window"), window(nullptr), mousePosX(0.0), mousePosY(0.0), vsyncEnabled(vsync) {
     
     // Initialize GLFW
     if (!glfwInit()) {
@@ -66,8 +67,9 @@ Window::Window(int width, int height)
 
     // Set viewport size
     glViewport(0, 0, width, height);
-    glEnable(GL_DEPTH_TEST);
-    glfwSwapInterval(1); // Enable VSync
+    GLStateCache::getInstance().invalidate();   // new context
+    GLStateCache::getInstance().enable(GL_DEPTH_TEST);
+    glfwSwapInterval(vsyncEnabled ? 1 : 0);
     glClearColor(0.8f, 0.8f, 0.8f, 1.0f); 
 }
 
@@ -83,7 +85,7 @@ void Window::update() {
     // Update mouse position
     //glfwGetCursorPos(window, &mousePosX, &mousePosY);
 
-    clear();
+    // No clear here: the render graph's world pass clears at the start of the next frame
 }
 
 void Window::clear() {
@@ -118,6 +120,17 @@ GLFWwindow* Window::getWindow() {
     return window;
 }
 
+void Window::setVSync(bool enabled) {
+    vsyncEnabled = enabled;
+    if (window) {
+        glfwSwapInterval(enabled ? 1 : 0);
+    }
+}
+
+bool Window::isVSyncEnabled() const {
+    return vsyncEnabled;
+}
+
 void Window::processInput() {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
@@ -0,0 +1,154 @@
+/*
+ * Atlas Baker
+ *
+ * Packs sprite images offline into a baked atlas file (see AtlasFile.hpp)
+ * that TextureAtlasManager::loadAtlasFile maps and uploads at startup
+ * without decoding or packing anything.
+ *
+ * Usage:
+ *   build/atlas_baker -o sprites.atlas [--size N] [--rotate] [--list sprites.txt]
+ *                     [name=path.png ...] [path.png ...]
+ *
+ * A sprite given as a bare path is named after the file without its
+ * directory and extension. A list file has one "name path" pair per line.
+ * Sprites keep the order they are given in, so animation frames listed one
+ * after another stay contiguous in the UV table.
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "AtlasFile.hpp"
+#include "RectPacker.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct SpriteSource {
+    std::string name;
+    std::string path;
+};
+
+static std::string nameFromPath(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string file = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    size_t dot = file.find_last_of('.');
+    return (dot == std::string::npos) ? file : file.substr(0, dot);
+}
+
+static bool readList(const std::string& listPath, std::vector<SpriteSource>& sources) {
+    std::ifstream list(listPath);
+    if (!list) {
+        std::cerr << "Failed to open sprite list: " << listPath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(list, line)) {
+        std::istringstream fields(line);
+        SpriteSource source;
+        if (!(fields >> source.name)) continue;     // blank line
+        if (source.name[0] == '#') continue;
+        if (!(fields >> source.path)) {
+            std::cerr << "Expected \"name path\" in " << listPath << ": " << line << std::endl;
+            return false;
+        }
+        sources.push_back(source);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string outputPath;
+    int pageSize = 2048;
+    bool allowRotation = false;
+    std::vector<SpriteSource> sources;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            outputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+            pageSize = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rotate") == 0) {
+            allowRotation = true;
+        } else if (std::strcmp(argv[i], "--list") == 0 && hasValue) {
+            if (!readList(argv[++i], sources)) return 1;
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        } else {
+            std::string argument = argv[i];
+            size_t equals = argument.find('=');
+            if (equals == std::string::npos) {
+                sources.push_back({nameFromPath(argument), argument});
+            } else {
+                sources.push_back({argument.substr(0, equals), argument.substr(equals + 1)});
+            }
+        }
+    }
+
+    if (outputPath.empty() || sources.empty() || pageSize <= 0) {
+        std::cerr << "Usage: atlas_baker -o out.atlas [--size N] [--rotate] [--list file] [name=path ...]" << std::endl;
+        return 1;
+    }
+
+    // Decode everything up front; the runtime never does this again
+    std::vector<AtlasSourceImage> images;
+    std::vector<int> paddedWidths, paddedHeights;
+    for (const auto& source : sources) {
+        AtlasSourceImage image;
+        image.data = stbi_load(source.path.c_str(), &image.width, &image.height, &image.channels, 4);
+        image.channels = 4;
+        if (!image.data) {
+            std::cerr << "Failed to load sprite: " << source.path << std::endl;
+            return 1;
+        }
+        images.push_back(image);
+
+        // Add 1 pixel border to prevent bleeding
+        paddedWidths.push_back(image.width + 2);
+        paddedHeights.push_back(image.height + 2);
+    }
+
+    RectPacker packer(pageSize, pageSize, allowRotation);
+    std::vector<PackedRect> placements = packer.pack(paddedWidths, paddedHeights);
+
+    std::vector<AtlasBakeSprite> sprites;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const PackedRect& rect = placements[i];
+        if (!rect.isPacked()) {
+            std::cerr << "Sprite larger than a page, skipped: " << sources[i].name << " (" << images[i].width
+                      << "x" << images[i].height << ")" << std::endl;
+            continue;
+        }
+
+        AtlasBakeSprite sprite;
+        sprite.name = sources[i].name;
+        atlasRegionUV(rect, pageSize, pageSize, sprite.uv0, sprite.uv1);
+        sprite.size[0] = static_cast<float>(images[i].width);
+        sprite.size[1] = static_cast<float>(images[i].height);
+        sprite.page = rect.page;
+        sprite.rotated = rect.rotated;
+        sprites.push_back(sprite);
+    }
+
+    std::vector<std::vector<unsigned char>> pages(packer.getPageCount());
+    for (int page = 0; page < packer.getPageCount(); ++page) {
+        composeAtlasPage(page, pageSize, pageSize, images, placements, pages[page]);
+    }
+
+    for (const auto& image : images) {
+        stbi_image_free(const_cast<unsigned char*>(image.data));
+    }
+
+    if (!writeAtlasFile(outputPath, pageSize, pageSize, sprites, pages)) return 1;
+
+    std::cout << "Baked " << sprites.size() << " sprites into " << pages.size() << " page(s) of "
+              << pageSize << "x" << pageSize << " (occupancy " << packer.getOccupancy() * 100.0 << "%): "
+              << outputPath << std::endl;
+    return 0;
+}
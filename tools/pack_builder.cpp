@@ -0,0 +1,78 @@
+/*
+ * Pack Builder
+ *
+ * Collects asset files into one pack (see PackFile.hpp) that
+ * VirtualFileSystem maps at startup, so loaders read from a single mapping
+ * instead of opening every file.
+ *
+ * Usage:
+ *   build/pack_builder -o assets.pak [--no-compress] directory|file ...
+ *
+ * Directories are added recursively. Files keep the path they are given by
+ * ("assets/textures/a.png"), which is the path the game loads them by, so
+ * run it from the directory the game runs in.
+ */
+
+#include "PackFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    std::string outputPath;
+    bool compress = true;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            outputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--no-compress") == 0) {
+            compress = false;
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if (outputPath.empty() || inputs.empty()) {
+        std::cerr << "Usage: pack_builder -o assets.pak [--no-compress] directory|file ..." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> files;
+    for (const auto& input : inputs) {
+        std::error_code error;
+        if (!std::filesystem::is_directory(input, error)) {
+            files.push_back(input);
+            continue;
+        }
+        for (auto it = std::filesystem::recursive_directory_iterator(input, error);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (error) break;
+            if (it->is_regular_file(error)) files.push_back(it->path().string());
+        }
+        if (error) {
+            std::cerr << "Failed to list " << input << ": " << error.message() << std::endl;
+            return 1;
+        }
+    }
+
+    // Don't pack a previous pack
+    std::string normalizedOutput = normalizePackPath(outputPath);
+    files.erase(std::remove_if(files.begin(), files.end(), [&](const std::string& file) {
+        return normalizePackPath(file) == normalizedOutput;
+    }), files.end());
+
+    PackWriteStats stats;
+    if (!writePackFile(outputPath, files, compress, &stats)) return 1;
+
+    std::cout << "Packed " << stats.fileCount << " files (" << stats.compressedCount << " compressed) into "
+              << outputPath << ": " << stats.bytes / 1024 << " KB -> " << stats.storedBytes / 1024 << " KB" << std::endl;
+    return 0;
+}
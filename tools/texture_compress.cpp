@@ -0,0 +1,127 @@
+/*
+ * Texture Compressor
+ *
+ * Converts images into block-compressed KTX2 files with a full mip chain.
+ * Texture::decode picks them up instead of the source image, so no call site
+ * changes.
+ *
+ * Usage:
+ *   build/texture_compress [--format auto|bc1|bc3|bc7] [--no-etc2] image.png ...
+ *
+ * For "a/b.png" it writes "a/b.ktx2" (BCn) and "a/b.etc2.ktx2" (ETC2, for GPUs
+ * without BCn). "auto" picks BC1 for opaque images and BC7 for images with alpha.
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "AtlasFile.hpp"
+#include "CompressedTexture.hpp"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::string outputBase(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path;
+    return path.substr(0, dot);
+}
+
+static void compressWithMips(BlockFormat format, const unsigned char* rgba, int width, int height,
+                             CompressedTextureData& texture) {
+    texture.format = format;
+    texture.width = width;
+    texture.height = height;
+    texture.levels.clear();
+    texture.data.clear();
+
+    std::vector<unsigned char> level(rgba, rgba + static_cast<size_t>(width) * height * 4);
+    std::vector<unsigned char> nextLevel, blocks;
+    int levelCount = atlasLevelCount(width, height);
+    for (int l = 0; l < levelCount; ++l) {
+        compressImage(format, level.data(), width, height, blocks);
+
+        CompressedLevel entry;
+        entry.width = width;
+        entry.height = height;
+        entry.offset = texture.data.size();
+        entry.size = blocks.size();
+        texture.levels.push_back(entry);
+        texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+
+        if (l + 1 < levelCount) {
+            downsampleAtlasLevel(level.data(), width, height, nextLevel);
+            level.swap(nextLevel);
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string formatName = "auto";
+    bool writeEtc2 = true;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--format") == 0 && hasValue) {
+            formatName = argv[++i];
+        } else if (std::strcmp(argv[i], "--no-etc2") == 0) {
+            writeEtc2 = false;
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if (inputs.empty() || (formatName != "auto" && formatName != "bc1" && formatName != "bc3" && formatName != "bc7")) {
+        std::cerr << "Usage: texture_compress [--format auto|bc1|bc3|bc7] [--no-etc2] image ..." << std::endl;
+        return 1;
+    }
+
+    for (const auto& input : inputs) {
+        int width, height, channels;
+        unsigned char* rgba = stbi_load(input.c_str(), &width, &height, &channels, 4);
+        if (!rgba) {
+            std::cerr << "Failed to load image: " << input << std::endl;
+            return 1;
+        }
+
+        bool hasAlpha = false;
+        for (size_t i = 3; i < static_cast<size_t>(width) * height * 4 && !hasAlpha; i += 4) {
+            hasAlpha = rgba[i] != 255;
+        }
+
+        BlockFormat format = hasAlpha ? BlockFormat::BC7 : BlockFormat::BC1;
+        if (formatName == "bc1") format = BlockFormat::BC1;
+        if (formatName == "bc3") format = BlockFormat::BC3;
+        if (formatName == "bc7") format = BlockFormat::BC7;
+
+        std::vector<std::pair<BlockFormat, std::string>> outputs = { { format, outputBase(input) + ".ktx2" } };
+        if (writeEtc2) {
+            bool etcAlpha = format != BlockFormat::BC1;
+            outputs.push_back({ etcAlpha ? BlockFormat::ETC2_RGBA : BlockFormat::ETC2_RGB, outputBase(input) + ".etc2.ktx2" });
+        }
+
+        // What the uncompressed path uploads: RGB8/RGBA8 plus generated mips (4/3)
+        double sourceBytes = static_cast<double>(width) * height * (channels == 4 ? 4 : 3) * 4.0 / 3.0;
+
+        for (const auto& output : outputs) {
+            CompressedTextureData texture;
+            compressWithMips(output.first, rgba, width, height, texture);
+            if (!writeKtx2(output.second, texture)) {
+                stbi_image_free(rgba);
+                return 1;
+            }
+            std::cout << input << " -> " << output.second << " (" << blockFormatName(output.first) << ", "
+                      << texture.levels.size() << " levels, " << texture.data.size() / 1024 << " KiB, "
+                      << sourceBytes / texture.data.size() << "x smaller)" << std::endl;
+        }
+        stbi_image_free(rgba);
+    }
+    return 0;
+}